@@ -31,10 +31,9 @@ void registerMcpTools() {
     "led_blink",
     "Control ESP32 onboard LEDs",
     "{\"type\":\"object\",\"properties\":{\"state\":{\"type\":\"string\",\"enum\":[\"on\",\"off\",\"blink\"]}},\"required\":[\"state\"]}",
-    [](const String& args) {
-      DynamicJsonDocument doc(256);
-      deserializeJson(doc, args);
-      String state = doc["state"].as<String>();
+    [](JsonObjectConst args) {
+      // args points into the already-parsed request, no need to parse it again
+      String state = args["state"].as<String>();
       
       if (state == "on") {
         digitalWrite(LED_BUILTIN, HIGH);
@@ -49,7 +48,7 @@ void registerMcpTools() {
         }
       }
       
-      return WebSocketMCP::ToolResponse("{\"success\":true,\"state\":\"" + state + "\"}");
+      return ToolResponse("{\"success\":true,\"state\":\"" + state + "\"}");
     }
   );
   Serial.println("[MCP] LED Control Tool Registered");
@@ -0,0 +1,63 @@
+// permessage-deflate benchmarks: CPU cost and compression ratio on real
+// tools/list payloads, and the tools/list reply end to end with compression
+// on (compare txB with BM_HandleJsonRpc_ToolsList_*).
+
+#include <WebSocketMCP.h>
+
+#include "Bench.h"
+#include "McpFixture.h"
+
+static void benchDeflate(BenchState &state, size_t toolCount, uint8_t windowBits) {
+    McpFixture f;
+    f.registerSampleTools(toolCount);
+    const String &json = WebSocketMCPHostAccess::toolsListJson(f.mcp);
+    McpDeflater deflater;
+    deflater.begin(windowBits);
+    uint8_t *out = (uint8_t *)malloc(json.length());
+    size_t compressedLen = 0;
+    while (state.keepRunning()) {
+        compressedLen = deflater.compress((const uint8_t *)json.c_str(), json.length(), out, json.length());
+        benchDoNotOptimize(out);
+    }
+    free(out);
+    state.setBytesPerOp(json.length());
+    state.setCounter("ratio%", 100.0 * compressedLen / json.length());
+}
+
+MCP_BENCHMARK(BM_Deflate_ToolsList_8) { benchDeflate(state, 8, MCP_DEFLATE_WINDOW_BITS); }
+MCP_BENCHMARK(BM_Deflate_ToolsList_64) { benchDeflate(state, 64, MCP_DEFLATE_WINDOW_BITS); }
+MCP_BENCHMARK(BM_Deflate_ToolsList_64_Window9) { benchDeflate(state, 64, 9); }
+MCP_BENCHMARK(BM_Deflate_ToolsList_64_Window15) { benchDeflate(state, 64, 15); }
+
+MCP_BENCHMARK(BM_Inflate_ToolsList_64) {
+    McpFixture f;
+    f.registerSampleTools(64);
+    const String &json = WebSocketMCPHostAccess::toolsListJson(f.mcp);
+    McpDeflater deflater;
+    deflater.begin(MCP_DEFLATE_WINDOW_BITS);
+    uint8_t *compressed = (uint8_t *)malloc(json.length());
+    uint8_t *out = (uint8_t *)malloc(json.length());
+    size_t compressedLen = deflater.compress((const uint8_t *)json.c_str(), json.length(), compressed, json.length());
+    while (state.keepRunning()) {
+        size_t len;
+        benchDoNotOptimize(McpInflater::inflate(compressed, compressedLen, out, json.length(), len));
+    }
+    free(compressed);
+    free(out);
+    state.setBytesPerOp(json.length());
+}
+
+static void benchToolsListDeflated(BenchState &state, size_t toolCount) {
+    McpFixture f;
+    f.registerSampleTools(toolCount);
+    WebSocketMCPHostAccess::enableCompression(f.mcp);
+    String message(MCP_REQ_TOOLS_LIST);
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message);
+    }
+    state.setCounter("txB", (double)f.client.txBytes() / (double)state.iterations());
+}
+
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsList_8_Deflate) { benchToolsListDeflated(state, 8); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsList_64_Deflate) { benchToolsListDeflated(state, 64); }
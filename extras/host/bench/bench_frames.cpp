@@ -0,0 +1,86 @@
+// Framing benchmarks: sendWebSocketFrame / receiveWebSocketFrame, and the send queue behind them.
+
+#include "Bench.h"
+#include "McpFixture.h"
+
+static String makePayload(size_t len) {
+    String s;
+    s.reserve(len);
+    for (size_t i = 0; i < len; i++) {
+        s += (char)('a' + i % 26);
+    }
+    return s;
+}
+
+static void benchSend(BenchState &state, size_t len) {
+    McpFixture f;
+    String payload = makePayload(len);
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::sendWebSocketFrame(f.mcp, payload);
+    }
+    state.setBytesPerOp(len);
+    state.setCounter("writes", (double)f.client.writeCalls() / (double)state.iterations());
+}
+
+MCP_BENCHMARK(BM_SendWebSocketFrame_64) { benchSend(state, 64); }
+MCP_BENCHMARK(BM_SendWebSocketFrame_512) { benchSend(state, 512); }
+MCP_BENCHMARK(BM_SendWebSocketFrame_2048) { benchSend(state, 2048); }
+MCP_BENCHMARK(BM_SendWebSocketFrame_70000) { benchSend(state, 70000); }
+
+// A socket that takes at most one TCP segment per write(): the rest is resumed from the queue.
+static void benchSendPartial(BenchState &state, size_t len) {
+    McpFixture f;
+    f.client.setWriteLimit(536);
+    String payload = makePayload(len);
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::sendWebSocketFrame(f.mcp, payload);
+        while (!WebSocketMCPHostAccess::flushSendQueue(f.mcp)) {
+        }
+    }
+    state.setBytesPerOp(len);
+    state.setCounter("writes", (double)f.client.writeCalls() / (double)state.iterations());
+}
+
+MCP_BENCHMARK(BM_SendWebSocketFrame_512_Partial) { benchSendPartial(state, 512); }
+MCP_BENCHMARK(BM_SendWebSocketFrame_2048_Partial) { benchSendPartial(state, 2048); }
+
+// 20 small requests arriving in one read: their replies are coalesced into shared writes.
+MCP_BENCHMARK(BM_NetworkLoop_Pings_20) {
+    McpFixture f;
+    std::vector<uint8_t> frame;
+    std::vector<uint8_t> burst;
+    LoopbackClient::appendServerFrame(frame, 0x1, MCP_REQ_PING, strlen(MCP_REQ_PING));
+    for (int i = 0; i < 20; i++) {
+        burst.insert(burst.end(), frame.begin(), frame.end());
+    }
+    f.client.pushRx(burst.data(), burst.size());
+    f.mcp.loop();
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        f.client.pushRx(burst.data(), burst.size());
+        f.mcp.loop();
+    }
+    state.setCounter("writes", (double)f.client.writeCalls() / (double)state.iterations());
+}
+
+static void benchReceive(BenchState &state, size_t len) {
+    McpFixture f;
+    String payload = makePayload(len);
+    std::vector<uint8_t> frame;
+    LoopbackClient::appendServerFrame(frame, 0x1, payload.c_str(), payload.length());
+    // Warm the loopback buffer so its growth is not attributed to the parser.
+    f.client.pushRx(frame.data(), frame.size());
+    WebSocketMCPHostAccess::receiveWebSocketFrame(f.mcp);
+    while (state.keepRunning()) {
+        f.client.pushRx(frame.data(), frame.size());
+        bool ready = WebSocketMCPHostAccess::receiveWebSocketFrame(f.mcp);
+        benchDoNotOptimize(ready);
+    }
+    state.setBytesPerOp(len);
+}
+
+MCP_BENCHMARK(BM_ReceiveWebSocketFrame_64) { benchReceive(state, 64); }
+MCP_BENCHMARK(BM_ReceiveWebSocketFrame_512) { benchReceive(state, 512); }
+MCP_BENCHMARK(BM_ReceiveWebSocketFrame_2048) { benchReceive(state, 2048); }
@@ -0,0 +1,147 @@
+// JSON-RPC dispatch benchmarks: handleJsonRpcMessage, escapeJsonString and
+// the McpResponseWriter escaping that replaces it on the reply path.
+// Each op includes building the reply and framing it onto the loopback.
+
+#include "Bench.h"
+#include "McpFixture.h"
+
+static void benchHandle(BenchState &state, const char *request, size_t toolCount) {
+    McpFixture f;
+    f.registerSampleTools(toolCount);
+    String message(request);
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message);
+    }
+    state.setCounter("txB", (double)f.client.txBytes() / (double)state.iterations());
+}
+
+MCP_BENCHMARK(BM_HandleJsonRpc_Ping) { benchHandle(state, MCP_REQ_PING, 1); }
+MCP_BENCHMARK(BM_HandleJsonRpc_Initialize) { benchHandle(state, MCP_REQ_INITIALIZE, 1); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsList_8) { benchHandle(state, MCP_REQ_TOOLS_LIST, 8); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsList_64) { benchHandle(state, MCP_REQ_TOOLS_LIST, 64); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvoke_8) { benchHandle(state, MCP_REQ_TOOLS_INVOKE, 8); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvoke_64) { benchHandle(state, MCP_REQ_TOOLS_INVOKE, 64); }
+// Same request, but the callback reads the parsed arguments through ToolParams
+// instead of receiving them re-serialized as a String.
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvokeArgs_8) {
+    McpFixture f;
+    f.registerSampleTools(8);
+    f.mcp.registerTool("led_blink", "Control the onboard LED", MCP_LED_SCHEMA, [](JsonObjectConst args) {
+        ToolParams params(args);
+        benchDoNotOptimize(params.getString("state").length());
+        return ToolResponse("{\"success\":true,\"state\":\"on\"}");
+    });
+    String message(MCP_REQ_TOOLS_INVOKE);
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message);
+    }
+}
+
+// Same request, the callback printing its result into the reply (McpToolResult):
+// no ToolResponse, no allocation.
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvokeWriter_8) {
+    McpFixture f;
+    f.registerSampleTools(8);
+    f.mcp.registerTool("led_blink", "Control the onboard LED", MCP_LED_SCHEMA,
+                       [](JsonObjectConst args, McpToolResult &result) {
+                           const char *state = args["state"] | "off";
+                           result.print("{\"success\":true,\"state\":\"");
+                           result.print(state);
+                           result.print("\"}");
+                       });
+    String message(MCP_REQ_TOOLS_INVOKE);
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message);
+    }
+}
+
+// Same request on the worker pool: copy of the arguments, hand-off to a worker
+// thread and back, reply sent from loop().
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvokeAsync_8) {
+    McpFixture f;
+    f.registerSampleTools(8);
+    f.mcp.setToolAsync("led_blink", 1);
+    f.mcp.beginToolWorkers(1);
+    String message(MCP_REQ_TOOLS_INVOKE);
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message);
+        size_t sent = f.client.txBytes();
+        while (f.client.txBytes() == sent) {
+            f.mcp.loop();
+        }
+    }
+    state.setCounter("txB", (double)f.client.txBytes() / (double)state.iterations());
+}
+
+// 20 tools/invoke calls, one at a time and as one JSON-RPC batch answered in one frame.
+static String invokeRelay(size_t i) {
+    char request[160];
+    snprintf(request, sizeof(request),
+             "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"relay_%u\","
+             "\"arguments\":{\"state\":true}}}",
+             (unsigned)i, (unsigned)(i + 1));
+    return String(request);
+}
+
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvoke_20x1) {
+    McpFixture f;
+    f.registerSampleTools(21);
+    String messages[20];
+    for (size_t i = 0; i < 20; i++) {
+        messages[i] = invokeRelay(i);
+    }
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        for (size_t i = 0; i < 20; i++) {
+            WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, messages[i]);
+        }
+    }
+    state.setCounter("writes", (double)f.client.writeCalls() / (double)state.iterations());
+}
+
+MCP_BENCHMARK(BM_HandleJsonRpc_Batch_20) {
+    McpFixture f;
+    f.registerSampleTools(21);
+    String batch("[");
+    for (size_t i = 0; i < 20; i++) {
+        if (i > 0) {
+            batch += ",";
+        }
+        batch += invokeRelay(i);
+    }
+    batch += "]";
+    f.mcp.setJsonDocumentCapacity(16384, 16384); // room for all 20 requests at once
+    f.client.resetCounters();
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, batch);
+    }
+    state.setCounter("writes", (double)f.client.writeCalls() / (double)state.iterations());
+}
+
+MCP_BENCHMARK(BM_HandleJsonRpc_UnknownMethod) {
+    benchHandle(state, "{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"resources/list\"}", 1);
+}
+
+MCP_BENCHMARK(BM_EscapeJsonString) {
+    McpFixture f;
+    String input("Control the onboard LED.\nArguments: {\"state\": \"on\" | \"off\" | \"blink\"}\t(see docs/led)");
+    while (state.keepRunning()) {
+        String out = WebSocketMCPHostAccess::escapeJsonString(f.mcp, input);
+        benchDoNotOptimize(out.length());
+    }
+    state.setBytesPerOp(input.length());
+}
+
+MCP_BENCHMARK(BM_ResponseWriter_String) {
+    WsFrameEncoder frame;
+    McpResponseWriter writer(frame);
+    String input("Control the onboard LED.\nArguments: {\"state\": \"on\" | \"off\" | \"blink\"}\t(see docs/led)");
+    while (state.keepRunning()) {
+        frame.begin();
+        writer.string(input);
+        benchDoNotOptimize(frame.payloadLength());
+    }
+    state.setBytesPerOp(input.length());
+}
@@ -0,0 +1,5 @@
+#include "Bench.h"
+
+int main(int argc, char **argv) {
+    return runBenchmarks(argc, argv);
+}
@@ -0,0 +1,106 @@
+// WsFrameParser throughput with input split into small TCP segments, many
+// frames coalesced into one read, or messages split into continuation frames.
+
+#include <WsFrameParser.h>
+
+#include <vector>
+
+#include "Bench.h"
+#include "LoopbackClient.h"
+
+static std::vector<uint8_t> makeFrames(size_t frameLen, size_t count) {
+    std::vector<char> payload(frameLen);
+    for (size_t i = 0; i < frameLen; i++) {
+        payload[i] = (char)('a' + i % 26);
+    }
+    std::vector<uint8_t> frame, stream;
+    LoopbackClient::appendServerFrame(frame, 0x1, payload.data(), payload.size());
+    for (size_t i = 0; i < count; i++) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    return stream;
+}
+
+// One frameLen message sent as `fragments` frames, with a PING between the first two.
+static std::vector<uint8_t> makeFragmentedMessage(size_t frameLen, size_t fragments) {
+    std::vector<char> payload(frameLen);
+    for (size_t i = 0; i < frameLen; i++) {
+        payload[i] = (char)('a' + i % 26);
+    }
+    std::vector<uint8_t> frame, stream;
+    size_t step = frameLen / fragments;
+    for (size_t i = 0; i < fragments; i++) {
+        size_t len = i + 1 == fragments ? frameLen - i * step : step;
+        LoopbackClient::appendServerFrame(frame, i == 0 ? 0x1 : 0x0, payload.data() + i * step, len,
+                                          i + 1 == fragments);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        if (i == 0) {
+            LoopbackClient::appendServerFrame(frame, 0x9, "ping", 4);
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+    }
+    return stream;
+}
+
+// Feed the stream in segments of at most segment bytes, as a TCP stack would deliver it.
+static void benchParseStream(BenchState &state, const std::vector<uint8_t> &stream, size_t maxMessage,
+                             size_t segment) {
+    WsFrameParser parser(maxMessage);
+    parser.begin();
+    size_t frames = 0;
+    while (state.keepRunning()) {
+        size_t pos = 0;
+        while (pos < stream.size()) {
+            size_t segLen = stream.size() - pos < segment ? stream.size() - pos : segment;
+            size_t segPos = 0;
+            while (segPos < segLen) {
+                size_t used;
+                if (parser.feed(stream.data() + pos + segPos, segLen - segPos, used) == WsFrameParser::MESSAGE_READY) {
+                    frames++;
+                }
+                segPos += used;
+            }
+            pos += segLen;
+        }
+    }
+    benchDoNotOptimize(frames);
+    state.setBytesPerOp(stream.size());
+    state.setCounter("frames", (double)frames / (double)state.iterations());
+}
+
+static void benchParse(BenchState &state, size_t frameLen, size_t count, size_t segment) {
+    benchParseStream(state, makeFrames(frameLen, count), frameLen, segment);
+}
+
+MCP_BENCHMARK(BM_ParseFrame_2048_Split1) { benchParse(state, 2048, 1, 1); }
+MCP_BENCHMARK(BM_ParseFrame_2048_Split7) { benchParse(state, 2048, 1, 7); }
+MCP_BENCHMARK(BM_ParseFrame_8192_Split1460) { benchParse(state, 8192, 1, 1460); }
+MCP_BENCHMARK(BM_ParseFrames_64x32_Coalesced) { benchParse(state, 64, 32, 1 << 20); }
+MCP_BENCHMARK(BM_ParseFrames_300x16_Split1460) { benchParse(state, 300, 16, 1460); }
+MCP_BENCHMARK(BM_ParseFragmented_8192x8_Split1460) {
+    benchParseStream(state, makeFragmentedMessage(8192, 8), 8192, 1460);
+}
+
+// Same stream pulled from a Client with readFrom(), payload read in place.
+static void benchReadFrom(BenchState &state, size_t frameLen, size_t count) {
+    std::vector<uint8_t> stream = makeFrames(frameLen, count);
+    LoopbackClient client;
+    client.setConnected(true);
+    WsFrameParser parser(frameLen);
+    parser.begin();
+    client.pushRx(stream.data(), stream.size());
+    while (parser.readFrom(client) == WsFrameParser::MESSAGE_READY) {
+    }
+    size_t frames = 0;
+    while (state.keepRunning()) {
+        client.pushRx(stream.data(), stream.size());
+        while (parser.readFrom(client) == WsFrameParser::MESSAGE_READY) {
+            frames++;
+        }
+    }
+    benchDoNotOptimize(frames);
+    state.setBytesPerOp(stream.size());
+}
+
+MCP_BENCHMARK(BM_ReadFrom_2048) { benchReadFrom(state, 2048, 1); }
+MCP_BENCHMARK(BM_ReadFrom_64x32) { benchReadFrom(state, 64, 32); }
@@ -0,0 +1,97 @@
+// Tool registry benchmarks at 10/100/1000 tools: name lookup through the hash
+// index (with a linear String scan as reference), tools/invoke of the most
+// recently registered tool, and registering a full set.
+
+#include <stdio.h>
+#include <vector>
+
+#include "Bench.h"
+#include "McpFixture.h"
+
+static std::vector<String> toolNames(size_t count) {
+    std::vector<String> names;
+    names.push_back("led_blink");
+    for (size_t i = 1; i < count; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "relay_%u", (unsigned)i);
+        names.push_back(name);
+    }
+    return names;
+}
+
+// One lookup per op, cycling through every registered name.
+static void benchFindTool(BenchState &state, size_t count) {
+    McpFixture f;
+    f.registerSampleTools(count);
+    std::vector<String> names = toolNames(count);
+    size_t i = 0;
+    long found = 0;
+    while (state.keepRunning()) {
+        found += WebSocketMCPHostAccess::findTool(f.mcp, names[i].c_str());
+        i = i + 1 == count ? 0 : i + 1;
+    }
+    benchDoNotOptimize(found);
+}
+
+MCP_BENCHMARK(BM_FindTool_10) { benchFindTool(state, 10); }
+MCP_BENCHMARK(BM_FindTool_100) { benchFindTool(state, 100); }
+MCP_BENCHMARK(BM_FindTool_1000) { benchFindTool(state, 1000); }
+
+MCP_BENCHMARK(BM_FindTool_Miss_1000) {
+    McpFixture f;
+    f.registerSampleTools(1000);
+    long found = 0;
+    while (state.keepRunning()) {
+        found += WebSocketMCPHostAccess::findTool(f.mcp, "relay_missing");
+    }
+    benchDoNotOptimize(found);
+}
+
+// What registerTool/tools/invoke did before the index: compare Strings in order.
+static void benchLinearScan(BenchState &state, size_t count) {
+    std::vector<String> names = toolNames(count);
+    size_t i = 0;
+    long found = 0;
+    while (state.keepRunning()) {
+        String wanted = names[i];
+        for (size_t j = 0; j < names.size(); j++) {
+            if (names[j] == wanted) {
+                found += (long)j;
+                break;
+            }
+        }
+        i = i + 1 == count ? 0 : i + 1;
+    }
+    benchDoNotOptimize(found);
+}
+
+MCP_BENCHMARK(BM_LinearScan_10) { benchLinearScan(state, 10); }
+MCP_BENCHMARK(BM_LinearScan_100) { benchLinearScan(state, 100); }
+MCP_BENCHMARK(BM_LinearScan_1000) { benchLinearScan(state, 1000); }
+
+// tools/invoke of the last tool, the worst case for a linear scan.
+static void benchInvokeLast(BenchState &state, size_t count) {
+    McpFixture f;
+    f.registerSampleTools(count);
+    char request[192];
+    snprintf(request, sizeof(request),
+             "{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"relay_%u\","
+             "\"arguments\":{\"state\":true}}}",
+             (unsigned)(count - 1));
+    String message(request);
+    while (state.keepRunning()) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message);
+    }
+}
+
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvokeLast_10) { benchInvokeLast(state, 10); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvokeLast_100) { benchInvokeLast(state, 100); }
+MCP_BENCHMARK(BM_HandleJsonRpc_ToolsInvokeLast_1000) { benchInvokeLast(state, 1000); }
+
+MCP_BENCHMARK(BM_RegisterTools_1000) {
+    McpFixture f;
+    while (state.keepRunning()) {
+        f.registerSampleTools(1000);
+        f.mcp.clearTools();
+    }
+}
@@ -0,0 +1,27 @@
+// McpSpscRing benchmarks: the hand-off cost between the network task and
+// loop() in network task mode, per message.
+
+#include <WebSocketMCP.h>
+
+#include <string.h>
+
+#include "Bench.h"
+
+static void benchPushPop(BenchState &state, size_t len) {
+    McpSpscRing ring;
+    ring.begin(MCP_NET_RX_RING_SIZE);
+    uint8_t message[1024];
+    memset(message, 'x', sizeof(message));
+    while (state.keepRunning()) {
+        ring.push(0, message, len);
+        size_t got;
+        uint8_t type;
+        benchDoNotOptimize(ring.peek(got, type));
+        ring.pop();
+    }
+    state.setBytesPerOp(len);
+}
+
+MCP_BENCHMARK(BM_SpscRing_PushPop_64) { benchPushPop(state, 64); }
+MCP_BENCHMARK(BM_SpscRing_PushPop_1024) { benchPushPop(state, 1024); }
+
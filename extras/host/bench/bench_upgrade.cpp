@@ -0,0 +1,61 @@
+// HTTP upgrade response parsing (WsUpgradeResponse), as done once per connect.
+
+#include "Bench.h"
+#include "McpFixture.h"
+
+#include <WsUpgradeResponse.h>
+
+// What a cloud endpoint behind nginx typically answers
+static const char *const NGINX_RESPONSE =
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Server: nginx/1.24.0\r\n"
+    "Date: Thu, 16 Oct 2025 08:00:00 GMT\r\n"
+    "Connection: upgrade\r\n"
+    "Upgrade: websocket\r\n"
+    "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+    "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover; client_max_window_bits=11\r\n"
+    "Strict-Transport-Security: max-age=31536000\r\n"
+    "\r\n";
+
+MCP_BENCHMARK(BM_UpgradeResponse_Feed) {
+    WsUpgradeResponse r;
+    size_t len = strlen(NGINX_RESPONSE);
+    while (state.keepRunning()) {
+        r.reset();
+        size_t consumed;
+        r.feed((const uint8_t *)NGINX_RESPONSE, len, consumed);
+        benchDoNotOptimize(r.header("sec-websocket-accept"));
+    }
+    state.setBytesPerOp(len);
+}
+
+// The socket handing over one byte per read: still one pass over the bytes
+MCP_BENCHMARK(BM_UpgradeResponse_Feed_Bytewise) {
+    WsUpgradeResponse r;
+    size_t len = strlen(NGINX_RESPONSE);
+    while (state.keepRunning()) {
+        r.reset();
+        for (size_t i = 0; i < len; i++) {
+            size_t consumed;
+            r.feed((const uint8_t *)NGINX_RESPONSE + i, 1, consumed);
+        }
+        benchDoNotOptimize(r.header("sec-websocket-accept"));
+    }
+    state.setBytesPerOp(len);
+}
+
+MCP_BENCHMARK(BM_UpgradeResponse_ReadFrom) {
+    LoopbackClient client;
+    client.setConnected(true);
+    WsUpgradeResponse r;
+    size_t len = strlen(NGINX_RESPONSE);
+    client.pushRx(NGINX_RESPONSE, len);
+    r.readFrom(client); // warm the loopback buffer
+    while (state.keepRunning()) {
+        client.pushRx(NGINX_RESPONSE, len);
+        r.reset();
+        r.readFrom(client);
+        benchDoNotOptimize(r.header("sec-websocket-accept"));
+    }
+    state.setBytesPerOp(len);
+}
@@ -0,0 +1,246 @@
+/*
+ * Replays a traffic capture (WebSocketMCP::writeCapture, McpCapture format)
+ * through the JSON-RPC layer and reports how long each message took to handle
+ * and how much it allocated.
+ *
+ *   ./build-host/mcp_replay CAPTURE [--realtime] [--speed=X] [--verbose]
+ *
+ * Every message the server sent is handed to handleJsonRpcMessage() in order,
+ * as fast as possible or, with --realtime, at the capture's own pace (--speed
+ * scales it). Replies go to a LoopbackClient and are only counted. A stub tool
+ * answering {"success":true} is registered for every tool the capture invokes,
+ * so tools/invoke runs the same dispatch path as on the device; the device's
+ * own tool code is not part of the measurement. Truncated messages cannot be
+ * replayed and are skipped.
+ */
+#include <McpCapture.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AllocHook.h"
+#include "McpFixture.h"
+
+namespace {
+
+// Library log lines would mix with the report
+class NullPrint : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+};
+
+struct Sample {
+    uint64_t ns;
+    uint64_t allocs;
+    uint64_t bytes;
+};
+
+struct MethodStats {
+    std::vector<Sample> samples;
+};
+
+uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool readFile(const char *path, std::vector<uint8_t> &data) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Method and tool name of a request; the method is "(invalid)" if it does not parse
+void describe(const McpCapture::Record &record, std::string &method, std::string &tool) {
+    DynamicJsonDocument doc(record.storedLength * 2 + 1024);
+    if (deserializeJson(doc, (const char *)record.payload, record.storedLength)) {
+        method = "(invalid)";
+        return;
+    }
+    if (doc.is<JsonArray>()) {
+        method = "(batch)";
+        return;
+    }
+    method = doc["method"] | "(response)";
+    tool = doc["params"]["tool_name"] | "";
+}
+
+uint64_t percentile(std::vector<uint64_t> sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+void printStats(const char *name, const std::vector<Sample> &samples) {
+    std::vector<uint64_t> ns;
+    uint64_t total = 0;
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        ns.push_back(samples[i].ns);
+        total += samples[i].ns;
+        allocs += samples[i].allocs;
+        bytes += samples[i].bytes;
+    }
+    std::sort(ns.begin(), ns.end());
+    size_t n = samples.size();
+    printf("%-32s %7zu %10.1f %10.1f %10.1f %10.1f %10.2f %10.1f\n", name, n, total / 1000.0 / n,
+           percentile(ns, 0.5) / 1000.0, percentile(ns, 0.99) / 1000.0, ns.back() / 1000.0,
+           (double)allocs / n, (double)bytes / n);
+}
+
+void usage() {
+    fprintf(stderr, "usage: mcp_replay CAPTURE [--realtime] [--speed=X] [--verbose]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *path = nullptr;
+    bool realtime = false;
+    bool verbose = false;
+    double speed = 1.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strncmp(argv[i], "--speed=", 8) == 0) {
+            speed = atof(argv[i] + 8);
+            realtime = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!path || speed <= 0) {
+        usage();
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        fprintf(stderr, "mcp_replay: cannot read %s\n", path);
+        return 1;
+    }
+    if (!McpCapture::validHeader(data.data(), data.size())) {
+        fprintf(stderr, "mcp_replay: %s is not a capture (or of another format version)\n", path);
+        return 1;
+    }
+
+    // One pass to find the tools to stub and the message count
+    std::vector<McpCapture::Record> records;
+    std::set<std::string> tools;
+    size_t pos = McpCapture::FILE_HEADER_LEN;
+    McpCapture::Record record;
+    while (McpCapture::next(data.data(), data.size(), pos, record)) {
+        records.push_back(record);
+        std::string method, tool;
+        if (!record.outgoing() && record.opcode() == WS_OP_TEXT) {
+            describe(record, method, tool);
+            if (!tool.empty()) {
+                tools.insert(tool);
+            }
+        }
+    }
+    if (pos != data.size()) {
+        fprintf(stderr, "mcp_replay: %zu trailing bytes ignored (incomplete record)\n", data.size() - pos);
+    }
+
+    NullPrint quiet;
+    McpLog::setOutput(quiet);
+    McpFixture f;
+    for (std::set<std::string>::const_iterator it = tools.begin(); it != tools.end(); ++it) {
+        f.mcp.registerTool(it->c_str(), "Replay stub", "{\"type\":\"object\"}",
+                           [](JsonObjectConst) { return ToolResponse("{\"success\":true}"); });
+    }
+
+    std::map<std::string, MethodStats> byMethod;
+    std::vector<Sample> all;
+    size_t outgoing = 0;
+    size_t control = 0;
+    size_t truncated = 0;
+    uint64_t lateNs = 0;
+    uint32_t firstMs = records.empty() ? 0 : records[0].timeMs;
+    uint64_t startNs = nowNs();
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const McpCapture::Record &r = records[i];
+        if (r.outgoing()) {
+            outgoing++;
+            continue;
+        }
+        if (r.opcode() != WS_OP_TEXT) {
+            control++;
+            continue;
+        }
+        if (r.flags & McpCapture::FLAG_TRUNCATED) {
+            truncated++;
+            continue;
+        }
+        std::string method, tool;
+        describe(r, method, tool);
+
+        if (realtime) {
+            uint64_t due = startNs + (uint64_t)((uint32_t)(r.timeMs - firstMs) * 1e6 / speed);
+            uint64_t now = nowNs();
+            if (due > now) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+            } else {
+                lateNs += now - due;
+            }
+        }
+
+        AllocStats a0 = allocSnapshot();
+        uint64_t t0 = nowNs();
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, (const char *)r.payload, r.storedLength);
+        uint64_t t1 = nowNs();
+        AllocStats a1 = allocSnapshot();
+
+        Sample sample = {t1 - t0, a1.count - a0.count, a1.bytes - a0.bytes};
+        all.push_back(sample);
+        byMethod[method].samples.push_back(sample);
+        if (verbose) {
+            printf("%10lu ms  %-24s %-16s %9.1f us %4llu allocs %7llu B\n", (unsigned long)(r.timeMs - firstMs),
+                   method.c_str(), tool.c_str(), sample.ns / 1000.0, (unsigned long long)sample.allocs,
+                   (unsigned long long)sample.bytes);
+        }
+    }
+
+    printf("%s: %zu records, %zu messages replayed, %zu sent by the device, %zu control frames, %zu truncated\n",
+           path, records.size(), all.size(), outgoing, control, truncated);
+    if (realtime && lateNs > 0) {
+        printf("behind schedule by %.1f ms in total\n", lateNs / 1e6);
+    }
+    if (all.empty()) {
+        return 0;
+    }
+    printf("%-32s %7s %10s %10s %10s %10s %10s %10s\n", "method", "count", "mean us", "p50 us", "p99 us",
+           "max us", "allocs", "B/msg");
+    for (std::map<std::string, MethodStats>::const_iterator it = byMethod.begin(); it != byMethod.end(); ++it) {
+        printStats(it->first.c_str(), it->second.samples);
+    }
+    printStats("(all)", all);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// Added by hostAdvanceMillis()
+static std::atomic<unsigned long> skippedMs(0);
+
+unsigned long millis(void) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - startTime).count() + skippedMs;
+}
+
+unsigned long micros(void) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - startTime).count() + skippedMs * 1000;
+}
+
+void hostAdvanceMillis(unsigned long ms) {
+    skippedMs += ms;
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield(void) {
+    std::this_thread::yield();
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+    delay(xTicksToDelay * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)millis();
+}
+
+// xorshift32: deterministic across runs so benchmark payloads are reproducible.
+static uint32_t randomState = 0x2545F491u;
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) {
+        randomState = (uint32_t)seed;
+    }
+}
+
+static uint32_t nextRandom() {
+    uint32_t x = randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+    return x;
+}
+
+long random(long howbig) {
+    if (howbig <= 0) {
+        return 0;
+    }
+    return (long)(nextRandom() % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
@@ -0,0 +1,61 @@
+/*
+ * Host (Linux) replacement for the ESP32 Arduino core entry header.
+ *
+ * Provides just enough of the core (String, Print/Stream/Client, Serial,
+ * timing, random and the FreeRTOS delay API) to compile src/ on a PC for the
+ * benchmarks in extras/host. Hardware APIs are intentionally absent.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+#include <algorithm>
+#endif
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "Client.h"
+#include "HardwareSerial.h"
+
+using std::max;
+using std::min;
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// Host only: move millis() and micros() forward without sleeping, for timeouts in tests.
+void hostAdvanceMillis(unsigned long ms);
+
+#endif
+
+#endif // HOST_ARDUINO_H
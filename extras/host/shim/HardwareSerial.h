@@ -0,0 +1,53 @@
+/*
+ * Host (Linux) replacement for the ESP32 HardwareSerial. Output goes to a
+ * stdio stream (stdout by default) and can be silenced with setOutput(nullptr)
+ * so that benchmarks measure the library rather than the terminal.
+ */
+#ifndef HOST_HARDWARESERIAL_H
+#define HOST_HARDWARESERIAL_H
+
+#include <stdio.h>
+
+#include "Stream.h"
+
+class HardwareSerial : public Stream {
+public:
+    HardwareSerial() : _out(stdout) {}
+
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+
+    // Host only: redirect or silence output.
+    void setOutput(FILE *out) { _out = out; }
+
+    size_t write(uint8_t c) override {
+        if (_out) {
+            fputc(c, _out);
+        }
+        return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        if (_out) {
+            fwrite(buffer, 1, size, _out);
+        }
+        return size;
+    }
+    void flush() override {
+        if (_out) {
+            fflush(_out);
+        }
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+
+    using Print::write;
+
+private:
+    FILE *_out;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_HARDWARESERIAL_H
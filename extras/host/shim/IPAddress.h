@@ -0,0 +1,46 @@
+/*
+ * Host (Linux) replacement for the Arduino core IPAddress class (IPv4 only).
+ */
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+class IPAddress {
+public:
+    IPAddress() { memset(_bytes, 0, sizeof(_bytes)); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        _bytes[0] = a;
+        _bytes[1] = b;
+        _bytes[2] = c;
+        _bytes[3] = d;
+    }
+    explicit IPAddress(uint32_t address) { memcpy(_bytes, &address, sizeof(_bytes)); }
+
+    operator uint32_t() const {
+        uint32_t v;
+        memcpy(&v, _bytes, sizeof(v));
+        return v;
+    }
+    bool operator==(const IPAddress &rhs) const { return memcmp(_bytes, rhs._bytes, sizeof(_bytes)) == 0; }
+    bool operator!=(const IPAddress &rhs) const { return !(*this == rhs); }
+    uint8_t operator[](int index) const { return _bytes[index]; }
+    uint8_t &operator[](int index) { return _bytes[index]; }
+
+    String toString() const {
+        String s(_bytes[0]);
+        for (int i = 1; i < 4; i++) {
+            s += '.';
+            s += _bytes[i];
+        }
+        return s;
+    }
+
+private:
+    uint8_t _bytes[4];
+};
+
+#endif // HOST_IPADDRESS_H
@@ -0,0 +1,42 @@
+#include "Print.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (write(*buffer++)) {
+            n++;
+        } else {
+            break;
+        }
+    }
+    return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+    char loc_buf[64];
+    va_list arg;
+    va_start(arg, format);
+    int len = vsnprintf(loc_buf, sizeof(loc_buf), format, arg);
+    va_end(arg);
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len < sizeof(loc_buf)) {
+        return write((const uint8_t *)loc_buf, len);
+    }
+    // Same fallback as the ESP32 core: format again into a heap buffer.
+    char *temp = (char *)malloc(len + 1);
+    if (!temp) {
+        return 0;
+    }
+    va_start(arg, format);
+    vsnprintf(temp, len + 1, format, arg);
+    va_end(arg);
+    size_t n = write((const uint8_t *)temp, len);
+    free(temp);
+    return n;
+}
@@ -0,0 +1,461 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+String::String(const char *cstr) {
+    initEmpty();
+    if (cstr) {
+        copy(cstr, strlen(cstr));
+    }
+}
+
+String::String(const char *cstr, unsigned int length) {
+    initEmpty();
+    if (cstr) {
+        copy(cstr, length);
+    }
+}
+
+String::String(const String &str) {
+    initEmpty();
+    copy(str._buf, str._len);
+}
+
+String::String(String &&rval) {
+    initEmpty();
+    move(rval);
+}
+
+String::String(StringSumHelper &&rval) {
+    initEmpty();
+    move(rval);
+}
+
+String::String(char c) {
+    initEmpty();
+    copy(&c, 1);
+}
+
+static void formatInteger(String &out, unsigned long long value, bool negative, unsigned char base) {
+    char buf[8 * sizeof(value) + 2];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        unsigned digit = (unsigned)(value % base);
+        *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value);
+    if (negative) {
+        *--p = '-';
+    }
+    out = p;
+}
+
+String::String(unsigned char value, unsigned char base) {
+    initEmpty();
+    formatInteger(*this, value, false, base);
+}
+
+String::String(int value, unsigned char base) {
+    initEmpty();
+    bool neg = base == 10 && value < 0;
+    formatInteger(*this, neg ? 0ULL - (unsigned long long)value : (unsigned int)value, neg, base);
+}
+
+String::String(unsigned int value, unsigned char base) {
+    initEmpty();
+    formatInteger(*this, value, false, base);
+}
+
+String::String(long value, unsigned char base) {
+    initEmpty();
+    bool neg = base == 10 && value < 0;
+    formatInteger(*this, neg ? 0ULL - (unsigned long long)value : (unsigned long)value, neg, base);
+}
+
+String::String(unsigned long value, unsigned char base) {
+    initEmpty();
+    formatInteger(*this, value, false, base);
+}
+
+String::String(long long value, unsigned char base) {
+    initEmpty();
+    bool neg = base == 10 && value < 0;
+    formatInteger(*this, neg ? 0ULL - (unsigned long long)value : (unsigned long long)value, neg, base);
+}
+
+String::String(unsigned long long value, unsigned char base) {
+    initEmpty();
+    formatInteger(*this, value, false, base);
+}
+
+String::String(float value, unsigned int decimalPlaces) {
+    initEmpty();
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, (double)value);
+    copy(buf, strlen(buf));
+}
+
+String::String(double value, unsigned int decimalPlaces) {
+    initEmpty();
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    copy(buf, strlen(buf));
+}
+
+String::~String() {
+    if (!isSSO()) {
+        free(_buf);
+    }
+}
+
+void String::initEmpty() {
+    _buf = _sso;
+    _cap = SSO_CAPACITY;
+    _len = 0;
+    _sso[0] = '\0';
+}
+
+void String::setLen(unsigned int len) {
+    _len = len;
+    _buf[len] = '\0';
+}
+
+bool String::reserve(unsigned int size) {
+    if (size <= _cap) {
+        return true;
+    }
+    // Exact-size growth, as in the ESP32 core's changeBuffer().
+    char *newBuf;
+    if (isSSO()) {
+        newBuf = (char *)malloc(size + 1);
+        if (!newBuf) {
+            return false;
+        }
+        memcpy(newBuf, _sso, _len + 1);
+    } else {
+        newBuf = (char *)realloc(_buf, size + 1);
+        if (!newBuf) {
+            return false;
+        }
+    }
+    _buf = newBuf;
+    _cap = size;
+    return true;
+}
+
+String &String::copy(const char *cstr, unsigned int length) {
+    if (!reserve(length)) {
+        setLen(0);
+        return *this;
+    }
+    memmove(_buf, cstr, length);
+    setLen(length);
+    return *this;
+}
+
+void String::move(String &rhs) {
+    if (this == &rhs) {
+        return;
+    }
+    if (rhs.isSSO()) {
+        copy(rhs._buf, rhs._len);
+    } else {
+        if (!isSSO()) {
+            free(_buf);
+        }
+        _buf = rhs._buf;
+        _cap = rhs._cap;
+        _len = rhs._len;
+        rhs.initEmpty();
+        return;
+    }
+    rhs.setLen(0);
+}
+
+String &String::operator=(const String &rhs) {
+    if (this != &rhs) {
+        copy(rhs._buf, rhs._len);
+    }
+    return *this;
+}
+
+String &String::operator=(const char *cstr) {
+    if (cstr) {
+        copy(cstr, strlen(cstr));
+    } else {
+        setLen(0);
+    }
+    return *this;
+}
+
+String &String::operator=(String &&rval) {
+    move(rval);
+    return *this;
+}
+
+String &String::operator=(StringSumHelper &&rval) {
+    move(rval);
+    return *this;
+}
+
+bool String::concat(const char *cstr, unsigned int length) {
+    if (!cstr) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    unsigned int newLen = _len + length;
+    // cstr may point into our own buffer, which reserve() may move.
+    if (cstr >= _buf && cstr < _buf + _len + 1) {
+        size_t offset = cstr - _buf;
+        if (!reserve(newLen)) {
+            return false;
+        }
+        cstr = _buf + offset;
+    } else if (!reserve(newLen)) {
+        return false;
+    }
+    memmove(_buf + _len, cstr, length);
+    setLen(newLen);
+    return true;
+}
+
+bool String::concat(const String &str) { return concat(str._buf, str._len); }
+bool String::concat(const char *cstr) { return cstr ? concat(cstr, strlen(cstr)) : false; }
+bool String::concat(char c) { return concat(&c, 1); }
+bool String::concat(unsigned char num) { return concat(String(num)); }
+bool String::concat(int num) { return concat(String(num)); }
+bool String::concat(unsigned int num) { return concat(String(num)); }
+bool String::concat(long num) { return concat(String(num)); }
+bool String::concat(unsigned long num) { return concat(String(num)); }
+bool String::concat(long long num) { return concat(String(num)); }
+bool String::concat(unsigned long long num) { return concat(String(num)); }
+bool String::concat(float num) { return concat(String(num)); }
+bool String::concat(double num) { return concat(String(num)); }
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const String &rhs) {
+    StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+    a.concat(rhs);
+    return a;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const char *cstr) {
+    StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+    a.concat(cstr);
+    return a;
+}
+
+#define HOST_STRING_SUM(type)                                                  \
+    StringSumHelper &operator+(const StringSumHelper &lhs, type num) {        \
+        StringSumHelper &a = const_cast<StringSumHelper &>(lhs);              \
+        a.concat(num);                                                         \
+        return a;                                                              \
+    }
+HOST_STRING_SUM(char)
+HOST_STRING_SUM(unsigned char)
+HOST_STRING_SUM(int)
+HOST_STRING_SUM(unsigned int)
+HOST_STRING_SUM(long)
+HOST_STRING_SUM(unsigned long)
+HOST_STRING_SUM(long long)
+HOST_STRING_SUM(unsigned long long)
+HOST_STRING_SUM(float)
+HOST_STRING_SUM(double)
+#undef HOST_STRING_SUM
+
+int String::compareTo(const String &s) const {
+    return strcmp(_buf, s._buf);
+}
+
+bool String::equals(const String &s) const {
+    return _len == s._len && memcmp(_buf, s._buf, _len) == 0;
+}
+
+bool String::equals(const char *cstr) const {
+    if (!cstr) {
+        return _len == 0;
+    }
+    return strcmp(_buf, cstr) == 0;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+    if (_len != s._len) {
+        return false;
+    }
+    for (unsigned int i = 0; i < _len; i++) {
+        if (tolower((unsigned char)_buf[i]) != tolower((unsigned char)s._buf[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool String::startsWith(const String &prefix) const {
+    return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const {
+    if (offset > _len || prefix._len > _len - offset) {
+        return false;
+    }
+    return memcmp(_buf + offset, prefix._buf, prefix._len) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+    if (suffix._len > _len) {
+        return false;
+    }
+    return memcmp(_buf + _len - suffix._len, suffix._buf, suffix._len) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+    return index < _len ? _buf[index] : '\0';
+}
+
+void String::setCharAt(unsigned int index, char c) {
+    if (index < _len) {
+        _buf[index] = c;
+    }
+}
+
+char String::operator[](unsigned int index) const {
+    return charAt(index);
+}
+
+char &String::operator[](unsigned int index) {
+    static char dummy;
+    if (index >= _len) {
+        dummy = '\0';
+        return dummy;
+    }
+    return _buf[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const {
+    if (!bufsize || !buf) {
+        return;
+    }
+    if (index >= _len) {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = bufsize - 1;
+    if (n > _len - index) {
+        n = _len - index;
+    }
+    memcpy(buf, _buf + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    if (fromIndex >= _len) {
+        return -1;
+    }
+    const char *p = (const char *)memchr(_buf + fromIndex, ch, _len - fromIndex);
+    return p ? (int)(p - _buf) : -1;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+    if (fromIndex > _len) {
+        return -1;
+    }
+    const char *p = strstr(_buf + fromIndex, str._buf);
+    return p ? (int)(p - _buf) : -1;
+}
+
+int String::lastIndexOf(char ch) const {
+    const char *p = strrchr(_buf, ch);
+    return p ? (int)(p - _buf) : -1;
+}
+
+int String::lastIndexOf(const String &str) const {
+    if (str._len > _len) {
+        return -1;
+    }
+    for (int i = (int)(_len - str._len); i >= 0; i--) {
+        if (memcmp(_buf + i, str._buf, str._len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+    if (left > right) {
+        unsigned int tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (left >= _len) {
+        return String();
+    }
+    if (right > _len) {
+        right = _len;
+    }
+    return String(_buf + left, right - left);
+}
+
+void String::replace(const String &find, const String &replace) {
+    if (find._len == 0) {
+        return;
+    }
+    String out;
+    unsigned int i = 0;
+    while (i < _len) {
+        if (i + find._len <= _len && memcmp(_buf + i, find._buf, find._len) == 0) {
+            out.concat(replace);
+            i += find._len;
+        } else {
+            out.concat(_buf[i]);
+            i++;
+        }
+    }
+    *this = out;
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index >= _len) {
+        return;
+    }
+    if (count > _len - index) {
+        count = _len - index;
+    }
+    memmove(_buf + index, _buf + index + count, _len - index - count);
+    setLen(_len - count);
+}
+
+void String::toLowerCase() {
+    for (unsigned int i = 0; i < _len; i++) {
+        _buf[i] = (char)tolower((unsigned char)_buf[i]);
+    }
+}
+
+void String::toUpperCase() {
+    for (unsigned int i = 0; i < _len; i++) {
+        _buf[i] = (char)toupper((unsigned char)_buf[i]);
+    }
+}
+
+void String::trim() {
+    unsigned int begin = 0;
+    while (begin < _len && isspace((unsigned char)_buf[begin])) {
+        begin++;
+    }
+    unsigned int end = _len;
+    while (end > begin && isspace((unsigned char)_buf[end - 1])) {
+        end--;
+    }
+    memmove(_buf, _buf + begin, end - begin);
+    setLen(end - begin);
+}
+
+long String::toInt() const { return atol(_buf); }
+float String::toFloat() const { return (float)atof(_buf); }
+double String::toDouble() const { return atof(_buf); }
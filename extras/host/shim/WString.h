@@ -0,0 +1,172 @@
+/*
+ * Host (Linux) replacement for the Arduino core String class.
+ *
+ * Only the subset used by the library, the examples and ArduinoJson is
+ * implemented. Growth behaviour deliberately mirrors the ESP32 core: short
+ * strings live in an 11 byte SSO buffer and every concatenation reallocates
+ * to the exact new length, so heap allocation counts measured on the host
+ * are representative of the device.
+ */
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class StringSumHelper;
+
+class String {
+public:
+    String(const char *cstr = "");
+    String(const char *cstr, unsigned int length);
+    String(const String &str);
+    String(String &&rval);
+    String(StringSumHelper &&rval);
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+    ~String();
+
+    // memory management
+    bool reserve(unsigned int size);
+    unsigned int length() const { return _len; }
+    bool isEmpty() const { return _len == 0; }
+    void clear() { setLen(0); }
+
+    // assignment
+    String &operator=(const String &rhs);
+    String &operator=(const char *cstr);
+    String &operator=(String &&rval);
+    String &operator=(StringSumHelper &&rval);
+
+    // concatenation
+    bool concat(const String &str);
+    bool concat(const char *cstr);
+    bool concat(const char *cstr, unsigned int length);
+    bool concat(const uint8_t *cstr, unsigned int length) { return concat((const char *)cstr, length); }
+    bool concat(char c);
+    bool concat(unsigned char num);
+    bool concat(int num);
+    bool concat(unsigned int num);
+    bool concat(long num);
+    bool concat(unsigned long num);
+    bool concat(long long num);
+    bool concat(unsigned long long num);
+    bool concat(float num);
+    bool concat(double num);
+
+    template <typename T>
+    String &operator+=(const T &rhs) {
+        concat(rhs);
+        return *this;
+    }
+    String &operator+=(const char *cstr) {
+        concat(cstr);
+        return *this;
+    }
+
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, const String &rhs);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, const char *cstr);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, char c);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, unsigned char num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, int num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, unsigned int num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, long num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, unsigned long num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, long long num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, unsigned long long num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, float num);
+    friend StringSumHelper &operator+(const StringSumHelper &lhs, double num);
+
+    // comparison
+    int compareTo(const String &s) const;
+    bool equals(const String &s) const;
+    bool equals(const char *cstr) const;
+    bool equalsIgnoreCase(const String &s) const;
+    bool operator==(const String &rhs) const { return equals(rhs); }
+    bool operator==(const char *cstr) const { return equals(cstr); }
+    bool operator!=(const String &rhs) const { return !equals(rhs); }
+    bool operator!=(const char *cstr) const { return !equals(cstr); }
+    bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+    bool startsWith(const String &prefix) const;
+    bool startsWith(const String &prefix, unsigned int offset) const;
+    bool endsWith(const String &suffix) const;
+
+    // character access
+    char charAt(unsigned int index) const;
+    void setCharAt(unsigned int index, char c);
+    char operator[](unsigned int index) const;
+    char &operator[](unsigned int index);
+    void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const {
+        getBytes((unsigned char *)buf, bufsize, index);
+    }
+    const char *c_str() const { return _buf; }
+    char *begin() { return _buf; }
+    char *end() { return _buf + _len; }
+    const char *begin() const { return _buf; }
+    const char *end() const { return _buf + _len; }
+
+    // search
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String &str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    int lastIndexOf(const String &str) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, _len); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    // modification
+    void replace(const String &find, const String &replace);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    // parsing / conversion
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+protected:
+    static const unsigned int SSO_CAPACITY = 11; // same as the 32-bit ESP32 core
+
+    char *_buf;
+    unsigned int _cap;
+    unsigned int _len;
+    char _sso[SSO_CAPACITY + 1];
+
+    bool isSSO() const { return _buf == _sso; }
+    void initEmpty();
+    void setLen(unsigned int len);
+    String &copy(const char *cstr, unsigned int length);
+    void move(String &rhs);
+};
+
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String &s) : String(s) {}
+    StringSumHelper(const char *p) : String(p) {}
+    StringSumHelper(char c) : String(c) {}
+    StringSumHelper(unsigned char num) : String(num) {}
+    StringSumHelper(int num) : String(num) {}
+    StringSumHelper(unsigned int num) : String(num) {}
+    StringSumHelper(long num) : String(num) {}
+    StringSumHelper(unsigned long num) : String(num) {}
+    StringSumHelper(long long num) : String(num) {}
+    StringSumHelper(unsigned long long num) : String(num) {}
+    StringSumHelper(float num) : String(num) {}
+    StringSumHelper(double num) : String(num) {}
+};
+
+inline bool operator==(const char *lhs, const String &rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char *lhs, const String &rhs) { return !rhs.equals(lhs); }
+
+#endif // HOST_WSTRING_H
@@ -0,0 +1,22 @@
+#include "WiFi.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+
+WiFiClass WiFi;
+
+int WiFiClass::hostByName(const char *host, IPAddress &result) {
+    lookups++;
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    struct addrinfo *info = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &info) != 0 || !info) {
+        return 0;
+    }
+    uint32_t address = ((struct sockaddr_in *)info->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(info);
+    result = IPAddress(address);
+    return 1;
+}
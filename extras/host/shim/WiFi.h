@@ -0,0 +1,24 @@
+/*
+ * Host (Linux) stand-in for the ESP32 WiFi library: only name resolution,
+ * through getaddrinfo(). Connectivity on the host comes from an injected
+ * Client (see extras/host/support/LoopbackClient.h).
+ */
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+class WiFiClass {
+public:
+    WiFiClass() : lookups(0) {}
+
+    // IPv4 address of a host name or dotted quad; 1 on success, like the ESP32 core
+    int hostByName(const char *host, IPAddress &result);
+
+    // Lookups made so far, for tests
+    unsigned long lookups;
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,29 @@
+/*
+ * Host (Linux) placeholder for the ESP32 WiFiClientSecure. It never connects;
+ * host programs inject their own Client implementation instead.
+ */
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+#include "Arduino.h"
+
+class WiFiClientSecure : public Client {
+public:
+    void setInsecure() {}
+    void setCACert(const char *rootCA) { (void)rootCA; }
+
+    int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return 0; }
+    int connect(const char *host, uint16_t port) override { (void)host; (void)port; return 0; }
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t *buf, size_t size) override { (void)buf; (void)size; return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(uint8_t *buf, size_t size) override { (void)buf; (void)size; return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+    void stop() override {}
+    uint8_t connected() override { return 0; }
+    operator bool() override { return false; }
+};
+
+#endif // HOST_WIFICLIENTSECURE_H
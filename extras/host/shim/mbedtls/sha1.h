@@ -0,0 +1,20 @@
+/*
+ * Host (Linux) stand-in for the mbedTLS one-shot SHA-1 API used by the
+ * WebSocket handshake.
+ */
+#ifndef HOST_MBEDTLS_SHA1_H
+#define HOST_MBEDTLS_SHA1_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int mbedtls_sha1(const unsigned char *input, size_t ilen, unsigned char output[20]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_MBEDTLS_SHA1_H
@@ -0,0 +1,111 @@
+#include "mbedtls/base64.h"
+#include "mbedtls/sha1.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static inline uint32_t rol32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1Block(uint32_t h[5], const unsigned char block[64]) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+int mbedtls_sha1(const unsigned char *input, size_t ilen, unsigned char output[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t full = ilen / 64;
+    for (size_t i = 0; i < full; i++) {
+        sha1Block(h, input + i * 64);
+    }
+
+    unsigned char tail[128];
+    size_t rem = ilen - full * 64;
+    memcpy(tail, input + full * 64, rem);
+    tail[rem] = 0x80;
+    size_t tailLen = rem + 1 + 8 <= 64 ? 64 : 128;
+    memset(tail + rem + 1, 0, tailLen - rem - 1);
+    uint64_t bits = (uint64_t)ilen * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tailLen - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    for (size_t off = 0; off < tailLen; off += 64) {
+        sha1Block(h, tail + off);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        output[i * 4] = (unsigned char)(h[i] >> 24);
+        output[i * 4 + 1] = (unsigned char)(h[i] >> 16);
+        output[i * 4 + 2] = (unsigned char)(h[i] >> 8);
+        output[i * 4 + 3] = (unsigned char)h[i];
+    }
+    return 0;
+}
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen,
+                          const unsigned char *src, size_t slen) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t needed = ((slen + 2) / 3) * 4 + 1;
+    if (dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    size_t o = 0;
+    size_t i = 0;
+    for (; i + 2 < slen; i += 3) {
+        uint32_t v = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 | src[i + 2];
+        dst[o++] = alphabet[(v >> 18) & 0x3F];
+        dst[o++] = alphabet[(v >> 12) & 0x3F];
+        dst[o++] = alphabet[(v >> 6) & 0x3F];
+        dst[o++] = alphabet[v & 0x3F];
+    }
+    if (i < slen) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < slen) {
+            v |= (uint32_t)src[i + 1] << 8;
+        }
+        dst[o++] = alphabet[(v >> 18) & 0x3F];
+        dst[o++] = alphabet[(v >> 12) & 0x3F];
+        dst[o++] = i + 1 < slen ? alphabet[(v >> 6) & 0x3F] : '=';
+        dst[o++] = '=';
+    }
+    dst[o] = 0;
+    *olen = o;
+    return 0;
+}
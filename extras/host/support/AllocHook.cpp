@@ -0,0 +1,70 @@
+#include "AllocHook.h"
+
+#include <McpHeapTrace.h>
+
+#include <atomic>
+#include <malloc.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<uint64_t> allocCount(0);
+static std::atomic<uint64_t> allocBytes(0);
+static std::atomic<int64_t> bytesInUse(0); // usable sizes of the live blocks
+
+static inline void record(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static inline void *track(void *ptr) {
+    if (ptr) {
+        bytesInUse.fetch_add((int64_t)malloc_usable_size(ptr), std::memory_order_relaxed);
+    }
+    return ptr;
+}
+
+extern "C" void *malloc(size_t size) {
+    record(size);
+    return track(__libc_malloc(size));
+}
+
+extern "C" void *calloc(size_t nmemb, size_t size) {
+    record(nmemb * size);
+    return track(__libc_calloc(nmemb, size));
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    record(size);
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void *result = __libc_realloc(ptr, size);
+    if (result || size == 0) {
+        bytesInUse.fetch_sub((int64_t)old, std::memory_order_relaxed);
+    }
+    return track(result);
+}
+
+extern "C" void free(void *ptr) {
+    if (ptr) {
+        bytesInUse.fetch_sub((int64_t)malloc_usable_size(ptr), std::memory_order_relaxed);
+    }
+    __libc_free(ptr);
+}
+
+AllocStats allocSnapshot() {
+    AllocStats s;
+    s.count = allocCount.load(std::memory_order_relaxed);
+    s.bytes = allocBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+// Feeds McpHeapSnapshot (the library's heap instrumentation)
+void mcpHostHeapCounters(uint32_t &allocs, uint32_t &bytes, uint32_t &inUse) {
+    allocs = (uint32_t)allocCount.load(std::memory_order_relaxed);
+    bytes = (uint32_t)allocBytes.load(std::memory_order_relaxed);
+    inUse = (uint32_t)bytesInUse.load(std::memory_order_relaxed);
+}
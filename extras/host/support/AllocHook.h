@@ -0,0 +1,24 @@
+/*
+ * Process-wide heap allocation counters for host benchmarks.
+ *
+ * AllocHook.cpp interposes malloc/calloc/realloc (operator new ends up in
+ * malloc with glibc), so every heap allocation made by the library, the
+ * Arduino String shim and ArduinoJson is counted. It also tracks the bytes in
+ * use and reports all three to the library's heap instrumentation
+ * (mcpHostHeapCounters, see McpHeapTrace.h). Link it into executables only,
+ * never into a library.
+ */
+#ifndef ALLOC_HOOK_H
+#define ALLOC_HOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct AllocStats {
+    uint64_t count; // number of malloc/calloc/realloc calls
+    uint64_t bytes; // bytes requested by those calls
+};
+
+AllocStats allocSnapshot();
+
+#endif // ALLOC_HOOK_H
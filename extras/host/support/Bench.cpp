@@ -0,0 +1,136 @@
+#include "Bench.h"
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BenchState::BenchState(uint64_t iterations)
+    : _iterations(iterations), _done(0), _started(false), _startNs(0), _elapsedNs(0),
+      _bytesPerOp(0), _counterName(nullptr), _counterValue(0) {
+    _startAllocs.count = _startAllocs.bytes = 0;
+    _allocs = _startAllocs;
+}
+
+void BenchState::start() {
+    _started = true;
+    _startAllocs = allocSnapshot();
+    _startNs = nowNs();
+}
+
+void BenchState::stop() {
+    _elapsedNs = nowNs() - _startNs;
+    AllocStats end = allocSnapshot();
+    _allocs.count = end.count - _startAllocs.count;
+    _allocs.bytes = end.bytes - _startAllocs.bytes;
+}
+
+bool BenchState::keepRunning() {
+    if (!_started) {
+        start();
+    }
+    if (_done < _iterations) {
+        _done++;
+        return true;
+    }
+    stop();
+    return false;
+}
+
+struct BenchEntry {
+    const char *name;
+    BenchFunction fn;
+};
+
+static std::vector<BenchEntry> &registry() {
+    static std::vector<BenchEntry> entries;
+    return entries;
+}
+
+BenchRegistrar::BenchRegistrar(const char *name, BenchFunction fn) {
+    BenchEntry e = {name, fn};
+    registry().push_back(e);
+}
+
+static void usage(const char *argv0) {
+    printf("usage: %s [--filter=SUBSTRING] [--benchtime=MS] [--list] [--verbose]\n", argv0);
+}
+
+int runBenchmarks(int argc, char **argv) {
+    const char *filter = nullptr;
+    uint64_t benchTimeNs = 200ull * 1000 * 1000;
+    bool list = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--benchtime=", 12) == 0) {
+            benchTimeNs = strtoull(argv[i] + 12, nullptr, 10) * 1000 * 1000;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (benchTimeNs == 0) {
+        benchTimeNs = 1;
+    }
+
+    // Library logging goes to the "UART"; keep it out of the timings unless asked.
+    Serial.setOutput(verbose ? stderr : nullptr);
+
+    printf("%-44s %12s %14s %12s %12s\n", "benchmark", "iterations", "ns/op", "B/op", "allocs/op");
+    for (size_t i = 0; i < registry().size(); i++) {
+        const BenchEntry &e = registry()[i];
+        if (filter && !strstr(e.name, filter)) {
+            continue;
+        }
+        if (list) {
+            printf("%s\n", e.name);
+            continue;
+        }
+
+        uint64_t n = 1;
+        while (true) {
+            BenchState state(n);
+            e.fn(state);
+            if (state.elapsedNs() >= benchTimeNs || n >= 1000000000ull) {
+                double nsPerOp = (double)state.elapsedNs() / (double)n;
+                printf("%-44s %12llu %14.1f %12.1f %12.2f", e.name, (unsigned long long)n, nsPerOp,
+                       (double)state.allocs().bytes / (double)n, (double)state.allocs().count / (double)n);
+                if (state.bytesPerOp() && nsPerOp > 0) {
+                    printf(" %10.2f MB/s", (double)state.bytesPerOp() * 1000.0 / nsPerOp);
+                }
+                if (state.counterName()) {
+                    printf(" %10.2f %s/op", state.counterValue(), state.counterName());
+                }
+                printf("\n");
+                fflush(stdout);
+                break;
+            }
+            // Aim 20% past the target, growing at most 100x per round (as Go's testing package does).
+            uint64_t elapsed = state.elapsedNs() ? state.elapsedNs() : 1;
+            uint64_t next = (uint64_t)((double)benchTimeNs * 1.2 * (double)n / (double)elapsed);
+            if (next > n * 100) {
+                next = n * 100;
+            }
+            if (next <= n) {
+                next = n + 1;
+            }
+            n = next;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Tiny benchmark harness for the host build.
+ *
+ *   MCP_BENCHMARK(BM_Something) {
+ *       ...setup...
+ *       while (state.keepRunning()) {
+ *           ...measured code...
+ *       }
+ *   }
+ *
+ * The first keepRunning() call starts the clock and the allocation counters,
+ * the last one stops them, so setup and teardown are not measured. Each
+ * benchmark is re-run with a growing iteration count until it takes at least
+ * the configured bench time, then reported as ns/op, B/op and allocs/op
+ * (B/op being heap bytes requested per iteration).
+ */
+#ifndef MCP_BENCH_H
+#define MCP_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "AllocHook.h"
+
+class BenchState {
+public:
+    explicit BenchState(uint64_t iterations);
+
+    bool keepRunning();
+    uint64_t iterations() const { return _iterations; }
+
+    // Optional: payload bytes processed per iteration, reported as MB/s.
+    void setBytesPerOp(uint64_t bytes) { _bytesPerOp = bytes; }
+    // Optional: benchmark-specific metric per iteration (e.g. write() calls).
+    void setCounter(const char *name, double valuePerOp) {
+        _counterName = name;
+        _counterValue = valuePerOp;
+    }
+
+    uint64_t elapsedNs() const { return _elapsedNs; }
+    AllocStats allocs() const { return _allocs; }
+    uint64_t bytesPerOp() const { return _bytesPerOp; }
+    const char *counterName() const { return _counterName; }
+    double counterValue() const { return _counterValue; }
+
+private:
+    void start();
+    void stop();
+
+    uint64_t _iterations;
+    uint64_t _done;
+    bool _started;
+    uint64_t _startNs;
+    uint64_t _elapsedNs;
+    AllocStats _startAllocs;
+    AllocStats _allocs;
+    uint64_t _bytesPerOp;
+    const char *_counterName;
+    double _counterValue;
+};
+
+typedef void (*BenchFunction)(BenchState &);
+
+struct BenchRegistrar {
+    BenchRegistrar(const char *name, BenchFunction fn);
+};
+
+int runBenchmarks(int argc, char **argv);
+
+#define MCP_BENCHMARK(name)                                                    \
+    static void name(BenchState &state);                                       \
+    static BenchRegistrar name##_registrar(#name, name);                       \
+    static void name(BenchState &state)
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void benchDoNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif // MCP_BENCH_H
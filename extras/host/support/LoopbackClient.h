@@ -0,0 +1,186 @@
+/*
+ * In-memory Client for host builds.
+ *
+ * Bytes queued with pushRx()/pushServerFrame() are what the library reads
+ * from the "server"; everything the library writes is captured in tx() (or
+ * only counted, when capture is off). Buffers keep their capacity between
+ * rounds so a warmed-up benchmark loop does not allocate inside the client.
+ */
+#ifndef LOOPBACK_CLIENT_H
+#define LOOPBACK_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include <string>
+#include <vector>
+
+class LoopbackClient : public Client {
+public:
+    LoopbackClient() : _connected(false), _connectResult(true), _captureTx(true), _rxPos(0), _txBytes(0), _writeCalls(0),
+          _writeLimit(0) {}
+
+    // --- Test/benchmark controls ---
+
+    void setConnected(bool connected) { _connected = connected; }
+    void setConnectResult(bool result) { _connectResult = result; }
+    void setTxCapture(bool capture) { _captureTx = capture; }
+    // Accept at most this many bytes per write() call, like a full socket buffer (0 = unlimited)
+    void setWriteLimit(size_t limit) { _writeLimit = limit; }
+
+    void pushRx(const uint8_t *data, size_t len) {
+        compactRx();
+        _rx.insert(_rx.end(), data, data + len);
+    }
+    void pushRx(const char *data, size_t len) { pushRx((const uint8_t *)data, len); }
+    void pushRx(const String &data) { pushRx(data.c_str(), data.length()); }
+
+    // Queue an unmasked server->client frame (RFC 6455 section 5.2).
+    void pushServerFrame(uint8_t opcode, const char *payload, size_t len, bool fin = true) {
+        appendServerFrame(_rxScratch, opcode, payload, len, fin);
+        pushRx(_rxScratch.data(), _rxScratch.size());
+    }
+    void pushServerFrame(uint8_t opcode, const String &payload, bool fin = true) {
+        pushServerFrame(opcode, payload.c_str(), payload.length(), fin);
+    }
+
+    static void appendServerFrame(std::vector<uint8_t> &out, uint8_t opcode, const char *payload, size_t len,
+                                  bool fin = true) {
+        out.clear();
+        out.push_back((uint8_t)((fin ? 0x80 : 0x00) | (opcode & 0x0F)));
+        if (len <= 125) {
+            out.push_back((uint8_t)len);
+        } else if (len <= 0xFFFF) {
+            out.push_back(126);
+            out.push_back((uint8_t)(len >> 8));
+            out.push_back((uint8_t)len);
+        } else {
+            out.push_back(127);
+            for (int i = 7; i >= 0; i--) {
+                out.push_back((uint8_t)((uint64_t)len >> (8 * i)));
+            }
+        }
+        out.insert(out.end(), payload, payload + len);
+    }
+
+    const std::vector<uint8_t> &tx() const { return _tx; }
+    void clearTx() { _tx.clear(); }
+
+    // Unmasked payloads of the complete client->server frames captured so far, one per
+    // frame (control frames included); they are removed from tx().
+    std::vector<std::string> takeTxPayloads() {
+        std::vector<std::string> payloads;
+        size_t pos = 0;
+        while (_tx.size() - pos >= 2) {
+            size_t header = 2;
+            uint64_t len = _tx[pos + 1] & 0x7F;
+            if (len == 126 || len == 127) {
+                size_t extra = len == 126 ? 2 : 8;
+                if (_tx.size() - pos < header + extra) {
+                    break;
+                }
+                len = 0;
+                for (size_t i = 0; i < extra; i++) {
+                    len = (len << 8) | _tx[pos + header + i];
+                }
+                header += extra;
+            }
+            if (_tx.size() - pos < header + 4 + len) {
+                break;
+            }
+            const uint8_t *mask = &_tx[pos + header];
+            std::string payload((size_t)len, '\0');
+            for (size_t i = 0; i < len; i++) {
+                payload[i] = (char)(_tx[pos + header + 4 + i] ^ mask[i % 4]);
+            }
+            payloads.push_back(payload);
+            pos += header + 4 + (size_t)len;
+        }
+        _tx.erase(_tx.begin(), _tx.begin() + pos);
+        return payloads;
+    }
+    size_t rxPending() const { return _rx.size() - _rxPos; }
+    size_t txBytes() const { return _txBytes; }
+    size_t writeCalls() const { return _writeCalls; }
+    void resetCounters() {
+        _txBytes = 0;
+        _writeCalls = 0;
+    }
+
+    // --- Client interface ---
+
+    int connect(IPAddress ip, uint16_t port) override {
+        (void)ip;
+        (void)port;
+        _connected = _connectResult;
+        return _connected ? 1 : 0;
+    }
+    int connect(const char *host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        _connected = _connectResult;
+        return _connected ? 1 : 0;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override {
+        if (!_connected) {
+            return 0;
+        }
+        _writeCalls++;
+        if (_writeLimit && size > _writeLimit) {
+            size = _writeLimit;
+        }
+        _txBytes += size;
+        if (_captureTx) {
+            _tx.insert(_tx.end(), buf, buf + size);
+        }
+        return size;
+    }
+    int available() override { return (int)rxPending(); }
+    int read() override {
+        if (_rxPos >= _rx.size()) {
+            return -1;
+        }
+        return _rx[_rxPos++];
+    }
+    int read(uint8_t *buf, size_t size) override {
+        size_t n = rxPending();
+        if (n == 0) {
+            return -1;
+        }
+        if (n > size) {
+            n = size;
+        }
+        memcpy(buf, _rx.data() + _rxPos, n);
+        _rxPos += n;
+        return (int)n;
+    }
+    int peek() override { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+    void flush() override {}
+    void stop() override { _connected = false; }
+    uint8_t connected() override { return _connected ? 1 : 0; }
+    operator bool() override { return _connected; }
+
+    using Print::write;
+
+private:
+    void compactRx() {
+        if (_rxPos == _rx.size()) {
+            _rx.clear();
+            _rxPos = 0;
+        }
+    }
+
+    bool _connected;
+    bool _connectResult;
+    bool _captureTx;
+    std::vector<uint8_t> _rx;
+    std::vector<uint8_t> _rxScratch;
+    size_t _rxPos;
+    std::vector<uint8_t> _tx;
+    size_t _txBytes;
+    size_t _writeCalls;
+    size_t _writeLimit;
+};
+
+#endif // LOOPBACK_CLIENT_H
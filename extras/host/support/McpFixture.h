@@ -0,0 +1,60 @@
+/*
+ * Shared setup for host benchmarks: a WebSocketMCP wired to a LoopbackClient
+ * in the connected state, plus canned JSON-RPC requests and sample tools.
+ */
+#ifndef MCP_FIXTURE_H
+#define MCP_FIXTURE_H
+
+#include <WebSocketMCP.h>
+
+#include <stdio.h>
+
+#include "LoopbackClient.h"
+#include "WebSocketMCPHostAccess.h"
+
+static const char *const MCP_REQ_PING = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"ping\"}";
+static const char *const MCP_REQ_INITIALIZE =
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"initialize\",\"params\":{\"protocolVersion\":\"2024-11-05\","
+    "\"capabilities\":{},\"clientInfo\":{\"name\":\"xiaozhi-mcp-endpoint\",\"version\":\"1.0.0\"}}}";
+static const char *const MCP_REQ_TOOLS_LIST = "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"tools/list\"}";
+static const char *const MCP_REQ_TOOLS_INVOKE =
+    "{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"led_blink\","
+    "\"arguments\":{\"state\":\"on\"}}}";
+
+// The led_blink schema from examples/XiaozhiEsp32MCP.
+static const char *const MCP_LED_SCHEMA =
+    "{\"type\":\"object\",\"properties\":{\"state\":{\"type\":\"string\",\"enum\":[\"on\",\"off\",\"blink\"]}},"
+    "\"required\":[\"state\"]}";
+
+struct McpFixture {
+    LoopbackClient client;
+    WebSocketMCP mcp;
+
+    McpFixture() : mcp(client) {
+        client.setConnected(true);
+        client.setTxCapture(false);
+        WebSocketMCPHostAccess::markConnected(mcp);
+    }
+
+    // led_blink plus (count - 1) relay-style tools, like a gateway board.
+    void registerSampleTools(size_t count) {
+        mcp.registerTool("led_blink", "Control the onboard LED: \"on\", \"off\" or \"blink\"", MCP_LED_SCHEMA,
+                         [](const String &args) {
+                             (void)args;
+                             return ToolResponse("{\"success\":true,\"state\":\"on\"}");
+                         });
+        for (size_t i = 1; i < count; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "relay_%u", (unsigned)i);
+            mcp.registerTool(name, "Switch relay channel on/off.\nReturns the new state.",
+                             "{\"type\":\"object\",\"properties\":{\"state\":{\"type\":\"boolean\"}},"
+                             "\"required\":[\"state\"]}",
+                             [](const String &args) {
+                                 (void)args;
+                                 return ToolResponse("{\"success\":true}");
+                             });
+        }
+    }
+};
+
+#endif // MCP_FIXTURE_H
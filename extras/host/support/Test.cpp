@@ -0,0 +1,81 @@
+#include "Test.h"
+
+#include <Arduino.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct TestEntry {
+    const char *name;
+    TestFunction fn;
+};
+
+static std::vector<TestEntry> &registry() {
+    static std::vector<TestEntry> entries;
+    return entries;
+}
+
+static int failures = 0;
+
+TestRegistrar::TestRegistrar(const char *name, TestFunction fn) {
+    TestEntry e = {name, fn};
+    registry().push_back(e);
+}
+
+bool testFailed(const char *file, int line, const char *expr) {
+    printf("  %s:%d: check failed: %s\n", file, line, expr);
+    failures++;
+    return false;
+}
+
+static void usage(const char *argv0) {
+    printf("usage: %s [--filter=SUBSTRING] [--list] [--verbose]\n", argv0);
+}
+
+int runTests(int argc, char **argv) {
+    const char *filter = nullptr;
+    bool list = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Library logging goes to the "UART"; keep the report readable unless asked.
+    Serial.setOutput(verbose ? stderr : nullptr);
+
+    size_t run = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < registry().size(); i++) {
+        const TestEntry &e = registry()[i];
+        if (filter && !strstr(e.name, filter)) {
+            continue;
+        }
+        if (list) {
+            printf("%s\n", e.name);
+            continue;
+        }
+        int before = failures;
+        e.fn();
+        run++;
+        if (failures != before) {
+            failed++;
+        }
+        printf("%-52s %s\n", e.name, failures == before ? "ok" : "FAILED");
+        fflush(stdout);
+    }
+    if (!list) {
+        printf("%u tests, %u failed\n", (unsigned)run, (unsigned)failed);
+    }
+    return failed ? 1 : 0;
+}
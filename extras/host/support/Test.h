@@ -0,0 +1,38 @@
+/*
+ * Tiny test harness for the host build.
+ *
+ *   MCP_TEST(UpgradeResponse_Something) {
+ *       ...
+ *       MCP_CHECK(condition);
+ *       MCP_CHECK_EQ(expected, actual);
+ *   }
+ *
+ * A failed check prints its file, line and expression and the test goes on;
+ * mcp_tests exits non-zero if any check failed, so ctest reports it.
+ */
+#ifndef MCP_TEST_H
+#define MCP_TEST_H
+
+#include <stddef.h>
+
+typedef void (*TestFunction)();
+
+struct TestRegistrar {
+    TestRegistrar(const char *name, TestFunction fn);
+};
+
+int runTests(int argc, char **argv);
+
+// Records a failed check; returns false so checks can be used in conditions.
+bool testFailed(const char *file, int line, const char *expr);
+
+#define MCP_TEST(name)                                                         \
+    static void name();                                                        \
+    static TestRegistrar name##_registrar(#name, name);                        \
+    static void name()
+
+#define MCP_CHECK(expr) ((expr) ? true : testFailed(__FILE__, __LINE__, #expr))
+#define MCP_CHECK_EQ(expected, actual)                                         \
+    (((expected) == (actual)) ? true : testFailed(__FILE__, __LINE__, #expected " == " #actual))
+
+#endif // MCP_TEST_H
@@ -0,0 +1,79 @@
+/*
+ * Reaches into WebSocketMCP internals for host benchmarks (the class names
+ * this type as a friend). Never used by firmware.
+ */
+#ifndef WEBSOCKET_MCP_HOST_ACCESS_H
+#define WEBSOCKET_MCP_HOST_ACCESS_H
+
+#include <WebSocketMCP.h>
+
+class WebSocketMCPHostAccess {
+public:
+    // Mark the session as established without running the HTTP upgrade.
+    static void markConnected(WebSocketMCP &mcp) {
+        if (mcp._sendQueue.maxFrame() == 0) {
+            mcp._sendQueue.begin(); // what begin() would have allocated
+        }
+        mcp.connected = true;
+        mcp._currentState = WebSocketMCP::WS_CONNECTED;
+        mcp._keepalive.reset(millis());
+    }
+
+    // Act as if the handshake had negotiated permessage-deflate.
+    static bool enableCompression(WebSocketMCP &mcp, uint8_t windowBits = MCP_DEFLATE_WINDOW_BITS,
+                                  size_t threshold = MCP_DEFLATE_THRESHOLD) {
+        if (!mcp.setCompression(true, windowBits, threshold)) {
+            return false;
+        }
+        mcp._deflateSendBits = windowBits;
+        mcp._rxParser.setRsv1Allowed(true);
+        mcp._deflateActive = true;
+        return true;
+    }
+
+    static bool sendWebSocketFrame(WebSocketMCP &mcp, const String &data, uint8_t opcode = WS_OP_TEXT) {
+        return mcp.sendWebSocketFrame(data, opcode);
+    }
+
+    // Write what the send queue holds as far as the client takes it
+    static bool flushSendQueue(WebSocketMCP &mcp) {
+        mcp.flushSendQueue();
+        return mcp._sendQueue.idle();
+    }
+
+    // True when a complete TEXT message is ready in rxParser()
+    static bool receiveWebSocketFrame(WebSocketMCP &mcp) {
+        return mcp.receiveWebSocketFrame();
+    }
+
+    static const WsFrameParser &rxParser(WebSocketMCP &mcp) {
+        return mcp._rxParser;
+    }
+
+    static void processReceivedData(WebSocketMCP &mcp) {
+        mcp.processReceivedData();
+    }
+
+    static void handleJsonRpcMessage(WebSocketMCP &mcp, const String &message) {
+        mcp.handleJsonRpcMessage(message.c_str(), message.length());
+    }
+    static void handleJsonRpcMessage(WebSocketMCP &mcp, const char *message, size_t length) {
+        mcp.handleJsonRpcMessage(message, length);
+    }
+
+    // The tools array of the tools/list reply
+    static const String &toolsListJson(WebSocketMCP &mcp) {
+        return mcp._registry->listJson();
+    }
+
+    static int findTool(const WebSocketMCP &mcp, const char *name) {
+        return mcp._registry->find(name, strlen(name));
+    }
+
+    static String escapeJsonString(WebSocketMCP &mcp, const String &input) {
+        (void)mcp;
+        return McpToolRegistry::escapeJsonString(input);
+    }
+};
+
+#endif // WEBSOCKET_MCP_HOST_ACCESS_H
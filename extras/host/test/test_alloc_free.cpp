@@ -0,0 +1,123 @@
+// Steady-state messages cost no heap allocation: receive, dispatch, reply and
+// the ToolWriterCallback tool path all run on buffers preallocated by the first
+// messages. Any allocation sneaking back into that path fails here.
+
+#include "Test.h"
+#include "AllocHook.h"
+#include "McpFixture.h"
+
+static const char *const REQ_TOOLS_INVOKE_WRITER =
+    "{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"read_sensor\","
+    "\"arguments\":{\"channel\":2}}}";
+static const char *const REQ_BATCH =
+    "[{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"ping\"},{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"},"
+    "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"tools/list\"}]";
+static const char *const REQ_UNKNOWN = "{\"jsonrpc\":\"2.0\",\"id\":8,\"method\":\"resources/list\"}";
+
+static void registerSensorTool(WebSocketMCP &mcp) {
+    mcp.registerTool("read_sensor", "Read an analog channel", "{\"type\":\"object\"}",
+                     [](JsonObjectConst args, McpToolResult &result) {
+                         int channel = args["channel"] | -1;
+                         if (channel < 0) {
+                             result.setError();
+                             result.print("{\"error\":\"no channel\"}");
+                             return;
+                         }
+                         result.print("{\"channel\":");
+                         result.print(channel);
+                         result.print(",\"value\":512}");
+                     });
+}
+
+// Allocations made by loop() while it handles one message that is already waiting
+static uint64_t allocationsPerMessage(McpFixture &f, const char *request) {
+    // The first messages size the JSON document and the frame buffers
+    for (int i = 0; i < 3; i++) {
+        f.client.pushServerFrame(WS_OP_TEXT, request, strlen(request));
+        f.mcp.loop();
+    }
+    f.client.pushServerFrame(WS_OP_TEXT, request, strlen(request));
+    AllocStats before = allocSnapshot();
+    f.mcp.loop();
+    return allocSnapshot().count - before.count;
+}
+
+static void checkSteadyState(McpFixture &f) {
+    MCP_CHECK_EQ(0u, allocationsPerMessage(f, MCP_REQ_PING));
+    MCP_CHECK_EQ(0u, allocationsPerMessage(f, MCP_REQ_INITIALIZE));
+    MCP_CHECK_EQ(0u, allocationsPerMessage(f, MCP_REQ_TOOLS_LIST));
+    MCP_CHECK_EQ(0u, allocationsPerMessage(f, REQ_TOOLS_INVOKE_WRITER));
+    MCP_CHECK_EQ(0u, allocationsPerMessage(f, REQ_BATCH));
+    MCP_CHECK_EQ(0u, allocationsPerMessage(f, REQ_UNKNOWN));
+}
+
+MCP_TEST(AllocFree_SteadyStateMessages) {
+    McpFixture f;
+    f.registerSampleTools(8);
+    registerSensorTool(f.mcp);
+    checkSteadyState(f);
+
+    McpToolStats stats;
+    MCP_CHECK(f.mcp.getToolStats("read_sensor", stats));
+    MCP_CHECK_EQ(4u, stats.calls);
+}
+
+MCP_TEST(AllocFree_SteadyStateCompressedReplies) {
+    McpFixture f;
+    f.registerSampleTools(8);
+    registerSensorTool(f.mcp);
+    MCP_CHECK(WebSocketMCPHostAccess::enableCompression(f.mcp, MCP_DEFLATE_WINDOW_BITS, 64));
+    checkSteadyState(f);
+}
+
+MCP_TEST(ToolResult_TextEscapedIntoReply) {
+    McpFixture f;
+    registerSensorTool(f.mcp);
+    f.client.setTxCapture(true);
+
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, REQ_TOOLS_INVOKE_WRITER, strlen(REQ_TOOLS_INVOKE_WRITER));
+    const char *invalid = "{\"jsonrpc\":\"2.0\",\"id\":9,\"method\":\"tools/invoke\","
+                          "\"params\":{\"tool_name\":\"read_sensor\",\"arguments\":{}}}";
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, invalid, strlen(invalid));
+    WebSocketMCPHostAccess::flushSendQueue(f.mcp);
+
+    std::vector<std::string> replies = f.client.takeTxPayloads();
+    MCP_CHECK_EQ((size_t)2, replies.size());
+    if (replies.size() != 2) {
+        return;
+    }
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":5,\"result\":{\"content\":[{\"type\":\"text\","
+                             "\"text\":\"{\\\"channel\\\":2,\\\"value\\\":512}\"}],\"isError\":false}}"),
+                 replies[0]);
+    MCP_CHECK(replies[1].find("\"text\":\"{\\\"error\\\":\\\"no channel\\\"}\"}],\"isError\":true}") !=
+              std::string::npos);
+}
+
+MCP_TEST(ToolResult_WriterToolsStayInline) {
+    McpFixture f;
+    registerSensorTool(f.mcp);
+    MCP_CHECK(!f.mcp.setToolAsync("read_sensor"));
+    MCP_CHECK(f.mcp.setToolAsync("read_sensor", 0));
+}
+
+// tools/list, escapeJsonString and the reply writer share one escaper
+MCP_TEST(ToolResult_ControlCharactersEscapedAlike) {
+    McpFixture f;
+    f.mcp.registerTool("bell", "Ring\x01 \"the\"\tbell\x1f", "{\"type\":\"object\"}",
+                       [](JsonObjectConst, McpToolResult &result) { result.print("Ring\x01 \"the\"\tbell\x1f"); });
+    const std::string escaped = "Ring\\u0001 \\\"the\\\"\\tbell\\u001f";
+
+    std::string list = WebSocketMCPHostAccess::toolsListJson(f.mcp).c_str();
+    MCP_CHECK(list.find("\"description\":\"" + escaped + "\"") != std::string::npos);
+    String direct = WebSocketMCPHostAccess::escapeJsonString(f.mcp, "Ring\x01 \"the\"\tbell\x1f");
+    MCP_CHECK_EQ(escaped, std::string(direct.c_str()));
+
+    f.client.setTxCapture(true);
+    const char *invoke = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/invoke\","
+                         "\"params\":{\"tool_name\":\"bell\",\"arguments\":{}}}";
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, invoke, strlen(invoke));
+    WebSocketMCPHostAccess::flushSendQueue(f.mcp);
+    std::vector<std::string> replies = f.client.takeTxPayloads();
+    MCP_CHECK_EQ((size_t)1, replies.size());
+    MCP_CHECK(!replies.empty() && replies[0].find("\"text\":\"" + escaped + "\"") != std::string::npos);
+}
@@ -0,0 +1,78 @@
+// JSON-RPC batches: every element answered inside the one batch reply, async
+// tools included.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <string>
+#include <thread>
+
+static const char *const REQ_BATCH_FAST_SLOW =
+    "[{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"fast\",\"arguments\":{}}},"
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"slow\",\"arguments\":{}}}]";
+static const char *const REQ_INVOKE_SLOW =
+    "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"slow\",\"arguments\":{}}}";
+
+struct AsyncFixture : McpFixture {
+    std::thread::id slowThread;
+
+    AsyncFixture() {
+        client.setTxCapture(true);
+        mcp.registerTool("fast", "Sync", "{\"type\":\"object\"}",
+                         [](JsonObjectConst) { return ToolResponse("{\"fast\":true}"); });
+        mcp.registerTool("slow", "Async", "{\"type\":\"object\"}", [this](JsonObjectConst) {
+            slowThread = std::this_thread::get_id();
+            return ToolResponse("{\"slow\":true}");
+        });
+        MCP_CHECK(mcp.beginToolWorkers(1));
+        MCP_CHECK(mcp.setToolAsync("slow", 1));
+    }
+
+    // Replies sent while handling message and from loop() until one arrives (or none, after a while)
+    std::vector<std::string> exchange(const char *message) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(mcp, message, strlen(message));
+        WebSocketMCPHostAccess::flushSendQueue(mcp);
+        std::vector<std::string> replies = client.takeTxPayloads();
+        for (int i = 0; i < 200 && replies.empty(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            mcp.loop();
+            WebSocketMCPHostAccess::flushSendQueue(mcp);
+            replies = client.takeTxPayloads();
+        }
+        return replies;
+    }
+};
+
+MCP_TEST(Batch_AsyncToolAnsweredInsideBatch) {
+    AsyncFixture f;
+    std::vector<std::string> replies = f.exchange(REQ_BATCH_FAST_SLOW);
+    MCP_CHECK_EQ(1u, replies.size());
+    if (replies.size() == 1) {
+        const std::string &batch = replies[0];
+        MCP_CHECK_EQ('[', batch.front());
+        MCP_CHECK_EQ(']', batch.back());
+        MCP_CHECK(batch.find("\"id\":1,\"result\"") != std::string::npos);
+        MCP_CHECK(batch.find("\"id\":2,\"result\"") != std::string::npos);
+        MCP_CHECK(batch.find("\\\"slow\\\":true") != std::string::npos);
+    }
+    MCP_CHECK(f.slowThread == std::this_thread::get_id());
+
+    // Nothing follows the batch reply
+    for (int i = 0; i < 5; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        f.mcp.loop();
+    }
+    WebSocketMCPHostAccess::flushSendQueue(f.mcp);
+    MCP_CHECK(f.client.takeTxPayloads().empty());
+}
+
+MCP_TEST(Batch_AsyncToolOnWorkerOutsideBatch) {
+    AsyncFixture f;
+    std::vector<std::string> replies = f.exchange(REQ_INVOKE_SLOW);
+    MCP_CHECK_EQ(1u, replies.size());
+    if (replies.size() == 1) {
+        MCP_CHECK(replies[0].find("\"id\":3,\"result\"") != std::string::npos);
+    }
+    MCP_CHECK(f.slowThread != std::thread::id());
+    MCP_CHECK(f.slowThread != std::this_thread::get_id());
+}
@@ -0,0 +1,140 @@
+// Traffic capture (McpCapture): the ring, the log format, and the frames
+// WebSocketMCP records.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <McpCapture.h>
+
+#include <string>
+#include <vector>
+
+class BufferPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        data.push_back(c);
+        return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        data.insert(data.end(), buffer, buffer + size);
+        return size;
+    }
+    std::vector<uint8_t> data;
+};
+
+static std::vector<McpCapture::Record> decode(const std::vector<uint8_t> &log) {
+    std::vector<McpCapture::Record> records;
+    if (!McpCapture::validHeader(log.data(), log.size())) {
+        return records;
+    }
+    size_t pos = McpCapture::FILE_HEADER_LEN;
+    McpCapture::Record record;
+    while (McpCapture::next(log.data(), log.size(), pos, record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+static std::string text(const McpCapture::Record &record) {
+    return std::string((const char *)record.payload, record.storedLength);
+}
+
+MCP_TEST(Capture_RecordsRoundTrip) {
+    McpCapture capture;
+    MCP_CHECK(capture.begin(1024, 64));
+    capture.record(false, WS_OP_TEXT, (const uint8_t *)"request", 7);
+    capture.record(true, WS_OP_PONG, nullptr, 0);
+
+    BufferPrint out;
+    size_t written = capture.writeTo(out);
+    MCP_CHECK_EQ(out.data.size(), written);
+    std::vector<McpCapture::Record> records = decode(out.data);
+    MCP_CHECK_EQ((size_t)2, records.size());
+    if (records.size() != 2) {
+        return;
+    }
+    MCP_CHECK(!records[0].outgoing());
+    MCP_CHECK_EQ((int)WS_OP_TEXT, (int)records[0].opcode());
+    MCP_CHECK(text(records[0]) == "request");
+    MCP_CHECK(records[1].outgoing());
+    MCP_CHECK_EQ((int)WS_OP_PONG, (int)records[1].opcode());
+    MCP_CHECK_EQ(0u, records[1].length);
+}
+
+MCP_TEST(Capture_LongPayloadTruncated) {
+    McpCapture capture;
+    MCP_CHECK(capture.begin(1024, 16));
+    std::string payload(100, 'x');
+    capture.record(true, WS_OP_TEXT, (const uint8_t *)payload.data(), payload.size());
+
+    BufferPrint out;
+    capture.writeTo(out);
+    std::vector<McpCapture::Record> records = decode(out.data);
+    MCP_CHECK_EQ((size_t)1, records.size());
+    if (records.size() == 1) {
+        MCP_CHECK(records[0].flags & McpCapture::FLAG_TRUNCATED);
+        MCP_CHECK_EQ(100u, records[0].length);
+        MCP_CHECK_EQ((size_t)16, records[0].storedLength);
+    }
+}
+
+MCP_TEST(Capture_FullRingKeepsLatest) {
+    McpCapture capture;
+    MCP_CHECK(capture.begin(100, 16));
+    char payload[16];
+    for (int i = 0; i < 50; i++) {
+        int n = snprintf(payload, sizeof(payload), "message %d", i);
+        capture.record(false, WS_OP_TEXT, (const uint8_t *)payload, (size_t)n);
+    }
+    MCP_CHECK(capture.dropped() > 0);
+    MCP_CHECK_EQ((size_t)50, capture.records() + capture.dropped());
+
+    BufferPrint out;
+    capture.writeTo(out);
+    std::vector<McpCapture::Record> records = decode(out.data);
+    MCP_CHECK_EQ(capture.records(), records.size());
+    if (!records.empty()) {
+        MCP_CHECK(text(records.back()) == "message 49");
+        MCP_CHECK(text(records.front()) == "message " + std::to_string(50 - records.size()));
+    }
+}
+
+MCP_TEST(Capture_IncompleteRecordRejected) {
+    McpCapture capture;
+    MCP_CHECK(capture.begin(1024, 64));
+    capture.record(false, WS_OP_TEXT, (const uint8_t *)"request", 7);
+    BufferPrint out;
+    capture.writeTo(out);
+
+    size_t pos = McpCapture::FILE_HEADER_LEN;
+    McpCapture::Record record;
+    MCP_CHECK(!McpCapture::next(out.data.data(), out.data.size() - 1, pos, record));
+    MCP_CHECK(!McpCapture::validHeader((const uint8_t *)"MCPX\1\0\0\0", 8));
+}
+
+MCP_TEST(Capture_WebSocketMCPRecordsBothDirections) {
+    McpFixture f;
+    MCP_CHECK(f.mcp.beginCapture(4096, 256));
+    f.client.pushServerFrame(WS_OP_TEXT, MCP_REQ_PING, strlen(MCP_REQ_PING));
+    f.client.pushServerFrame(WS_OP_PING, "hi", 2);
+    f.mcp.loop();
+
+    BufferPrint out;
+    f.mcp.writeCapture(out);
+    std::vector<McpCapture::Record> records = decode(out.data);
+    // The request, its reply, the PING and the PONG answering it
+    MCP_CHECK_EQ((size_t)4, records.size());
+    if (records.size() != 4) {
+        return;
+    }
+    MCP_CHECK(!records[0].outgoing() && text(records[0]) == MCP_REQ_PING);
+    MCP_CHECK(records[1].outgoing() && records[1].opcode() == WS_OP_TEXT);
+    MCP_CHECK(text(records[1]).find("\"id\":1") != std::string::npos);
+    MCP_CHECK(!records[2].outgoing() && records[2].opcode() == WS_OP_PING);
+    MCP_CHECK(records[3].outgoing() && records[3].opcode() == WS_OP_PONG && text(records[3]) == "hi");
+
+    f.mcp.endCapture();
+    f.client.pushServerFrame(WS_OP_TEXT, MCP_REQ_PING, strlen(MCP_REQ_PING));
+    f.mcp.loop();
+    MCP_CHECK(!f.mcp.capture().active());
+}
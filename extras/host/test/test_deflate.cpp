@@ -0,0 +1,190 @@
+// McpDeflater / McpInflater: round trips for every window size, streams
+// produced by zlib, and the malformed streams the inflater has to reject.
+
+#include "Test.h"
+#include "McpDeflate.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Raw deflate from zlib 1.2.13 (windowBits -15), each ended with Z_SYNC_FLUSH
+// so the last four bytes are the 00 00 FF FF tail permessage-deflate strips.
+
+static const char *const STORED_TEXT = "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":{}}";
+// level 0: a stored block
+static const uint8_t STORED_STREAM[] = {
+    0x00, 0x24, 0x00, 0xdb, 0xff, 0x7b, 0x22, 0x6a, 0x73, 0x6f, 0x6e, 0x72, 0x70, 0x63, 0x22, 0x3a,
+    0x22, 0x32, 0x2e, 0x30, 0x22, 0x2c, 0x22, 0x69, 0x64, 0x22, 0x3a, 0x31, 0x2c, 0x22, 0x72, 0x65,
+    0x73, 0x75, 0x6c, 0x74, 0x22, 0x3a, 0x7b, 0x7d, 0x7d, 0x00, 0x00, 0x00, 0xff, 0xff,
+};
+
+static const char *const FIXED_TEXT =
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"result\":{\"tools\":[{\"name\":\"led\"},{\"name\":\"led2\"}]}}";
+// level 9, Z_FIXED: a fixed Huffman block
+static const uint8_t FIXED_STREAM[] = {
+    0xaa, 0x56, 0xca, 0x2a, 0xce, 0xcf, 0x2b, 0x2a, 0x48, 0x56, 0xb2, 0x52, 0x32, 0xd2, 0x33, 0x50,
+    0xd2, 0x51, 0xca, 0x4c, 0x51, 0xb2, 0x32, 0xd2, 0x51, 0x2a, 0x4a, 0x2d, 0x2e, 0xcd, 0x29, 0x51,
+    0xb2, 0xaa, 0x56, 0x2a, 0xc9, 0xcf, 0xcf, 0x29, 0x56, 0xb2, 0x8a, 0xae, 0x56, 0xca, 0x4b, 0xcc,
+    0x4d, 0x05, 0xaa, 0xcb, 0x49, 0x4d, 0x51, 0xaa, 0xd5, 0x41, 0xe6, 0x1a, 0x29, 0xd5, 0xc6, 0xd6,
+    0xd6, 0x02, 0x00, 0x00, 0x00, 0xff, 0xff,
+};
+
+static const char *const DYNAMIC_TEXT =
+    "{\"values\":[0,1,4,9,16,25,36,49,64,81,3,24,47,72,2,31,62,95,33,70,12,53,96,44,91,43,94,50,8,65,27,"
+    "88,54,22,89,61,35,11,86,66,48,32,18,6,93,85,79,75,73,73,75,79,85,93,6,18,32,48,66,86]}";
+// level 9: a dynamic Huffman block
+static const uint8_t DYNAMIC_STREAM[] = {
+    0x1c, 0x8c, 0x3b, 0x0e, 0xc2, 0x40, 0x0c, 0x05, 0xef, 0x92, 0x7a, 0x8a, 0xd8, 0x5e, 0x7b, 0xbd,
+    0x5c, 0x05, 0x51, 0xa4, 0xa0, 0xa3, 0x43, 0xd0, 0x20, 0xee, 0xce, 0x23, 0x92, 0x65, 0xf9, 0x33,
+    0xf3, 0x3e, 0xdb, 0xfb, 0x78, 0xbc, 0xee, 0xcf, 0xed, 0x72, 0xdd, 0x31, 0x06, 0x0b, 0x2b, 0x3c,
+    0x89, 0x62, 0x2c, 0x6a, 0xd0, 0x46, 0xe0, 0x83, 0x31, 0x99, 0x8e, 0x13, 0x46, 0x39, 0x4b, 0x44,
+    0x30, 0xe5, 0x38, 0x19, 0x2c, 0xd1, 0x72, 0x15, 0xa0, 0x79, 0x90, 0x3b, 0x4d, 0x25, 0x3e, 0xe9,
+    0x26, 0x07, 0xee, 0xb4, 0xd2, 0x14, 0x95, 0x98, 0xd1, 0x45, 0xc9, 0x68, 0xc2, 0x31, 0x91, 0xac,
+    0xa0, 0x93, 0xb9, 0x98, 0xea, 0x71, 0xd6, 0xb9, 0xea, 0xa8, 0x57, 0xfd, 0x21, 0xa1, 0x12, 0xa4,
+    0x75, 0xdd, 0xbe, 0x3f, 0x00, 0x00, 0x00, 0xff, 0xff,
+};
+
+// Final fixed Huffman blocks: 'a' then a length 3 match at distance 1 ("aaaa"), or at distance 2
+static const uint8_t MATCH_DISTANCE_1[] = {0x4b, 0x04, 0x02, 0x00};
+static const uint8_t MATCH_DISTANCE_2[] = {0x4b, 0x04, 0x42, 0x00};
+
+// Final dynamic blocks whose code tables zlib rejects
+static const uint8_t LITLEN_OVERSUBSCRIBED[] = {
+    0x05, 0xc0, 0x01, 0x09, 0x00, 0x00, 0x00, 0x80, 0x20, 0xf5, 0xff, 0x68, 0x05, 0x00, 0x00,
+};
+static const uint8_t LITLEN_INCOMPLETE[] = {
+    0x05, 0xc0, 0x01, 0x09, 0x00, 0x00, 0x00, 0x80, 0xa0, 0xfe, 0xaf, 0x4e, 0x00, 0x00,
+};
+static const uint8_t CODE_LENGTHS_INCOMPLETE[] = {0x05, 0x00, 0x00, 0x04, 0x00, 0x00};
+static const uint8_t CODE_LENGTHS_OVERSUBSCRIBED[] = {0x05, 0x00, 0x92, 0x00, 0x00, 0x00};
+
+static McpInflater::Result inflate(const uint8_t *in, size_t len, std::string &text, size_t outCap = 4096) {
+    std::vector<uint8_t> out(outCap + 1);
+    size_t outLen = 0;
+    McpInflater::Result result = McpInflater::inflate(in, len, out.data(), outCap, outLen);
+    text.assign((const char *)out.data(), result == McpInflater::OK ? outLen : 0);
+    return result;
+}
+
+// Bytes from a fixed LCG: no repeats for the compressor to find by chance
+static void appendNoise(std::vector<uint8_t> &out, size_t len, uint32_t &seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        out.push_back((uint8_t)(seed >> 23));
+    }
+}
+
+static size_t compress(McpDeflater &deflater, const std::vector<uint8_t> &in, std::vector<uint8_t> &out,
+                       uint8_t windowBits) {
+    out.resize(in.size() + in.size() / 4 + 64);
+    size_t len = deflater.compress(in.data(), in.size(), out.data(), out.size(), windowBits);
+    out.resize(len);
+    return len;
+}
+
+static bool roundTrips(const std::vector<uint8_t> &in, const std::vector<uint8_t> &compressed) {
+    std::vector<uint8_t> out(in.size() + 1);
+    size_t outLen = 0;
+    return McpInflater::inflate(compressed.data(), compressed.size(), out.data(), in.size(), outLen) ==
+               McpInflater::OK &&
+           outLen == in.size() && memcmp(out.data(), in.data(), in.size()) == 0;
+}
+
+MCP_TEST(Deflate_RoundTripEveryWindow) {
+    std::string json;
+    for (int i = 0; i < 200; i++) {
+        json += "{\"type\":\"text\",\"text\":\"reading " + std::to_string(i * 37 % 101) + "\"},";
+    }
+    std::vector<uint8_t> text(json.begin(), json.end());
+
+    McpDeflater deflater;
+    MCP_CHECK(deflater.begin(15));
+    for (uint8_t windowBits = 9; windowBits <= 15; windowBits++) {
+        std::vector<uint8_t> compressed;
+        MCP_CHECK(compress(deflater, text, compressed, windowBits) > 0);
+        MCP_CHECK(compressed.size() < text.size() / 2);
+        MCP_CHECK(roundTrips(text, compressed));
+    }
+
+    // Too small an output: 0, not a truncated stream
+    uint8_t small[16];
+    MCP_CHECK_EQ(0u, deflater.compress(text.data(), text.size(), small, sizeof(small), 11));
+}
+
+MCP_TEST(Deflate_MatchesAtTheWindowLimit) {
+    McpDeflater deflater;
+    MCP_CHECK(deflater.begin(15));
+    for (uint8_t windowBits = 9; windowBits <= 15; windowBits++) {
+        const size_t window = (size_t)1 << windowBits;
+        const size_t repeat = 200;
+        uint32_t seed = windowBits;
+
+        // The block comes back at exactly the window size, then one byte further
+        std::vector<uint8_t> block;
+        appendNoise(block, repeat, seed);
+        std::vector<uint8_t> within(block);
+        appendNoise(within, window - repeat, seed);
+        within.insert(within.end(), block.begin(), block.end());
+
+        std::vector<uint8_t> beyond(block);
+        appendNoise(beyond, window - repeat + 1, seed);
+        beyond.insert(beyond.end(), block.begin(), block.end());
+
+        std::vector<uint8_t> compressedWithin, compressedBeyond;
+        MCP_CHECK(compress(deflater, within, compressedWithin, windowBits) > 0);
+        MCP_CHECK(compress(deflater, beyond, compressedBeyond, windowBits) > 0);
+        MCP_CHECK(roundTrips(within, compressedWithin));
+        MCP_CHECK(roundTrips(beyond, compressedBeyond));
+        // Found within the window; out of reach one byte later, so sent as literals
+        MCP_CHECK(compressedWithin.size() + repeat / 2 < compressedBeyond.size());
+    }
+}
+
+MCP_TEST(Deflate_InflatesZlibStreams) {
+    struct Case {
+        const char *text;
+        const uint8_t *stream;
+        size_t len;
+    };
+    const Case cases[] = {
+        {STORED_TEXT, STORED_STREAM, sizeof(STORED_STREAM)},
+        {FIXED_TEXT, FIXED_STREAM, sizeof(FIXED_STREAM)},
+        {DYNAMIC_TEXT, DYNAMIC_STREAM, sizeof(DYNAMIC_STREAM)},
+    };
+    for (const Case &c : cases) {
+        std::string text;
+        // As sent over permessage-deflate, and with the tail left on
+        MCP_CHECK_EQ(McpInflater::OK, inflate(c.stream, c.len - 4, text));
+        MCP_CHECK_EQ(std::string(c.text), text);
+        MCP_CHECK_EQ(McpInflater::OK, inflate(c.stream, c.len, text));
+        MCP_CHECK_EQ(std::string(c.text), text);
+
+        // Exactly the output size is enough, one byte less is not
+        size_t size = strlen(c.text);
+        MCP_CHECK_EQ(McpInflater::OK, inflate(c.stream, c.len - 4, text, size));
+        MCP_CHECK_EQ(McpInflater::ERR_TOO_LARGE, inflate(c.stream, c.len - 4, text, size - 1));
+    }
+}
+
+MCP_TEST(Deflate_RejectsMalformedStreams) {
+    std::string text;
+    MCP_CHECK_EQ(McpInflater::OK, inflate(MATCH_DISTANCE_1, sizeof(MATCH_DISTANCE_1), text));
+    MCP_CHECK_EQ(std::string("aaaa"), text);
+    // No history before the message: the distance reaches past the output
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(MATCH_DISTANCE_2, sizeof(MATCH_DISTANCE_2), text));
+    // The match itself does not fit
+    MCP_CHECK_EQ(McpInflater::ERR_TOO_LARGE, inflate(MATCH_DISTANCE_1, sizeof(MATCH_DISTANCE_1), text, 2));
+
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(LITLEN_OVERSUBSCRIBED, sizeof(LITLEN_OVERSUBSCRIBED), text));
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(LITLEN_INCOMPLETE, sizeof(LITLEN_INCOMPLETE), text));
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(CODE_LENGTHS_INCOMPLETE, sizeof(CODE_LENGTHS_INCOMPLETE), text));
+    MCP_CHECK_EQ(McpInflater::ERR_DATA,
+                 inflate(CODE_LENGTHS_OVERSUBSCRIBED, sizeof(CODE_LENGTHS_OVERSUBSCRIBED), text));
+
+    // Reserved block type, and a stream cut off in the middle of a block
+    const uint8_t reserved[] = {0x07, 0x00};
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(reserved, sizeof(reserved), text));
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(DYNAMIC_STREAM, 40, text));
+    MCP_CHECK_EQ(McpInflater::ERR_DATA, inflate(STORED_STREAM, 20, text));
+}
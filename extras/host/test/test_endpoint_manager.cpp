@@ -0,0 +1,89 @@
+// Several connections serving one shared tool registry (McpEndpointManager).
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <McpEndpointManager.h>
+
+#include <string>
+
+struct ManagerFixture {
+    LoopbackClient clients[2];
+    McpEndpointManager manager;
+    WebSocketMCP *endpoints[2];
+
+    ManagerFixture() {
+        for (size_t i = 0; i < 2; i++) {
+            endpoints[i] = manager.addEndpoint(clients[i], i == 0 ? "ws://prod.example/mcp" : "ws://staging.example/mcp");
+            clients[i].setConnected(true);
+            WebSocketMCPHostAccess::markConnected(*endpoints[i]);
+        }
+    }
+
+    void request(size_t index, const char *json) {
+        clients[index].pushServerFrame(WS_OP_TEXT, json, strlen(json));
+    }
+
+    // The one text reply endpoint index sent since the last call, or "" if none
+    std::string reply(size_t index) {
+        std::vector<std::string> payloads = clients[index].takeTxPayloads();
+        return payloads.size() == 1 ? payloads[0] : std::string();
+    }
+};
+
+static ToolResponse echoTool(JsonObjectConst args) {
+    return ToolResponse(args["text"] | "");
+}
+
+MCP_TEST(EndpointManager_ToolsRegisteredOnceServedEverywhere) {
+    ManagerFixture f;
+    f.manager.registerTool("echo", "Echo the text", "{\"type\":\"object\"}", echoTool);
+    MCP_CHECK_EQ((size_t)1, f.endpoints[0]->getToolCount());
+    MCP_CHECK_EQ((size_t)1, f.endpoints[1]->getToolCount());
+
+    // Registering through one connection registers for all
+    f.endpoints[1]->registerTool("other", "Other", "{}", echoTool);
+    MCP_CHECK_EQ((size_t)2, f.manager.tools().size());
+
+    f.request(0, MCP_REQ_TOOLS_LIST);
+    f.request(1, MCP_REQ_TOOLS_LIST);
+    f.manager.loop();
+    std::string list0 = f.reply(0);
+    MCP_CHECK(list0.find("\"echo\"") != std::string::npos && list0.find("\"other\"") != std::string::npos);
+    MCP_CHECK(list0 == f.reply(1));
+}
+
+MCP_TEST(EndpointManager_RepliesGoToTheAskingConnection) {
+    ManagerFixture f;
+    f.manager.registerTool("echo", "Echo the text", "{\"type\":\"object\"}", echoTool);
+
+    f.request(1, "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"echo\","
+                 "\"arguments\":{\"text\":\"staging\"}}}");
+    f.manager.loop();
+    MCP_CHECK(f.reply(0).empty());
+    std::string reply = f.reply(1);
+    MCP_CHECK(reply.find("\"id\":7") != std::string::npos);
+    MCP_CHECK(reply.find("staging") != std::string::npos);
+
+    McpToolStats stats;
+    MCP_CHECK(f.endpoints[0]->getToolStats("echo", stats));
+    MCP_CHECK_EQ(1u, stats.calls);
+}
+
+MCP_TEST(EndpointManager_ConnectionsKeepTheirOwnState) {
+    ManagerFixture f;
+    f.request(0, MCP_REQ_PING);
+    f.request(0, MCP_REQ_PING);
+    f.manager.loop();
+    MCP_CHECK_EQ(2u, f.endpoints[0]->getMetrics().messagesIn);
+    MCP_CHECK_EQ(0u, f.endpoints[1]->getMetrics().messagesIn);
+    MCP_CHECK_EQ((size_t)2, f.manager.connectedCount());
+
+    // A server going away leaves the other connection up
+    f.clients[0].setConnected(false);
+    f.clients[0].setConnectResult(false);
+    f.manager.loop();
+    MCP_CHECK(!f.endpoints[0]->isConnected());
+    MCP_CHECK(f.endpoints[1]->isConnected());
+    MCP_CHECK(f.manager.endpointUrl(1) == "ws://staging.example/mcp");
+}
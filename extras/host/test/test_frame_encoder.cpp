@@ -0,0 +1,118 @@
+// WsFrameEncoder: header encoding for each length form, word-at-a-time masking
+// against a byte-wise reference, and whole frames built in the reusable buffer.
+
+#include "Test.h"
+#include "WsFrameEncoder.h"
+#include "WsFrameParser.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const uint32_t MASK_KEY = 0x37FA213D;
+
+// RFC 6455 5.3: octet i of the payload is XORed with octet i % 4 of the key
+static void referenceMask(uint8_t *data, size_t len, uint32_t maskKey, size_t offset) {
+    for (size_t i = 0; i < len; i++) {
+        data[i] ^= (uint8_t)(maskKey >> (8 * (3 - (offset + i) % 4)));
+    }
+}
+
+MCP_TEST(FrameEncoder_HeaderLengthForms) {
+    uint8_t header[WsFrameEncoder::MAX_HEADER_LEN];
+
+    MCP_CHECK_EQ(6u, WsFrameEncoder::encodeHeader(header, WS_OP_TEXT, 125, MASK_KEY));
+    MCP_CHECK_EQ(0x81, header[0]);
+    MCP_CHECK_EQ(0x80 | 125, header[1]);
+    MCP_CHECK_EQ(0x37, header[2]);
+    MCP_CHECK_EQ(0x3D, header[5]);
+
+    MCP_CHECK_EQ(8u, WsFrameEncoder::encodeHeader(header, WS_OP_BINARY, 126, MASK_KEY));
+    MCP_CHECK_EQ(0x80 | 126, header[1]);
+    MCP_CHECK_EQ(0x00, header[2]);
+    MCP_CHECK_EQ(126, header[3]);
+
+    MCP_CHECK_EQ(8u, WsFrameEncoder::encodeHeader(header, WS_OP_TEXT, 0xFFFF, MASK_KEY));
+    MCP_CHECK_EQ(0xFF, header[2]);
+    MCP_CHECK_EQ(0xFF, header[3]);
+
+    MCP_CHECK_EQ(14u, WsFrameEncoder::encodeHeader(header, WS_OP_TEXT, 0x10000, MASK_KEY));
+    MCP_CHECK_EQ(0x80 | 127, header[1]);
+    const uint8_t length64[8] = {0, 0, 0, 0, 0, 1, 0, 0};
+    MCP_CHECK(memcmp(header + 2, length64, 8) == 0);
+
+    // Not final, and RSV1 for a compressed first fragment
+    WsFrameEncoder::encodeHeader(header, WS_OP_TEXT | WS_FLAG_RSV1, 0, MASK_KEY, false);
+    MCP_CHECK_EQ(0x41, header[0]);
+    WsFrameEncoder::encodeHeader(header, WS_OP_PONG, 0, MASK_KEY);
+    MCP_CHECK_EQ(0x8A, header[0]);
+}
+
+MCP_TEST(FrameEncoder_MaskMatchesReferenceAtAnyAlignment) {
+    uint8_t source[64];
+    for (size_t i = 0; i < sizeof(source); i++) {
+        source[i] = (uint8_t)(i * 7 + 1);
+    }
+    // Every start alignment, key offset and length, including the byte-wise head and tail
+    for (size_t align = 0; align < 4; align++) {
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t len = 0; len <= 40; len++) {
+                uint32_t words[12];
+                uint8_t *data = (uint8_t *)words + align;
+                uint8_t expected[40];
+                memcpy(data, source, len);
+                memcpy(expected, source, len);
+                WsFrameEncoder::applyMask(data, len, MASK_KEY, offset);
+                referenceMask(expected, len, MASK_KEY, offset);
+                MCP_CHECK(memcmp(data, expected, len) == 0);
+            }
+        }
+    }
+}
+
+MCP_TEST(FrameEncoder_FrameParsesBack) {
+    std::string text(300, 'x');
+    for (size_t i = 0; i < text.size(); i++) {
+        text[i] = (char)('a' + i % 26);
+    }
+    WsFrameEncoder encoder;
+    MCP_CHECK(encoder.encode(WS_OP_TEXT, (const uint8_t *)text.data(), text.size(), MASK_KEY));
+    MCP_CHECK_EQ(8 + text.size(), encoder.frameLength());
+
+    WsFrameParser parser(1024);
+    size_t consumed = 0;
+    MCP_CHECK_EQ(WsFrameParser::MESSAGE_READY, parser.feed(encoder.frame(), encoder.frameLength(), consumed));
+    MCP_CHECK_EQ(encoder.frameLength(), consumed);
+    MCP_CHECK_EQ(text, std::string((const char *)parser.payload(), parser.payloadLength()));
+}
+
+MCP_TEST(FrameEncoder_BufferReusedBetweenFrames) {
+    WsFrameEncoder encoder;
+    MCP_CHECK(encoder.reserve(1000));
+    size_t capacity = encoder.capacity();
+    MCP_CHECK(capacity >= 1000);
+
+    // Appended in pieces; the header moves to sit right in front of the short payload
+    for (int i = 0; i < 3; i++) {
+        encoder.begin();
+        MCP_CHECK(encoder.append("{\"id\":", 6));
+        MCP_CHECK(encoder.append('1'));
+        MCP_CHECK(encoder.append("}", 1));
+        MCP_CHECK(encoder.finish(WS_OP_TEXT, 0));
+        MCP_CHECK_EQ(6u + 8u, encoder.frameLength());
+        MCP_CHECK_EQ(0x81, encoder.frame()[0]);
+        MCP_CHECK_EQ(0x88, encoder.frame()[1]);
+        MCP_CHECK(memcmp(encoder.frame() + 6, "{\"id\":1}", 8) == 0); // a zero key leaves it as is
+    }
+    MCP_CHECK_EQ(capacity, encoder.capacity());
+
+    // truncate() drops the tail; growing past the capacity keeps the payload
+    encoder.begin();
+    std::vector<uint8_t> big(capacity + 1, 'z');
+    MCP_CHECK(encoder.append("ab", 2));
+    MCP_CHECK(encoder.append(big.data(), big.size()));
+    MCP_CHECK(encoder.capacity() > capacity);
+    MCP_CHECK(memcmp(encoder.payload(), "abz", 3) == 0);
+    encoder.truncate(2);
+    MCP_CHECK_EQ(2u, encoder.payloadLength());
+}
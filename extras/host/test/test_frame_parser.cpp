@@ -0,0 +1,235 @@
+// WsFrameParser: messages and control frames delivered from byte-split and
+// coalesced input, through feed() and readFrom(), fragment reassembly, and the
+// close codes of rejected frames.
+
+#include "Test.h"
+#include "LoopbackClient.h"
+#include "WsFrameParser.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+static const uint8_t OP_CONTINUATION = 0x0;
+static const uint8_t OP_TEXT = 0x1;
+static const uint8_t OP_BINARY = 0x2;
+static const uint8_t OP_CLOSE = 0x8;
+static const uint8_t OP_PING = 0x9;
+
+static void appendFrame(std::vector<uint8_t> &out, uint8_t opcode, const std::string &payload, bool fin = true) {
+    std::vector<uint8_t> frame;
+    LoopbackClient::appendServerFrame(frame, opcode, payload.data(), payload.size(), fin);
+    out.insert(out.end(), frame.begin(), frame.end());
+}
+
+/* *
+ * Feed input in pieces of step bytes and describe what came out, one entry per
+ * delivery: "<opcode>:<payload>" for messages and control frames, "error:<close
+ * code>" for a rejected frame (after which nothing more is fed).
+ */
+static std::vector<std::string> parse(WsFrameParser &parser, const std::vector<uint8_t> &input, size_t step) {
+    std::vector<std::string> out;
+    size_t pos = 0;
+    while (pos < input.size()) {
+        size_t len = input.size() - pos < step ? input.size() - pos : step;
+        size_t offset = 0;
+        while (offset < len) {
+            size_t consumed = 0;
+            WsFrameParser::Result result = parser.feed(input.data() + pos + offset, len - offset, consumed);
+            offset += consumed;
+            if (result == WsFrameParser::ERROR) {
+                out.push_back("error:" + std::to_string(parser.closeCode()));
+                return out;
+            }
+            if (result == WsFrameParser::MESSAGE_READY || result == WsFrameParser::CONTROL_READY) {
+                out.push_back(std::to_string(parser.opcode()) + ":" +
+                              std::string((const char *)parser.payload(), parser.payloadLength()));
+            }
+        }
+        pos += len;
+    }
+    return out;
+}
+
+static std::vector<std::string> parse(const std::vector<uint8_t> &input, size_t step,
+                                      size_t maxMessageSize = 1024) {
+    WsFrameParser parser(maxMessageSize);
+    return parse(parser, input, step);
+}
+
+static std::vector<std::string> events(std::initializer_list<const char *> list) {
+    return std::vector<std::string>(list.begin(), list.end());
+}
+
+MCP_TEST(FrameParser_SplitAndCoalescedInput) {
+    std::string longText(300, 'x'); // 16-bit extended length
+    std::vector<uint8_t> input;
+    appendFrame(input, OP_TEXT, "{\"id\":1}");
+    appendFrame(input, OP_BINARY, "");
+    appendFrame(input, OP_TEXT, longText);
+    appendFrame(input, OP_TEXT, "{\"id\":2}");
+
+    std::vector<std::string> expected = {"1:{\"id\":1}", "2:", "1:" + longText, "1:{\"id\":2}"};
+    // All at once, byte by byte, and in pieces straddling the frame boundaries
+    const size_t steps[] = {input.size(), 1, 2, 3, 7, 64};
+    for (size_t step : steps) {
+        MCP_CHECK(expected == parse(input, step));
+    }
+}
+
+MCP_TEST(FrameParser_MaskedFrameUnmasked) {
+    const uint8_t key[4] = {0x37, 0xfa, 0x21, 0x3d};
+    const char *text = "Hello";
+    std::vector<uint8_t> input = {0x81, 0x85};
+    input.insert(input.end(), key, key + 4);
+    for (size_t i = 0; i < 5; i++) {
+        input.push_back((uint8_t)(text[i] ^ key[i % 4]));
+    }
+    MCP_CHECK(events({"1:Hello"}) == parse(input, 1));
+    MCP_CHECK(events({"1:Hello"}) == parse(input, input.size()));
+}
+
+MCP_TEST(FrameParser_FragmentsReassembled) {
+    std::vector<uint8_t> input;
+    appendFrame(input, OP_TEXT, "{\"jsonrpc\":", false);
+    appendFrame(input, OP_CONTINUATION, "\"2.0\",", false);
+    appendFrame(input, OP_CONTINUATION, "\"id\":3}", true);
+    appendFrame(input, OP_TEXT, "next");
+
+    for (size_t step = 1; step <= input.size(); step++) {
+        WsFrameParser parser(1024);
+        MCP_CHECK(events({"1:{\"jsonrpc\":\"2.0\",\"id\":3}", "1:next"}) == parse(parser, input, step));
+        MCP_CHECK_EQ(4u, parser.framesIn());
+        MCP_CHECK_EQ((uint64_t)input.size(), parser.bytesIn());
+    }
+
+    // Between fragments nothing is delivered
+    WsFrameParser parser(1024);
+    std::vector<uint8_t> first(input.begin(), input.begin() + 13);
+    MCP_CHECK(parse(parser, first, first.size()).empty());
+    MCP_CHECK(parser.fragmented());
+}
+
+MCP_TEST(FrameParser_ControlFramesInsideFragmentedMessage) {
+    std::vector<uint8_t> input;
+    appendFrame(input, OP_TEXT, "first ", false);
+    appendFrame(input, OP_PING, "p1");
+    appendFrame(input, OP_CONTINUATION, "second ", false);
+    appendFrame(input, OP_PING, "");
+    appendFrame(input, OP_CONTINUATION, "third", true);
+    appendFrame(input, OP_CLOSE, std::string("\x03\xe8", 2));
+
+    std::vector<std::string> expected = {"9:p1", "9:", "1:first second third", "8:" + std::string("\x03\xe8", 2)};
+    const size_t steps[] = {input.size(), 1, 5};
+    for (size_t step : steps) {
+        MCP_CHECK(expected == parse(input, step));
+    }
+}
+
+MCP_TEST(FrameParser_MessageTooLarge) {
+    std::vector<uint8_t> input;
+    appendFrame(input, OP_TEXT, std::string(64, 'a'));
+    MCP_CHECK(events({"error:1009"}) == parse(input, input.size(), 63));
+    MCP_CHECK_EQ(1u, parse(input, input.size(), 64).size());
+
+    // The limit covers the whole reassembled message, not each fragment
+    input.clear();
+    appendFrame(input, OP_TEXT, std::string(40, 'a'), false);
+    appendFrame(input, OP_CONTINUATION, std::string(40, 'b'), true);
+    MCP_CHECK(events({"error:1009"}) == parse(input, 1, 64));
+
+    WsFrameParser parser(64);
+    parse(parser, input, input.size());
+    MCP_CHECK_EQ(WsFrameParser::ERR_TOO_LARGE, parser.error());
+}
+
+MCP_TEST(FrameParser_ProtocolErrors) {
+    struct Case {
+        const char *what;
+        std::vector<uint8_t> input;
+    };
+    const Case cases[] = {
+        {"RSV1 without permessage-deflate", {0xC1, 0x00}},
+        {"RSV2", {0xA1, 0x00}},
+        {"RSV3", {0x91, 0x00}},
+        {"reserved data opcode", {0x83, 0x00}},
+        {"reserved control opcode", {0x8B, 0x00}},
+        {"fragmented control frame", {0x09, 0x00}},
+        {"control frame over 125 bytes", {0x89, 0x7E, 0x00, 0x7E}},
+        {"continuation without a message", {0x80, 0x00}},
+        {"new message inside a fragmented one", {0x01, 0x01, 'a', 0x81, 0x01, 'b'}},
+    };
+    for (const Case &c : cases) {
+        WsFrameParser parser(1024);
+        std::vector<std::string> out = parse(parser, c.input, 1);
+        if (!MCP_CHECK(events({"error:1002"}) == out)) {
+            printf("    case: %s\n", c.what);
+        }
+        MCP_CHECK_EQ(WsFrameParser::ERR_PROTOCOL, parser.error());
+    }
+}
+
+MCP_TEST(FrameParser_Rsv1OnceNegotiated) {
+    WsFrameParser parser(1024);
+    parser.setRsv1Allowed(true);
+    std::vector<uint8_t> input = {0x41, 0x01, 'a', 0x80, 0x01, 'b'}; // RSV1 on the first frame only
+    MCP_CHECK(events({"1:ab"}) == parse(parser, input, 1));
+    MCP_CHECK(parser.compressed());
+
+    // Still not on a continuation or a control frame
+    std::vector<uint8_t> badContinuation = {0x01, 0x01, 'a', 0xC0, 0x01, 'b'};
+    MCP_CHECK(events({"error:1002"}) == parse(parser, badContinuation, 1));
+    parser.reset();
+    std::vector<uint8_t> badPing = {0xC9, 0x00};
+    MCP_CHECK(events({"error:1002"}) == parse(parser, badPing, 1));
+}
+
+MCP_TEST(FrameParser_ErrorIsStickyUntilReset) {
+    WsFrameParser parser(1024);
+    std::vector<uint8_t> bad = {0xA1, 0x00};
+    std::vector<uint8_t> good;
+    appendFrame(good, OP_TEXT, "ok");
+
+    MCP_CHECK(events({"error:1002"}) == parse(parser, bad, 2));
+    // Further input is not parsed: the connection is being closed
+    MCP_CHECK(events({"error:1002"}) == parse(parser, good, good.size()));
+
+    parser.reset();
+    MCP_CHECK_EQ(WsFrameParser::ERR_NONE, parser.error());
+    MCP_CHECK(events({"1:ok"}) == parse(parser, good, good.size()));
+}
+
+// readFrom() takes what the socket has and picks up where it stopped on the next call
+MCP_TEST(FrameParser_ReadFromResumesAcrossCalls) {
+    std::vector<uint8_t> input;
+    std::string big(500, 'b');
+    appendFrame(input, OP_TEXT, big);
+    appendFrame(input, OP_PING, "p");
+    appendFrame(input, OP_TEXT, "tail");
+
+    LoopbackClient client;
+    client.setConnected(true);
+    WsFrameParser parser(1024);
+    MCP_CHECK_EQ(WsFrameParser::NEED_MORE, parser.readFrom(client));
+
+    // The first message arrives in three pieces, split inside the header and the payload
+    const size_t cuts[] = {1, 200, input.size()};
+    size_t pos = 0;
+    std::vector<std::string> out;
+    for (size_t cut : cuts) {
+        client.pushRx(input.data() + pos, cut - pos);
+        pos = cut;
+        WsFrameParser::Result result;
+        while ((result = parser.readFrom(client)) != WsFrameParser::NEED_MORE) {
+            MCP_CHECK(result != WsFrameParser::ERROR);
+            if (result == WsFrameParser::ERROR) {
+                return;
+            }
+            out.push_back(std::to_string(parser.opcode()) + ":" +
+                          std::string((const char *)parser.payload(), parser.payloadLength()));
+        }
+    }
+    MCP_CHECK((std::vector<std::string>{"1:" + big, "9:p", "1:tail"}) == out);
+    MCP_CHECK_EQ(0u, client.rxPending());
+    MCP_CHECK_EQ(3u, parser.framesIn());
+}
@@ -0,0 +1,108 @@
+// Heap instrumentation per JSON-RPC method and per tool (WebSocketMCP::setHeapTrace),
+// counted through AllocHook on the host.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <stdlib.h>
+#include <string>
+
+static const char *const REQ_INVOKE_KEEPER =
+    "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"keeper\",\"arguments\":{}}}";
+static const char *const REQ_INVOKE_WRITER =
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"writer\",\"arguments\":{}}}";
+
+static void *kept[4];
+static size_t keptCount;
+
+struct TextPrint : public Print {
+    std::string text;
+    size_t write(uint8_t c) override {
+        text += (char)c;
+        return 1;
+    }
+    using Print::write;
+};
+
+// "keeper" holds on to a 1 KB block per call, "writer" allocates nothing
+static void registerHeapTools(WebSocketMCP &mcp) {
+    mcp.registerTool("keeper", "Keeps memory", "{\"type\":\"object\"}", [](JsonObjectConst) {
+        if (keptCount < 4) {
+            kept[keptCount++] = malloc(1024);
+        }
+        return ToolResponse("{\"kept\":true}");
+    });
+    mcp.registerTool("writer", "Prints its result", "{\"type\":\"object\"}",
+                     [](JsonObjectConst, McpToolResult &result) { result.print("{\"ok\":true}"); });
+}
+
+static void releaseKept() {
+    while (keptCount > 0) {
+        free(kept[--keptCount]);
+    }
+}
+
+MCP_TEST(HeapTrace_OffByDefault) {
+    McpFixture f;
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, MCP_REQ_PING, strlen(MCP_REQ_PING));
+    McpHeapStats stats;
+    MCP_CHECK(!f.mcp.isHeapTraceEnabled());
+    MCP_CHECK(f.mcp.getMethodHeapStats("ping", stats));
+    MCP_CHECK_EQ(0u, stats.calls);
+    MCP_CHECK(!f.mcp.getMethodHeapStats("resources/list", stats));
+}
+
+MCP_TEST(HeapTrace_PerToolAndMethod) {
+    McpFixture f;
+    registerHeapTools(f.mcp);
+    f.mcp.setHeapTrace(true);
+    MCP_CHECK(McpHeapSnapshot::countsAllocations());
+
+    for (int i = 0; i < 2; i++) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, REQ_INVOKE_KEEPER, strlen(REQ_INVOKE_KEEPER));
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, REQ_INVOKE_WRITER, strlen(REQ_INVOKE_WRITER));
+    }
+
+    McpHeapStats keeper;
+    MCP_CHECK(f.mcp.getToolHeapStats("keeper", keeper));
+    MCP_CHECK_EQ(2u, keeper.calls);
+    MCP_CHECK(keeper.maxAllocs >= 1);
+    MCP_CHECK(keeper.maxBytes >= 1024);
+    // The block stays allocated: the free heap shrank across each call
+    MCP_CHECK(keeper.lastFreeDelta <= -1024);
+    MCP_CHECK(keeper.minFreeDelta <= -1024);
+
+    McpHeapStats writer;
+    MCP_CHECK(f.mcp.getToolHeapStats("writer", writer));
+    MCP_CHECK_EQ(2u, writer.calls);
+    MCP_CHECK_EQ(0u, writer.allocs);
+    MCP_CHECK_EQ(0, writer.lastFreeDelta);
+
+    // The method covers the tool call plus building and queuing the reply
+    McpHeapStats invoke;
+    MCP_CHECK(f.mcp.getMethodHeapStats("tools/invoke", invoke));
+    MCP_CHECK_EQ(4u, invoke.calls);
+    MCP_CHECK(invoke.allocs >= keeper.allocs);
+
+    f.mcp.resetMetrics();
+    MCP_CHECK(f.mcp.getToolHeapStats("keeper", keeper));
+    MCP_CHECK_EQ(0u, keeper.calls);
+    releaseKept();
+}
+
+MCP_TEST(HeapTrace_SummaryListsCalledOnly) {
+    McpFixture f;
+    registerHeapTools(f.mcp);
+    f.mcp.setHeapTrace(true);
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, REQ_INVOKE_KEEPER, strlen(REQ_INVOKE_KEEPER));
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, MCP_REQ_PING, strlen(MCP_REQ_PING));
+
+    TextPrint out;
+    f.mcp.printHeapStats(out);
+    MCP_CHECK(out.text.find("method ping ") != std::string::npos);
+    MCP_CHECK(out.text.find("method tools/invoke ") != std::string::npos);
+    MCP_CHECK(out.text.find("tool   keeper ") != std::string::npos);
+    MCP_CHECK(out.text.find("writer") == std::string::npos);
+    MCP_CHECK(out.text.find("initialize") == std::string::npos);
+    releaseKept();
+}
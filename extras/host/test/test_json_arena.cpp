@@ -0,0 +1,119 @@
+// McpJsonArena: one document reused across messages, doubling up to
+// maxCapacity when a message does not fit, and the stats behind it.
+
+#include "Test.h"
+#include "AllocHook.h"
+
+#include <McpJsonArena.h>
+
+#include <string.h>
+#include <string>
+
+// A JSON array of count short strings, each taking a slot and a string copy
+static std::string stringArray(int count) {
+    std::string json = "[";
+    for (int i = 0; i < count; i++) {
+        json += i ? ",\"item_" : "\"item_";
+        json += std::to_string(i) + "\"";
+    }
+    return json + "]";
+}
+
+static DeserializationError parse(McpJsonArena &arena, const std::string &json) {
+    return arena.parse(json.data(), json.size());
+}
+
+static DeserializationError parse(McpJsonArena &arena, const char *json) {
+    return arena.parse(json, strlen(json));
+}
+
+MCP_TEST(JsonArena_DocumentReusedBetweenMessages) {
+    McpJsonArena arena(256, 256);
+    MCP_CHECK(arena.begin());
+    MCP_CHECK_EQ((size_t)256, arena.doc().capacity());
+
+    MCP_CHECK(!parse(arena, "{\"id\":1,\"method\":\"ping\"}"));
+    AllocStats before = allocSnapshot();
+    for (int i = 0; i < 10; i++) {
+        MCP_CHECK(!parse(arena, "{\"id\":2,\"method\":\"tools/list\"}"));
+    }
+    MCP_CHECK_EQ(before.count, allocSnapshot().count);
+    MCP_CHECK_EQ(std::string("tools/list"), std::string(arena.doc()["method"].as<const char *>()));
+    MCP_CHECK_EQ(11u, arena.stats().messages);
+    MCP_CHECK_EQ(0u, arena.stats().grows);
+}
+
+MCP_TEST(JsonArena_AllocatedOnFirstParse) {
+    McpJsonArena arena(512, 512);
+    MCP_CHECK(!parse(arena, "[1,2,3]"));
+    MCP_CHECK_EQ(3u, arena.doc().as<JsonArrayConst>().size());
+    MCP_CHECK_EQ((size_t)512, arena.doc().capacity());
+}
+
+MCP_TEST(JsonArena_GrowsByDoublingAndKeepsTheSize) {
+    McpJsonArena arena(128, 4096);
+    MCP_CHECK(arena.begin());
+    std::string big = stringArray(40);
+    MCP_CHECK(!parse(arena, big));
+    MCP_CHECK_EQ(40u, arena.doc().as<JsonArrayConst>().size());
+
+    const McpJsonArena::Stats &stats = arena.stats();
+    MCP_CHECK(stats.grows >= 1);
+    MCP_CHECK(stats.capacity > 128 && stats.capacity <= 4096);
+    // Every step doubled from the initial capacity
+    MCP_CHECK_EQ((size_t)128 << stats.grows, stats.capacity);
+    MCP_CHECK(stats.peakUsage > 128 && stats.peakUsage <= stats.capacity);
+    MCP_CHECK_EQ(0u, stats.overflows);
+
+    // The larger size stays: the same message fits straight away
+    uint32_t grows = stats.grows;
+    size_t capacity = stats.capacity;
+    MCP_CHECK(!parse(arena, "{}"));
+    MCP_CHECK(!parse(arena, big));
+    MCP_CHECK_EQ(grows, stats.grows);
+    MCP_CHECK_EQ(capacity, stats.capacity);
+}
+
+MCP_TEST(JsonArena_GrowthClampedToMaxCapacity) {
+    // 128 -> 256 -> 300 rather than 512
+    McpJsonArena arena(128, 300);
+    MCP_CHECK(arena.begin());
+    MCP_CHECK(parse(arena, stringArray(200)) == DeserializationError::NoMemory);
+    MCP_CHECK_EQ((size_t)300, arena.stats().capacity);
+    MCP_CHECK_EQ((size_t)300, arena.doc().capacity());
+    MCP_CHECK_EQ(2u, arena.stats().grows);
+}
+
+MCP_TEST(JsonArena_OverflowRejectedAndDocumentStillUsable) {
+    McpJsonArena arena(256, 256);
+    MCP_CHECK(arena.begin());
+    MCP_CHECK(parse(arena, stringArray(200)) == DeserializationError::NoMemory);
+    MCP_CHECK(parse(arena, stringArray(200)) == DeserializationError::NoMemory);
+    MCP_CHECK_EQ(2u, arena.stats().overflows);
+    MCP_CHECK_EQ(0u, arena.stats().grows);
+    MCP_CHECK_EQ(0u, arena.stats().messages);
+
+    // The next message that fits parses into the same document
+    MCP_CHECK(!parse(arena, "{\"id\":3}"));
+    MCP_CHECK_EQ(3, arena.doc()["id"].as<int>());
+    MCP_CHECK_EQ(1u, arena.stats().messages);
+
+    // Malformed input is neither a message nor an overflow
+    MCP_CHECK(parse(arena, "{\"id\":") != DeserializationError::Ok);
+    MCP_CHECK_EQ(1u, arena.stats().messages);
+    MCP_CHECK_EQ(2u, arena.stats().overflows);
+}
+
+MCP_TEST(JsonArena_BeginSetsCapacities) {
+    McpJsonArena arena(128, 1024);
+    // A ceiling below the capacity is raised to it
+    MCP_CHECK(arena.begin(512, 64));
+    MCP_CHECK_EQ((size_t)512, arena.stats().capacity);
+    MCP_CHECK_EQ((size_t)512, arena.stats().maxCapacity);
+
+    // The same capacity keeps the document as it is
+    AllocStats before = allocSnapshot();
+    MCP_CHECK(arena.begin(512, 2048));
+    MCP_CHECK_EQ(before.count, allocSnapshot().count);
+    MCP_CHECK_EQ((size_t)2048, arena.stats().maxCapacity);
+}
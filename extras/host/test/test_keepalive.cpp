@@ -0,0 +1,150 @@
+// PING scheduling, PONG matching and the RTT estimates (McpKeepalive), and the
+// keepalive exchange through WebSocketMCP.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <McpKeepalive.h>
+
+// Answer the PING just sent, RTT ms later
+static bool answer(McpKeepalive &k, const uint8_t *ping, unsigned long now, uint32_t &rtt) {
+    return k.pong(ping, McpKeepalive::PAYLOAD_LEN, now, rtt);
+}
+
+MCP_TEST(Keepalive_ProbesOnlyAfterQuietInterval) {
+    McpKeepalive k;
+    k.configure(1000, 3);
+    k.reset(5000);
+    MCP_CHECK_EQ(McpKeepalive::NONE, k.poll(5999));
+    MCP_CHECK_EQ(McpKeepalive::PROBE, k.poll(6000));
+}
+
+MCP_TEST(Keepalive_NoProbeWhileDataFlows) {
+    McpKeepalive k;
+    k.configure(1000, 3);
+    k.reset(0);
+    for (unsigned long now = 500; now < 10000; now += 500) {
+        k.received(now);
+        MCP_CHECK_EQ(McpKeepalive::NONE, k.poll(now + 999));
+    }
+}
+
+MCP_TEST(Keepalive_DeadAfterUnansweredProbes) {
+    McpKeepalive k;
+    k.configure(1000, 2);
+    k.reset(0);
+    uint8_t ping[McpKeepalive::PAYLOAD_LEN];
+    unsigned long now = 1000;
+    MCP_CHECK_EQ(McpKeepalive::PROBE, k.poll(now));
+    k.probe(now, ping);
+    // Without an RTT sample each PING gets the maximum timeout
+    MCP_CHECK_EQ(McpKeepalive::NONE, k.poll(now + MCP_KEEPALIVE_MAX_TIMEOUT_MS - 1));
+    now += MCP_KEEPALIVE_MAX_TIMEOUT_MS;
+    MCP_CHECK_EQ(McpKeepalive::PROBE, k.poll(now));
+    k.probe(now, ping);
+    now += MCP_KEEPALIVE_MAX_TIMEOUT_MS;
+    MCP_CHECK_EQ(McpKeepalive::DEAD, k.poll(now));
+
+    // Anything from the server in the meantime would have saved it
+    k.received(now);
+    MCP_CHECK_EQ(McpKeepalive::NONE, k.poll(now));
+}
+
+MCP_TEST(Keepalive_PongGivesRttAndSmoothedEstimates) {
+    McpKeepalive k;
+    k.reset(0);
+    uint8_t ping[McpKeepalive::PAYLOAD_LEN];
+    uint32_t rtt = 0;
+
+    k.probe(10000, ping);
+    MCP_CHECK(answer(k, ping, 10400, rtt));
+    MCP_CHECK_EQ(400u, rtt);
+    // First sample: SRTT = R, RTTVAR = R / 2
+    MCP_CHECK_EQ(400u, k.srtt());
+    MCP_CHECK_EQ(200u, k.rttVar());
+
+    k.probe(20000, ping);
+    MCP_CHECK(answer(k, ping, 20720, rtt));
+    // SRTT = 7/8 * 400 + 1/8 * 720, RTTVAR = 3/4 * 200 + 1/4 * |400 - 720|
+    MCP_CHECK_EQ(440u, k.srtt());
+    MCP_CHECK_EQ(230u, k.rttVar());
+    MCP_CHECK_EQ((uint32_t)2 * (440 + 4 * 230), k.timeout());
+}
+
+MCP_TEST(Keepalive_TimeoutWithinBounds) {
+    McpKeepalive k;
+    uint8_t ping[McpKeepalive::PAYLOAD_LEN];
+    uint32_t rtt;
+    k.probe(0, ping);
+    answer(k, ping, 1, rtt);
+    MCP_CHECK_EQ((uint32_t)MCP_KEEPALIVE_MIN_TIMEOUT_MS, k.timeout());
+
+    McpKeepalive slow;
+    slow.probe(0, ping);
+    answer(slow, ping, 30000, rtt);
+    MCP_CHECK_EQ((uint32_t)MCP_KEEPALIVE_MAX_TIMEOUT_MS, slow.timeout());
+}
+
+MCP_TEST(Keepalive_IgnoresUnsolicitedAndRepeatedPongs) {
+    McpKeepalive k;
+    uint8_t ping[McpKeepalive::PAYLOAD_LEN];
+    uint32_t rtt;
+    MCP_CHECK(!k.pong(nullptr, 0, 100, rtt));
+
+    k.probe(0, ping);
+    uint8_t other[McpKeepalive::PAYLOAD_LEN];
+    memcpy(other, ping, sizeof(other));
+    other[3]++; // a sequence number never sent
+    MCP_CHECK(!answer(k, other, 50, rtt));
+    MCP_CHECK(!k.pong(ping, 4, 50, rtt));
+    MCP_CHECK(answer(k, ping, 50, rtt));
+    MCP_CHECK(!answer(k, ping, 60, rtt));
+    MCP_CHECK_EQ(50u, k.srtt());
+}
+
+MCP_TEST(Keepalive_LateAnswerToEarlierProbeCounts) {
+    McpKeepalive k;
+    uint8_t first[McpKeepalive::PAYLOAD_LEN];
+    uint8_t second[McpKeepalive::PAYLOAD_LEN];
+    uint32_t rtt;
+    k.probe(0, first);
+    k.probe(3000, second);
+    MCP_CHECK(answer(k, first, 3200, rtt));
+    MCP_CHECK_EQ(3200u, rtt);
+    MCP_CHECK(answer(k, second, 3250, rtt));
+    MCP_CHECK_EQ(250u, rtt);
+    MCP_CHECK(!answer(k, first, 3300, rtt));
+}
+
+MCP_TEST(Keepalive_PingEchoedByServerUpdatesMetrics) {
+    McpFixture f;
+    f.client.setTxCapture(true);
+    f.mcp.setKeepalive(0);
+    f.mcp.loop();
+
+    // Our PING: FIN + opcode, masked length, mask key, masked payload
+    const std::vector<uint8_t> &tx = f.client.tx();
+    MCP_CHECK_EQ((size_t)2 + 4 + McpKeepalive::PAYLOAD_LEN, tx.size());
+    if (tx.size() != 2 + 4 + McpKeepalive::PAYLOAD_LEN) {
+        return;
+    }
+    MCP_CHECK_EQ(0x80 | WS_OP_PING, (int)tx[0]);
+    MCP_CHECK_EQ(0x80 | (int)McpKeepalive::PAYLOAD_LEN, (int)tx[1]);
+    char payload[McpKeepalive::PAYLOAD_LEN];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (char)(tx[6 + i] ^ tx[2 + i % 4]);
+    }
+
+    f.mcp.setKeepalive(MCP_KEEPALIVE_INTERVAL_MS); // no second PING once the PONG made the link busy
+    f.client.pushServerFrame(WS_OP_PONG, payload, sizeof(payload));
+    f.mcp.loop();
+    McpMetrics m = f.mcp.getMetrics();
+    MCP_CHECK_EQ(1u, m.pingsSent);
+    MCP_CHECK_EQ(1u, m.pongsReceived);
+    MCP_CHECK_EQ(m.rttLastMs, f.mcp.getSmoothedRtt());
+
+    // An unsolicited PONG is only activity
+    f.client.pushServerFrame(WS_OP_PONG, "x", 1);
+    f.mcp.loop();
+    MCP_CHECK_EQ(1u, f.mcp.getMetrics().pongsReceived);
+}
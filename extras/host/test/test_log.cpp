@@ -0,0 +1,92 @@
+// McpLog: the prefix with the level letter, deferred records printed with
+// their level and time, and lines dropped while the ring is full.
+
+#include "Test.h"
+
+#include <McpLog.h>
+
+#include <ctype.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Collects each write() as one line
+struct LineCapture : Print {
+    std::vector<std::string> lines;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        lines.push_back(std::string((const char *)buffer, size));
+        return size;
+    }
+};
+
+// Routes the log into a LineCapture for one test, then back to Serial
+struct LogCapture {
+    LineCapture out;
+    LogCapture() { McpLog::setOutput(out); }
+    ~LogCapture() {
+        McpLog::setDeferred(false);
+        McpLog::setOutput(Serial);
+    }
+};
+
+MCP_TEST(Log_LevelLetterInPrefix) {
+    LogCapture log;
+    McpLog::write(MCP_LOG_LEVEL_ERROR, "failed: %d", 7);
+    McpLog::write(MCP_LOG_LEVEL_WARN, "slow");
+    McpLog::write(MCP_LOG_LEVEL_INFO, "up");
+    McpLog::write(MCP_LOG_LEVEL_DEBUG, "%s", "frame");
+    MCP_CHECK_EQ(4u, log.out.lines.size());
+    if (log.out.lines.size() == 4) {
+        MCP_CHECK_EQ(std::string("[xiaozhi-mcp] E failed: 7\r\n"), log.out.lines[0]);
+        MCP_CHECK_EQ(std::string("[xiaozhi-mcp] W slow\r\n"), log.out.lines[1]);
+        MCP_CHECK_EQ(std::string("[xiaozhi-mcp] I up\r\n"), log.out.lines[2]);
+        MCP_CHECK_EQ(std::string("[xiaozhi-mcp] D frame\r\n"), log.out.lines[3]);
+    }
+
+    // Long messages are cut at MCP_LOG_LINE_SIZE - 1 characters
+    log.out.lines.clear();
+    McpLog::write(MCP_LOG_LEVEL_INFO, "%s", std::string(300, 'x').c_str());
+    MCP_CHECK(!log.out.lines.empty() &&
+              log.out.lines[0].size() == strlen("[xiaozhi-mcp] I ") + MCP_LOG_LINE_SIZE - 1 + 2);
+}
+
+MCP_TEST(Log_DeferredKeepsLevelAndTime) {
+    LogCapture log;
+    MCP_CHECK(McpLog::setDeferred(true));
+    MCP_CHECK(McpLog::deferred());
+    McpLog::write(MCP_LOG_LEVEL_WARN, "queued %s", "first");
+    McpLog::write(MCP_LOG_LEVEL_ERROR, "queued second");
+    MCP_CHECK(log.out.lines.empty());
+
+    MCP_CHECK_EQ((size_t)1, McpLog::flush(1));
+    MCP_CHECK_EQ((size_t)1, McpLog::flush());
+    MCP_CHECK_EQ((size_t)0, McpLog::flush());
+    MCP_CHECK_EQ(2u, log.out.lines.size());
+    if (log.out.lines.size() == 2) {
+        // "[xiaozhi-mcp] W <millis> queued first"
+        const std::string &first = log.out.lines[0];
+        MCP_CHECK_EQ(0u, first.find("[xiaozhi-mcp] W "));
+        MCP_CHECK(first.size() > 16 && isdigit((unsigned char)first[16]));
+        MCP_CHECK(first.find(" queued first\r\n") != std::string::npos);
+        MCP_CHECK_EQ(0u, log.out.lines[1].find("[xiaozhi-mcp] E "));
+    }
+}
+
+MCP_TEST(Log_FullRingDropsAndSwitchingOffFlushes) {
+    LogCapture log;
+    MCP_CHECK(McpLog::setDeferred(true));
+    uint32_t dropped = McpLog::dropped();
+    for (int i = 0; i < MCP_LOG_RING_RECORDS + 3; i++) {
+        McpLog::write(MCP_LOG_LEVEL_INFO, "line %d", i);
+    }
+    MCP_CHECK_EQ(dropped + 3, McpLog::dropped());
+
+    // Switching off prints what is left, then lines go out directly again
+    MCP_CHECK(McpLog::setDeferred(false));
+    MCP_CHECK(!McpLog::deferred());
+    MCP_CHECK_EQ((size_t)MCP_LOG_RING_RECORDS, log.out.lines.size());
+    MCP_CHECK_EQ((size_t)0, McpLog::flush());
+    McpLog::write(MCP_LOG_LEVEL_INFO, "direct");
+    MCP_CHECK_EQ(std::string("[xiaozhi-mcp] I direct\r\n"), log.out.lines.back());
+}
@@ -0,0 +1,5 @@
+#include "Test.h"
+
+int main(int argc, char **argv) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,155 @@
+// McpToolStats and McpMetrics: latency histogram bucket bounds, RTT min/max,
+// and the counters WebSocketMCP keeps per message and per tool call.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <McpMetrics.h>
+
+#include <string>
+
+static const char *const REQ_INVOKE_FAILING =
+    "{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"failing\",\"arguments\":{}}}";
+static const char *const REQ_INVOKE_STATS =
+    "{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"mcp_stats\","
+    "\"arguments\":{\"reset\":true}}}";
+
+static size_t bucketOf(const McpToolStats &stats) {
+    for (size_t b = 0; b < MCP_LATENCY_BUCKETS; b++) {
+        if (stats.histogram[b]) {
+            return b;
+        }
+    }
+    return MCP_LATENCY_BUCKETS;
+}
+
+static void send(McpFixture &f, const char *message) {
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, message, strlen(message));
+}
+
+MCP_TEST(Metrics_HistogramBucketBounds) {
+    // Each bound is exclusive: one microsecond below stays, the bound itself moves up
+    for (size_t b = 0; b + 1 < MCP_LATENCY_BUCKETS; b++) {
+        uint32_t bound = McpToolStats::bucketBound(b);
+        MCP_CHECK(b == 0 || bound > McpToolStats::bucketBound(b - 1));
+
+        McpToolStats below;
+        below.record(bound - 1, false);
+        MCP_CHECK_EQ(b, bucketOf(below));
+        McpToolStats at;
+        at.record(bound, false);
+        MCP_CHECK_EQ(b + 1, bucketOf(at));
+    }
+    MCP_CHECK_EQ(100u, McpToolStats::bucketBound(0));
+    MCP_CHECK_EQ(1000000u, McpToolStats::bucketBound(MCP_LATENCY_BUCKETS - 2));
+    MCP_CHECK_EQ(0u, McpToolStats::bucketBound(MCP_LATENCY_BUCKETS - 1));
+
+    McpToolStats extremes;
+    extremes.record(0, false);
+    extremes.record(0xFFFFFFFF, false);
+    MCP_CHECK_EQ(1u, extremes.histogram[0]);
+    MCP_CHECK_EQ(1u, extremes.histogram[MCP_LATENCY_BUCKETS - 1]);
+}
+
+MCP_TEST(Metrics_ToolStatsCountsAndReset) {
+    McpToolStats stats;
+    stats.record(50, false);
+    stats.record(2500, true);
+    stats.record(700, false);
+    MCP_CHECK_EQ(3u, stats.calls);
+    MCP_CHECK_EQ(1u, stats.errors);
+    MCP_CHECK_EQ(2500u, stats.maxUs);
+    MCP_CHECK_EQ((uint64_t)3250, stats.totalUs);
+    MCP_CHECK_EQ(1u, stats.histogram[0]);
+    MCP_CHECK_EQ(1u, stats.histogram[1]);
+    MCP_CHECK_EQ(1u, stats.histogram[2]);
+
+    stats.reset();
+    MCP_CHECK_EQ(0u, stats.calls);
+    MCP_CHECK_EQ(0u, stats.maxUs);
+    MCP_CHECK_EQ(MCP_LATENCY_BUCKETS, bucketOf(stats));
+}
+
+MCP_TEST(Metrics_RttMinMaxAndTotal) {
+    McpMetrics metrics;
+    // The first sample sets the minimum even though it is the largest
+    metrics.recordRtt(80);
+    MCP_CHECK_EQ(80u, metrics.rttMinMs);
+    metrics.recordRtt(20);
+    metrics.recordRtt(45);
+    MCP_CHECK_EQ(3u, metrics.pongsReceived);
+    MCP_CHECK_EQ(45u, metrics.rttLastMs);
+    MCP_CHECK_EQ(20u, metrics.rttMinMs);
+    MCP_CHECK_EQ(80u, metrics.rttMaxMs);
+    MCP_CHECK_EQ((uint64_t)145, metrics.rttTotalMs);
+
+    metrics.reset();
+    MCP_CHECK_EQ(0u, metrics.pongsReceived);
+    metrics.recordRtt(300);
+    MCP_CHECK_EQ(300u, metrics.rttMinMs);
+}
+
+MCP_TEST(Metrics_MessagesAndToolCallsCounted) {
+    McpFixture f;
+    f.registerSampleTools(2);
+    f.mcp.registerTool("failing", "Always fails", "{}",
+                       [](JsonObjectConst) { return ToolResponse("{\"reason\":\"no\"}", true); });
+
+    send(f, MCP_REQ_PING);
+    send(f, MCP_REQ_TOOLS_INVOKE);
+    send(f, MCP_REQ_TOOLS_INVOKE);
+    send(f, REQ_INVOKE_FAILING);
+    send(f, "{\"jsonrpc\":");
+
+    McpMetrics metrics = f.mcp.getMetrics();
+    MCP_CHECK_EQ(4u, metrics.messagesIn);
+    MCP_CHECK_EQ(1u, metrics.parseFailures);
+
+    McpToolStats led;
+    MCP_CHECK(f.mcp.getToolStats("led_blink", led));
+    MCP_CHECK_EQ(2u, led.calls);
+    MCP_CHECK_EQ(0u, led.errors);
+    uint32_t inHistogram = 0;
+    for (size_t b = 0; b < MCP_LATENCY_BUCKETS; b++) {
+        inHistogram += led.histogram[b];
+    }
+    MCP_CHECK_EQ(led.calls, inHistogram);
+
+    McpToolStats failing;
+    MCP_CHECK(f.mcp.getToolStats("failing", failing));
+    MCP_CHECK_EQ(1u, failing.calls);
+    MCP_CHECK_EQ(1u, failing.errors);
+    MCP_CHECK(!f.mcp.getToolStats("missing", failing));
+
+    f.mcp.resetMetrics();
+    MCP_CHECK_EQ(0u, f.mcp.getMetrics().messagesIn);
+    MCP_CHECK(f.mcp.getToolStats("led_blink", led));
+    MCP_CHECK_EQ(0u, led.calls);
+}
+
+MCP_TEST(Metrics_StatsToolReportsAndResets) {
+    McpFixture f;
+    f.client.setTxCapture(true);
+    f.registerSampleTools(1);
+    MCP_CHECK(f.mcp.enableStatsTool());
+    send(f, MCP_REQ_TOOLS_INVOKE);
+    f.client.clearTx();
+
+    send(f, REQ_INVOKE_STATS);
+    WebSocketMCPHostAccess::flushSendQueue(f.mcp);
+    std::vector<std::string> replies = f.client.takeTxPayloads();
+    MCP_CHECK_EQ(1u, replies.size());
+    if (replies.size() == 1) {
+        // The report is the text of the tool result, so its quotes are escaped
+        const std::string &report = replies[0];
+        MCP_CHECK(report.find("\\\"latencyBucketsUs\\\":[100,1000,10000,50000,100000,500000,1000000]") !=
+                  std::string::npos);
+        MCP_CHECK(report.find("\\\"led_blink\\\":{\\\"calls\\\":1,\\\"errors\\\":0,") != std::string::npos);
+        MCP_CHECK(report.find("\\\"messagesIn\\\":2,") != std::string::npos);
+    }
+
+    // "reset": true cleared the counters after the report was taken
+    McpToolStats led;
+    MCP_CHECK(f.mcp.getToolStats("led_blink", led));
+    MCP_CHECK_EQ(0u, led.calls);
+}
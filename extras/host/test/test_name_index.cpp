@@ -0,0 +1,106 @@
+// McpNameIndex: lookups through growth, colliding hashes, removal shifting the
+// later positions like vector::erase, and the tool registry built on it.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <McpNameIndex.h>
+
+#include <string>
+#include <vector>
+
+// The vector the index points into, as the tool registry keeps it
+struct NamedIndex {
+    std::vector<std::string> names;
+    McpNameIndex index;
+
+    bool add(const std::string &name, uint32_t hash) {
+        names.push_back(name);
+        return index.insert(hash, names.size() - 1);
+    }
+    bool add(const std::string &name) { return add(name, McpNameIndex::hash(name.data(), name.size())); }
+
+    int find(const std::string &name, uint32_t hash) const {
+        return index.find(hash, [&](size_t position) { return names[position] == name; });
+    }
+    int find(const std::string &name) const { return find(name, McpNameIndex::hash(name.data(), name.size())); }
+
+    void remove(size_t position) {
+        names.erase(names.begin() + position);
+        index.remove(position);
+    }
+};
+
+MCP_TEST(NameIndex_FindsEveryNameThroughGrowth) {
+    NamedIndex n;
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("anything"));
+    for (int i = 0; i < 100; i++) {
+        MCP_CHECK(n.add("tool_" + std::to_string(i)));
+    }
+    MCP_CHECK_EQ(100u, n.index.size());
+    for (int i = 0; i < 100; i++) {
+        MCP_CHECK_EQ(i, n.find("tool_" + std::to_string(i)));
+    }
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("tool_100"));
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("tool_"));
+
+    n.index.clear();
+    MCP_CHECK_EQ(0u, n.index.size());
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("tool_1"));
+}
+
+MCP_TEST(NameIndex_CollidingHashesTellNamesApart) {
+    NamedIndex n;
+    // All on one hash, and so one probe chain: the name compare decides
+    for (int i = 0; i < 20; i++) {
+        MCP_CHECK(n.add("same_" + std::to_string(i), 42));
+    }
+    MCP_CHECK(n.add("other", 43));
+    for (int i = 0; i < 20; i++) {
+        MCP_CHECK_EQ(i, n.find("same_" + std::to_string(i), 42));
+    }
+    MCP_CHECK_EQ(20, n.find("other", 43));
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("same_20", 42));
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("same_1", 43));
+
+    // Removing from the middle of the chain keeps the rest reachable
+    n.remove(5);
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("same_5", 42));
+    MCP_CHECK_EQ(4, n.find("same_4", 42));
+    MCP_CHECK_EQ(5, n.find("same_6", 42));
+    MCP_CHECK_EQ(18, n.find("same_19", 42));
+    MCP_CHECK_EQ(19, n.find("other", 43));
+}
+
+MCP_TEST(NameIndex_RemoveShiftsLaterPositions) {
+    NamedIndex n;
+    for (int i = 0; i < 10; i++) {
+        n.add("t" + std::to_string(i));
+    }
+    n.remove(0);
+    n.remove(8); // the last one, t9
+    n.remove(3); // t4
+    MCP_CHECK_EQ(7u, n.index.size());
+    for (size_t i = 0; i < n.names.size(); i++) {
+        MCP_CHECK_EQ((int)i, n.find(n.names[i]));
+    }
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("t0"));
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("t4"));
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, n.find("t9"));
+
+    // Positions beyond the 16-bit slot field are refused
+    McpNameIndex index;
+    MCP_CHECK(!index.insert(1, 0xFFFF));
+}
+
+MCP_TEST(NameIndex_ToolRegistryAfterUnregister) {
+    McpFixture f;
+    f.registerSampleTools(8);
+    MCP_CHECK_EQ(0, WebSocketMCPHostAccess::findTool(f.mcp, "led_blink"));
+    MCP_CHECK(f.mcp.unregisterTool("relay_3"));
+    MCP_CHECK(!f.mcp.unregisterTool("relay_3"));
+    MCP_CHECK_EQ(McpNameIndex::NOT_FOUND, WebSocketMCPHostAccess::findTool(f.mcp, "relay_3"));
+    MCP_CHECK_EQ(2, WebSocketMCPHostAccess::findTool(f.mcp, "relay_2"));
+    MCP_CHECK_EQ(3, WebSocketMCPHostAccess::findTool(f.mcp, "relay_4"));
+    MCP_CHECK_EQ(6, WebSocketMCPHostAccess::findTool(f.mcp, "relay_7"));
+}
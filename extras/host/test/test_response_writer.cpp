@@ -0,0 +1,103 @@
+// McpResponseWriter: JSON-RPC envelopes written straight into the frame buffer,
+// ids echoed as received, escaping, and batch replies collected in one array.
+
+#include "Test.h"
+
+#include <McpResponseWriter.h>
+
+#include <string>
+
+static std::string payloadOf(WsFrameEncoder &out) {
+    return std::string((const char *)out.payload(), out.payloadLength());
+}
+
+struct Ids {
+    StaticJsonDocument<128> doc;
+    Ids() { deserializeJson(doc, "{\"number\":7,\"text\":\"a-1\"}"); }
+    JsonVariantConst number() const { return doc["number"]; }
+    JsonVariantConst text() const { return doc["text"]; }
+};
+
+MCP_TEST(ResponseWriter_Envelopes) {
+    Ids ids;
+    WsFrameEncoder out;
+    McpResponseWriter reply(out);
+
+    reply.beginResult(ids.number());
+    reply.raw("{\"ok\":true}");
+    MCP_CHECK(reply.started());
+    MCP_CHECK(reply.end());
+    MCP_CHECK(!reply.started());
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":{\"ok\":true}}"), payloadOf(out));
+
+    // A string id stays a string; a missing one is null
+    reply.error(ids.text(), -32601, "Method \"x\" not found");
+    reply.end();
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":\"a-1\",\"error\":{\"code\":-32601,"
+                             "\"message\":\"Method \\\"x\\\" not found\"}}"),
+                 payloadOf(out));
+    reply.beginResult(JsonVariantConst());
+    reply.raw("1");
+    reply.end();
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":null,\"result\":1}"), payloadOf(out));
+
+    reply.beginNotification("notifications/progress");
+    reply.raw(",\"params\":{}");
+    reply.end();
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":{}}"),
+                 payloadOf(out));
+}
+
+MCP_TEST(ResponseWriter_StringsAndPrint) {
+    WsFrameEncoder out;
+    McpResponseWriter reply(out);
+    reply.beginResult(JsonVariantConst());
+    reply.raw("[");
+    reply.string("a/b\\c\n\x02");
+    reply.raw(",\"");
+    reply.escaped(String("\t\""));
+    reply.raw("\",");
+    reply.print(42); // a Print: numbers and serializeJson() go through write()
+    reply.raw("]");
+    reply.end();
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":null,\"result\":[\"a\\/b\\\\c\\n\\u0002\",\"\\t\\\"\",42]}"),
+                 payloadOf(out));
+
+    const char *text = "a/b\\c\n\x02";
+    MCP_CHECK_EQ(strlen("a\\/b\\\\c\\n\\u0002"), McpResponseWriter::escapedLength(text, strlen(text)));
+}
+
+MCP_TEST(ResponseWriter_BatchCollectsResponses) {
+    Ids ids;
+    WsFrameEncoder out;
+    McpResponseWriter reply(out);
+
+    reply.beginBatch();
+    MCP_CHECK(reply.batching());
+    reply.beginResult(ids.number());
+    reply.raw("1");
+    reply.end();
+    // A notification has no place in a batch reply
+    reply.beginNotification("notifications/message");
+    reply.end();
+    // Beginning again replaces the reply left open
+    reply.beginResult(ids.text());
+    reply.raw("\"dropped\"");
+    reply.error(ids.text(), -32000, "busy");
+    reply.end();
+    // As does discard()
+    reply.beginResult(ids.text());
+    reply.raw("\"discarded\"");
+    reply.discard();
+    MCP_CHECK(reply.endBatch());
+    MCP_CHECK(!reply.batching());
+    MCP_CHECK_EQ(std::string("[{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":1},"
+                             "{\"jsonrpc\":\"2.0\",\"id\":\"a-1\",\"error\":{\"code\":-32000,\"message\":\"busy\"}}]"),
+                 payloadOf(out));
+
+    // Notifications only: nothing to send
+    reply.beginBatch();
+    reply.beginNotification("notifications/message");
+    reply.end();
+    MCP_CHECK(!reply.endBatch());
+}
@@ -0,0 +1,166 @@
+// McpSendQueue against a socket that takes a few bytes per write(): control
+// frames ahead of data, partly written frames finished first, the rest of a
+// write() following its head, large frames written in place, frames of an
+// earlier connection dropped, and STALLED after MCP_TX_STALL_TIMEOUT_MS.
+
+#include "Test.h"
+
+#include <McpSendQueue.h>
+#include "LoopbackClient.h"
+
+#include <string>
+
+static const uint8_t TAG = 5;
+
+// A "frame" of len bytes: the letter repeated, so misplaced bytes show up
+static std::string frame(size_t len, char letter) {
+    return std::string(len, letter);
+}
+
+static bool push(McpSendQueue &queue, const std::string &bytes, uint8_t tag = TAG) {
+    return queue.push(tag, (const uint8_t *)bytes.data(), bytes.size());
+}
+
+static bool pushControl(McpSendQueue &queue, const std::string &bytes) {
+    return queue.pushControl((const uint8_t *)bytes.data(), bytes.size());
+}
+
+// flush() until the queue is empty; everything written so far
+static std::string drain(McpSendQueue &queue, LoopbackClient &client, uint8_t tag = TAG) {
+    for (int i = 0; i < 10000 && queue.flush(client, tag) != McpSendQueue::IDLE; i++) {
+    }
+    return std::string(client.tx().begin(), client.tx().end());
+}
+
+struct QueueFixture {
+    LoopbackClient client;
+    McpSendQueue queue;
+
+    QueueFixture() {
+        client.setConnected(true);
+        MCP_CHECK(queue.begin(16384));
+    }
+};
+
+MCP_TEST(SendQueue_ControlFramesGoFirstInOneWrite) {
+    QueueFixture f;
+    std::string a = frame(40, 'a'), b = frame(60, 'b'), ping = frame(6, 'P'), pong = frame(8, 'Q');
+    MCP_CHECK(push(f.queue, a));
+    MCP_CHECK(push(f.queue, b));
+    MCP_CHECK(pushControl(f.queue, ping));
+    MCP_CHECK(pushControl(f.queue, pong));
+    MCP_CHECK(!f.queue.idle());
+
+    MCP_CHECK_EQ(McpSendQueue::IDLE, f.queue.flush(f.client, TAG));
+    MCP_CHECK_EQ(ping + pong + a + b, std::string(f.client.tx().begin(), f.client.tx().end()));
+    // Coalesced into one write()
+    MCP_CHECK_EQ((size_t)1, f.client.writeCalls());
+    MCP_CHECK_EQ(4u, f.queue.stats().framesOut);
+    MCP_CHECK(f.queue.idle());
+
+    // The slots are few and control frames short
+    for (int i = 0; i < MCP_TX_CONTROL_SLOTS; i++) {
+        MCP_CHECK(pushControl(f.queue, ping));
+    }
+    MCP_CHECK(!pushControl(f.queue, ping));
+    f.queue.clear();
+    MCP_CHECK(!pushControl(f.queue, frame(200, 'x')));
+}
+
+MCP_TEST(SendQueue_PartialFrameFinishedBeforeControl) {
+    QueueFixture f;
+    f.client.setWriteLimit(7);
+    std::string a = frame(30, 'a'), big = frame(3000, 'L'), ping = frame(6, 'P');
+
+    // Coalesced frames part-way out: a control frame waits for them
+    MCP_CHECK(push(f.queue, a));
+    MCP_CHECK_EQ(McpSendQueue::PENDING, f.queue.flush(f.client, TAG));
+    MCP_CHECK(pushControl(f.queue, ping));
+    MCP_CHECK_EQ(a + ping, drain(f.queue, f.client));
+
+    // Likewise a large frame being written in place
+    f.client.clearTx();
+    MCP_CHECK(push(f.queue, big));
+    MCP_CHECK_EQ(McpSendQueue::PENDING, f.queue.flush(f.client, TAG));
+    MCP_CHECK(pushControl(f.queue, ping));
+    MCP_CHECK(push(f.queue, a));
+    MCP_CHECK_EQ(big + ping + a, drain(f.queue, f.client));
+}
+
+MCP_TEST(SendQueue_WriteRestFollowsItsHead) {
+    QueueFixture f;
+    f.client.setWriteLimit(100);
+    std::string direct = frame(350, 'w'), ping = frame(6, 'P'), later = frame(20, 'd');
+
+    // write() hands what the socket did not take to the queue
+    MCP_CHECK(f.queue.idle());
+    MCP_CHECK(f.queue.write(f.client, TAG, (const uint8_t *)direct.data(), direct.size()));
+    MCP_CHECK_EQ((size_t)100, f.client.tx().size());
+    MCP_CHECK(!f.queue.idle());
+
+    // Neither control nor data frames may cut into it
+    MCP_CHECK(pushControl(f.queue, ping));
+    MCP_CHECK(push(f.queue, later));
+    MCP_CHECK_EQ(direct + ping + later, drain(f.queue, f.client));
+    MCP_CHECK_EQ(3u, f.queue.stats().framesOut);
+}
+
+MCP_TEST(SendQueue_LargeFramesWrittenInPlace) {
+    QueueFixture f;
+    std::string s1 = frame(100, 's'), s2 = frame(200, 't'), big = frame(6000, 'L'), s3 = frame(50, 'u');
+    MCP_CHECK(push(f.queue, s1));
+    MCP_CHECK(push(f.queue, s2));
+    MCP_CHECK(push(f.queue, big));
+    MCP_CHECK(push(f.queue, s3));
+
+    MCP_CHECK_EQ(McpSendQueue::IDLE, f.queue.flush(f.client, TAG));
+    MCP_CHECK_EQ(s1 + s2 + big + s3, std::string(f.client.tx().begin(), f.client.tx().end()));
+    // s1 + s2, big in MCP_TX_CHUNK_SIZE pieces straight from the queue, then s3
+    size_t bigWrites = (big.size() + MCP_TX_CHUNK_SIZE - 1) / MCP_TX_CHUNK_SIZE;
+    MCP_CHECK_EQ(2 + bigWrites, f.client.writeCalls());
+    MCP_CHECK_EQ((uint64_t)(s1.size() + s2.size() + big.size() + s3.size()), f.queue.stats().bytesOut);
+
+    // A frame the queue cannot hold is refused and counted
+    MCP_CHECK(!push(f.queue, frame(2 * f.queue.maxFrame(), 'x')));
+    MCP_CHECK_EQ(1u, f.queue.stats().full);
+}
+
+MCP_TEST(SendQueue_EarlierConnectionFramesDropped) {
+    QueueFixture f;
+    uint8_t oldTag = McpSendQueue::tagFor(4), newTag = McpSendQueue::tagFor(5);
+    std::string stale = frame(30, 'o'), fresh = frame(30, 'n');
+    MCP_CHECK(push(f.queue, stale, oldTag));
+    MCP_CHECK(push(f.queue, fresh, newTag));
+    MCP_CHECK(push(f.queue, stale, oldTag));
+    MCP_CHECK_EQ(fresh, drain(f.queue, f.client, newTag));
+    MCP_CHECK_EQ(1u, f.queue.stats().framesOut);
+
+    // The rest of a frame write() started on the old connection goes too
+    f.client.clearTx();
+    f.client.setWriteLimit(10);
+    MCP_CHECK(f.queue.write(f.client, oldTag, (const uint8_t *)stale.data(), stale.size()));
+    f.client.clearTx();
+    MCP_CHECK(push(f.queue, fresh, newTag));
+    MCP_CHECK_EQ(fresh, drain(f.queue, f.client, newTag));
+    MCP_CHECK(f.queue.idle());
+}
+
+MCP_TEST(SendQueue_StalledAfterTimeout) {
+    QueueFixture f;
+    MCP_CHECK(push(f.queue, frame(40, 'a')));
+    // A disconnected LoopbackClient takes nothing
+    f.client.setConnected(false);
+    MCP_CHECK_EQ(McpSendQueue::PENDING, f.queue.flush(f.client, TAG));
+    MCP_CHECK_EQ(1u, f.queue.stats().stalls);
+    hostAdvanceMillis(MCP_TX_STALL_TIMEOUT_MS / 2);
+    MCP_CHECK_EQ(McpSendQueue::PENDING, f.queue.flush(f.client, TAG));
+    MCP_CHECK_EQ(1u, f.queue.stats().stalls);
+    hostAdvanceMillis(MCP_TX_STALL_TIMEOUT_MS / 2 + 1);
+    MCP_CHECK_EQ(McpSendQueue::STALLED, f.queue.flush(f.client, TAG));
+
+    // Once the socket takes data again the wait ends and is accounted for
+    f.client.setConnected(true);
+    MCP_CHECK_EQ(McpSendQueue::IDLE, f.queue.flush(f.client, TAG));
+    MCP_CHECK(f.queue.stats().stallMs > MCP_TX_STALL_TIMEOUT_MS);
+    MCP_CHECK_EQ(frame(40, 'a'), std::string(f.client.tx().begin(), f.client.tx().end()));
+}
@@ -0,0 +1,176 @@
+// McpSpscRing: records wrapping at the end of the buffer, the exact fit that
+// would make a full ring look empty, maxRecord(), zero-length records, and a
+// producer and consumer on two threads.
+
+#include "Test.h"
+
+#include <McpSpscRing.h>
+
+#include <string.h>
+#include <thread>
+
+// Move an empty ring's position on by count 4-byte (header only) records
+static void advance(McpSpscRing &ring, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        ring.push(1, nullptr, 0);
+        size_t len;
+        uint8_t type;
+        ring.peek(len, type);
+        ring.pop();
+    }
+}
+
+static bool pushText(McpSpscRing &ring, uint8_t type, const char *text) {
+    return ring.push(type, (const uint8_t *)text, strlen(text));
+}
+
+static bool popText(McpSpscRing &ring, uint8_t type, const char *text) {
+    size_t len;
+    uint8_t gotType;
+    const uint8_t *data = ring.peek(len, gotType);
+    bool ok = data && gotType == type && len == strlen(text) && memcmp(data, text, len) == 0;
+    if (data) {
+        ring.pop();
+    }
+    return ok;
+}
+
+MCP_TEST(SpscRing_RecordsInOrderIncludingEmptyOnes) {
+    McpSpscRing ring;
+    MCP_CHECK(ring.begin(62));
+    MCP_CHECK_EQ((size_t)64, ring.capacity());
+    MCP_CHECK(ring.empty());
+
+    size_t len;
+    uint8_t type;
+    MCP_CHECK(ring.peek(len, type) == nullptr);
+
+    MCP_CHECK(pushText(ring, 1, "abc"));
+    MCP_CHECK(ring.push(2, nullptr, 0));
+    MCP_CHECK(pushText(ring, 3, "defgh"));
+    // Headers and padding: 4 + 4, 4, 4 + 8
+    MCP_CHECK_EQ((size_t)24, ring.used());
+
+    MCP_CHECK(popText(ring, 1, "abc"));
+    MCP_CHECK(ring.peek(len, type) != nullptr);
+    MCP_CHECK_EQ((size_t)0, len);
+    MCP_CHECK_EQ(2, type);
+    ring.pop();
+    MCP_CHECK(popText(ring, 3, "defgh"));
+    MCP_CHECK(ring.empty());
+}
+
+MCP_TEST(SpscRing_WrapsAtEndOfBuffer) {
+    McpSpscRing ring;
+    MCP_CHECK(ring.begin(64));
+    uint8_t *start = ring.reserve(0) - 4; // the buffer itself
+
+    // Head at 40, tail at 32: a 24-byte record (28 with its header) does not fit before the end
+    advance(ring, 8);
+    MCP_CHECK(pushText(ring, 1, "abc"));
+    MCP_CHECK_EQ(start + 4, ring.reserve(24));
+    MCP_CHECK(pushText(ring, 2, "0123456789abcdef01234567"));
+
+    // The wrap marker is skipped and the payload comes back in one piece from offset 0
+    MCP_CHECK(popText(ring, 1, "abc"));
+    size_t len;
+    uint8_t type;
+    MCP_CHECK_EQ((const uint8_t *)start + 4, ring.peek(len, type));
+    MCP_CHECK(popText(ring, 2, "0123456789abcdef01234567"));
+    MCP_CHECK(ring.empty());
+
+    // Not wrapped while the tail still holds offset 0
+    McpSpscRing full;
+    MCP_CHECK(full.begin(64));
+    MCP_CHECK(pushText(full, 1, "0123456789abcdef0123456789abcdef0123456789ab")); // 48 bytes
+    MCP_CHECK(full.reserve(20) == nullptr);
+    MCP_CHECK(full.reserve(8) != nullptr);
+}
+
+MCP_TEST(SpscRing_ExactFitAtEndNeedsTailMoved) {
+    McpSpscRing ring;
+    MCP_CHECK(ring.begin(64));
+    // A 48-byte record at 0, then 16 bytes would end exactly at the buffer end:
+    // the head would come back to 0 == tail and the full ring would look empty
+    MCP_CHECK(pushText(ring, 1, "0123456789abcdef0123456789abcdef0123456789ab"));
+    MCP_CHECK(ring.reserve(12) == nullptr);
+    MCP_CHECK(!pushText(ring, 2, "twelve bytes"));
+
+    // With the tail moved on the same record fits, and the head wraps to 0
+    MCP_CHECK(popText(ring, 1, "0123456789abcdef0123456789abcdef0123456789ab"));
+    MCP_CHECK(pushText(ring, 2, "twelve bytes"));
+    MCP_CHECK(!ring.empty());
+    MCP_CHECK_EQ((size_t)16, ring.used());
+    MCP_CHECK(pushText(ring, 3, "after"));
+    MCP_CHECK(popText(ring, 2, "twelve bytes"));
+    MCP_CHECK(popText(ring, 3, "after"));
+    MCP_CHECK(ring.empty());
+}
+
+MCP_TEST(SpscRing_MaxRecordFitsAtEveryPosition) {
+    const size_t capacities[] = {32, 64, 100, 1024};
+    for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+        McpSpscRing ring;
+        MCP_CHECK(ring.begin(capacities[c]));
+        size_t max = ring.maxRecord();
+        MCP_CHECK(max > 0 && max < ring.capacity() / 2);
+        for (size_t pos = 0; pos < ring.capacity() / 4; pos++) {
+            MCP_CHECK(ring.reserve(max) != nullptr);
+            advance(ring, 1);
+        }
+        // Never the whole buffer
+        MCP_CHECK(ring.reserve(ring.capacity() - 4) == nullptr);
+    }
+
+    // Half the buffer does not fit when the ring sits in the middle
+    McpSpscRing ring;
+    MCP_CHECK(ring.begin(64));
+    advance(ring, 8);
+    MCP_CHECK(ring.reserve(32) == nullptr);
+
+    // Too small for any record, and lengths beyond the 24-bit header field
+    McpSpscRing tiny;
+    MCP_CHECK(tiny.begin(12));
+    MCP_CHECK_EQ((size_t)0, tiny.maxRecord());
+    MCP_CHECK(ring.reserve(0x1000000) == nullptr);
+}
+
+MCP_TEST(SpscRing_ProducerAndConsumerThreads) {
+    McpSpscRing ring;
+    MCP_CHECK(ring.begin(256));
+    const uint32_t records = 200000;
+    const size_t maxLen = ring.maxRecord();
+
+    // Record n has length n % (maxLen + 1) and bytes derived from n
+    std::thread producer([&] {
+        uint8_t data[256];
+        for (uint32_t n = 0; n < records; n++) {
+            size_t len = n % (maxLen + 1);
+            for (size_t i = 0; i < len; i++) {
+                data[i] = (uint8_t)(n + i);
+            }
+            while (!ring.push((uint8_t)(n % 200), data, len)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t bad = 0;
+    for (uint32_t n = 0; n < records; n++) {
+        size_t len;
+        uint8_t type;
+        const uint8_t *data;
+        while ((data = ring.peek(len, type)) == nullptr) {
+            std::this_thread::yield();
+        }
+        bool ok = type == (uint8_t)(n % 200) && len == n % (maxLen + 1);
+        for (size_t i = 0; ok && i < len; i++) {
+            ok = data[i] == (uint8_t)(n + i);
+        }
+        bad += ok ? 0 : 1;
+        ring.pop();
+    }
+    producer.join();
+    MCP_CHECK_EQ(0u, bad);
+    MCP_CHECK(ring.empty());
+}
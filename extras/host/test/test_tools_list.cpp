@@ -0,0 +1,76 @@
+// The cached tools/list array (McpToolRegistry::listJson): reused while the
+// registry is unchanged, rebuilt after every registration change.
+
+#include "Test.h"
+#include "AllocHook.h"
+#include "McpFixture.h"
+
+#include <string>
+
+static std::string listOf(WebSocketMCP &mcp) {
+    return WebSocketMCPHostAccess::toolsListJson(mcp).c_str();
+}
+
+static bool listed(WebSocketMCP &mcp, const char *name) {
+    return listOf(mcp).find(std::string("{\"name\":\"") + name + "\"") != std::string::npos;
+}
+
+MCP_TEST(ToolsList_ReusedWhileUnchanged) {
+    McpFixture f;
+    f.registerSampleTools(4);
+    std::string first = listOf(f.mcp);
+    MCP_CHECK(listed(f.mcp, "led_blink"));
+    MCP_CHECK(listed(f.mcp, "relay_3"));
+
+    AllocStats before = allocSnapshot();
+    const String &cached = WebSocketMCPHostAccess::toolsListJson(f.mcp);
+    MCP_CHECK_EQ(before.count, allocSnapshot().count);
+    MCP_CHECK_EQ(first, std::string(cached.c_str()));
+
+    // Registering an existing name only swaps its callback: the list stays
+    f.mcp.registerTool("relay_1", "Another description", "{}",
+                       [](JsonObjectConst) { return ToolResponse("{}"); });
+    MCP_CHECK_EQ(first, listOf(f.mcp));
+    MCP_CHECK(listOf(f.mcp).find("Another description") == std::string::npos);
+}
+
+MCP_TEST(ToolsList_RebuiltAfterChanges) {
+    McpFixture f;
+    f.registerSampleTools(3);
+
+    f.mcp.registerTool("extra", "Added later", "{\"type\":\"object\"}",
+                       [](JsonObjectConst) { return ToolResponse("{}"); });
+    MCP_CHECK(listed(f.mcp, "extra"));
+    // Registration order is kept
+    MCP_CHECK(listOf(f.mcp).find("relay_2") < listOf(f.mcp).find("extra"));
+
+    MCP_CHECK(f.mcp.unregisterTool("relay_1"));
+    MCP_CHECK(!listed(f.mcp, "relay_1"));
+    MCP_CHECK(listed(f.mcp, "relay_2"));
+
+    f.mcp.clearTools();
+    MCP_CHECK_EQ(std::string(), listOf(f.mcp));
+    f.mcp.registerTool("again", "Back", "{}", [](JsonObjectConst) { return ToolResponse("{}"); });
+    MCP_CHECK_EQ(std::string("{\"name\":\"again\",\"description\":\"Back\",\"inputSchema\":{}}"), listOf(f.mcp));
+}
+
+MCP_TEST(ToolsList_ReplyCarriesCurrentList) {
+    McpFixture f;
+    f.client.setTxCapture(true);
+    f.mcp.registerTool("one", "First", "{}", [](JsonObjectConst) { return ToolResponse("{}"); });
+
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, MCP_REQ_TOOLS_LIST, strlen(MCP_REQ_TOOLS_LIST));
+    f.mcp.registerTool("two", "Second", "{}", [](JsonObjectConst) { return ToolResponse("{}"); });
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, MCP_REQ_TOOLS_LIST, strlen(MCP_REQ_TOOLS_LIST));
+    WebSocketMCPHostAccess::flushSendQueue(f.mcp);
+
+    std::vector<std::string> replies = f.client.takeTxPayloads();
+    MCP_CHECK_EQ((size_t)2, replies.size());
+    if (replies.size() != 2) {
+        return;
+    }
+    MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":3,\"result\":{\"tools\":["
+                             "{\"name\":\"one\",\"description\":\"First\",\"inputSchema\":{}}]}}"),
+                 replies[0]);
+    MCP_CHECK(replies[1].find("{\"name\":\"two\"") != std::string::npos);
+}
@@ -0,0 +1,156 @@
+// Typed tool declarations (McpTypedTool): schema generation, extraction into the
+// arguments struct and argument validation; ToolParams defaults and parsing.
+
+#include "Test.h"
+#include "AllocHook.h"
+#include "McpFixture.h"
+
+#include <string>
+
+struct BlinkArgs {
+    const char *state = "on";
+    int times = 3;
+    float period = 0.5f;
+    bool fast = false;
+};
+
+static constexpr McpToolParam BLINK_PARAMS[] = {
+    MCP_TOOL_PARAM(BlinkArgs, state, "LED state").oneOf("on|off|blink").required(),
+    MCP_TOOL_PARAM(BlinkArgs, times, "How often to blink").range(1, 10),
+    MCP_TOOL_PARAM(BlinkArgs, period, "Seconds per blink").range(0.1, 2),
+    MCP_TOOL_PARAM(BlinkArgs, fast, "Blink \"fast\""),
+};
+
+struct BlinkFixture : McpFixture {
+    BlinkArgs last;
+    int calls = 0;
+
+    BlinkFixture() {
+        client.setTxCapture(true);
+        mcp.registerTypedTool<BlinkArgs>("led_blink", "Control the LED", BLINK_PARAMS,
+                                         [this](const BlinkArgs &args, McpToolResult &result) {
+                                             last = args;
+                                             calls++;
+                                             result.print("{\"success\":true}");
+                                         });
+    }
+
+    // The reply to a tools/invoke of led_blink with these arguments
+    std::string invoke(const char *arguments) {
+        std::string request = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/invoke\",\"params\":"
+                              "{\"tool_name\":\"led_blink\",\"arguments\":";
+        request += arguments;
+        request += "}}";
+        WebSocketMCPHostAccess::handleJsonRpcMessage(mcp, request.c_str(), request.size());
+        WebSocketMCPHostAccess::flushSendQueue(mcp);
+        std::vector<std::string> replies = client.takeTxPayloads();
+        return replies.size() == 1 ? replies[0] : std::string();
+    }
+};
+
+MCP_TEST(TypedTool_SchemaFromDeclaration) {
+    BlinkFixture f;
+    std::string list = WebSocketMCPHostAccess::toolsListJson(f.mcp).c_str();
+    MCP_CHECK_EQ(std::string("{\"name\":\"led_blink\",\"description\":\"Control the LED\",\"inputSchema\":"
+                             "{\"type\":\"object\",\"properties\":{"
+                             "\"state\":{\"type\":\"string\",\"description\":\"LED state\",\"enum\":[\"on\",\"off\",\"blink\"]},"
+                             "\"times\":{\"type\":\"integer\",\"description\":\"How often to blink\",\"minimum\":1,\"maximum\":10},"
+                             "\"period\":{\"type\":\"number\",\"description\":\"Seconds per blink\",\"minimum\":0.1,\"maximum\":2},"
+                             "\"fast\":{\"type\":\"boolean\",\"description\":\"Blink \\\"fast\\\"\"}},"
+                             "\"required\":[\"state\"]}}"),
+                 list);
+}
+
+MCP_TEST(TypedTool_ArgumentsExtractedIntoStruct) {
+    BlinkFixture f;
+    std::string reply = f.invoke("{\"fast\":true,\"state\":\"blink\",\"times\":0,\"unknown\":1}");
+    // times is out of range: 0 is a value, not "missing"
+    MCP_CHECK(reply.find("\"isError\":true") != std::string::npos);
+    MCP_CHECK(reply.find("invalid argument\\\",\\\"argument\\\":\\\"times") != std::string::npos);
+    MCP_CHECK_EQ(0, f.calls);
+
+    reply = f.invoke("{\"fast\":false,\"state\":\"blink\",\"times\":7,\"unknown\":1}");
+    MCP_CHECK(reply.find("\"isError\":false") != std::string::npos);
+    MCP_CHECK_EQ(1, f.calls);
+    MCP_CHECK_EQ(std::string("blink"), std::string(f.last.state));
+    MCP_CHECK_EQ(7, f.last.times);
+    MCP_CHECK(!f.last.fast);
+    MCP_CHECK(f.last.period == 0.5f); // left out: the struct's default
+
+    reply = f.invoke("{\"state\":\"off\",\"period\":1}");
+    MCP_CHECK_EQ(2, f.calls);
+    MCP_CHECK(f.last.period == 1.0f); // an integer is a number too
+    MCP_CHECK_EQ(3, f.last.times);
+}
+
+MCP_TEST(TypedTool_InvalidArgumentsRejected) {
+    BlinkFixture f;
+    const char *invalid[] = {
+        "{}",                              // state is required
+        "{\"state\":\"dim\"}",             // not in the enum
+        "{\"state\":1}",                   // wrong type
+        "{\"state\":\"on\",\"times\":2.5}", // not an integer
+        "{\"state\":\"on\",\"fast\":1}",    // not a boolean
+        "{\"state\":\"on\",\"period\":5}",  // out of range
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        std::string reply = f.invoke(invalid[i]);
+        MCP_CHECK(reply.find("\"isError\":true") != std::string::npos);
+    }
+    MCP_CHECK(f.invoke("{}").find("missing argument\\\",\\\"argument\\\":\\\"state") != std::string::npos);
+    MCP_CHECK_EQ(0, f.calls);
+}
+
+MCP_TEST(TypedTool_NoAllocationPerCall) {
+    BlinkFixture f;
+    f.client.setTxCapture(false);
+    const char *request = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/invoke\",\"params\":"
+                          "{\"tool_name\":\"led_blink\",\"arguments\":{\"state\":\"on\",\"times\":2}}}";
+    for (int i = 0; i < 3; i++) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, request, strlen(request));
+    }
+    AllocStats before = allocSnapshot();
+    WebSocketMCPHostAccess::handleJsonRpcMessage(f.mcp, request, strlen(request));
+    MCP_CHECK_EQ(before.count, allocSnapshot().count);
+    MCP_CHECK_EQ(4, f.calls);
+}
+
+MCP_TEST(ToolParams_ZeroAndFalseAreValues) {
+    StaticJsonDocument<256> doc;
+    deserializeJson(doc, "{\"count\":0,\"on\":false,\"level\":0.0,\"name\":\"x\"}");
+    ToolParams params(doc.as<JsonObjectConst>());
+    MCP_CHECK_EQ(0, params.getInt("count", 5));
+    MCP_CHECK(!params.getBool("on", true));
+    MCP_CHECK(params.getFloat("level", 1.5f) == 0.0f);
+    // Missing or of another type: the default
+    MCP_CHECK_EQ(5, params.getInt("missing", 5));
+    MCP_CHECK_EQ(5, params.getInt("name", 5));
+    MCP_CHECK(params.getBool("missing", true));
+    MCP_CHECK(params.getFloat("missing", 1.5f) == 1.5f);
+}
+
+MCP_TEST(ToolParams_ParsedFromString) {
+    ToolParams params(String("{\"count\":2,\"name\":\"x\"}"));
+    MCP_CHECK(params.isValid());
+    MCP_CHECK_EQ(2, params.getInt("count", 5));
+
+    // Not JSON, or not an object: invalid, and every getter gives its default
+    ToolParams broken(String("{\"count\":"));
+    MCP_CHECK(!broken.isValid());
+    MCP_CHECK_EQ(5, broken.getInt("count", 5));
+    MCP_CHECK(!ToolParams(String("[1,2]")).isValid());
+}
+
+MCP_TEST(TypedTool_SchemaNamesAndEnumValuesEscaped) {
+    struct Args {
+        const char *mode;
+    };
+    const McpToolParam params[] = {
+        McpToolParam("mo\"de", "Mode", MCP_PARAM_STRING, offsetof(Args, mode)).oneOf("a\"b|c\\d|\x01").required(),
+    };
+    MCP_CHECK_EQ(std::string("{\"type\":\"object\",\"properties\":{"
+                             "\"mo\\\"de\":{\"type\":\"string\",\"description\":\"Mode\","
+                             "\"enum\":[\"a\\\"b\",\"c\\\\d\",\"\\u0001\"]}},"
+                             "\"required\":[\"mo\\\"de\"]}"),
+                 std::string(McpTypedTool::schema(params, 1).c_str()));
+}
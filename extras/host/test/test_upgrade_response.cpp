@@ -0,0 +1,368 @@
+// HTTP upgrade response parsing (WsUpgradeResponse) and the handshake built on it,
+// including malformed and hostile responses.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <WsUpgradeResponse.h>
+
+#include <string>
+
+#include "mbedtls/base64.h"
+#include "mbedtls/sha1.h"
+
+static const char *const RESPONSE =
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+    "\r\n";
+
+static WsUpgradeResponse::Result feedAll(WsUpgradeResponse &r, const std::string &text, size_t &consumed) {
+    return r.feed((const uint8_t *)text.data(), text.size(), consumed);
+}
+
+// Same input one byte per call
+static WsUpgradeResponse::Result feedBytewise(WsUpgradeResponse &r, const std::string &text, size_t &consumed) {
+    consumed = 0;
+    WsUpgradeResponse::Result result = WsUpgradeResponse::NEED_MORE;
+    for (size_t i = 0; i < text.size() && result == WsUpgradeResponse::NEED_MORE; i++) {
+        size_t used = 0;
+        result = r.feed((const uint8_t *)text.data() + i, 1, used);
+        consumed += used;
+    }
+    return result;
+}
+
+static WsUpgradeResponse::Error parseError(const std::string &text) {
+    WsUpgradeResponse r;
+    size_t consumed;
+    feedAll(r, text, consumed);
+    return r.error();
+}
+
+MCP_TEST(UpgradeResponse_ParsesStatusAndHeaders) {
+    WsUpgradeResponse r;
+    size_t consumed = 0;
+    MCP_CHECK_EQ(WsUpgradeResponse::COMPLETE, feedAll(r, RESPONSE, consumed));
+    MCP_CHECK_EQ(strlen(RESPONSE), consumed);
+    MCP_CHECK_EQ(101, r.status());
+    MCP_CHECK_EQ((size_t)3, r.headerCount());
+    MCP_CHECK(strcmp(r.header("Sec-WebSocket-Accept"), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+    MCP_CHECK(r.header("Sec-WebSocket-Protocol") == nullptr);
+}
+
+MCP_TEST(UpgradeResponse_NamesAnyCaseValuesTrimmed) {
+    WsUpgradeResponse r;
+    size_t consumed;
+    feedAll(r, "HTTP/1.1 101\r\nUPGRADE:\t WebSocket \t\r\nx-empty:\r\n\r\n", consumed);
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_NONE, r.error());
+    MCP_CHECK(r.header("upgrade") != nullptr && strcmp(r.header("upgrade"), "WebSocket") == 0);
+    MCP_CHECK(r.header("X-Empty") != nullptr && r.header("X-Empty")[0] == '\0');
+}
+
+MCP_TEST(UpgradeResponse_BareLineFeeds) {
+    WsUpgradeResponse r;
+    size_t consumed;
+    MCP_CHECK_EQ(WsUpgradeResponse::COMPLETE, feedAll(r, "HTTP/1.1 101 OK\nUpgrade: websocket\n\n", consumed));
+    MCP_CHECK(strcmp(r.header("Upgrade"), "websocket") == 0);
+}
+
+MCP_TEST(UpgradeResponse_ByteAtATimeMatchesBulk) {
+    WsUpgradeResponse r;
+    size_t consumed = 0;
+    MCP_CHECK_EQ(WsUpgradeResponse::COMPLETE, feedBytewise(r, RESPONSE, consumed));
+    MCP_CHECK_EQ(strlen(RESPONSE), consumed);
+    MCP_CHECK_EQ((size_t)3, r.headerCount());
+}
+
+MCP_TEST(UpgradeResponse_StopsAtEmptyLine) {
+    std::string text = std::string(RESPONSE) + "\x81\x02hi";
+    WsUpgradeResponse r;
+    size_t consumed = 0;
+    MCP_CHECK_EQ(WsUpgradeResponse::COMPLETE, feedAll(r, text, consumed));
+    MCP_CHECK_EQ(strlen(RESPONSE), consumed);
+    MCP_CHECK_EQ((size_t)0, r.pendingLength());
+}
+
+MCP_TEST(UpgradeResponse_ReadFromKeepsFrameBytesPending) {
+    LoopbackClient client;
+    client.setConnected(true);
+    client.pushRx(std::string(RESPONSE).append("\x81\x02hi").c_str(), strlen(RESPONSE) + 4);
+    WsUpgradeResponse r;
+    MCP_CHECK_EQ(WsUpgradeResponse::COMPLETE, r.readFrom(client));
+    MCP_CHECK_EQ((size_t)4, r.pendingLength());
+    MCP_CHECK(memcmp(r.pending(), "\x81\x02hi", 4) == 0);
+    r.consumePending(4);
+    MCP_CHECK_EQ((size_t)0, r.pendingLength());
+}
+
+MCP_TEST(UpgradeResponse_RejectsBadStatusLines) {
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_STATUS_LINE, parseError("\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_STATUS_LINE, parseError("HTTP/2 101\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_STATUS_LINE, parseError("HTTP/1.1 10\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_STATUS_LINE, parseError("HTTP/1.1 1O1 Switching\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_STATUS_LINE, parseError("HTTP/1.1 1011\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_STATUS_LINE, parseError("SSH-2.0-OpenSSH_8.9\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_NONE, parseError("HTTP/1.0 400 Bad Request\r\n\r\n"));
+}
+
+MCP_TEST(UpgradeResponse_RejectsBadHeaderLines) {
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_HEADER_LINE, parseError("HTTP/1.1 101\r\nno colon here\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_HEADER_LINE, parseError("HTTP/1.1 101\r\n: empty name\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_HEADER_LINE, parseError("HTTP/1.1 101\r\nBad Name: x\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_HEADER_LINE, parseError("HTTP/1.1 101\r\nUpgrade : websocket\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_HEADER_LINE, parseError("HTTP/1.1 101\r\nA: b\r\n folded\r\n\r\n"));
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_HEADER_LINE, parseError(std::string("HTTP/1.1 101\r\nA\0B: c\r\n\r\n", 25)));
+}
+
+MCP_TEST(UpgradeResponse_BoundedSize) {
+    // Headers that never end stop at the buffer size instead of growing
+    std::string text = "HTTP/1.1 101\r\n";
+    while (text.size() < MCP_HTTP_RESPONSE_MAX_SIZE * 4) {
+        text += "X-Filler: aaaaaaaaaaaaaaaa\r\n";
+    }
+    WsUpgradeResponse r;
+    size_t consumed = 0;
+    MCP_CHECK_EQ(WsUpgradeResponse::ERROR, feedAll(r, text, consumed));
+    MCP_CHECK(r.error() == WsUpgradeResponse::ERR_TOO_LARGE || r.error() == WsUpgradeResponse::ERR_TOO_MANY_HEADERS);
+    MCP_CHECK(consumed <= (size_t)MCP_HTTP_RESPONSE_MAX_SIZE);
+
+    std::string line(MCP_HTTP_RESPONSE_MAX_SIZE * 2, 'a');
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_TOO_LARGE, parseError("HTTP/1.1 101\r\nX: " + line + "\r\n\r\n"));
+
+    // Exactly at the limit still fits
+    std::string fit = "HTTP/1.1 101\r\nX: ";
+    fit += std::string(MCP_HTTP_RESPONSE_MAX_SIZE - fit.size() - 4, 'b');
+    fit += "\r\n\r\n";
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_NONE, parseError(fit));
+}
+
+MCP_TEST(UpgradeResponse_TooManyHeaders) {
+    std::string text = "HTTP/1.1 101\r\n";
+    for (int i = 0; i <= MCP_HTTP_MAX_HEADERS; i++) {
+        text += "A: b\r\n";
+    }
+    text += "\r\n";
+    MCP_CHECK_EQ(WsUpgradeResponse::ERR_TOO_MANY_HEADERS, parseError(text));
+}
+
+MCP_TEST(UpgradeResponse_ErrorIsSticky) {
+    WsUpgradeResponse r;
+    size_t consumed;
+    feedAll(r, "HTTP/9\r\n", consumed);
+    MCP_CHECK_EQ(WsUpgradeResponse::ERROR, feedAll(r, RESPONSE, consumed));
+    MCP_CHECK_EQ((size_t)0, consumed);
+    r.reset();
+    MCP_CHECK_EQ(WsUpgradeResponse::COMPLETE, feedAll(r, RESPONSE, consumed));
+}
+
+MCP_TEST(UpgradeResponse_RandomInputNeverOverruns) {
+    // Garbage, and valid responses cut at random points, must end in a defined state
+    randomSeed(12345);
+    for (int round = 0; round < 2000; round++) {
+        std::string text;
+        if (round % 2) {
+            size_t len = random(2 * MCP_HTTP_RESPONSE_MAX_SIZE);
+            for (size_t i = 0; i < len; i++) {
+                static const char alphabet[] = "HTP/1.0 :\r\n\tab";
+                text += (round % 4 == 1) ? (char)random(256) : alphabet[random(sizeof(alphabet) - 1)];
+            }
+        } else {
+            text = RESPONSE;
+            text.resize(random(text.size() + 1));
+        }
+        WsUpgradeResponse bulk;
+        WsUpgradeResponse bytewise;
+        size_t bulkUsed;
+        size_t bytewiseUsed;
+        WsUpgradeResponse::Result a = feedAll(bulk, text, bulkUsed);
+        WsUpgradeResponse::Result b = feedBytewise(bytewise, text, bytewiseUsed);
+        MCP_CHECK(bulkUsed <= text.size());
+        if (a != WsUpgradeResponse::ERROR || bulk.error() != WsUpgradeResponse::ERR_TOO_LARGE) {
+            // Byte-wise feeding sees the same lines (only the size limit may trip at another point)
+            MCP_CHECK_EQ(a, b);
+        }
+        if (a == WsUpgradeResponse::COMPLETE) {
+            MCP_CHECK_EQ(bulk.headerCount(), bytewise.headerCount());
+        }
+    }
+}
+
+MCP_TEST(UpgradeResponse_HasToken) {
+    MCP_CHECK(WsUpgradeResponse::hasToken("Upgrade", "upgrade"));
+    MCP_CHECK(WsUpgradeResponse::hasToken("keep-alive, Upgrade", "upgrade"));
+    MCP_CHECK(WsUpgradeResponse::hasToken(" a ,b,  UPGRADE  ", "upgrade"));
+    MCP_CHECK(!WsUpgradeResponse::hasToken("upgrades", "upgrade"));
+    MCP_CHECK(!WsUpgradeResponse::hasToken("", "upgrade"));
+    MCP_CHECK(!WsUpgradeResponse::hasToken(",,", "upgrade"));
+}
+
+// --- Handshake through WebSocketMCP ---
+
+// Answers the upgrade request with a valid 101 plus extra headers and bytes.
+class UpgradeServer : public LoopbackClient {
+public:
+    std::string extraHeaders;
+    std::string afterResponse;
+    std::string request;
+
+    size_t write(const uint8_t *buf, size_t size) override {
+        if (!connected()) {
+            return 0;
+        }
+        if (!_answered) {
+            _pending.append((const char *)buf, size);
+            if (_pending.find("\r\n\r\n") != std::string::npos) {
+                request = _pending;
+                answer();
+            }
+            return size;
+        }
+        return LoopbackClient::write(buf, size);
+    }
+
+private:
+    void answer() {
+        _answered = true;
+        size_t key = request.find("Sec-WebSocket-Key: ");
+        std::string combined = request.substr(key + 19, 24) + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        uint8_t hash[20];
+        mbedtls_sha1((const unsigned char *)combined.data(), combined.size(), hash);
+        char accept[32];
+        size_t len;
+        mbedtls_base64_encode((unsigned char *)accept, sizeof(accept), &len, hash, sizeof(hash));
+        accept[len] = '\0';
+        std::string response = "HTTP/1.1 101 Switching Protocols\r\nupgrade: WebSocket\r\n"
+                               "connection: keep-alive, Upgrade\r\nsec-websocket-accept:  ";
+        response += accept;
+        response += "\r\n" + extraHeaders + "\r\n" + afterResponse;
+        pushRx(response.data(), response.size());
+    }
+
+    bool _answered = false;
+    std::string _pending;
+};
+
+MCP_TEST(Handshake_SendsCustomHeadersAndSubprotocols) {
+    UpgradeServer server;
+    server.extraHeaders = "Sec-WebSocket-Protocol: mcp.v2\r\n";
+    WebSocketMCP mcp(server);
+    MCP_CHECK(mcp.setHeader("Authorization", "Bearer secret"));
+    MCP_CHECK(mcp.setHeader("X-Device", "a"));
+    MCP_CHECK(mcp.setHeader("x-device", "")); // removed again
+    MCP_CHECK(!mcp.setHeader("Host", "evil"));
+    MCP_CHECK(!mcp.setHeader("X-Inject", "a\r\nHost: evil"));
+    MCP_CHECK(!mcp.setHeader("Bad Name", "a"));
+    mcp.setSubprotocols("mcp, mcp.v2");
+    mcp.begin("ws://localhost/mcp");
+    mcp.loop();
+
+    MCP_CHECK(mcp.isConnected());
+    MCP_CHECK(server.request.find("\r\nAuthorization: Bearer secret\r\n") != std::string::npos);
+    MCP_CHECK(server.request.find("X-Device") == std::string::npos);
+    MCP_CHECK(server.request.find("\r\nSec-WebSocket-Protocol: mcp, mcp.v2\r\n") != std::string::npos);
+    MCP_CHECK(mcp.subprotocol() == "mcp.v2");
+}
+
+MCP_TEST(Handshake_RequestLineFromUrlAndLongRequestSplit) {
+    UpgradeServer server;
+    WebSocketMCP mcp(server);
+    // Longer than the buffer the request is assembled in
+    std::string token(MCP_HANDSHAKE_WRITE_SIZE, 'x');
+    MCP_CHECK(mcp.setHeader("Authorization", token.c_str()));
+    uint16_t port = 0;
+    mcp.setConnectHandler([&port](Client &client, const IPAddress &, const char *host, uint16_t p, McpConnectInfo &) {
+        port = p;
+        return client.connect(host, p) == 1;
+    });
+    mcp.begin("wss://localhost:8443/mcp/?token=abc");
+    mcp.loop();
+
+    MCP_CHECK(mcp.isConnected());
+    MCP_CHECK_EQ(8443, (int)port);
+    MCP_CHECK_EQ((size_t)0, server.request.find("GET /mcp/?token=abc HTTP/1.1\r\nHost: localhost\r\n"));
+    MCP_CHECK(server.request.find("\r\nAuthorization: " + token + "\r\n") != std::string::npos);
+}
+
+MCP_TEST(Handshake_DnsCacheOnlyWhereTheAddressIsUsed) {
+    // wss:// without a handler connects by name: the client resolves it, the cache is not asked
+    UpgradeServer secure;
+    WebSocketMCP direct(secure);
+    direct.begin("wss://localhost/mcp");
+    direct.loop();
+    MCP_CHECK(direct.isConnected());
+    MCP_CHECK_EQ(0u, direct.getMetrics().dnsLookups + direct.getMetrics().dnsCacheHits);
+    MCP_CHECK_EQ(0u, direct.getMetrics().lastConnect.dnsMs);
+
+    // A handler gets the cached address
+    UpgradeServer handled;
+    WebSocketMCP viaHandler(handled);
+    viaHandler.setConnectHandler([](Client &client, const IPAddress &ip, const char *, uint16_t port,
+                                    McpConnectInfo &) { return client.connect(ip, port) == 1; });
+    viaHandler.begin("wss://localhost/mcp");
+    viaHandler.loop();
+    MCP_CHECK(viaHandler.isConnected());
+    MCP_CHECK_EQ(1u, viaHandler.getMetrics().dnsLookups);
+
+    UpgradeServer plain;
+    WebSocketMCP ws(plain);
+    ws.begin("ws://localhost/mcp");
+    ws.loop();
+    MCP_CHECK(ws.isConnected());
+    MCP_CHECK_EQ(1u, ws.getMetrics().dnsLookups);
+}
+
+MCP_TEST(Handshake_RejectsSubprotocolNotOffered) {
+    UpgradeServer server;
+    server.extraHeaders = "Sec-WebSocket-Protocol: other\r\n";
+    WebSocketMCP mcp(server);
+    mcp.setSubprotocols("mcp");
+    mcp.begin("ws://localhost/mcp");
+    mcp.loop();
+    MCP_CHECK(!mcp.isConnected());
+}
+
+MCP_TEST(Handshake_RejectsUnofferedExtension) {
+    UpgradeServer server;
+    server.extraHeaders = "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n";
+    WebSocketMCP mcp(server);
+    mcp.begin("ws://localhost/mcp");
+    mcp.loop();
+    MCP_CHECK(!mcp.isConnected());
+}
+
+MCP_TEST(Handshake_DeflateParameters) {
+    UpgradeServer server;
+    server.extraHeaders = "sec-websocket-extensions: permessage-deflate;server_no_context_takeover; "
+                          "client_max_window_bits=\"10\"\r\n";
+    WebSocketMCP mcp(server);
+    mcp.setCompression(true, 12);
+    mcp.begin("ws://localhost/mcp");
+    mcp.loop();
+    MCP_CHECK(mcp.isConnected());
+    MCP_CHECK(mcp.isCompressionActive());
+
+    UpgradeServer unknown;
+    unknown.extraHeaders = "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover; x=1\r\n";
+    WebSocketMCP other(unknown);
+    other.setCompression(true);
+    other.begin("ws://localhost/mcp");
+    other.loop();
+    MCP_CHECK(!other.isConnected());
+}
+
+MCP_TEST(Handshake_FrameRightBehindResponseIsDelivered) {
+    UpgradeServer server;
+    server.setTxCapture(true);
+    std::vector<uint8_t> frame;
+    LoopbackClient::appendServerFrame(frame, 0x1, MCP_REQ_PING, strlen(MCP_REQ_PING));
+    server.afterResponse.assign(frame.begin(), frame.end());
+    WebSocketMCP mcp(server);
+    mcp.begin("ws://localhost/mcp");
+    mcp.loop(); // connects
+    mcp.loop(); // answers the ping that arrived with the response
+    MCP_CHECK(mcp.isConnected());
+    std::string tx(server.tx().begin(), server.tx().end());
+    MCP_CHECK(!tx.empty() && (uint8_t)tx[0] == 0x81);
+}
@@ -0,0 +1,229 @@
+// McpWorkerPool and async tools: items run off the calling thread and come back
+// through takeCompleted(), busy and cancelled invocations, skipped queued jobs.
+
+#include "Test.h"
+#include "McpFixture.h"
+
+#include <McpWorkerPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static const char *const REQ_INVOKE_GATED_5 =
+    "{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"gated\",\"arguments\":{}}}";
+static const char *const REQ_INVOKE_GATED_6 =
+    "{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"tools/invoke\",\"params\":{\"tool_name\":\"gated\",\"arguments\":{}}}";
+static const char *const REQ_CANCEL_5 =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/cancelled\",\"params\":{\"requestId\":5}}";
+static const char *const REQ_CANCEL_6 =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/cancelled\",\"params\":{\"requestId\":6}}";
+
+struct CountingItem : McpWorkItem {
+    std::atomic<bool> ran{false};
+    std::thread::id thread;
+    void run() override {
+        thread = std::this_thread::get_id();
+        ran = true;
+    }
+};
+
+// Blocks its worker until released
+struct BlockingItem : McpWorkItem {
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    void run() override {
+        started = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Polls done until it returns true, for up to two seconds; done is called once per poll
+template <typename Predicate> static bool waitFor(Predicate done) {
+    for (int i = 0; i < 2000; i++) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// A fixture with an async tool "gated" whose callbacks wait for release
+struct GatedFixture : McpFixture {
+    std::atomic<int> started{0};
+    std::atomic<bool> release{false};
+
+    explicit GatedFixture(uint8_t maxConcurrency) {
+        client.setTxCapture(true);
+        mcp.registerTool("gated", "Waits", "{\"type\":\"object\"}", [this](JsonObjectConst) {
+            started++;
+            while (!release) {
+                std::this_thread::yield();
+            }
+            return ToolResponse("{\"done\":true}");
+        });
+        MCP_CHECK(mcp.beginToolWorkers(1));
+        MCP_CHECK(mcp.setToolAsync("gated", maxConcurrency));
+    }
+
+    // The workers are joined on destruction: never leave a callback waiting
+    ~GatedFixture() { release = true; }
+
+    void send(const char *message) {
+        WebSocketMCPHostAccess::handleJsonRpcMessage(mcp, message, strlen(message));
+        WebSocketMCPHostAccess::flushSendQueue(mcp);
+    }
+
+    // Replies sent from loop() over a few milliseconds
+    std::vector<std::string> settle() {
+        for (int i = 0; i < 20; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            mcp.loop();
+        }
+        WebSocketMCPHostAccess::flushSendQueue(mcp);
+        return client.takeTxPayloads();
+    }
+};
+
+MCP_TEST(WorkerPool_ItemsRunOnWorkersAndComeBack) {
+    McpWorkerPool pool;
+    CountingItem items[5];
+    MCP_CHECK(!pool.submit(&items[0])); // not running yet
+    MCP_CHECK(!pool.begin(0, 4096, 1));
+    MCP_CHECK(!pool.begin(MCP_MAX_TOOL_WORKERS + 1, 4096, 1));
+    MCP_CHECK(pool.begin(2, 4096, 1));
+    MCP_CHECK(!pool.begin(2, 4096, 1));
+    MCP_CHECK(pool.running());
+
+    for (int i = 0; i < 5; i++) {
+        MCP_CHECK(pool.submit(&items[i]));
+    }
+    int completed = 0;
+    MCP_CHECK(waitFor([&] {
+        while (McpWorkItem *item = pool.takeCompleted()) {
+            MCP_CHECK(static_cast<CountingItem *>(item)->ran);
+            completed++;
+        }
+        return completed == 5;
+    }));
+    for (int i = 0; i < 5; i++) {
+        MCP_CHECK(items[i].thread != std::this_thread::get_id());
+    }
+    MCP_CHECK(pool.takeCompleted() == nullptr);
+
+    pool.end();
+    MCP_CHECK(!pool.running());
+    MCP_CHECK(!pool.submit(&items[0]));
+}
+
+MCP_TEST(WorkerPool_QueueBoundedAndNotRunAfterEnd) {
+    McpWorkerPool pool;
+    MCP_CHECK(pool.begin(1, 4096, 1));
+    BlockingItem blocker;
+    MCP_CHECK(pool.submit(&blocker));
+    MCP_CHECK(waitFor([&] { return blocker.started.load(); }));
+
+    CountingItem queued[MCP_TOOL_QUEUE_LENGTH + 1];
+    for (int i = 0; i < MCP_TOOL_QUEUE_LENGTH; i++) {
+        MCP_CHECK(pool.submit(&queued[i]));
+    }
+    MCP_CHECK(!pool.submit(&queued[MCP_TOOL_QUEUE_LENGTH]));
+
+    // end() lets the running item finish and drops the queued ones
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        blocker.release = true;
+    });
+    pool.end();
+    releaser.join();
+    for (int i = 0; i < MCP_TOOL_QUEUE_LENGTH; i++) {
+        MCP_CHECK(!queued[i].ran);
+    }
+}
+
+MCP_TEST(WorkerPool_AsyncReplyFromLoop) {
+    GatedFixture f(1);
+    f.send(REQ_INVOKE_GATED_5);
+    MCP_CHECK(waitFor([&] { return f.started == 1; }));
+    // Nothing while the callback runs
+    MCP_CHECK(f.settle().empty());
+
+    f.release = true;
+    std::vector<std::string> replies;
+    MCP_CHECK(waitFor([&] {
+        replies = f.settle();
+        return !replies.empty();
+    }));
+    MCP_CHECK_EQ(1u, replies.size());
+    if (replies.size() == 1) {
+        MCP_CHECK(replies[0].find("\"id\":5,\"result\"") != std::string::npos);
+        MCP_CHECK(replies[0].find("\\\"done\\\":true") != std::string::npos);
+    }
+    McpToolStats stats;
+    MCP_CHECK(f.mcp.getToolStats("gated", stats));
+    MCP_CHECK_EQ(1u, stats.calls);
+}
+
+MCP_TEST(WorkerPool_BusyPastMaxConcurrency) {
+    GatedFixture f(1);
+    f.send(REQ_INVOKE_GATED_5);
+    f.send(REQ_INVOKE_GATED_6);
+    std::vector<std::string> replies = f.client.takeTxPayloads();
+    MCP_CHECK_EQ(1u, replies.size());
+    if (replies.size() == 1) {
+        MCP_CHECK_EQ(std::string("{\"jsonrpc\":\"2.0\",\"id\":6,\"error\":{\"code\":-32000,"
+                                 "\"message\":\"Tool busy: gated\"}}"),
+                     replies[0]);
+    }
+
+    // The slot frees up once the first reply is out
+    f.release = true;
+    MCP_CHECK(waitFor([&] { return !f.settle().empty(); }));
+    f.send(REQ_INVOKE_GATED_6);
+    std::vector<std::string> second;
+    MCP_CHECK(waitFor([&] {
+        second = f.settle();
+        return !second.empty();
+    }));
+    MCP_CHECK(!second.empty() && second[0].find("\"id\":6,\"result\"") != std::string::npos);
+}
+
+MCP_TEST(WorkerPool_CancelledReplyDropped) {
+    GatedFixture f(1);
+    f.send(REQ_INVOKE_GATED_5);
+    MCP_CHECK(waitFor([&] { return f.started == 1; }));
+    f.send(REQ_CANCEL_5);
+    f.release = true;
+
+    // The callback finishes, but neither a reply nor its stats follow
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    MCP_CHECK(f.settle().empty());
+    McpToolStats stats;
+    MCP_CHECK(f.mcp.getToolStats("gated", stats));
+    MCP_CHECK_EQ(0u, stats.calls);
+}
+
+MCP_TEST(WorkerPool_CancelledWhileQueuedIsSkipped) {
+    // One worker, two invocations allowed: the second waits in the queue
+    GatedFixture f(2);
+    f.send(REQ_INVOKE_GATED_5);
+    MCP_CHECK(waitFor([&] { return f.started == 1; }));
+    f.send(REQ_INVOKE_GATED_6);
+    f.send(REQ_CANCEL_6);
+    f.release = true;
+
+    std::vector<std::string> replies;
+    MCP_CHECK(waitFor([&] {
+        replies = f.settle();
+        return !replies.empty();
+    }));
+    MCP_CHECK(f.settle().empty());
+    MCP_CHECK_EQ(1u, replies.size());
+    MCP_CHECK(!replies.empty() && replies[0].find("\"id\":5,\"result\"") != std::string::npos);
+    // The cancelled job never reached its callback
+    MCP_CHECK_EQ(1, f.started.load());
+}
@@ -0,0 +1,213 @@
+#include "McpCapture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// timeMs, flags, stored length
+static const size_t RECORD_HEADER_LEN = 7;
+// original length, after the header of a truncated record
+static const size_t ORIGINAL_LEN_LEN = 4;
+
+static void putLe(uint8_t *out, uint32_t v, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t getLe(const uint8_t *in, size_t bytes) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        v |= (uint32_t)in[i] << (8 * i);
+    }
+    return v;
+}
+
+McpCapture::McpCapture()
+    : _active(false), _buf(nullptr), _size(0), _maxPayload(0), _head(0), _tail(0), _used(0), _records(0),
+      _dropped(0), _writing(false) {
+#ifdef ESP32
+    _lock = xSemaphoreCreateMutexStatic(&_lockBuffer);
+#endif
+}
+
+McpCapture::~McpCapture() {
+    end();
+#ifdef ESP32
+    vSemaphoreDelete(_lock);
+#endif
+}
+
+void McpCapture::lock() {
+#ifdef ESP32
+    xSemaphoreTake(_lock, portMAX_DELAY);
+#else
+    _lock.lock();
+#endif
+}
+
+void McpCapture::unlock() {
+#ifdef ESP32
+    xSemaphoreGive(_lock);
+#else
+    _lock.unlock();
+#endif
+}
+
+bool McpCapture::begin(size_t size, size_t maxPayload) {
+    // The stored length field is 16 bits, and the largest record must fit the ring
+    if (maxPayload > 0xFFFF) {
+        maxPayload = 0xFFFF;
+    }
+    if (size < RECORD_HEADER_LEN + ORIGINAL_LEN_LEN + maxPayload) {
+        return false;
+    }
+    end();
+    uint8_t *buf = (uint8_t *)malloc(size);
+    if (!buf) {
+        return false;
+    }
+    lock();
+    _buf = buf;
+    _size = size;
+    _maxPayload = maxPayload;
+    _head = 0;
+    _tail = 0;
+    _used = 0;
+    _records = 0;
+    _dropped = 0;
+    _writing = false;
+    unlock();
+    _active = true;
+    return true;
+}
+
+void McpCapture::end() {
+    _active = false;
+    lock();
+    uint8_t *buf = _buf;
+    _buf = nullptr;
+    unlock();
+    free(buf);
+}
+
+void McpCapture::put(const uint8_t *data, size_t len) {
+    size_t first = _size - _head < len ? _size - _head : len;
+    memcpy(_buf + _head, data, first);
+    memcpy(_buf, data + first, len - first);
+    _head = (_head + len) % _size;
+    _used += len;
+}
+
+void McpCapture::get(size_t pos, uint8_t *data, size_t len) const {
+    pos %= _size;
+    size_t first = _size - pos < len ? _size - pos : len;
+    memcpy(data, _buf + pos, first);
+    memcpy(data + first, _buf, len - first);
+}
+
+size_t McpCapture::recordSizeAt(size_t pos) const {
+    uint8_t header[RECORD_HEADER_LEN];
+    get(pos, header, sizeof(header));
+    size_t size = RECORD_HEADER_LEN + getLe(header + 5, 2);
+    return (header[4] & FLAG_TRUNCATED) ? size + ORIGINAL_LEN_LEN : size;
+}
+
+void McpCapture::record(bool outgoing, uint8_t opcode, const uint8_t *payload, size_t len) {
+    if (!active()) {
+        return;
+    }
+    uint8_t header[RECORD_HEADER_LEN + ORIGINAL_LEN_LEN];
+    uint32_t now = millis();
+
+    lock();
+    if (!_buf || _writing) {
+        if (_buf) {
+            _dropped++;
+        }
+        unlock();
+        return;
+    }
+    size_t stored = len > _maxPayload ? _maxPayload : len;
+    uint8_t flags = (uint8_t)((outgoing ? FLAG_OUT : 0) | (opcode & OPCODE_MASK));
+    size_t headerLen = RECORD_HEADER_LEN;
+    if (stored < len) {
+        flags |= FLAG_TRUNCATED;
+        putLe(header + RECORD_HEADER_LEN, (uint32_t)len, ORIGINAL_LEN_LEN);
+        headerLen += ORIGINAL_LEN_LEN;
+    }
+    putLe(header, now, 4);
+    header[4] = flags;
+    putLe(header + 5, (uint32_t)stored, 2);
+
+    // Oldest records make room
+    while (_size - _used < headerLen + stored) {
+        size_t oldest = recordSizeAt(_tail);
+        _tail = (_tail + oldest) % _size;
+        _used -= oldest;
+        _records--;
+        _dropped++;
+    }
+    put(header, headerLen);
+    put(payload, stored);
+    _records++;
+    unlock();
+}
+
+size_t McpCapture::writeTo(Print &out) {
+    uint8_t header[FILE_HEADER_LEN] = {'M', 'C', 'P', 'C', FORMAT_VERSION, 0, 0, 0};
+    size_t written = out.write(header, sizeof(header));
+    if (!active()) {
+        return written;
+    }
+
+    // Frames arriving while the (possibly slow) output is written are not captured,
+    // so the ring can be read without holding the lock
+    lock();
+    _writing = true;
+    size_t pos = _tail;
+    size_t remaining = _used;
+    unlock();
+    while (remaining > 0) {
+        size_t n = _size - pos < remaining ? _size - pos : remaining;
+        size_t w = out.write(_buf + pos, n);
+        written += w;
+        if (w < n) {
+            break;
+        }
+        pos = (pos + n) % _size;
+        remaining -= n;
+    }
+    lock();
+    _writing = false;
+    unlock();
+    return written;
+}
+
+bool McpCapture::validHeader(const uint8_t *data, size_t len) {
+    return len >= FILE_HEADER_LEN && memcmp(data, "MCPC", 4) == 0 && data[4] == FORMAT_VERSION;
+}
+
+bool McpCapture::next(const uint8_t *data, size_t len, size_t &pos, Record &record) {
+    if (pos > len || len - pos < RECORD_HEADER_LEN) {
+        return false;
+    }
+    const uint8_t *p = data + pos;
+    record.timeMs = getLe(p, 4);
+    record.flags = p[4];
+    record.storedLength = getLe(p + 5, 2);
+    size_t headerLen = RECORD_HEADER_LEN;
+    record.length = (uint32_t)record.storedLength;
+    if (record.flags & FLAG_TRUNCATED) {
+        if (len - pos < RECORD_HEADER_LEN + ORIGINAL_LEN_LEN) {
+            return false;
+        }
+        record.length = getLe(p + RECORD_HEADER_LEN, ORIGINAL_LEN_LEN);
+        headerLen += ORIGINAL_LEN_LEN;
+    }
+    if (len - pos - headerLen < record.storedLength) {
+        return false;
+    }
+    record.payload = p + headerLen;
+    pos += headerLen + record.storedLength;
+    return true;
+}
@@ -0,0 +1,141 @@
+#ifndef MCP_CAPTURE_H
+#define MCP_CAPTURE_H
+
+#include <Arduino.h>
+#include <atomic>
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#else
+#include <mutex>
+#endif
+
+/* *
+ * McpCapture Class
+ * Records the WebSocket traffic of a connection into a RAM ring buffer, so a
+ * stall seen in the field can be taken back to the bench and replayed
+ * (extras/host, mcp_replay).
+ *
+ * Every frame is captured as a record: the millis() timestamp, the direction
+ * and opcode, and the payload, cut at a fixed maximum. Incoming TEXT payloads
+ * are captured after decompression, outgoing ones before, so a capture reads
+ * the same with or without permessage-deflate. When the ring is full the
+ * oldest records make room; the ring always holds the latest traffic.
+ *
+ * writeTo() copies the ring to any Print: a LittleFS/SPIFFS File on the
+ * device (e.g. from the connection callback after an unexpected disconnect),
+ * a file on the host. Nothing is written to flash while capturing.
+ *
+ * Log format, all integers little-endian:
+ *   file header   "MCPC", format version (1), 3 reserved bytes
+ *   record        uint32 timeMs, uint8 flags, uint16 stored payload length,
+ *                 [uint32 original length, if FLAG_TRUNCATED], payload
+ *   flags         bit 7 FLAG_OUT (sent by the device), bit 6 FLAG_TRUNCATED,
+ *                 bits 0-3 the WebSocket opcode
+ *
+ * Frames are captured from both sides of the network task, so record() takes a
+ * lock, held only to copy one record. On ESP32 it is a FreeRTOS mutex, not a
+ * critical section: copying up to maxPayload bytes and evicting old records
+ * must not hold off interrupts. While writeTo() runs, frames are not captured
+ * (they count as dropped), so a slow flash write never holds the lock.
+ * begin(), end() and writeTo() belong to the application task.
+ */
+
+// Ring buffer size
+#ifndef MCP_CAPTURE_SIZE
+#define MCP_CAPTURE_SIZE 16384
+#endif
+
+// Payload bytes kept per frame; longer payloads are cut (and flagged)
+#ifndef MCP_CAPTURE_MAX_PAYLOAD
+#define MCP_CAPTURE_MAX_PAYLOAD 1024
+#endif
+
+class McpCapture {
+public:
+    static const uint8_t FLAG_OUT = 0x80;
+    static const uint8_t FLAG_TRUNCATED = 0x40;
+    static const uint8_t OPCODE_MASK = 0x0F;
+    static const size_t FILE_HEADER_LEN = 8;
+    static const uint8_t FORMAT_VERSION = 1;
+
+    // One decoded record; payload points into the buffer it was read from
+    struct Record {
+        uint32_t timeMs;
+        uint8_t flags;
+        uint32_t length;         // of the frame's payload
+        const uint8_t *payload;
+        size_t storedLength;     // bytes at payload: length, unless truncated
+
+        bool outgoing() const { return (flags & FLAG_OUT) != 0; }
+        uint8_t opcode() const { return flags & OPCODE_MASK; }
+    };
+
+    McpCapture();
+    ~McpCapture();
+
+    /* *
+     * Allocate the ring and start capturing; restarts an active capture empty
+     * @param size Ring size in bytes
+     * @param maxPayload Payload bytes kept per frame
+     * @return false if the ring could not be allocated
+     */
+    bool begin(size_t size = MCP_CAPTURE_SIZE, size_t maxPayload = MCP_CAPTURE_MAX_PAYLOAD);
+
+    // Stop capturing and free the ring
+    void end();
+
+    bool active() const { return _active.load(std::memory_order_relaxed); }
+
+    // Capture one frame; does nothing unless active
+    void record(bool outgoing, uint8_t opcode, const uint8_t *payload, size_t len);
+
+    /* *
+     * Write the file header and the records held, oldest first
+     * @return Bytes written
+     */
+    size_t writeTo(Print &out);
+
+    // Records held, and frames lost since begin(): overwritten by newer ones, or sent or
+    // received while writeTo() was running
+    size_t records() const { return _records; }
+    uint32_t dropped() const { return _dropped; }
+
+    /* *
+     * Decode the record at pos of a log (after the file header) and advance pos past it
+     * @return false at the end of the data, or if the record there is incomplete
+     */
+    static bool next(const uint8_t *data, size_t len, size_t &pos, Record &record);
+
+    // Whether data starts with a file header this version reads
+    static bool validHeader(const uint8_t *data, size_t len);
+
+private:
+    McpCapture(const McpCapture &);
+    McpCapture &operator=(const McpCapture &);
+
+    void lock();
+    void unlock();
+    void put(const uint8_t *data, size_t len);
+    void get(size_t pos, uint8_t *data, size_t len) const;
+    size_t recordSizeAt(size_t pos) const;
+
+    std::atomic<bool> _active; // unlocked check on the frame path
+    uint8_t *_buf;
+    size_t _size;
+    size_t _maxPayload;
+    size_t _head;    // where the next record goes
+    size_t _tail;    // oldest record
+    size_t _used;
+    size_t _records;
+    uint32_t _dropped;
+    bool _writing;   // writeTo() is reading the ring
+#ifdef ESP32
+    StaticSemaphore_t _lockBuffer;
+    SemaphoreHandle_t _lock;
+#else
+    std::mutex _lock;
+#endif
+};
+
+#endif // MCP_CAPTURE_H
@@ -0,0 +1,479 @@
+#include "McpDeflate.h"
+
+#include <string.h>
+
+namespace {
+
+const uint8_t MIN_MATCH = 3;
+const uint16_t MAX_MATCH = 258;
+
+// Length codes 257..285 and distance codes 0..29 (RFC 1951 3.2.5)
+const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Order of the code length code lengths in a dynamic block header
+const uint8_t CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+const uint8_t MAX_BITS = 15;
+const uint16_t MAX_LITLEN_CODES = 286;
+const uint16_t MAX_DIST_CODES = 30;
+const uint16_t FIXED_LITLEN_CODES = 288;
+
+// ---------------------------------------------------------------------------
+// Compressor
+
+// LSB-first bit writer into a bounded buffer
+struct BitWriter {
+    uint8_t *out;
+    size_t cap;
+    size_t pos;
+    uint32_t bits;
+    uint8_t count;
+    bool overflow;
+
+    BitWriter(uint8_t *buffer, size_t capacity)
+        : out(buffer), cap(capacity), pos(0), bits(0), count(0), overflow(false) {}
+
+    void put(uint32_t value, uint8_t n) {
+        bits |= value << count;
+        count += n;
+        while (count >= 8) {
+            if (pos < cap) {
+                out[pos++] = (uint8_t)bits;
+            } else {
+                overflow = true;
+            }
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are packed starting from their most significant bit
+    void putCode(uint32_t code, uint8_t n) {
+        uint32_t reversed = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            reversed = (reversed << 1) | (code & 1);
+            code >>= 1;
+        }
+        put(reversed, n);
+    }
+
+    void align() {
+        if (count > 0) {
+            put(0, 8 - count);
+        }
+    }
+};
+
+// Fixed Huffman literal/length code (RFC 1951 3.2.6)
+void putLiteralLength(BitWriter &writer, uint16_t symbol) {
+    if (symbol < 144) {
+        writer.putCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        writer.putCode(0x190 + (symbol - 144), 9);
+    } else if (symbol < 280) {
+        writer.putCode(symbol - 256, 7);
+    } else {
+        writer.putCode(0xC0 + (symbol - 280), 8);
+    }
+}
+
+void putMatch(BitWriter &writer, uint16_t length, uint16_t distance) {
+    uint8_t code = 28;
+    while (LENGTH_BASE[code] > length) {
+        code--;
+    }
+    putLiteralLength(writer, 257 + code);
+    writer.put(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+    code = 29;
+    while (DIST_BASE[code] > distance) {
+        code--;
+    }
+    writer.putCode(code, 5);
+    writer.put(distance - DIST_BASE[code], DIST_EXTRA[code]);
+}
+
+inline uint32_t hash3(const uint8_t *p, uint8_t hashBits) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - hashBits);
+}
+
+// ---------------------------------------------------------------------------
+// Decompressor (canonical Huffman decoding as in zlib's puff.c)
+
+struct Huffman {
+    uint16_t count[MAX_BITS + 1]; // number of codes of each length
+    uint16_t symbol[FIXED_LITLEN_CODES]; // symbols ordered by code
+};
+
+// LSB-first bit reader over the message followed by the virtual 00 00 FF FF tail
+struct BitReader {
+    const uint8_t *in;
+    size_t len;
+    size_t pos; // counts into the tail once past len
+    uint32_t bits;
+    uint8_t count;
+    bool truncated;
+
+    BitReader(const uint8_t *data, size_t length)
+        : in(data), len(length), pos(0), bits(0), count(0), truncated(false) {}
+
+    size_t total() const { return len + 4; }
+
+    int nextByte() {
+        if (pos < len) {
+            return in[pos++];
+        }
+        if (pos < total()) {
+            static const uint8_t TAIL[4] = {0x00, 0x00, 0xFF, 0xFF};
+            return TAIL[pos++ - len];
+        }
+        truncated = true;
+        return 0;
+    }
+
+    uint32_t get(uint8_t n) {
+        while (count < n) {
+            bits |= (uint32_t)nextByte() << count;
+            count += 8;
+        }
+        uint32_t value = bits & ((1UL << n) - 1);
+        bits >>= n;
+        count -= n;
+        return value;
+    }
+
+    // Through the appended tail, or on a byte boundary at the end of a message
+    // that kept its own 00 00 FF FF
+    bool atEnd() const { return (pos >= len && count == 0) || (pos >= total() && count < 3); }
+};
+
+// @return 0 if complete, > 0 if incomplete, < 0 if over-subscribed
+int buildHuffman(Huffman &h, const uint8_t *lengths, uint16_t n) {
+    memset(h.count, 0, sizeof(h.count));
+    for (uint16_t i = 0; i < n; i++) {
+        h.count[lengths[i]]++;
+    }
+    if (h.count[0] == n) {
+        return 0; // no codes; decoding will fail if one is used
+    }
+
+    int left = 1;
+    for (uint8_t len = 1; len <= MAX_BITS; len++) {
+        left <<= 1;
+        left -= h.count[len];
+        if (left < 0) {
+            return left;
+        }
+    }
+
+    uint16_t offsets[MAX_BITS + 1];
+    offsets[1] = 0;
+    for (uint8_t len = 1; len < MAX_BITS; len++) {
+        offsets[len + 1] = offsets[len] + h.count[len];
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (lengths[i] != 0) {
+            h.symbol[offsets[lengths[i]]++] = i;
+        }
+    }
+    return left;
+}
+
+// @return Symbol, or -1 if no code matches
+int decodeSymbol(BitReader &reader, const Huffman &h) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (uint8_t len = 1; len <= MAX_BITS; len++) {
+        code |= (int)reader.get(1);
+        int count = h.count[len];
+        if (code - count < first) {
+            return h.symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+struct Output {
+    uint8_t *out;
+    size_t cap;
+    size_t len;
+};
+
+McpInflater::Result inflateCodes(BitReader &reader, Output &output,
+                                 const Huffman &litlen, const Huffman &dist) {
+    for (;;) {
+        int symbol = decodeSymbol(reader, litlen);
+        if (symbol < 0 || reader.truncated) {
+            return McpInflater::ERR_DATA;
+        }
+        if (symbol < 256) {
+            if (output.len >= output.cap) {
+                return McpInflater::ERR_TOO_LARGE;
+            }
+            output.out[output.len++] = (uint8_t)symbol;
+            continue;
+        }
+        if (symbol == 256) {
+            return McpInflater::OK;
+        }
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            return McpInflater::ERR_DATA;
+        }
+        size_t length = LENGTH_BASE[symbol] + reader.get(LENGTH_EXTRA[symbol]);
+
+        symbol = decodeSymbol(reader, dist);
+        if (symbol < 0 || symbol >= 30) {
+            return McpInflater::ERR_DATA;
+        }
+        size_t distance = DIST_BASE[symbol] + reader.get(DIST_EXTRA[symbol]);
+        if (reader.truncated || distance > output.len) {
+            return McpInflater::ERR_DATA; // no history before this message
+        }
+        if (length > output.cap - output.len) {
+            return McpInflater::ERR_TOO_LARGE;
+        }
+        // Byte by byte: the source may overlap the bytes being written
+        uint8_t *to = output.out + output.len;
+        const uint8_t *from = to - distance;
+        for (size_t i = 0; i < length; i++) {
+            to[i] = from[i];
+        }
+        output.len += length;
+    }
+}
+
+McpInflater::Result inflateStored(BitReader &reader, Output &output) {
+    // Skip to the byte boundary; whole bytes still buffered are part of the block
+    reader.bits >>= reader.count & 7;
+    reader.count &= ~7;
+    uint32_t length = reader.get(16);
+    uint32_t complement = reader.get(16);
+    if (reader.truncated || length != (~complement & 0xFFFF)) {
+        return McpInflater::ERR_DATA;
+    }
+    if (length > output.cap - output.len) {
+        return McpInflater::ERR_TOO_LARGE;
+    }
+    while (length--) {
+        output.out[output.len++] = (uint8_t)reader.get(8);
+    }
+    return reader.truncated ? McpInflater::ERR_DATA : McpInflater::OK;
+}
+
+McpInflater::Result inflateFixed(BitReader &reader, Output &output) {
+    uint8_t lengths[FIXED_LITLEN_CODES];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    Huffman litlen;
+    buildHuffman(litlen, lengths, FIXED_LITLEN_CODES);
+
+    memset(lengths, 5, MAX_DIST_CODES);
+    Huffman dist;
+    buildHuffman(dist, lengths, MAX_DIST_CODES);
+
+    return inflateCodes(reader, output, litlen, dist);
+}
+
+McpInflater::Result inflateDynamic(BitReader &reader, Output &output) {
+    uint16_t nlen = reader.get(5) + 257;
+    uint16_t ndist = reader.get(5) + 1;
+    uint8_t ncode = reader.get(4) + 4;
+    if (nlen > MAX_LITLEN_CODES || ndist > MAX_DIST_CODES) {
+        return McpInflater::ERR_DATA;
+    }
+
+    uint8_t lengths[MAX_LITLEN_CODES + MAX_DIST_CODES];
+    memset(lengths, 0, 19);
+    for (uint8_t i = 0; i < ncode; i++) {
+        lengths[CODE_LENGTH_ORDER[i]] = reader.get(3);
+    }
+    Huffman litlen;
+    if (reader.truncated || buildHuffman(litlen, lengths, 19) != 0) {
+        return McpInflater::ERR_DATA; // code length code must be complete
+    }
+
+    uint16_t index = 0;
+    while (index < nlen + ndist) {
+        int symbol = decodeSymbol(reader, litlen);
+        if (symbol < 0 || reader.truncated) {
+            return McpInflater::ERR_DATA;
+        }
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+        uint8_t value = 0;
+        uint8_t repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return McpInflater::ERR_DATA; // nothing to repeat
+            }
+            value = lengths[index - 1];
+            repeat = 3 + reader.get(2);
+        } else if (symbol == 17) {
+            repeat = 3 + reader.get(3);
+        } else {
+            repeat = 11 + reader.get(7);
+        }
+        if (index + repeat > nlen + ndist) {
+            return McpInflater::ERR_DATA;
+        }
+        while (repeat--) {
+            lengths[index++] = value;
+        }
+    }
+    if (lengths[256] == 0) {
+        return McpInflater::ERR_DATA; // no end-of-block code
+    }
+
+    // Incomplete codes are only allowed for a single length-1 code
+    int left = buildHuffman(litlen, lengths, nlen);
+    if (left < 0 || (left > 0 && nlen - litlen.count[0] != 1)) {
+        return McpInflater::ERR_DATA;
+    }
+    Huffman dist;
+    left = buildHuffman(dist, lengths + nlen, ndist);
+    if (left < 0 || (left > 0 && ndist - dist.count[0] != 1)) {
+        return McpInflater::ERR_DATA;
+    }
+
+    return inflateCodes(reader, output, litlen, dist);
+}
+
+} // namespace
+
+McpDeflater::McpDeflater()
+    : _head(nullptr), _hashBits(0), _window(0) {}
+
+McpDeflater::~McpDeflater() {
+    end();
+}
+
+bool McpDeflater::begin(uint8_t windowBits) {
+    if (windowBits < 9) {
+        windowBits = 9;
+    } else if (windowBits > 15) {
+        windowBits = 15;
+    }
+    end();
+    _hashBits = windowBits - 2;
+    _window = (size_t)1 << windowBits;
+    _head = (uint16_t *)malloc(sizeof(uint16_t) << _hashBits);
+    return _head != nullptr;
+}
+
+void McpDeflater::end() {
+    free(_head);
+    _head = nullptr;
+}
+
+size_t McpDeflater::compress(const uint8_t *in, size_t len, uint8_t *out, size_t outCap, uint8_t windowBits) {
+    if (!_head) {
+        return 0;
+    }
+    size_t window = windowBits < 15 ? (size_t)1 << windowBits : _window;
+    if (window > _window) {
+        window = _window;
+    }
+    // Entries hold position + 1 (mod 2^16) so that 0 means empty
+    memset(_head, 0, sizeof(uint16_t) << _hashBits);
+
+    BitWriter writer(out, outCap);
+    writer.put(2, 3); // BFINAL = 0, BTYPE = 01 (fixed Huffman)
+
+    size_t pos = 0;
+    while (pos < len) {
+        if (writer.overflow) {
+            return 0;
+        }
+        if (len - pos < MIN_MATCH) {
+            putLiteralLength(writer, in[pos++]);
+            continue;
+        }
+
+        uint32_t h = hash3(in + pos, _hashBits);
+        uint16_t previous = _head[h];
+        _head[h] = (uint16_t)(pos + 1);
+
+        size_t matchLength = 0;
+        size_t distance = (uint16_t)(pos + 1 - previous);
+        if (previous != 0 && distance != 0 && distance <= window && distance <= pos) {
+            const uint8_t *candidate = in + pos - distance;
+            size_t limit = len - pos < MAX_MATCH ? len - pos : MAX_MATCH;
+            while (matchLength < limit && candidate[matchLength] == in[pos + matchLength]) {
+                matchLength++;
+            }
+        }
+
+        if (matchLength < MIN_MATCH) {
+            putLiteralLength(writer, in[pos++]);
+            continue;
+        }
+
+        putMatch(writer, (uint16_t)matchLength, (uint16_t)distance);
+        // Index the positions inside the match too, so later repeats can find them
+        size_t end = pos + matchLength;
+        for (pos++; pos < end && len - pos >= MIN_MATCH; pos++) {
+            _head[hash3(in + pos, _hashBits)] = (uint16_t)(pos + 1);
+        }
+        pos = end;
+    }
+
+    putLiteralLength(writer, 256); // end of block
+    // Sync flush: an empty stored block whose 00 00 FF FF is left off (RFC 7692 7.2.1)
+    writer.put(0, 3);
+    writer.align();
+    return writer.overflow ? 0 : writer.pos;
+}
+
+McpInflater::Result McpInflater::inflate(const uint8_t *in, size_t len, uint8_t *out, size_t outCap, size_t &outLen) {
+    BitReader reader(in, len);
+    Output output = {out, outCap, 0};
+
+    bool last = false;
+    while (!last && !reader.atEnd()) {
+        last = reader.get(1) != 0;
+        Result result;
+        switch (reader.get(2)) {
+            case 0: result = inflateStored(reader, output); break;
+            case 1: result = inflateFixed(reader, output); break;
+            case 2: result = inflateDynamic(reader, output); break;
+            default: result = ERR_DATA; break;
+        }
+        if (result != OK) {
+            return result;
+        }
+    }
+    if (reader.truncated) {
+        return ERR_DATA;
+    }
+    outLen = output.len;
+    return OK;
+}
@@ -0,0 +1,77 @@
+#ifndef MCP_DEFLATE_H
+#define MCP_DEFLATE_H
+
+#include <Arduino.h>
+
+/* *
+ * Raw DEFLATE (RFC 1951) for permessage-deflate (RFC 7692), sized for a microcontroller.
+ *
+ * Both directions work on whole messages in flat buffers and keep no history
+ * between messages (client_no_context_takeover / server_no_context_takeover),
+ * so the only RAM beyond the message buffers is McpDeflater's hash table.
+ *
+ * McpDeflater: greedy LZ77 with a single-entry hash table and fixed Huffman
+ * codes, one block per message, ended with the sync flush RFC 7692 expects
+ * (the trailing 00 00 FF FF removed). windowBits bounds the match distance and
+ * sets the hash table to 2^(windowBits - 1) bytes.
+ *
+ * McpInflater: stored, fixed and dynamic Huffman blocks, with the 00 00 FF FF
+ * tail appended implicitly (a message that still ends with it is accepted too).
+ */
+
+// permessage-deflate window (9 to 15): match distance limit, also offered for the server
+#ifndef MCP_DEFLATE_WINDOW_BITS
+#define MCP_DEFLATE_WINDOW_BITS 11
+#endif
+
+// Messages shorter than this are sent uncompressed
+#ifndef MCP_DEFLATE_THRESHOLD
+#define MCP_DEFLATE_THRESHOLD 256
+#endif
+
+class McpDeflater {
+public:
+    McpDeflater();
+    ~McpDeflater();
+
+    /* *
+     * Allocate the hash table
+     * @param windowBits 9 to 15
+     * @return false if the allocation failed
+     */
+    bool begin(uint8_t windowBits);
+    void end();
+
+    /* *
+     * Compress one message
+     * @param outCap Output capacity; pass less than the input length to compress only when it pays off
+     * @param windowBits Lowers the match distance below the begin() window (e.g. as negotiated)
+     * @return Compressed length, or 0 if it did not fit in outCap
+     */
+    size_t compress(const uint8_t *in, size_t len, uint8_t *out, size_t outCap, uint8_t windowBits = 15);
+
+private:
+    McpDeflater(const McpDeflater &);
+    McpDeflater &operator=(const McpDeflater &);
+
+    uint16_t *_head;   // last position (low 16 bits) seen for each 3-byte hash
+    uint8_t _hashBits;
+    size_t _window;
+};
+
+class McpInflater {
+public:
+    enum Result {
+        OK,
+        ERR_DATA,     // malformed or truncated stream
+        ERR_TOO_LARGE // output does not fit
+    };
+
+    /* *
+     * Decompress one message
+     * @param outLen Set to the decompressed length on OK
+     */
+    static Result inflate(const uint8_t *in, size_t len, uint8_t *out, size_t outCap, size_t &outLen);
+};
+
+#endif // MCP_DEFLATE_H
@@ -0,0 +1,23 @@
+#include "McpDnsCache.h"
+
+#include <WiFi.h>
+
+bool McpDnsCache::resolve(const String &host, IPAddress &ip, bool &cached) {
+    unsigned long now = millis();
+    if (_valid && _host == host && now - _resolvedAt < MCP_DNS_CACHE_TTL_MS) {
+        ip = _ip;
+        cached = true;
+        return true;
+    }
+
+    cached = false;
+    if (WiFi.hostByName(host.c_str(), _ip) != 1) {
+        _valid = false;
+        return false;
+    }
+    _host = host;
+    _resolvedAt = now;
+    _valid = true;
+    ip = _ip;
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef MCP_DNS_CACHE_H
+#define MCP_DNS_CACHE_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+/* *
+ * McpDnsCache Class
+ * Remembers the address of the server host between reconnects.
+ *
+ * The resolver behind WiFi.hostByName() does not report the record's TTL, so
+ * an entry is trusted for a fixed MCP_DNS_CACHE_TTL_MS. invalidate() drops it
+ * early, e.g. when connecting to the cached address failed (the server may
+ * have moved). One entry: the library only ever talks to one host.
+ */
+
+// How long a resolved address is reused
+#ifndef MCP_DNS_CACHE_TTL_MS
+#define MCP_DNS_CACHE_TTL_MS 300000
+#endif
+
+class McpDnsCache {
+public:
+    McpDnsCache() : _resolvedAt(0), _valid(false) {}
+
+    /* *
+     * Address of host, looked up only when the cached one is missing or expired
+     * @param cached Set to whether the answer came from the cache
+     * @return false if the lookup failed
+     */
+    bool resolve(const String &host, IPAddress &ip, bool &cached);
+
+    void invalidate() { _valid = false; }
+
+private:
+    String _host;
+    IPAddress _ip;
+    unsigned long _resolvedAt;
+    bool _valid;
+};
+
+#endif // MCP_DNS_CACHE_H
@@ -0,0 +1,61 @@
+#include "McpEndpointManager.h"
+
+#include <new>
+
+McpEndpointManager::~McpEndpointManager() {
+    for (size_t i = 0; i < _endpoints.size(); i++) {
+        delete _endpoints[i];
+    }
+}
+
+WebSocketMCP *McpEndpointManager::addEndpoint(Client &client, const char *mcpEndpoint) {
+    Endpoint *endpoint = new (std::nothrow) Endpoint(client);
+    if (!endpoint) {
+        MCP_LOGE("ERROR: Out of memory adding endpoint %s", mcpEndpoint);
+        return nullptr;
+    }
+    endpoint->url = mcpEndpoint;
+    endpoint->mcp.useToolRegistry(_tools);
+    _endpoints.push_back(endpoint);
+    return &endpoint->mcp;
+}
+
+bool McpEndpointManager::begin(EndpointCallback callback) {
+    _callback = callback;
+    bool ok = true;
+    for (size_t i = 0; i < _endpoints.size(); i++) {
+        Endpoint *endpoint = _endpoints[i];
+        bool started = endpoint->mcp.begin(endpoint->url.c_str(), [this, i](bool up) {
+            if (_callback) {
+                _callback(i, up);
+            }
+        });
+        if (!started) {
+            MCP_LOGE("ERROR: Endpoint %u (%s) did not start.", (unsigned)i, endpoint->url.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void McpEndpointManager::loop() {
+    for (size_t i = 0; i < _endpoints.size(); i++) {
+        _endpoints[i]->mcp.loop();
+    }
+}
+
+void McpEndpointManager::disconnect() {
+    for (size_t i = 0; i < _endpoints.size(); i++) {
+        _endpoints[i]->mcp.disconnect();
+    }
+}
+
+size_t McpEndpointManager::connectedCount() {
+    size_t count = 0;
+    for (size_t i = 0; i < _endpoints.size(); i++) {
+        if (_endpoints[i]->mcp.isConnected()) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,110 @@
+#ifndef MCP_ENDPOINT_MANAGER_H
+#define MCP_ENDPOINT_MANAGER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include "WebSocketMCP.h"
+
+/* *
+ * McpEndpointManager Class
+ * Serves one set of tools to several MCP servers at once, e.g. a production
+ * and a staging agent.
+ *
+ * Each endpoint is a complete WebSocketMCP with its own client, transport
+ * state, reconnect backoff, keepalive and metrics; a dropped or misbehaving
+ * server does not affect the others. All of them answer from one
+ * McpToolRegistry, so tools are registered once, and loop() polls them in
+ * turn from the calling task.
+ *
+ * An endpoint costs what a single WebSocketMCP costs, minus the tools. At the
+ * default sizes that is about 3 KB for the object (1 KB of it the upgrade
+ * response buffer) and, from begin(), about 28 KB of heap: the MCP_TX_QUEUE_SIZE
+ * send queue (16 KB) with its 1 KB coalescing buffer and control frame slots,
+ * the MCP_RX_MAX_MESSAGE_SIZE receive buffer (8 KB), the 1 KB outgoing frame
+ * buffer and the MCP_JSON_DOC_CAPACITY document (1 KB, growing up to
+ * MCP_JSON_DOC_MAX_CAPACITY). A wss:// endpoint adds its TLS client's buffers,
+ * and beginNetworkTask() on it another task stack and MCP_NET_RX_RING_SIZE.
+ *
+ * loop() serves the endpoints one after another, so a blocking connect or
+ * handshake on one of them delays the rest; give each endpoint its network
+ * task where that matters.
+ */
+
+// Connection changes of endpoint number index (in the order added)
+typedef std::function<void(size_t index, bool connected)> EndpointCallback;
+
+class McpEndpointManager {
+public:
+    McpEndpointManager() {}
+    ~McpEndpointManager();
+
+    /* *
+    * Add a server to connect to
+    * The connection uses the shared tools; configure it further (headers, compression, keepalive)
+    * through the returned pointer before begin().
+    * @param client Client of this connection only; must outlive the manager
+    * @param mcpEndpoint WebSocket server address (ws://host:port/path or wss://...)
+    * @return The connection, or nullptr if out of memory
+    */
+    WebSocketMCP *addEndpoint(Client &client, const char *mcpEndpoint);
+
+    /* *
+    * Start connecting every endpoint added
+    * @param callback Called from loop() when an endpoint connects or disconnects
+    * @return false if any endpoint failed to start (the others still run)
+    */
+    bool begin(EndpointCallback callback = nullptr);
+
+    // Poll every endpoint; call frequently from the main loop
+    void loop();
+
+    // Disconnect every endpoint
+    void disconnect();
+
+    size_t endpointCount() const { return _endpoints.size(); }
+    WebSocketMCP &endpoint(size_t index) { return _endpoints[index]->mcp; }
+    const String &endpointUrl(size_t index) const { return _endpoints[index]->url; }
+    size_t connectedCount();
+
+    // Tools served on every endpoint; stats are summed over all of them
+    McpToolRegistry &tools() { return _tools; }
+
+    bool registerTool(const String &name, const String &description, const String &inputSchema,
+                      ToolCallback callback) {
+        return _tools.add(name, description, inputSchema, McpToolRegistry::adaptStringCallback(callback));
+    }
+    bool registerTool(const String &name, const String &description, const String &inputSchema,
+                      ToolArgsCallback callback) {
+        return _tools.add(name, description, inputSchema, callback);
+    }
+    bool registerTool(const String &name, const String &description, const String &inputSchema,
+                      ToolWriterCallback callback) {
+        return _tools.add(name, description, inputSchema, callback);
+    }
+    template <typename Args, size_t N>
+    bool registerTypedTool(const String &name, const String &description, const McpToolParam (&params)[N],
+                           typename McpTypedTool::Callback<Args>::Type callback) {
+        static_assert(N <= McpTypedTool::MAX_PARAMS, "too many tool parameters");
+        return _tools.add(name, description, McpTypedTool::schema(params, N),
+                          McpTypedTool::writer<Args>(params, N, callback));
+    }
+    bool unregisterTool(const String &name) { return _tools.remove(name); }
+
+private:
+    struct Endpoint {
+        explicit Endpoint(Client &client) : mcp(client) {}
+        WebSocketMCP mcp;
+        String url;
+    };
+
+    McpEndpointManager(const McpEndpointManager &);
+    McpEndpointManager &operator=(const McpEndpointManager &);
+
+    // Declared first: the endpoints refer to it and are destroyed before it
+    McpToolRegistry _tools;
+    std::vector<Endpoint *> _endpoints;
+    EndpointCallback _callback;
+};
+
+#endif // MCP_ENDPOINT_MANAGER_H
@@ -0,0 +1,118 @@
+#include "McpHeapTrace.h"
+
+#include <limits.h>
+#include <string.h>
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+
+#if MCP_HEAP_TRACE_HOOKS && CONFIG_HEAP_USE_HOOKS
+#define MCP_HEAP_COUNTS 1
+#include <atomic>
+
+static std::atomic<uint32_t> heapTracers(0);
+static std::atomic<uint32_t> heapAllocs(0);
+static std::atomic<uint32_t> heapBytes(0);
+
+// Called by the allocator for every successful allocation; must stay short and in IRAM
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    (void)ptr;
+    (void)caps;
+    if (heapTracers.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    heapBytes.fetch_add((uint32_t)size, std::memory_order_relaxed);
+}
+#else
+#define MCP_HEAP_COUNTS 0
+#endif
+
+McpHeapSnapshot McpHeapSnapshot::take() {
+    McpHeapSnapshot s;
+#if MCP_HEAP_COUNTS
+    s.allocs = heapAllocs.load(std::memory_order_relaxed);
+    s.bytes = heapBytes.load(std::memory_order_relaxed);
+#else
+    s.allocs = 0;
+    s.bytes = 0;
+#endif
+    s.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    return s;
+}
+
+bool McpHeapSnapshot::countsAllocations() {
+#if MCP_HEAP_COUNTS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void McpHeapSnapshot::setCounting(bool on) {
+#if MCP_HEAP_COUNTS
+    if (on) {
+        heapTracers.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        heapTracers.fetch_sub(1, std::memory_order_relaxed);
+    }
+#else
+    (void)on;
+#endif
+}
+
+#else
+
+McpHeapSnapshot McpHeapSnapshot::take() {
+    McpHeapSnapshot s;
+    uint32_t inUse = 0;
+    s.allocs = 0;
+    s.bytes = 0;
+    if (mcpHostHeapCounters) {
+        mcpHostHeapCounters(s.allocs, s.bytes, inUse);
+    }
+    s.freeHeap = UINT32_MAX - inUse;
+    s.largestBlock = s.freeHeap;
+    return s;
+}
+
+bool McpHeapSnapshot::countsAllocations() {
+    return mcpHostHeapCounters != nullptr;
+}
+
+// The host executable counts all the time
+void McpHeapSnapshot::setCounting(bool on) {
+    (void)on;
+}
+
+#endif
+
+void McpHeapStats::reset() {
+    memset(this, 0, sizeof(*this));
+}
+
+void McpHeapStats::record(const McpHeapSnapshot &before, const McpHeapSnapshot &after) {
+    uint32_t callAllocs = after.allocs - before.allocs;
+    uint32_t callBytes = after.bytes - before.bytes;
+    int32_t freeDelta = (int32_t)(after.freeHeap - before.freeHeap);
+    int32_t largestDelta = (int32_t)(after.largestBlock - before.largestBlock);
+
+    calls++;
+    allocs += callAllocs;
+    bytes += callBytes;
+    if (callAllocs > maxAllocs) {
+        maxAllocs = callAllocs;
+    }
+    if (callBytes > maxBytes) {
+        maxBytes = callBytes;
+    }
+    lastFreeDelta = freeDelta;
+    lastLargestDelta = largestDelta;
+    if (freeDelta < minFreeDelta) {
+        minFreeDelta = freeDelta;
+    }
+    if (largestDelta < minLargestDelta) {
+        minLargestDelta = largestDelta;
+    }
+}
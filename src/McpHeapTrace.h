@@ -0,0 +1,72 @@
+#ifndef MCP_HEAP_TRACE_H
+#define MCP_HEAP_TRACE_H
+
+#include <Arduino.h>
+
+/* *
+ * Heap instrumentation around JSON-RPC methods and tool callbacks
+ * (see WebSocketMCP::setHeapTrace).
+ *
+ * A snapshot is taken before and after each call; the difference is the
+ * number of allocations and bytes the call made and how much the free heap and
+ * the largest free block changed across it. A shrinking largest block with an
+ * unchanged free heap is fragmentation.
+ *
+ * Where the figures come from:
+ * - ESP32: free heap and largest block from heap_caps (8-bit capable memory).
+ *   Allocations are counted by the library's esp_heap_trace_alloc_hook, which
+ *   needs CONFIG_HEAP_USE_HOOKS in the sdkconfig and MCP_HEAP_TRACE_HOOKS set to
+ *   1; otherwise the counts stay 0. ESP-IDF has a single slot for that hook, so
+ *   the application opts in: one that defines the hook itself leaves the macro
+ *   at 0. The hook counts only while heap tracing is on somewhere.
+ * - Host: the executable counts by interposing malloc and reports through
+ *   mcpHostHeapCounters() (extras/host/support/AllocHook.cpp). glibc's heap has
+ *   no fixed size, so both heap figures follow the bytes in use.
+ *
+ * The counters are process wide: whatever other tasks allocate during a call
+ * (the network task, WiFi) is counted as well.
+ */
+
+// Define as 1 to have the library define ESP-IDF's esp_heap_trace_alloc_hook (see above)
+#ifndef MCP_HEAP_TRACE_HOOKS
+#define MCP_HEAP_TRACE_HOOKS 0
+#endif
+
+struct McpHeapSnapshot {
+    uint32_t allocs;       // allocations so far (wraps; only differences matter)
+    uint32_t bytes;        // bytes requested by them
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+
+    static McpHeapSnapshot take();
+
+    // Whether allocations are counted on this build (see above)
+    static bool countsAllocations();
+
+    // Count allocations while at least one caller has it on; calls nest
+    static void setCounting(bool on);
+};
+
+// What the calls of one method or tool did to the heap
+struct McpHeapStats {
+    uint32_t calls;
+    uint32_t allocs;          // over all calls
+    uint64_t bytes;
+    uint32_t maxAllocs;       // most in one call
+    uint32_t maxBytes;
+    int32_t lastFreeDelta;    // change of the free heap across the latest call
+    int32_t lastLargestDelta; // change of the largest free block across the latest call
+    int32_t minFreeDelta;     // largest drop across one call: memory the call kept
+    int32_t minLargestDelta;  // largest drop of the biggest block: fragmentation
+
+    McpHeapStats() { reset(); }
+    void reset();
+    void record(const McpHeapSnapshot &before, const McpHeapSnapshot &after);
+};
+
+#ifndef ESP32
+// Provided by a host executable counting allocations; weak, so absent means no counts
+void mcpHostHeapCounters(uint32_t &allocs, uint32_t &bytes, uint32_t &inUse) __attribute__((weak));
+#endif
+
+#endif // MCP_HEAP_TRACE_H
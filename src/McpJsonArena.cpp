@@ -0,0 +1,76 @@
+#include "McpJsonArena.h"
+
+#include <new>
+
+McpJsonArena::McpJsonArena(size_t capacity, size_t maxCapacity) : _doc(nullptr) {
+    _stats.capacity = capacity;
+    _stats.maxCapacity = maxCapacity < capacity ? capacity : maxCapacity;
+    _stats.peakUsage = 0;
+    _stats.messages = 0;
+    _stats.grows = 0;
+    _stats.overflows = 0;
+}
+
+McpJsonArena::~McpJsonArena() {
+    delete _doc;
+}
+
+bool McpJsonArena::allocate(size_t capacity) {
+    delete _doc;
+    _doc = new (std::nothrow) DynamicJsonDocument(capacity);
+    // DynamicJsonDocument reports capacity 0 when its pool allocation failed
+    if (!_doc || _doc->capacity() == 0) {
+        delete _doc;
+        _doc = nullptr;
+        return false;
+    }
+    _stats.capacity = capacity;
+    return true;
+}
+
+bool McpJsonArena::begin(size_t capacity, size_t maxCapacity) {
+    _stats.maxCapacity = maxCapacity < capacity ? capacity : maxCapacity;
+    if (_doc && _stats.capacity == capacity) {
+        return true;
+    }
+    return allocate(capacity);
+}
+
+DeserializationError McpJsonArena::parse(const char *json, size_t length) {
+    if (!_doc && !allocate(_stats.capacity)) {
+        return DeserializationError::NoMemory;
+    }
+
+    while (true) {
+        _doc->clear();
+        DeserializationError error = deserializeJson(*_doc, json, length);
+
+        if (error == DeserializationError::NoMemory) {
+            if (_stats.capacity >= _stats.maxCapacity) {
+                _stats.overflows++;
+                return error;
+            }
+            size_t grown = _stats.capacity * 2;
+            if (grown > _stats.maxCapacity) {
+                grown = _stats.maxCapacity;
+            }
+            size_t previous = _stats.capacity;
+            if (!allocate(grown)) {
+                // Fall back to the previous size so the next message still has a document
+                allocate(previous);
+                _stats.overflows++;
+                return error;
+            }
+            _stats.grows++;
+            continue;
+        }
+
+        if (!error) {
+            _stats.messages++;
+            if (_doc->memoryUsage() > _stats.peakUsage) {
+                _stats.peakUsage = _doc->memoryUsage();
+            }
+        }
+        return error;
+    }
+}
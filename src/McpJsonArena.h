@@ -0,0 +1,70 @@
+#ifndef MCP_JSON_ARENA_H
+#define MCP_JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/* *
+ * McpJsonArena Class
+ * One persistent JSON document reused for every inbound JSON-RPC message.
+ *
+ * The document is allocated once (at WebSocketMCP::begin() or on first use) and
+ * cleared between messages instead of being allocated and freed per message.
+ * When a message does not fit, the document is reallocated at twice the size,
+ * up to maxCapacity, and the message parsed again; the larger size is kept.
+ * Messages that do not fit even at maxCapacity are rejected and counted, so
+ * the sizes can be tuned from getJsonDocumentStats() in the field.
+ */
+
+// Initial document capacity in bytes
+#ifndef MCP_JSON_DOC_CAPACITY
+#define MCP_JSON_DOC_CAPACITY 1024
+#endif
+
+// Hard ceiling for growth; equal to MCP_JSON_DOC_CAPACITY disables growth
+#ifndef MCP_JSON_DOC_MAX_CAPACITY
+#define MCP_JSON_DOC_MAX_CAPACITY 4096
+#endif
+
+class McpJsonArena {
+public:
+    struct Stats {
+        size_t capacity;     // current document capacity
+        size_t maxCapacity;  // growth ceiling
+        size_t peakUsage;    // largest memoryUsage() of a parsed message
+        uint32_t messages;   // messages parsed successfully
+        uint32_t grows;      // times the document was reallocated larger
+        uint32_t overflows;  // messages rejected for not fitting at maxCapacity
+    };
+
+    McpJsonArena(size_t capacity = MCP_JSON_DOC_CAPACITY, size_t maxCapacity = MCP_JSON_DOC_MAX_CAPACITY);
+    ~McpJsonArena();
+
+    /* *
+     * Set the capacities and allocate the document now
+     * @param maxCapacity Growth ceiling; values below capacity are raised to it
+     * @return false if the allocation failed
+     */
+    bool begin(size_t capacity, size_t maxCapacity);
+    bool begin() { return begin(_stats.capacity, _stats.maxCapacity); }
+
+    /* *
+     * Clear the document and parse a message into it, growing if needed
+     * The document stays valid until the next parse().
+     */
+    DeserializationError parse(const char *json, size_t length);
+
+    JsonDocument &doc() { return *_doc; }
+    const Stats &stats() const { return _stats; }
+
+private:
+    McpJsonArena(const McpJsonArena &);
+    McpJsonArena &operator=(const McpJsonArena &);
+
+    bool allocate(size_t capacity);
+
+    DynamicJsonDocument *_doc;
+    Stats _stats;
+};
+
+#endif // MCP_JSON_ARENA_H
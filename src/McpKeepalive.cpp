@@ -0,0 +1,88 @@
+#include "McpKeepalive.h"
+
+McpKeepalive::McpKeepalive()
+    : _interval(MCP_KEEPALIVE_INTERVAL_MS), _probes(MCP_KEEPALIVE_PROBES), _lastReceived(0), _probeSentAt(0),
+      _probesOut(0), _sequence(0), _answered(0), _srtt(0), _rttVar(0) {}
+
+void McpKeepalive::configure(uint32_t intervalMs, uint8_t probes) {
+    _interval = intervalMs;
+    _probes = probes > 0 ? probes : 1;
+}
+
+void McpKeepalive::reset(unsigned long now) {
+    _lastReceived = now;
+    _probesOut = 0;
+    _answered = _sequence;
+}
+
+void McpKeepalive::received(unsigned long now) {
+    _lastReceived = now;
+    _probesOut = 0;
+}
+
+uint32_t McpKeepalive::timeout() const {
+    if (_srtt == 0) {
+        return MCP_KEEPALIVE_MAX_TIMEOUT_MS;
+    }
+    uint32_t t = 2 * (srtt() + 4 * rttVar());
+    if (t < MCP_KEEPALIVE_MIN_TIMEOUT_MS) {
+        return MCP_KEEPALIVE_MIN_TIMEOUT_MS;
+    }
+    return t > MCP_KEEPALIVE_MAX_TIMEOUT_MS ? MCP_KEEPALIVE_MAX_TIMEOUT_MS : t;
+}
+
+McpKeepalive::Action McpKeepalive::poll(unsigned long now) {
+    if (_probesOut == 0) {
+        return now - _lastReceived >= _interval ? PROBE : NONE;
+    }
+    if (now - _probeSentAt < timeout()) {
+        return NONE;
+    }
+    return _probesOut >= _probes ? DEAD : PROBE;
+}
+
+static void putBigEndian(uint8_t *out, uint32_t v) {
+    out[0] = (uint8_t)(v >> 24);
+    out[1] = (uint8_t)(v >> 16);
+    out[2] = (uint8_t)(v >> 8);
+    out[3] = (uint8_t)v;
+}
+
+static uint32_t getBigEndian(const uint8_t *in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+void McpKeepalive::probe(unsigned long now, uint8_t *payload) {
+    _sequence++;
+    _probesOut++;
+    _probeSentAt = now;
+    putBigEndian(payload, _sequence);
+    putBigEndian(payload + 4, (uint32_t)now);
+}
+
+bool McpKeepalive::pong(const uint8_t *payload, size_t len, unsigned long now, uint32_t &rttMs) {
+    if (len != PAYLOAD_LEN) {
+        return false;
+    }
+    // Only PINGs sent and not answered yet; a late answer to an earlier one still counts
+    uint32_t sequence = getBigEndian(payload);
+    if (sequence - _answered - 1 >= _sequence - _answered) {
+        return false;
+    }
+    _answered = sequence;
+    rttMs = (uint32_t)now - getBigEndian(payload + 4);
+
+    // RFC 6298 2.2/2.3 in fixed point: _srtt holds 8 * SRTT, _rttVar 4 * RTTVAR
+    if (_srtt == 0) {
+        _srtt = (rttMs << 3) | 1; // never 0 again, even for a 0 ms sample
+        _rttVar = rttMs << 1;
+    } else {
+        int32_t delta = (int32_t)rttMs - (int32_t)(_srtt >> 3);
+        _srtt += delta;
+        if (delta < 0) {
+            delta = -delta;
+        }
+        _rttVar += delta - (int32_t)(_rttVar >> 2);
+    }
+    return true;
+}
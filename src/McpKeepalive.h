@@ -0,0 +1,96 @@
+#ifndef MCP_KEEPALIVE_H
+#define MCP_KEEPALIVE_H
+
+#include <Arduino.h>
+
+/* *
+ * McpKeepalive Class
+ * Decides when to PING the server and when to give up on it (transport side only).
+ *
+ * Anything received from the server proves it is alive, so a PING only goes out
+ * after MCP_KEEPALIVE_INTERVAL_MS without a single byte from it; while data is
+ * flowing no PINGs are sent at all. Each PING carries a sequence number and its
+ * send time, so the matching PONG gives a round-trip sample without any state
+ * per PING. The samples feed a smoothed RTT and mean deviation as TCP keeps them
+ * (RFC 6298, gains 1/8 and 1/4).
+ *
+ * An unanswered PING is repeated after a timeout derived from those estimates,
+ * 2 * (SRTT + 4 * RTTVAR) kept within MCP_KEEPALIVE_MIN/MAX_TIMEOUT_MS (the
+ * maximum until the first sample). After MCP_KEEPALIVE_PROBES unanswered PINGs
+ * the peer is considered dead. A link with a 100 ms RTT is thus given up about
+ * 16 s after it went quiet, instead of after a fixed minute.
+ */
+
+// Quiet time before the server is probed with a PING
+#ifndef MCP_KEEPALIVE_INTERVAL_MS
+#define MCP_KEEPALIVE_INTERVAL_MS 10000
+#endif
+
+// Unanswered PINGs before the connection is closed
+#ifndef MCP_KEEPALIVE_PROBES
+#define MCP_KEEPALIVE_PROBES 3
+#endif
+
+// Bounds of the time a PING is given to be answered
+#ifndef MCP_KEEPALIVE_MIN_TIMEOUT_MS
+#define MCP_KEEPALIVE_MIN_TIMEOUT_MS 2000
+#endif
+#ifndef MCP_KEEPALIVE_MAX_TIMEOUT_MS
+#define MCP_KEEPALIVE_MAX_TIMEOUT_MS 15000
+#endif
+
+class McpKeepalive {
+public:
+    enum Action {
+        NONE,
+        PROBE, // send a PING with probe()
+        DEAD   // MCP_KEEPALIVE_PROBES PINGs went unanswered
+    };
+
+    static const size_t PAYLOAD_LEN = 8; // sequence number and send time, big-endian
+
+    McpKeepalive();
+
+    void configure(uint32_t intervalMs, uint8_t probes);
+    uint32_t interval() const { return _interval; }
+    uint8_t probes() const { return _probes; }
+
+    // A connection was established; the RTT estimates are kept from earlier ones
+    void reset(unsigned long now);
+
+    // Some bytes arrived from the server
+    void received(unsigned long now);
+
+    Action poll(unsigned long now);
+
+    // Fill the payload of the PING to send now; call when poll() returned PROBE
+    void probe(unsigned long now, uint8_t *payload);
+
+    /* *
+     * A PONG arrived
+     * @param rttMs Set to the round-trip time of the PING it answers
+     * @return false if it answers none of ours (e.g. an unsolicited PONG)
+     */
+    bool pong(const uint8_t *payload, size_t len, unsigned long now, uint32_t &rttMs);
+
+    // Smoothed round-trip time and mean deviation in ms; 0 before the first sample
+    uint32_t srtt() const { return _srtt >> 3; }
+    uint32_t rttVar() const { return _rttVar >> 2; }
+
+    // How long a PING is given to be answered
+    uint32_t timeout() const;
+
+private:
+    uint32_t _interval;
+    uint8_t _probes;
+
+    unsigned long _lastReceived;
+    unsigned long _probeSentAt;
+    uint8_t _probesOut;    // PINGs sent since the server last sent anything
+    uint32_t _sequence;    // of the last PING sent
+    uint32_t _answered;    // sequence of the last PING answered
+    uint32_t _srtt;        // scaled by 8, as in RFC 6298 implementations
+    uint32_t _rttVar;      // scaled by 4
+};
+
+#endif // MCP_KEEPALIVE_H
@@ -0,0 +1,164 @@
+#include "McpLog.h"
+
+#include <stdarg.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#else
+#include <mutex>
+#endif
+
+namespace {
+
+const char PREFIX[] = "[xiaozhi-mcp] ";
+const size_t PREFIX_LEN = sizeof(PREFIX) - 1;
+
+struct Record {
+    uint32_t time;   // millis() when logged
+    uint16_t length; // of text, without the terminator
+    uint8_t level;
+    char text[MCP_LOG_LINE_SIZE];
+};
+
+Print *output = &Serial;
+
+// Ring buffer for deferred mode; written from any task, so guarded by a lock
+// that is only held to copy one record
+Record *ring = nullptr;
+size_t ringHead = 0; // next record to write
+size_t ringCount = 0;
+uint32_t ringDropped = 0;
+
+#ifdef ESP32
+portMUX_TYPE ringLock = portMUX_INITIALIZER_UNLOCKED;
+#define RING_LOCK() portENTER_CRITICAL(&ringLock)
+#define RING_UNLOCK() portEXIT_CRITICAL(&ringLock)
+#else
+std::mutex ringLock;
+#define RING_LOCK() ringLock.lock()
+#define RING_UNLOCK() ringLock.unlock()
+#endif
+
+// E, W, I or D, as in ESP-IDF logs
+char levelLetter(uint8_t level) {
+    static const char LETTERS[] = "?EWID";
+    return level < sizeof(LETTERS) - 1 ? LETTERS[level] : '?';
+}
+
+// "[xiaozhi-mcp] W " + text + "\r\n", in one write() so lines from different tasks do not mix
+void printLine(uint8_t level, const char *text, size_t length) {
+    char line[PREFIX_LEN + 2 + MCP_LOG_LINE_SIZE + 2];
+    memcpy(line, PREFIX, PREFIX_LEN);
+    line[PREFIX_LEN] = levelLetter(level);
+    line[PREFIX_LEN + 1] = ' ';
+    memcpy(line + PREFIX_LEN + 2, text, length);
+    length += PREFIX_LEN + 2;
+    line[length] = '\r';
+    line[length + 1] = '\n';
+    output->write((const uint8_t *)line, length + 2);
+}
+
+} // namespace
+
+void McpLog::write(uint8_t level, const char *format, ...) {
+    char text[MCP_LOG_LINE_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+    if ((size_t)length >= sizeof(text)) {
+        length = sizeof(text) - 1; // truncated
+    }
+
+    uint32_t now = millis();
+    RING_LOCK();
+    if (!ring) {
+        RING_UNLOCK();
+        printLine(level, text, length);
+        return;
+    }
+    if (ringCount < MCP_LOG_RING_RECORDS) {
+        Record &record = ring[ringHead];
+        record.time = now;
+        record.length = (uint16_t)length;
+        record.level = level;
+        memcpy(record.text, text, length);
+        ringHead = (ringHead + 1) % MCP_LOG_RING_RECORDS;
+        ringCount++;
+    } else {
+        ringDropped++;
+    }
+    RING_UNLOCK();
+}
+
+bool McpLog::setDeferred(bool deferred) {
+    if (deferred == (ring != nullptr)) {
+        return true;
+    }
+    if (deferred) {
+        Record *records = (Record *)malloc(sizeof(Record) * MCP_LOG_RING_RECORDS);
+        if (!records) {
+            return false;
+        }
+        RING_LOCK();
+        ring = records;
+        RING_UNLOCK();
+        return true;
+    }
+
+    flush(MCP_LOG_RING_RECORDS);
+    RING_LOCK();
+    Record *old = ring;
+    ring = nullptr;
+    ringCount = 0;
+    RING_UNLOCK();
+    free(old);
+    return true;
+}
+
+bool McpLog::deferred() {
+    return ring != nullptr;
+}
+
+size_t McpLog::flush(size_t maxRecords) {
+    size_t printed = 0;
+    while (printed < maxRecords) {
+        Record record;
+        RING_LOCK();
+        // Checked under the lock: setDeferred(false) may free the ring from another task
+        if (!ring || ringCount == 0) {
+            RING_UNLOCK();
+            break;
+        }
+        size_t tail = (ringHead + MCP_LOG_RING_RECORDS - ringCount) % MCP_LOG_RING_RECORDS;
+        record.time = ring[tail].time;
+        record.length = ring[tail].length;
+        record.level = ring[tail].level;
+        memcpy(record.text, ring[tail].text, record.length);
+        ringCount--;
+        RING_UNLOCK();
+
+        // The time it was logged, since it is printed later
+        char line[MCP_LOG_LINE_SIZE + 16];
+        int stamp = snprintf(line, sizeof(line), "%lu ", (unsigned long)record.time);
+        size_t length = record.length;
+        if (stamp + length > MCP_LOG_LINE_SIZE) {
+            length = MCP_LOG_LINE_SIZE - stamp;
+        }
+        memcpy(line + stamp, record.text, length);
+        printLine(record.level, line, stamp + length);
+        printed++;
+    }
+    return printed;
+}
+
+uint32_t McpLog::dropped() {
+    return ringDropped;
+}
+
+void McpLog::setOutput(Print &out) {
+    output = &out;
+}
@@ -0,0 +1,95 @@
+#ifndef MCP_LOG_H
+#define MCP_LOG_H
+
+#include <Arduino.h>
+
+/* *
+ * McpLog
+ * Logging facade for the library: MCP_LOGE / MCP_LOGW / MCP_LOGI / MCP_LOGD take
+ * printf-style arguments and print "[xiaozhi-mcp] <level> <message>" lines, the level
+ * being one letter: E, W, I or D.
+ *
+ * Levels above MCP_LOG_LEVEL compile to nothing, arguments included, so per-message
+ * debug logging costs nothing in a release build. Lines are formatted into a stack
+ * buffer of MCP_LOG_LINE_SIZE bytes (longer ones are truncated) and written with a
+ * single write(), never building Strings.
+ *
+ * In deferred mode (setDeferred(true)) a line is only formatted into a fixed-size
+ * record of a ring buffer; WebSocketMCP::loop() prints the records (flush()) after
+ * the messages have been handled, so the UART is off the request path. When the
+ * ring is full new lines are dropped and counted.
+ */
+
+#define MCP_LOG_LEVEL_NONE 0
+#define MCP_LOG_LEVEL_ERROR 1
+#define MCP_LOG_LEVEL_WARN 2
+#define MCP_LOG_LEVEL_INFO 3
+#define MCP_LOG_LEVEL_DEBUG 4
+
+// Most verbose level compiled in; MCP_LOG_LEVEL_DEBUG also logs every frame and payload
+#ifndef MCP_LOG_LEVEL
+#define MCP_LOG_LEVEL MCP_LOG_LEVEL_INFO
+#endif
+
+// Longest message kept, including the terminator
+#ifndef MCP_LOG_LINE_SIZE
+#define MCP_LOG_LINE_SIZE 128
+#endif
+
+// Records held by the deferred ring buffer
+#ifndef MCP_LOG_RING_RECORDS
+#define MCP_LOG_RING_RECORDS 32
+#endif
+
+class McpLog {
+public:
+    // Format and print (or queue, in deferred mode) one line; use the MCP_LOG* macros
+    static void write(uint8_t level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    /* *
+     * Switch deferred mode on or off
+     * Switching on allocates the ring buffer; switching off prints what it still holds.
+     * @return false if the ring buffer could not be allocated
+     */
+    static bool setDeferred(bool deferred);
+    static bool deferred();
+
+    /* *
+     * Print the queued records, oldest first
+     * @param maxRecords Stop after this many
+     * @return Number of records printed
+     */
+    static size_t flush(size_t maxRecords = MCP_LOG_RING_RECORDS);
+
+    // Lines dropped because the ring buffer was full
+    static uint32_t dropped();
+
+    // Where lines go (Serial by default)
+    static void setOutput(Print &output);
+};
+
+#if MCP_LOG_LEVEL >= MCP_LOG_LEVEL_ERROR
+#define MCP_LOGE(...) McpLog::write(MCP_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define MCP_LOGE(...) do { } while (0)
+#endif
+
+#if MCP_LOG_LEVEL >= MCP_LOG_LEVEL_WARN
+#define MCP_LOGW(...) McpLog::write(MCP_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define MCP_LOGW(...) do { } while (0)
+#endif
+
+#if MCP_LOG_LEVEL >= MCP_LOG_LEVEL_INFO
+#define MCP_LOGI(...) McpLog::write(MCP_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define MCP_LOGI(...) do { } while (0)
+#endif
+
+#if MCP_LOG_LEVEL >= MCP_LOG_LEVEL_DEBUG
+#define MCP_LOGD(...) McpLog::write(MCP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define MCP_LOGD(...) do { } while (0)
+#endif
+
+#endif // MCP_LOG_H
@@ -0,0 +1,49 @@
+#include "McpMetrics.h"
+
+#include <string.h>
+
+// Bucket upper bounds in microseconds: 100us, 1ms, 10ms, 50ms, 100ms, 500ms, 1s, then unbounded
+static const uint32_t LATENCY_BOUNDS[MCP_LATENCY_BUCKETS - 1] = {
+    100, 1000, 10000, 50000, 100000, 500000, 1000000
+};
+
+void McpToolStats::reset() {
+    memset(this, 0, sizeof(*this));
+}
+
+void McpToolStats::record(uint32_t us, bool error) {
+    calls++;
+    if (error) {
+        errors++;
+    }
+    totalUs += us;
+    if (us > maxUs) {
+        maxUs = us;
+    }
+
+    size_t bucket = 0;
+    while (bucket < MCP_LATENCY_BUCKETS - 1 && us >= LATENCY_BOUNDS[bucket]) {
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+uint32_t McpToolStats::bucketBound(size_t bucket) {
+    return bucket < MCP_LATENCY_BUCKETS - 1 ? LATENCY_BOUNDS[bucket] : 0;
+}
+
+void McpMetrics::reset() {
+    memset(this, 0, sizeof(*this));
+}
+
+void McpMetrics::recordRtt(uint32_t ms) {
+    pongsReceived++;
+    rttLastMs = ms;
+    rttTotalMs += ms;
+    if (pongsReceived == 1 || ms < rttMinMs) {
+        rttMinMs = ms;
+    }
+    if (ms > rttMaxMs) {
+        rttMaxMs = ms;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef MCP_METRICS_H
+#define MCP_METRICS_H
+
+#include <Arduino.h>
+
+/* *
+ * Runtime counters kept by WebSocketMCP (see getMetrics() / getToolStats()).
+ *
+ * Recording is a few integer increments per frame or call, plus two micros()
+ * reads around each tool callback, so it stays on in production. Counters are
+ * plain integers written by the task that owns them; in network task mode a
+ * snapshot taken from loop() may be a few frames behind.
+ */
+
+// Number of latency histogram buckets; the last one has no upper bound
+#define MCP_LATENCY_BUCKETS 8
+
+// Per-tool invocation counters and latency histogram
+struct McpToolStats {
+    uint32_t calls;
+    uint32_t errors;   // responses with isError set
+    uint32_t maxUs;
+    uint64_t totalUs;  // sum of all call durations, for the mean
+    uint32_t histogram[MCP_LATENCY_BUCKETS];
+
+    McpToolStats() { reset(); }
+    void reset();
+    void record(uint32_t us, bool error);
+
+    /* *
+     * Upper bound of a histogram bucket
+     * @return Microseconds (exclusive), or 0 for the last, unbounded bucket
+     */
+    static uint32_t bucketBound(size_t bucket);
+};
+
+// Where the time of one connect went, in ms. tlsMs is only split from tcpMs when the
+// connect handler reports it (see WebSocketMCP::setConnectHandler); otherwise it is 0.
+// A wss:// client without a handler looks the name up itself: dnsMs is 0, tcpMs has it.
+struct McpConnectTiming {
+    uint32_t dnsMs;
+    uint32_t tcpMs;
+    uint32_t tlsMs;
+    uint32_t upgradeMs;  // HTTP upgrade request and response
+};
+
+// Transport-level counters
+struct McpMetrics {
+    uint32_t framesIn;          // WebSocket frames received, fragments counted separately
+    uint32_t framesOut;
+    uint64_t bytesIn;           // frame bytes, headers included
+    uint64_t bytesOut;
+    uint32_t socketWrites;      // Client::write() calls; below framesOut when frames were coalesced
+    uint32_t sendQueueDepth;    // bytes waiting in the send queue now
+    uint32_t sendQueueHighWater;
+    uint32_t sendQueueFull;     // frames refused because the send queue was full
+    uint32_t sendStalls;        // times the socket took less than offered
+    uint32_t sendStallMs;       // total time frames waited for the socket
+    uint32_t messagesIn;        // JSON-RPC messages handled
+    uint32_t parseFailures;     // messages that were not valid JSON (or did not fit the document)
+    uint32_t frameErrors;       // protocol violations / oversized messages that closed the connection
+    uint32_t reconnectAttempts;
+    uint32_t reconnectTimeMs;   // total time spent connecting and handshaking
+    uint32_t connects;          // successful handshakes
+    McpConnectTiming lastConnect; // breakdown of the latest successful connect
+    uint32_t dnsLookups;        // host name resolutions; the others were served from the cache
+    uint32_t dnsCacheHits;
+    uint32_t tlsResumed;        // connects that resumed a TLS session (reported by the connect handler)
+    uint32_t pingsSent;
+    uint32_t pongsReceived;     // answers to our PINGs
+    uint32_t rttLastMs;         // PING round-trip time
+    uint32_t rttMinMs;
+    uint32_t rttMaxMs;
+    uint64_t rttTotalMs;        // sum over pongsReceived, for the mean
+    uint32_t rttSmoothedMs;     // RFC 6298 SRTT and RTTVAR, driving the PONG timeout
+    uint32_t rttVarMs;
+    uint32_t keepaliveTimeouts; // connections closed because PINGs went unanswered
+
+    McpMetrics() { reset(); }
+    void reset();
+    void recordRtt(uint32_t ms);
+};
+
+#endif // MCP_METRICS_H
@@ -0,0 +1,77 @@
+#include "McpNameIndex.h"
+
+// Static constant definition
+const int McpNameIndex::NOT_FOUND;
+const uint16_t McpNameIndex::EMPTY;
+
+// Smallest table, enough for the handful of tools a typical sketch registers
+static const size_t MIN_SLOTS = 16;
+
+uint32_t McpNameIndex::hash(const char *name, size_t len) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void McpNameIndex::place(uint32_t hash, uint16_t position) {
+    size_t mask = _slots.size() - 1;
+    size_t i = hash & mask;
+    while (_slots[i].position != EMPTY) {
+        i = (i + 1) & mask;
+    }
+    _slots[i].hash = hash;
+    _slots[i].position = position;
+}
+
+void McpNameIndex::rehash(size_t slotCount) {
+    std::vector<Slot> old;
+    old.swap(_slots);
+    Slot empty = {0, EMPTY};
+    _slots.assign(slotCount, empty);
+    for (size_t i = 0; i < old.size(); i++) {
+        if (old[i].position != EMPTY) {
+            place(old[i].hash, old[i].position);
+        }
+    }
+}
+
+bool McpNameIndex::insert(uint32_t hash, size_t position) {
+    if (position >= EMPTY) {
+        return false;
+    }
+    // Keep the load factor at or below 3/4 so probe sequences stay short
+    if ((_count + 1) * 4 > _slots.size() * 3) {
+        size_t slotCount = _slots.empty() ? MIN_SLOTS : _slots.size() * 2;
+        rehash(slotCount);
+    }
+    place(hash, (uint16_t)position);
+    _count++;
+    return true;
+}
+
+void McpNameIndex::remove(size_t position) {
+    // Removal is rare (unregisterTool), so rebuild instead of tombstoning:
+    // drop the entry and shift later positions down to follow vector::erase.
+    std::vector<Slot> old;
+    old.swap(_slots);
+    Slot empty = {0, EMPTY};
+    _slots.assign(old.size(), empty);
+    _count = 0;
+    for (size_t i = 0; i < old.size(); i++) {
+        uint16_t pos = old[i].position;
+        if (pos == EMPTY || pos == position) {
+            continue;
+        }
+        place(old[i].hash, pos > position ? pos - 1 : pos);
+        _count++;
+    }
+}
+
+void McpNameIndex::clear() {
+    _slots.clear();
+    _count = 0;
+}
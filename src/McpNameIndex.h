@@ -0,0 +1,72 @@
+#ifndef MCP_NAME_INDEX_H
+#define MCP_NAME_INDEX_H
+
+#include <Arduino.h>
+#include <vector>
+
+/* *
+ * McpNameIndex Class
+ * Open-addressing hash index from a name to its position in a vector.
+ * Used for registered tools and JSON-RPC method handlers.
+ *
+ * The entries themselves stay in a vector in registration order (tools/list needs
+ * that order); the index only stores each name's 32-bit FNV-1a hash and position,
+ * so a lookup is one hash of the requested name plus, on average, a single full
+ * name compare. The table is a power of two, linearly probed and kept at most
+ * 3/4 full: 8 bytes per slot, about 1 KB for 64 tools.
+ */
+class McpNameIndex {
+public:
+    static const int NOT_FOUND = -1;
+
+    McpNameIndex() : _count(0) {}
+
+    static uint32_t hash(const char *name, size_t len);
+
+    // Add a name hash at the given vector position
+    bool insert(uint32_t hash, size_t position);
+
+    // Remove the entry at position; entries after it move down by one, like vector::erase
+    void remove(size_t position);
+
+    void clear();
+    size_t size() const { return _count; }
+
+    /* *
+     * Find the position of a name
+     * @param match Called with candidate positions whose hash matches; returns true on a real match
+     * @return Vector position, or NOT_FOUND
+     */
+    template <typename Match>
+    int find(uint32_t hash, Match match) const {
+        if (_slots.empty()) {
+            return NOT_FOUND;
+        }
+        size_t mask = _slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot &slot = _slots[i];
+            if (slot.position == EMPTY) {
+                return NOT_FOUND;
+            }
+            if (slot.hash == hash && match((size_t)slot.position)) {
+                return (int)slot.position;
+            }
+        }
+    }
+
+private:
+    static const uint16_t EMPTY = 0xFFFF;
+
+    struct Slot {
+        uint32_t hash;
+        uint16_t position;
+    };
+
+    void place(uint32_t hash, uint16_t position);
+    void rehash(size_t slotCount);
+
+    std::vector<Slot> _slots;
+    size_t _count;
+};
+
+#endif // MCP_NAME_INDEX_H
@@ -0,0 +1,179 @@
+#include "McpResponseWriter.h"
+
+void McpResponseWriter::begin(const char *closing) {
+    if (_batch) {
+        // Beginning again replaces the open reply, as outside a batch
+        discard();
+        _entryStart = _out.payloadLength();
+        raw(_entries > 0 ? "," : "[");
+    } else {
+        _out.begin();
+        _ok = true;
+    }
+    _open = true;
+    _notification = false;
+    _closing = closing;
+}
+
+void McpResponseWriter::id(JsonVariantConst id) {
+    raw("{\"jsonrpc\":\"2.0\",\"id\":");
+    if (id.isNull()) {
+        raw("null");
+    } else {
+        serializeJson(id, *this);
+    }
+}
+
+void McpResponseWriter::beginResult(JsonVariantConst requestId) {
+    begin("}");
+    id(requestId);
+    raw(",\"result\":");
+}
+
+void McpResponseWriter::beginError(JsonVariantConst requestId, int code) {
+    begin("}}");
+    id(requestId);
+    char buf[48]; // fits any int code
+    int n = snprintf(buf, sizeof(buf), ",\"error\":{\"code\":%d,\"message\":", code);
+    raw(buf, (size_t)n);
+}
+
+void McpResponseWriter::beginNotification(const char *method) {
+    begin("}");
+    _notification = true;
+    raw("{\"jsonrpc\":\"2.0\",\"method\":\"");
+    raw(method); // Method names are literals that need no escaping
+    raw("\"");
+}
+
+void McpResponseWriter::error(JsonVariantConst requestId, int code, const char *message) {
+    beginError(requestId, code);
+    string(message);
+}
+
+bool McpResponseWriter::end() {
+    if (_batch && _notification) {
+        discard(); // A batch reply holds responses only
+        return _ok;
+    }
+    raw(_closing);
+    _open = false;
+    if (_batch) {
+        _entries++;
+    }
+    return _ok;
+}
+
+void McpResponseWriter::discard() {
+    if (_open && _batch) {
+        _out.truncate(_entryStart);
+    }
+    _open = false;
+}
+
+void McpResponseWriter::beginBatch() {
+    _out.begin();
+    _ok = true;
+    _open = false;
+    _batch = true;
+    _entries = 0;
+}
+
+bool McpResponseWriter::endBatch() {
+    discard();
+    _batch = false;
+    if (_entries == 0) {
+        return false;
+    }
+    raw("]");
+    return _ok;
+}
+
+void McpResponseWriter::raw(const char *json, size_t len) {
+    if (_ok && !_out.append(json, len)) {
+        _ok = false;
+    }
+}
+
+void McpResponseWriter::string(const char *text, size_t len) {
+    raw("\"", 1);
+    escaped(text, len);
+    raw("\"", 1);
+}
+
+void McpResponseWriter::escaped(const char *text, size_t len) {
+    escape(*this, text, len);
+}
+
+// Escape sequence for c written into esc, or 0 if c is copied as is
+static size_t escapeChar(char c, char esc[6]) {
+    static const char hex[] = "0123456789abcdef";
+    char letter;
+    switch (c) {
+    case '\"': letter = '\"'; break;
+    case '\\': letter = '\\'; break;
+    case '/':  letter = '/'; break;
+    case '\b': letter = 'b'; break;
+    case '\f': letter = 'f'; break;
+    case '\n': letter = 'n'; break;
+    case '\r': letter = 'r'; break;
+    case '\t': letter = 't'; break;
+    default:
+        if ((uint8_t)c >= 0x20) {
+            return 0;
+        }
+        // Other control characters
+        esc[0] = '\\';
+        esc[1] = 'u';
+        esc[2] = '0';
+        esc[3] = '0';
+        esc[4] = hex[(uint8_t)c >> 4];
+        esc[5] = hex[c & 0x0F];
+        return 6;
+    }
+    esc[0] = '\\';
+    esc[1] = letter;
+    return 2;
+}
+
+void McpResponseWriter::escape(Print &out, const char *text, size_t len) {
+    char esc[6];
+    size_t run = 0; // start of the pending run of characters that need no escaping
+
+    for (size_t i = 0; i < len; i++) {
+        size_t n = escapeChar(text[i], esc);
+        if (n == 0) {
+            continue;
+        }
+        if (i > run) {
+            out.write(text + run, i - run);
+        }
+        out.write(esc, n);
+        run = i + 1;
+    }
+    if (len > run) {
+        out.write(text + run, len - run);
+    }
+}
+
+size_t McpResponseWriter::escapedLength(const char *text, size_t len) {
+    char esc[6];
+    size_t total = len;
+    for (size_t i = 0; i < len; i++) {
+        size_t n = escapeChar(text[i], esc);
+        if (n > 0) {
+            total += n - 1;
+        }
+    }
+    return total;
+}
+
+size_t McpResponseWriter::write(uint8_t c) {
+    raw((const char *)&c, 1);
+    return _ok ? 1 : 0;
+}
+
+size_t McpResponseWriter::write(const uint8_t *buffer, size_t size) {
+    raw((const char *)buffer, size);
+    return _ok ? size : 0;
+}
@@ -0,0 +1,116 @@
+#ifndef MCP_RESPONSE_WRITER_H
+#define MCP_RESPONSE_WRITER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "WsFrameEncoder.h"
+
+/* *
+ * McpResponseWriter Class
+ * Streams a JSON-RPC 2.0 reply straight into the outgoing frame buffer.
+ *
+ * A reply is begin (result, error or notification), any number of raw JSON and
+ * escaped string pieces, then end(). Nothing is built in temporary Strings:
+ * every piece is appended to the WsFrameEncoder payload, whose capacity is kept
+ * between messages. It is a Print, so serializeJson() can write into it too
+ * (that is how request ids are echoed, quoted or not, exactly as received).
+ *
+ * Usage:
+ *   McpResponseWriter reply(_txFrame);
+ *   reply.beginResult(doc["id"]);
+ *   reply.raw("{\"content\":[{\"type\":\"text\",\"text\":");
+ *   reply.string(text);
+ *   reply.raw("}]}");
+ *   if (reply.end()) sendTxFrame(WS_OP_TEXT);
+ *
+ * Between beginBatch() and endBatch() replies are collected as elements of one
+ * JSON array in the same buffer instead of replacing each other, so the answer
+ * to a JSON-RPC batch goes out as a single frame.
+ */
+class McpResponseWriter : public Print {
+public:
+    explicit McpResponseWriter(WsFrameEncoder &out)
+        : _out(out), _ok(true), _open(false), _closing("}"), _batch(false), _notification(false),
+          _entries(0), _entryStart(0) {}
+
+    // {"jsonrpc":"2.0","id":<id>,"result":   -- followed by the result value
+    void beginResult(JsonVariantConst id);
+
+    // {"jsonrpc":"2.0","id":<id>,"error":{"code":<code>,"message":   -- followed by the message string
+    void beginError(JsonVariantConst id, int code);
+
+    // {"jsonrpc":"2.0","method":"<method>"   -- optionally followed by raw(",\"params\":...")
+    void beginNotification(const char *method);
+
+    // Complete error reply with a plain message
+    void error(JsonVariantConst id, int code, const char *message);
+
+    // JSON text copied as is
+    void raw(const char *json, size_t len);
+    void raw(const char *json) { raw(json, strlen(json)); }
+    void raw(const String &json) { raw(json.c_str(), json.length()); }
+
+    // Quoted, escaped JSON string
+    void string(const char *text, size_t len);
+    void string(const char *text) { string(text, strlen(text)); }
+    void string(const String &text) { string(text.c_str(), text.length()); }
+
+    // String content without the quotes, for messages assembled from pieces
+    void escaped(const char *text, size_t len);
+    void escaped(const char *text) { escaped(text, strlen(text)); }
+    void escaped(const String &text) { escaped(text.c_str(), text.length()); }
+
+    /* *
+     * Close the envelope opened by begin*()
+     * @return false if the frame buffer could not grow at some point
+     */
+    bool end();
+
+    // Drop the reply begun last; within a batch the earlier elements stay
+    void discard();
+
+    bool ok() const { return _ok; }
+    // Whether a reply was begun and not yet ended
+    bool started() const { return _open; }
+
+    // Collect the following replies into one array; notifications are left out of it
+    void beginBatch();
+
+    /* *
+     * Close the array
+     * @return false if nothing was collected (nothing to send) or the buffer could not grow
+     */
+    bool endBatch();
+
+    bool batching() const { return _batch; }
+
+    /* *
+     * Write text as JSON string content (no quotes) into out
+     * Quotes, backslashes, slashes and control characters are escaped, the latter as
+     * \b \f \n \r \t or \u00XX; the runs between escapes are written in one piece each.
+     */
+    static void escape(Print &out, const char *text, size_t len);
+
+    // Length of text once escaped
+    static size_t escapedLength(const char *text, size_t len);
+
+    // Print
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+private:
+    void begin(const char *closing);
+    void id(JsonVariantConst id);
+
+    WsFrameEncoder &_out;
+    bool _ok;
+    bool _open;
+    const char *_closing;
+    bool _batch;
+    bool _notification; // the open reply is a notification
+    size_t _entries;    // replies collected in the batch
+    size_t _entryStart; // payload length before the open reply, for discard()
+};
+
+#endif // MCP_RESPONSE_WRITER_H
@@ -0,0 +1,228 @@
+#include "McpSendQueue.h"
+
+#include <string.h>
+
+McpSendQueue::McpSendQueue()
+    : _controlHead(0), _controlCount(0), _out(nullptr), _outLen(0), _outPos(0), _inPlace(false),
+      _inPlaceOffset(0), _stalling(false), _stallStart(0) {
+    resetStats();
+}
+
+McpSendQueue::~McpSendQueue() {
+    end();
+}
+
+bool McpSendQueue::begin(size_t capacity) {
+    end();
+    _out = (uint8_t *)malloc(MCP_TX_COALESCE_SIZE);
+    if (!_out || !_data.begin(capacity)) {
+        end();
+        return false;
+    }
+    return true;
+}
+
+void McpSendQueue::end() {
+    _data.end();
+    free(_out);
+    _out = nullptr;
+    _outLen = _outPos = 0;
+    _inPlace = false;
+    _inPlaceOffset = 0;
+    _controlCount = 0;
+    _stalling = false;
+}
+
+void McpSendQueue::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool McpSendQueue::push(uint8_t tag, const uint8_t *frame, size_t len) {
+    if (!_data.push(tag & TAG_MASK, frame, len)) {
+        _stats.full++;
+        return false;
+    }
+    size_t used = _data.used();
+    if (used > _stats.highWater) {
+        _stats.highWater = used;
+    }
+    return true;
+}
+
+bool McpSendQueue::pushControl(const uint8_t *frame, size_t len) {
+    if (_controlCount >= MCP_TX_CONTROL_SLOTS || len > CONTROL_FRAME_MAX) {
+        return false;
+    }
+    uint8_t slot = (_controlHead + _controlCount) % MCP_TX_CONTROL_SLOTS;
+    memcpy(_control[slot], frame, len);
+    _controlLen[slot] = (uint8_t)len;
+    _controlCount++;
+    return true;
+}
+
+bool McpSendQueue::idle() const {
+    return _outPos == _outLen && !_inPlace && _controlCount == 0 && _data.empty();
+}
+
+void McpSendQueue::clear() {
+    size_t len;
+    uint8_t type;
+    while (_data.peek(len, type)) {
+        _data.pop();
+    }
+    _outLen = _outPos = 0;
+    _inPlace = false;
+    _inPlaceOffset = 0;
+    _controlCount = 0;
+    stallEnded();
+}
+
+void McpSendQueue::sent(size_t len) {
+    _stats.framesOut++;
+    _stats.bytesOut += len;
+}
+
+McpSendQueue::Result McpSendQueue::stalled() {
+    unsigned long now = millis();
+    if (!_stalling) {
+        _stalling = true;
+        _stallStart = now;
+        _stats.stalls++;
+    }
+    return now - _stallStart > MCP_TX_STALL_TIMEOUT_MS ? STALLED : PENDING;
+}
+
+void McpSendQueue::stallEnded() {
+    if (_stalling) {
+        _stats.stallMs += millis() - _stallStart;
+        _stalling = false;
+    }
+}
+
+bool McpSendQueue::write(Client &client, uint8_t tag, const uint8_t *frame, size_t len) {
+    sent(len);
+    size_t offset = 0;
+    while (offset < len) {
+        size_t chunk = len - offset;
+        if (chunk > MCP_TX_CHUNK_SIZE) {
+            chunk = MCP_TX_CHUNK_SIZE;
+        }
+        size_t written = client.write(frame + offset, chunk);
+        _stats.writes++;
+        offset += written;
+        if (written == chunk) {
+            stallEnded();
+            continue;
+        }
+
+        // The socket is full: leave the rest to flush(), ahead of everything else
+        if (_data.push((tag & TAG_MASK) | REST, frame + offset, len - offset)) {
+            stalled();
+            return true;
+        }
+        // Too large to queue; only waiting is left
+        if (stalled() == STALLED) {
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+/**
+ * @brief Moves the next frames into _out, or marks the oldest data frame for writing in place.
+ * @return False if there is nothing to write.
+ */
+bool McpSendQueue::fill(uint8_t tag) {
+    size_t len;
+    uint8_t type;
+    const uint8_t *record = _data.peek(len, type);
+
+    // The rest of a frame write() started must directly follow its beginning
+    while (record && (type & REST)) {
+        if ((type & TAG_MASK) == tag) {
+            _inPlace = true;
+            _inPlaceOffset = 0;
+            return true;
+        }
+        _data.pop();
+        record = _data.peek(len, type);
+    }
+
+    while (_controlCount > 0) {
+        size_t controlLen = _controlLen[_controlHead];
+        if (_outLen + controlLen > MCP_TX_COALESCE_SIZE) {
+            return true; // The rest, then the data frames, go out with the next fill()
+        }
+        memcpy(_out + _outLen, _control[_controlHead], controlLen);
+        _outLen += controlLen;
+        sent(controlLen);
+        _controlHead = (_controlHead + 1) % MCP_TX_CONTROL_SLOTS;
+        _controlCount--;
+    }
+
+    while ((record = _data.peek(len, type)) != nullptr) {
+        if ((type & TAG_MASK) != tag) {
+            _data.pop(); // Encoded for an earlier connection
+            continue;
+        }
+        if (_outLen + len > MCP_TX_COALESCE_SIZE) {
+            if (_outLen == 0) {
+                _inPlace = true;
+                _inPlaceOffset = 0;
+                sent(len);
+            }
+            break;
+        }
+        memcpy(_out + _outLen, record, len);
+        _outLen += len;
+        sent(len);
+        _data.pop();
+    }
+    return _outLen > 0 || _inPlace;
+}
+
+McpSendQueue::Result McpSendQueue::flush(Client &client, uint8_t tag) {
+    tag &= TAG_MASK;
+    for (;;) {
+        if (_outPos == _outLen && !_inPlace) {
+            _outLen = _outPos = 0;
+            if (!fill(tag)) {
+                stallEnded();
+                return IDLE;
+            }
+        }
+
+        const uint8_t *data;
+        size_t len;
+        size_t recordLen = 0;
+        if (_outPos < _outLen) {
+            data = _out + _outPos;
+            len = _outLen - _outPos;
+        } else {
+            uint8_t type;
+            data = _data.peek(recordLen, type) + _inPlaceOffset;
+            len = recordLen - _inPlaceOffset;
+            if (len > MCP_TX_CHUNK_SIZE) {
+                len = MCP_TX_CHUNK_SIZE;
+            }
+        }
+
+        size_t written = client.write(data, len);
+        _stats.writes++;
+        if (_outPos < _outLen) {
+            _outPos += written;
+        } else {
+            _inPlaceOffset += written;
+            if (_inPlaceOffset == recordLen) {
+                _data.pop();
+                _inPlace = false;
+                _inPlaceOffset = 0;
+            }
+        }
+        if (written < len) {
+            return stalled(); // Resumed by the next flush()
+        }
+        stallEnded();
+    }
+}
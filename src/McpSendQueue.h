@@ -0,0 +1,161 @@
+#ifndef MCP_SEND_QUEUE_H
+#define MCP_SEND_QUEUE_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "McpSpscRing.h"
+#include "WsFrameEncoder.h"
+
+/* *
+ * McpSendQueue Class
+ * Bounded queue of encoded outgoing frames in front of the socket.
+ *
+ * Data frames are queued in an McpSpscRing, so loop() can queue replies while
+ * the network task writes them. Control frames (PING/PONG/CLOSE) come from the
+ * socket side itself and wait in a few fixed slots that are served before any
+ * queued data frame. A frame already partly on the wire is always finished
+ * first, because frames cannot be interleaved.
+ *
+ * flush() never waits for the socket. Small frames are coalesced into one
+ * write() of up to MCP_TX_COALESCE_SIZE bytes. Larger ones are written from the
+ * queue in place, in MCP_TX_CHUNK_SIZE pieces. Whatever the socket did not take
+ * is resumed by the next flush().
+ *
+ * Every data frame carries a tag naming the connection it was encoded for
+ * (tagFor(session)); flush() drops frames whose tag is not the current one.
+ */
+
+// Outgoing frame queue; only half of it is guaranteed to hold one frame
+#ifndef MCP_TX_QUEUE_SIZE
+#ifdef MCP_NET_TX_RING_SIZE
+#define MCP_TX_QUEUE_SIZE MCP_NET_TX_RING_SIZE // earlier name of this setting
+#else
+#define MCP_TX_QUEUE_SIZE 16384
+#endif
+#endif
+
+// Frames up to this size are gathered into one write() (one TLS record)
+#ifndef MCP_TX_COALESCE_SIZE
+#define MCP_TX_COALESCE_SIZE 1024
+#endif
+
+// Control frames that can wait for the socket at once
+#ifndef MCP_TX_CONTROL_SLOTS
+#define MCP_TX_CONTROL_SLOTS 4
+#endif
+
+// A socket that takes no more data for this long is considered dead
+#ifndef MCP_TX_STALL_TIMEOUT_MS
+#define MCP_TX_STALL_TIMEOUT_MS 10000
+#endif
+
+class McpSendQueue {
+public:
+    enum Result {
+        IDLE,    // everything was written
+        PENDING, // the socket is full; call flush() again later
+        STALLED  // no room in the socket for MCP_TX_STALL_TIMEOUT_MS
+    };
+
+    struct Stats {
+        uint32_t framesOut;
+        uint64_t bytesOut;
+        uint32_t writes;     // Client::write() calls
+        uint32_t full;       // frames refused because the queue was full
+        uint32_t stalls;     // times the socket took less than offered
+        uint32_t stallMs;    // total time spent waiting for the socket
+        size_t highWater;    // most bytes queued at once
+    };
+
+    McpSendQueue();
+    ~McpSendQueue();
+
+    /* *
+     * Allocate the data queue and the coalescing buffer
+     * @param capacity Data queue size in bytes
+     * @return false if an allocation failed
+     */
+    bool begin(size_t capacity = MCP_TX_QUEUE_SIZE);
+    void end();
+
+    static uint8_t tagFor(uint32_t session) { return (uint8_t)(session & TAG_MASK); }
+
+    // --- Producer side (the task encoding the frames) ---
+
+    /* *
+     * Queue a data frame
+     * @return false if the queue is full right now (backpressure) or the frame exceeds maxFrame()
+     */
+    bool push(uint8_t tag, const uint8_t *frame, size_t len);
+
+    // Largest data frame that can be queued
+    size_t maxFrame() const { return _data.maxRecord(); }
+
+    // Bytes waiting in the data queue, headers included; approximate from the other task
+    size_t depth() const { return _data.used(); }
+
+    // --- Socket side ---
+
+    /* *
+     * Queue a control frame ahead of all queued data frames
+     * @return false if all MCP_TX_CONTROL_SLOTS are taken
+     */
+    bool pushControl(const uint8_t *frame, size_t len);
+
+    /* *
+     * Write a data frame straight from the caller's buffer, without copying it into the queue
+     * Only when the producer is the socket side too and idle() is true. Whatever the socket
+     * does not take is queued; a remainder too large to queue is retried until it is taken.
+     * @return false if the socket stalled mid-frame (the connection must be closed)
+     */
+    bool write(Client &client, uint8_t tag, const uint8_t *frame, size_t len);
+
+    // Write as much as the socket takes right now
+    Result flush(Client &client, uint8_t tag);
+
+    // Nothing queued or partly written
+    bool idle() const;
+
+    // Drop everything; the connection is gone
+    void clear();
+
+    const Stats &stats() const { return _stats; }
+    void resetStats();
+
+private:
+    McpSendQueue(const McpSendQueue &);
+    McpSendQueue &operator=(const McpSendQueue &);
+
+    static const uint8_t TAG_MASK = 0x3F;
+    static const uint8_t REST = 0x40; // record holding the rest of a frame write() started
+    static const size_t CONTROL_FRAME_MAX = WsFrameEncoder::MAX_HEADER_LEN + 125;
+    static_assert(MCP_TX_COALESCE_SIZE >= MCP_TX_CONTROL_SLOTS * CONTROL_FRAME_MAX,
+                  "MCP_TX_COALESCE_SIZE must hold all waiting control frames");
+
+    bool fill(uint8_t tag);
+    void sent(size_t len);
+    Result stalled();
+    void stallEnded();
+
+    McpSpscRing _data;
+
+    uint8_t _control[MCP_TX_CONTROL_SLOTS][CONTROL_FRAME_MAX];
+    uint8_t _controlLen[MCP_TX_CONTROL_SLOTS];
+    uint8_t _controlHead;
+    uint8_t _controlCount;
+
+    // Coalesced frames being written
+    uint8_t *_out;
+    size_t _outLen;
+    size_t _outPos;
+
+    // Oldest data record, too large to coalesce, being written in place
+    bool _inPlace;
+    size_t _inPlaceOffset;
+
+    bool _stalling;            // the socket took less than offered and has not caught up since
+    unsigned long _stallStart;
+    Stats _stats;
+};
+
+#endif // MCP_SEND_QUEUE_H
@@ -0,0 +1,135 @@
+#include "McpSpscRing.h"
+
+McpSpscRing::McpSpscRing() : _buf(nullptr), _capacity(0), _head(0), _reservedPos(0), _reservedLen(0), _tail(0) {
+}
+
+McpSpscRing::~McpSpscRing() {
+    end();
+}
+
+bool McpSpscRing::begin(size_t capacity) {
+    end();
+    capacity = padded(capacity);
+    _buf = (uint8_t *)malloc(capacity);
+    if (!_buf) {
+        return false;
+    }
+    _capacity = capacity;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void McpSpscRing::end() {
+    free(_buf);
+    _buf = nullptr;
+    _capacity = 0;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+}
+
+size_t McpSpscRing::maxRecord() const {
+    // A record must fit either before or after the (empty) ring's current position,
+    // so only half the buffer is guaranteed to be contiguous
+    if (_capacity < 4 * HEADER_LEN) {
+        return 0;
+    }
+    return ((_capacity / 2) & ~(size_t)3) - 2 * HEADER_LEN;
+}
+
+void McpSpscRing::writeHeader(size_t pos, size_t len, uint8_t type) {
+    uint32_t header = ((uint32_t)len << 8) | type;
+    memcpy(_buf + pos, &header, HEADER_LEN);
+}
+
+uint8_t *McpSpscRing::reserve(size_t len) {
+    if (!_buf || len > 0xFFFFFF) {
+        return nullptr;
+    }
+    size_t need = HEADER_LEN + padded(len);
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t tail = _tail.load(std::memory_order_acquire);
+    size_t pos;
+
+    // The head may never catch up with the tail: equal means empty
+    if (head >= tail) {
+        if (head + need < _capacity || (head + need == _capacity && tail != 0)) {
+            pos = head;
+        } else if (need < tail) {
+            pos = 0; // after a wrap marker at head
+        } else {
+            return nullptr;
+        }
+    } else if (head + need < tail) {
+        pos = head;
+    } else {
+        return nullptr;
+    }
+
+    _reservedPos = pos;
+    _reservedLen = len;
+    return _buf + pos + HEADER_LEN;
+}
+
+void McpSpscRing::commit(uint8_t type) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (_reservedPos != head) {
+        // Sizes are multiples of 4, so there is always room for the marker
+        writeHeader(head, 0, WRAP);
+    }
+    writeHeader(_reservedPos, _reservedLen, type);
+
+    size_t next = _reservedPos + HEADER_LEN + padded(_reservedLen);
+    if (next == _capacity) {
+        next = 0;
+    }
+    _head.store(next, std::memory_order_release);
+}
+
+bool McpSpscRing::push(uint8_t type, const uint8_t *data, size_t len) {
+    uint8_t *dst = reserve(len);
+    if (!dst) {
+        return false;
+    }
+    if (len > 0) {
+        memcpy(dst, data, len);
+    }
+    commit(type);
+    return true;
+}
+
+const uint8_t *McpSpscRing::peek(size_t &len, uint8_t &type) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t head = _head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return nullptr;
+    }
+
+    uint32_t header;
+    memcpy(&header, _buf + tail, HEADER_LEN);
+    if ((uint8_t)header == WRAP) {
+        // The record was published together with the marker, so it is there
+        tail = 0;
+        _tail.store(0, std::memory_order_release);
+        memcpy(&header, _buf, HEADER_LEN);
+    }
+    len = header >> 8;
+    type = (uint8_t)header;
+    return _buf + tail + HEADER_LEN;
+}
+
+void McpSpscRing::pop() {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t header;
+    memcpy(&header, _buf + tail, HEADER_LEN);
+    if ((uint8_t)header == WRAP) {
+        tail = 0;
+        memcpy(&header, _buf, HEADER_LEN);
+    }
+
+    size_t next = tail + HEADER_LEN + padded(header >> 8);
+    if (next == _capacity) {
+        next = 0;
+    }
+    _tail.store(next, std::memory_order_release);
+}
@@ -0,0 +1,100 @@
+#ifndef MCP_SPSC_RING_H
+#define MCP_SPSC_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/* *
+ * McpSpscRing Class
+ * Lock-free single-producer/single-consumer queue of variable-length records.
+ *
+ * One task pushes, one other task peeks and pops; neither ever blocks or takes
+ * a lock. Each record is a 4-byte header (24-bit length, 8-bit type) followed
+ * by the payload, padded to 4 bytes. A record is never split across the end of
+ * the buffer: when it does not fit there, a wrap marker is written and the
+ * record starts again at offset 0. So the consumer always gets the payload as
+ * one contiguous block it can use in place until pop().
+ *
+ * The producer publishes a record by storing the head index with release
+ * order after writing it; the consumer frees space the same way with the tail.
+ */
+class McpSpscRing {
+public:
+    McpSpscRing();
+    ~McpSpscRing();
+
+    /* *
+     * Allocate the buffer; call before either side uses the ring
+     * @param capacity Size in bytes, rounded up to a multiple of 4
+     * @return false if the allocation failed
+     */
+    bool begin(size_t capacity);
+
+    // Free the buffer; neither side may be using the ring
+    void end();
+
+    size_t capacity() const { return _capacity; }
+
+    // Largest payload that fits at all (into an empty ring)
+    size_t maxRecord() const;
+
+    // --- Producer side ---
+
+    /* *
+     * Reserve space for a record of len bytes
+     * @return Where to write the payload, or nullptr if the ring is too full right now
+     */
+    uint8_t *reserve(size_t len);
+
+    // Publish the record reserved last, with the given type
+    void commit(uint8_t type);
+
+    // reserve() + copy + commit()
+    bool push(uint8_t type, const uint8_t *data, size_t len);
+
+    // --- Consumer side ---
+
+    /* *
+     * The oldest record, valid until pop()
+     * @return Payload pointer, or nullptr if the ring is empty
+     */
+    const uint8_t *peek(size_t &len, uint8_t &type);
+
+    // Release the record returned by peek()
+    void pop();
+
+    // Bytes in use, headers and padding included; approximate from either side
+    size_t used() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : _capacity - tail + head;
+    }
+
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    McpSpscRing(const McpSpscRing &);
+    McpSpscRing &operator=(const McpSpscRing &);
+
+    static const size_t HEADER_LEN = 4;
+    static const uint8_t WRAP = 0xFF;
+
+    static size_t padded(size_t len) { return (len + 3) & ~(size_t)3; }
+
+    void writeHeader(size_t pos, size_t len, uint8_t type);
+
+    uint8_t *_buf;
+    size_t _capacity;
+
+    // Written by the producer only
+    std::atomic<size_t> _head;
+    size_t _reservedPos; // where the reserved record starts
+    size_t _reservedLen;
+
+    // Written by the consumer only
+    std::atomic<size_t> _tail;
+};
+
+#endif // MCP_SPSC_RING_H
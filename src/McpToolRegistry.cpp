@@ -0,0 +1,151 @@
+#include "McpToolRegistry.h"
+#include "McpLog.h"
+
+bool McpToolRegistry::add(const String &name, const String &description, const String &inputSchema,
+                          ToolArgsCallback callback) {
+    return add(name, description, inputSchema, callback, ToolWriterCallback());
+}
+
+bool McpToolRegistry::add(const String &name, const String &description, const String &inputSchema,
+                          ToolWriterCallback writer) {
+    return add(name, description, inputSchema, ToolArgsCallback(), writer);
+}
+
+bool McpToolRegistry::add(const String &name, const String &description, const String &inputSchema,
+                          ToolArgsCallback callback, ToolWriterCallback writer) {
+    // Check if the tool already exists
+    int existing = find(name.c_str(), name.length());
+    if (existing != McpNameIndex::NOT_FOUND) {
+        // If the tool exists, update the callback
+        _tools[existing].callback = callback;
+        _tools[existing].writer = writer;
+        MCP_LOGI("Update tool callback:%s", name.c_str());
+        return true;
+    }
+
+    if (!_index.insert(McpNameIndex::hash(name.c_str(), name.length()), _tools.size())) {
+        MCP_LOGE("Too many tools, cannot register:%s", name.c_str());
+        return false;
+    }
+
+    // Create a new tool and add it to the list
+    Tool newTool;
+    newTool.name = name;
+    newTool.description = description;
+    newTool.inputSchema = inputSchema;
+    newTool.callback = callback;
+    newTool.writer = writer;
+    _tools.push_back(newTool);
+    _version++;
+
+    MCP_LOGI("Successful registration tool:%s", name.c_str());
+    return true;
+}
+
+bool McpToolRegistry::remove(const String &name) {
+    int index = find(name.c_str(), name.length());
+    if (index == McpNameIndex::NOT_FOUND) {
+        MCP_LOGW("Tools %s Does not exist, cannot be uninstalled", name.c_str());
+        return false;
+    }
+    _tools.erase(_tools.begin() + index);
+    _index.remove(index);
+    _version++;
+    MCP_LOGI("Uninstalled tool:%s", name.c_str());
+    return true;
+}
+
+void McpToolRegistry::clear() {
+    _tools.clear();
+    _index.clear();
+    _version++;
+    MCP_LOGI("All tools have been cleared");
+}
+
+// Find a tool by name through the hash index
+int McpToolRegistry::find(const char *name, size_t len) const {
+    return _index.find(McpNameIndex::hash(name, len), [&](size_t position) {
+        const String &toolName = _tools[position].name;
+        return toolName.length() == len && memcmp(toolName.c_str(), name, len) == 0;
+    });
+}
+
+namespace {
+
+// Print into a String, for the shared escaper
+class StringPrint : public Print {
+public:
+    explicit StringPrint(String &out) : _out(out) {}
+
+    size_t write(uint8_t c) override { return _out.concat((char)c) ? 1 : 0; }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        return _out.concat((const char *)buffer, size) ? size : 0;
+    }
+    using Print::write;
+
+private:
+    String &_out;
+};
+
+} // namespace
+
+void McpToolRegistry::appendEscaped(String &out, const char *text, size_t len) {
+    StringPrint print(out);
+    McpResponseWriter::escape(print, text, len);
+}
+
+const String &McpToolRegistry::listJson() {
+    if (_listVersion == _version) {
+        return _listJson;
+    }
+
+    size_t estimate = 0;
+    for (const auto& tool : _tools) {
+        // Fixed keys plus some room for escaping
+        estimate += 48 + tool.name.length() + tool.description.length() * 9 / 8 + tool.inputSchema.length();
+    }
+    _listJson = "";
+    _listJson.reserve(estimate);
+
+    bool firstTool = true;
+    for (const auto& tool : _tools) {
+        if (!firstTool) {
+            _listJson += ",";
+        }
+        _listJson += "{\"name\":\"";
+        appendEscaped(_listJson, tool.name.c_str(), tool.name.length());
+        _listJson += "\",\"description\":\"";
+        appendEscaped(_listJson, tool.description.c_str(), tool.description.length());
+        _listJson += "\",\"inputSchema\":";
+        _listJson += tool.inputSchema;
+        _listJson += "}";
+        firstTool = false;
+    }
+
+    _listVersion = _version;
+    return _listJson;
+}
+
+// Adapter: serialize the arguments back to the JSON string a ToolCallback expects
+ToolArgsCallback McpToolRegistry::adaptStringCallback(ToolCallback callback) {
+    if (!callback) {
+        return ToolArgsCallback();
+    }
+    return [callback](JsonObjectConst args) {
+        String argsJson;
+        serializeJson(args, argsJson);
+        return callback(argsJson);
+    };
+}
+
+String McpToolRegistry::escapeJsonString(const String &input) {
+    const char *in = input.c_str();
+    size_t len = input.length();
+
+    // Size the result once
+    String result;
+    if (result.reserve(McpResponseWriter::escapedLength(in, len))) {
+        appendEscaped(result, in, len);
+    }
+    return result;
+}
@@ -0,0 +1,168 @@
+#ifndef MCP_TOOL_REGISTRY_H
+#define MCP_TOOL_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include <vector>
+#include "McpNameIndex.h"
+#include "McpMetrics.h"
+#include "McpHeapTrace.h"
+#include "McpResponseWriter.h"
+
+// Define the tool response content structure
+struct ToolContentItem {
+    String type; // Content type, such as "text"
+    String text; // Text content
+};
+
+// Define tool response structure
+class ToolResponse {
+public:
+    std::vector<ToolContentItem> content; // Response content array
+    bool isError; // Is it an error response
+
+    // Constructor: Create a response from a single text content (used for JSON response)
+    ToolResponse(const String& textContent, bool error = false) : isError(error) {
+        ToolContentItem item;
+        item.type = "text";
+        item.text = textContent;
+        content.push_back(item);
+    }
+
+    // Constructor: Create a response from a boolean status and message (used for text response)
+    ToolResponse(bool error, const String& message) {
+        ToolContentItem item;
+        item.type = "text";
+        item.text = message;
+        content.push_back(item);
+        isError = error;
+    }
+
+    // Default constructor
+    ToolResponse() : isError(false) {}
+
+    // Create a response from a JSON object (convenient method)
+    static ToolResponse fromJson(const JsonObject& json, bool error = false) {
+        String jsonStr;
+        serializeJson(json, jsonStr);
+        return ToolResponse(jsonStr, error);
+    }
+};
+
+// Redefine the tool callback function type - receive JSON string parameters and return the ToolResponse structure
+typedef std::function<ToolResponse(const String&)> ToolCallback;
+
+// Tool callback receiving the already-parsed "arguments" object; valid only during the call.
+// Avoids serializing the arguments to a string and parsing them again in the callback.
+typedef std::function<ToolResponse(JsonObjectConst)> ToolArgsCallback;
+
+/* *
+ * McpToolResult Class
+ * What a ToolWriterCallback prints its result text into. The text goes, escaped,
+ * straight into the reply being built in the outgoing frame buffer: no String,
+ * no ToolResponse, no heap allocation. It is a Print, so print() and
+ * serializeJson(doc, result) work. Printing nothing answers {"success":true}.
+ */
+class McpToolResult : public Print {
+public:
+    explicit McpToolResult(McpResponseWriter &reply) : _reply(reply), _length(0), _error(false) {}
+
+    void setError(bool error = true) { _error = error; }
+    bool isError() const { return _error; }
+    // Bytes of result text so far, before escaping
+    size_t length() const { return _length; }
+
+    // Print
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        _reply.escaped((const char *)buffer, size);
+        _length += size;
+        return size;
+    }
+    using Print::write;
+
+private:
+    McpResponseWriter &_reply;
+    size_t _length;
+    bool _error;
+};
+
+// Tool callback writing its result into the reply; the allocation-free form. Always runs in loop(),
+// never on the worker pool, since the reply buffer belongs to loop().
+typedef std::function<void(JsonObjectConst, McpToolResult &)> ToolWriterCallback;
+
+/* *
+ * McpToolRegistry Class
+ * The registered tools, their stats and the cached tools/list content.
+ *
+ * Every WebSocketMCP has one of its own; several connections can instead share
+ * one (WebSocketMCP::useToolRegistry, McpEndpointManager), so each tool, its
+ * schema and the serialized tools/list exist once however many servers the
+ * device talks to. The registry is read-mostly: lookups and the per-tool stats
+ * happen while handling requests, which all connections sharing it must do
+ * from the same task (their loop()). Registering and removing tools is done
+ * from that task too.
+ *
+ * Tools stay in registration order (tools/list needs it) with McpNameIndex
+ * pointing into the vector. version() changes with every registration or
+ * removal, so a caller holding a position across a callback can tell whether
+ * to look the tool up again.
+ */
+class McpToolRegistry {
+public:
+    struct Tool {
+        String name;
+        String description;
+        String inputSchema;
+        ToolArgsCallback callback;  // String callbacks are wrapped in an adapter
+        ToolWriterCallback writer;  // set instead of callback for tools writing into the reply
+        uint8_t maxConcurrency = 0; // > 0: async, on the worker pool
+        uint8_t running = 0;        // async invocations in flight, over all connections
+        McpToolStats stats;         // over all connections
+        McpHeapStats heap;          // inline calls while heap tracing is on
+    };
+
+    McpToolRegistry() : _version(1), _listVersion(0) {}
+
+    // Add a tool, or replace the callback of the one with that name
+    bool add(const String &name, const String &description, const String &inputSchema, ToolArgsCallback callback);
+    bool add(const String &name, const String &description, const String &inputSchema, ToolWriterCallback writer);
+    bool remove(const String &name);
+    void clear();
+
+    size_t size() const { return _tools.size(); }
+    Tool &operator[](size_t index) { return _tools[index]; }
+    const Tool &operator[](size_t index) const { return _tools[index]; }
+
+    // Position of the named tool, or McpNameIndex::NOT_FOUND
+    int find(const char *name, size_t len) const;
+
+    uint32_t version() const { return _version; }
+
+    // Comma-separated tool objects for tools/list, rebuilt only when the registry changed
+    const String &listJson();
+
+    // Serialize the arguments back to the JSON string a ToolCallback expects
+    static ToolArgsCallback adaptStringCallback(ToolCallback callback);
+
+    static String escapeJsonString(const String &input);
+    // Append text escaped as JSON string content (McpResponseWriter::escape)
+    static void appendEscaped(String &out, const char *text, size_t len);
+
+private:
+    bool add(const String &name, const String &description, const String &inputSchema,
+             ToolArgsCallback callback, ToolWriterCallback writer);
+
+    // Shared by reference only
+    McpToolRegistry(const McpToolRegistry &);
+    McpToolRegistry &operator=(const McpToolRegistry &);
+
+    std::vector<Tool> _tools;
+    McpNameIndex _index; // name hash -> position in _tools
+    uint32_t _version;     // bumped by every mutation
+    String _listJson;
+    uint32_t _listVersion; // _version that _listJson was built from
+};
+
+#endif // MCP_TOOL_REGISTRY_H
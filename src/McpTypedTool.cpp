@@ -0,0 +1,199 @@
+#include "McpTypedTool.h"
+
+#include <string.h>
+
+static const char *jsonType(McpParamKind kind) {
+    switch (kind) {
+    case MCP_PARAM_INT:
+    case MCP_PARAM_LONG:
+        return "integer";
+    case MCP_PARAM_FLOAT:
+    case MCP_PARAM_DOUBLE:
+        return "number";
+    case MCP_PARAM_BOOL:
+        return "boolean";
+    default:
+        return "string";
+    }
+}
+
+static bool isNumber(McpParamKind kind) {
+    return kind != MCP_PARAM_BOOL && kind != MCP_PARAM_STRING;
+}
+
+// Bounds are written as integers where the schema type is one
+static void appendBound(String &out, const char *key, double value, McpParamKind kind) {
+    char text[32];
+    if (kind == MCP_PARAM_INT || kind == MCP_PARAM_LONG || kind == MCP_PARAM_STRING) {
+        snprintf(text, sizeof(text), ",\"%s\":%ld", key, (long)value);
+    } else {
+        snprintf(text, sizeof(text), ",\"%s\":%.9g", key, value);
+    }
+    out += text;
+}
+
+static void appendEscaped(String &out, const char *text) {
+    McpToolRegistry::appendEscaped(out, text, strlen(text));
+}
+
+String McpTypedTool::schema(const McpToolParam *params, size_t count) {
+    String out = "{\"type\":\"object\",\"properties\":{";
+    for (size_t i = 0; i < count; i++) {
+        const McpToolParam &p = params[i];
+        if (i > 0) {
+            out += ",";
+        }
+        out += "\"";
+        appendEscaped(out, p.name);
+        out += "\":{\"type\":\"";
+        out += jsonType(p.kind);
+        out += "\"";
+        if (p.description) {
+            out += ",\"description\":\"";
+            appendEscaped(out, p.description);
+            out += "\"";
+        }
+        if (p.flags & McpToolParam::HAS_RANGE) {
+            bool number = isNumber(p.kind);
+            appendBound(out, number ? "minimum" : "minLength", p.minimum, p.kind);
+            appendBound(out, number ? "maximum" : "maxLength", p.maximum, p.kind);
+        }
+        if (p.enumValues) {
+            out += ",\"enum\":[";
+            const char *value = p.enumValues;
+            while (true) {
+                const char *end = strchr(value, '|');
+                size_t len = end ? (size_t)(end - value) : strlen(value);
+                out += "\"";
+                McpToolRegistry::appendEscaped(out, value, len);
+                out += "\"";
+                if (!end) {
+                    break;
+                }
+                out += ",";
+                value = end + 1;
+            }
+            out += "]";
+        }
+        out += "}";
+    }
+    out += "}";
+
+    bool first = true;
+    for (size_t i = 0; i < count; i++) {
+        if (params[i].flags & McpToolParam::REQUIRED) {
+            out += first ? ",\"required\":[\"" : ",\"";
+            appendEscaped(out, params[i].name);
+            out += "\"";
+            first = false;
+        }
+    }
+    if (!first) {
+        out += "]";
+    }
+    out += "}";
+    return out;
+}
+
+// Whether value is one of the '|' separated values
+static bool inEnum(const char *values, const char *value) {
+    size_t len = strlen(value);
+    const char *p = values;
+    while (true) {
+        const char *end = strchr(p, '|');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && memcmp(p, value, len) == 0) {
+            return true;
+        }
+        if (!end) {
+            return false;
+        }
+        p = end + 1;
+    }
+}
+
+static bool inRange(const McpToolParam &p, double value) {
+    return !(p.flags & McpToolParam::HAS_RANGE) || (value >= p.minimum && value <= p.maximum);
+}
+
+// Check the value against the declaration and store it into the member
+static bool store(const McpToolParam &p, JsonVariantConst value, uint8_t *args) {
+    void *field = args + p.offset;
+    switch (p.kind) {
+    case MCP_PARAM_INT:
+        if (!value.is<int>() || !inRange(p, value.as<int>())) {
+            return false;
+        }
+        *(int *)field = value.as<int>();
+        return true;
+    case MCP_PARAM_LONG:
+        if (!value.is<long>() || !inRange(p, value.as<long>())) {
+            return false;
+        }
+        *(long *)field = value.as<long>();
+        return true;
+    case MCP_PARAM_FLOAT:
+        if (!value.is<float>() || !inRange(p, value.as<float>())) {
+            return false;
+        }
+        *(float *)field = value.as<float>();
+        return true;
+    case MCP_PARAM_DOUBLE:
+        if (!value.is<double>() || !inRange(p, value.as<double>())) {
+            return false;
+        }
+        *(double *)field = value.as<double>();
+        return true;
+    case MCP_PARAM_BOOL:
+        if (!value.is<bool>()) {
+            return false;
+        }
+        *(bool *)field = value.as<bool>();
+        return true;
+    case MCP_PARAM_STRING: {
+        const char *text = value.as<const char *>();
+        if (!text || !inRange(p, strlen(text)) || (p.enumValues && !inEnum(p.enumValues, text))) {
+            return false;
+        }
+        *(const char **)field = text;
+        return true;
+    }
+    }
+    return false;
+}
+
+static void printArgumentError(McpToolResult &result, const char *error, const char *name) {
+    result.setError();
+    result.print("{\"success\":false,\"error\":\"");
+    result.print(error);
+    result.print("\",\"argument\":\"");
+    result.print(name);
+    result.print("\"}");
+}
+
+bool McpTypedTool::extract(JsonObjectConst json, const McpToolParam *params, size_t count, void *args,
+                           McpToolResult &result) {
+    uint32_t seen = 0;
+    for (JsonPairConst pair : json) {
+        const char *key = pair.key().c_str();
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(params[i].name, key) != 0) {
+                continue;
+            }
+            if (!store(params[i], pair.value(), (uint8_t *)args)) {
+                printArgumentError(result, "invalid argument", key);
+                return false;
+            }
+            seen |= (uint32_t)1 << i;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if ((params[i].flags & McpToolParam::REQUIRED) && !(seen & ((uint32_t)1 << i))) {
+            printArgumentError(result, "missing argument", params[i].name);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,133 @@
+#ifndef MCP_TYPED_TOOL_H
+#define MCP_TYPED_TOOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include "McpToolRegistry.h"
+
+/* *
+ * Typed tool declarations
+ * A tool's arguments are a plain struct; each member is declared once, with its
+ * description and constraints, in a constant table. The table gives both the
+ * inputSchema and the extraction of the arguments into the struct, so the two
+ * can no longer disagree.
+ *
+ * Usage:
+ *   struct BlinkArgs {
+ *       const char *state = "on";
+ *       int times = 3;      // defaults: members the request leaves out keep them
+ *       bool fast = false;
+ *   };
+ *   static constexpr McpToolParam BLINK_PARAMS[] = {
+ *       MCP_TOOL_PARAM(BlinkArgs, state, "LED state").oneOf("on|off|blink").required(),
+ *       MCP_TOOL_PARAM(BlinkArgs, times, "How often to blink").range(1, 10),
+ *       MCP_TOOL_PARAM(BlinkArgs, fast, "Blink fast"),
+ *   };
+ *   mcp.registerTypedTool<BlinkArgs>("led_blink", "Control the LED", BLINK_PARAMS,
+ *       [](const BlinkArgs &args, McpToolResult &result) { ... });
+ *
+ * The JSON type comes from the member's C++ type: int and long are "integer",
+ * float and double "number", bool "boolean", const char * "string" (pointing
+ * into the request, valid during the call). The table is built at compile time
+ * and stays in flash; the schema text is generated from it once, at
+ * registration, since the registry and the tools/list cache hold it in RAM
+ * anyway.
+ *
+ * The arguments object is walked once, each key matched against the table and
+ * its value stored straight into the struct: no lookup by key afterwards. A
+ * value of the wrong type, out of range or not among the enum values, or a
+ * missing required one, answers an error result without calling the callback.
+ * Unknown keys are ignored. A typed tool is a ToolWriterCallback tool: no
+ * allocation per call, and it runs in loop().
+ */
+
+enum McpParamKind : uint8_t {
+    MCP_PARAM_INT,
+    MCP_PARAM_LONG,
+    MCP_PARAM_FLOAT,
+    MCP_PARAM_DOUBLE,
+    MCP_PARAM_BOOL,
+    MCP_PARAM_STRING // const char *
+};
+
+// Kind of a struct member, from its type; other member types do not compile
+template <typename T> struct McpParamKindOf;
+template <> struct McpParamKindOf<int> { static constexpr McpParamKind value = MCP_PARAM_INT; };
+template <> struct McpParamKindOf<long> { static constexpr McpParamKind value = MCP_PARAM_LONG; };
+template <> struct McpParamKindOf<float> { static constexpr McpParamKind value = MCP_PARAM_FLOAT; };
+template <> struct McpParamKindOf<double> { static constexpr McpParamKind value = MCP_PARAM_DOUBLE; };
+template <> struct McpParamKindOf<bool> { static constexpr McpParamKind value = MCP_PARAM_BOOL; };
+template <> struct McpParamKindOf<const char *> { static constexpr McpParamKind value = MCP_PARAM_STRING; };
+
+// One argument of a typed tool. Constraints are added by chaining; each returns a modified copy.
+struct McpToolParam {
+    enum Flags : uint8_t {
+        REQUIRED = 0x01,
+        HAS_RANGE = 0x02
+    };
+
+    const char *name;
+    const char *description;
+    McpParamKind kind;
+    uint8_t flags;
+    uint16_t offset;        // of the member in the arguments struct
+    double minimum;         // HAS_RANGE: inclusive bounds for numbers, length bounds for strings
+    double maximum;
+    const char *enumValues; // strings only: allowed values separated by '|', or nullptr
+
+    constexpr McpToolParam(const char *name, const char *description, McpParamKind kind, size_t offset,
+                           uint8_t flags = 0, double minimum = 0, double maximum = 0,
+                           const char *enumValues = nullptr)
+        : name(name), description(description), kind(kind), flags(flags), offset((uint16_t)offset),
+          minimum(minimum), maximum(maximum), enumValues(enumValues) {}
+
+    constexpr McpToolParam required() const {
+        return McpToolParam(name, description, kind, offset, flags | REQUIRED, minimum, maximum, enumValues);
+    }
+    constexpr McpToolParam range(double lo, double hi) const {
+        return McpToolParam(name, description, kind, offset, flags | HAS_RANGE, lo, hi, enumValues);
+    }
+    // e.g. oneOf("on|off|blink")
+    constexpr McpToolParam oneOf(const char *values) const {
+        return McpToolParam(name, description, kind, offset, flags, minimum, maximum, values);
+    }
+};
+
+// Declares the member field of Struct as an argument named after it
+#define MCP_TOOL_PARAM(Struct, field, description) \
+    McpToolParam(#field, description, McpParamKindOf<decltype(Struct::field)>::value, offsetof(Struct, field))
+
+class McpTypedTool {
+public:
+    // Required arguments are tracked in a 32-bit mask
+    static const size_t MAX_PARAMS = 32;
+
+    template <typename Args> struct Callback {
+        typedef std::function<void(const Args &, McpToolResult &)> Type;
+    };
+
+    // {"type":"object","properties":{...},"required":[...]}
+    static String schema(const McpToolParam *params, size_t count);
+
+    /* *
+     * Store the arguments into the struct at args
+     * @return false after printing an error result into result
+     */
+    static bool extract(JsonObjectConst json, const McpToolParam *params, size_t count, void *args,
+                        McpToolResult &result);
+
+    // The ToolWriterCallback running a typed callback; params must outlive the tool
+    template <typename Args>
+    static ToolWriterCallback writer(const McpToolParam *params, size_t count,
+                                     typename Callback<Args>::Type callback) {
+        return [params, count, callback](JsonObjectConst json, McpToolResult &result) {
+            Args args;
+            if (extract(json, params, count, &args, result)) {
+                callback(args, result);
+            }
+        };
+    }
+};
+
+#endif // MCP_TYPED_TOOL_H
@@ -0,0 +1,181 @@
+#include "McpWorkerPool.h"
+
+#ifdef ESP32
+
+McpWorkerPool::McpWorkerPool() : _workers(0), _pending(nullptr), _completed(nullptr), _exited(nullptr) {
+}
+
+McpWorkerPool::~McpWorkerPool() {
+    end();
+}
+
+bool McpWorkerPool::begin(uint8_t workers, uint32_t stackSize, uint8_t priority) {
+    if (_workers > 0 || workers == 0 || workers > MCP_MAX_TOOL_WORKERS) {
+        return false;
+    }
+
+    // Room for every item in flight, plus one stop marker per worker
+    _pending = xQueueCreate(MCP_TOOL_QUEUE_LENGTH + MCP_MAX_TOOL_WORKERS, sizeof(McpWorkItem *));
+    _completed = xQueueCreate(MCP_TOOL_QUEUE_LENGTH, sizeof(McpWorkItem *));
+    _exited = xSemaphoreCreateCounting(MCP_MAX_TOOL_WORKERS, 0);
+    if (!_pending || !_completed || !_exited) {
+        end();
+        return false;
+    }
+
+    for (uint8_t i = 0; i < workers; i++) {
+        if (xTaskCreate(workerTask, "mcp_tool", stackSize, this, priority, nullptr) != pdPASS) {
+            end();
+            return false;
+        }
+        _workers++;
+    }
+    return true;
+}
+
+void McpWorkerPool::end() {
+    // A null item tells one worker to exit
+    McpWorkItem *stop = nullptr;
+    for (uint8_t i = 0; i < _workers; i++) {
+        xQueueSendToFront(_pending, &stop, portMAX_DELAY);
+    }
+    uint8_t exited = 0;
+    while (exited < _workers) {
+        // Keep the completed queue drained so no worker blocks on it
+        McpWorkItem *item;
+        while (xQueueReceive(_completed, &item, 0) == pdTRUE) {
+        }
+        if (xSemaphoreTake(_exited, pdMS_TO_TICKS(10)) == pdTRUE) {
+            exited++;
+        }
+    }
+    _workers = 0;
+
+    if (_pending) {
+        vQueueDelete(_pending);
+        _pending = nullptr;
+    }
+    if (_completed) {
+        vQueueDelete(_completed);
+        _completed = nullptr;
+    }
+    if (_exited) {
+        vSemaphoreDelete(_exited);
+        _exited = nullptr;
+    }
+}
+
+bool McpWorkerPool::submit(McpWorkItem *item) {
+    return _workers > 0 && xQueueSend(_pending, &item, 0) == pdTRUE;
+}
+
+McpWorkItem *McpWorkerPool::takeCompleted() {
+    McpWorkItem *item = nullptr;
+    if (!_completed || xQueueReceive(_completed, &item, 0) != pdTRUE) {
+        return nullptr;
+    }
+    return item;
+}
+
+void McpWorkerPool::workerTask(void *arg) {
+    McpWorkerPool *pool = static_cast<McpWorkerPool *>(arg);
+    pool->work();
+    xSemaphoreGive(pool->_exited);
+    vTaskDelete(nullptr);
+}
+
+void McpWorkerPool::work() {
+    while (true) {
+        McpWorkItem *item;
+        if (xQueueReceive(_pending, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (!item) {
+            return;
+        }
+        item->run();
+        xQueueSend(_completed, &item, portMAX_DELAY);
+    }
+}
+
+#else // Host build: std::thread
+
+McpWorkerPool::McpWorkerPool() : _workers(0), _stopping(false) {
+}
+
+McpWorkerPool::~McpWorkerPool() {
+    end();
+}
+
+bool McpWorkerPool::begin(uint8_t workers, uint32_t stackSize, uint8_t priority) {
+    (void)stackSize;
+    (void)priority;
+    if (_workers > 0 || workers == 0 || workers > MCP_MAX_TOOL_WORKERS) {
+        return false;
+    }
+    _stopping = false;
+    for (uint8_t i = 0; i < workers; i++) {
+        _threads.push_back(std::thread(&McpWorkerPool::work, this));
+    }
+    _workers = workers;
+    return true;
+}
+
+void McpWorkerPool::end() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (size_t i = 0; i < _threads.size(); i++) {
+        _threads[i].join();
+    }
+    _threads.clear();
+    _pending.clear();
+    _completed.clear();
+    _workers = 0;
+}
+
+bool McpWorkerPool::submit(McpWorkItem *item) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_workers == 0 || _pending.size() >= MCP_TOOL_QUEUE_LENGTH) {
+            return false;
+        }
+        _pending.push_back(item);
+    }
+    _wake.notify_one();
+    return true;
+}
+
+McpWorkItem *McpWorkerPool::takeCompleted() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_completed.empty()) {
+        return nullptr;
+    }
+    McpWorkItem *item = _completed.front();
+    _completed.pop_front();
+    return item;
+}
+
+void McpWorkerPool::work() {
+    while (true) {
+        McpWorkItem *item;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_stopping && _pending.empty()) {
+                _wake.wait(lock);
+            }
+            if (_stopping) {
+                return;
+            }
+            item = _pending.front();
+            _pending.pop_front();
+        }
+        item->run();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _completed.push_back(item);
+    }
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef MCP_WORKER_POOL_H
+#define MCP_WORKER_POOL_H
+
+#include <Arduino.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+/* *
+ * McpWorkerPool Class
+ * A fixed set of worker tasks (FreeRTOS tasks on ESP32, std::thread on the host
+ * build) that run McpWorkItems off the loop() task.
+ *
+ * The owner submits items from loop() and collects them again with
+ * takeCompleted(), also from loop(); everything else (framing, replies) stays on
+ * that one task. The pool never owns the items, it only passes pointers, and
+ * the owner keeps at most MCP_TOOL_QUEUE_LENGTH in flight so neither queue can
+ * fill up.
+ */
+
+// Maximum number of work items in flight (queued, running or completed)
+#ifndef MCP_TOOL_QUEUE_LENGTH
+#define MCP_TOOL_QUEUE_LENGTH 8
+#endif
+
+#ifndef MCP_TOOL_WORKER_STACK_SIZE
+#define MCP_TOOL_WORKER_STACK_SIZE 6144
+#endif
+
+#ifndef MCP_TOOL_WORKER_PRIORITY
+#define MCP_TOOL_WORKER_PRIORITY 1
+#endif
+
+#ifndef MCP_MAX_TOOL_WORKERS
+#define MCP_MAX_TOOL_WORKERS 4
+#endif
+
+class McpWorkItem {
+public:
+    virtual ~McpWorkItem() {}
+    // Runs on a worker task
+    virtual void run() = 0;
+};
+
+class McpWorkerPool {
+public:
+    McpWorkerPool();
+    ~McpWorkerPool();
+
+    /* *
+     * Start the workers
+     * @param workers Number of worker tasks (1 to MCP_MAX_TOOL_WORKERS)
+     * @param stackSize Stack per worker in bytes (ESP32 only)
+     * @param priority FreeRTOS priority (ESP32 only)
+     * @return false if already running or a task could not be created
+     */
+    bool begin(uint8_t workers, uint32_t stackSize, uint8_t priority);
+
+    // Stop the workers after their current item; items still queued are not run
+    void end();
+
+    bool running() const { return _workers > 0; }
+
+    // Queue an item for a worker; never blocks
+    bool submit(McpWorkItem *item);
+
+    // A finished item, or nullptr; never blocks
+    McpWorkItem *takeCompleted();
+
+private:
+    McpWorkerPool(const McpWorkerPool &);
+    McpWorkerPool &operator=(const McpWorkerPool &);
+
+    void work();
+
+    uint8_t _workers;
+
+#ifdef ESP32
+    static void workerTask(void *arg);
+
+    QueueHandle_t _pending;
+    QueueHandle_t _completed;
+    SemaphoreHandle_t _exited;
+#else
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<McpWorkItem *> _pending;
+    std::deque<McpWorkItem *> _completed;
+    std::vector<std::thread> _threads;
+    bool _stopping;
+#endif
+};
+
+#endif // MCP_WORKER_POOL_H
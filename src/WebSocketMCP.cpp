@@ -1,19 +1,39 @@
 #include "WebSocketMCP.h"
 #include <WiFi.h> 
 #include <ArduinoJson.h>
+#include <atomic>
+#include <new>
+#include <strings.h>
 
 // Includes for native Handshake (assuming mbedtls headers are accessible in the ESP32 Arduino Core environment)
 #include "mbedtls/sha1.h" 
 #include "mbedtls/base64.h" 
 
-// Static instance pointer initialization
-WebSocketMCP* WebSocketMCP::instance = nullptr;
-
 // Static constant definition
 const int WebSocketMCP::INITIAL_BACKOFF;
 const int WebSocketMCP::MAX_BACKOFF;
-const int WebSocketMCP::PING_INTERVAL;
-const int WebSocketMCP::DISCONNECT_TIMEOUT;
+
+// An invocation of an async tool, run on the worker pool
+struct WebSocketMCP::ToolJob : public McpWorkItem {
+    explicit ToolJob(size_t capacity) : doc(capacity), cancelled(false), session(0), elapsedUs(0) {}
+
+    void run() override {
+        // Cancelled while still queued: skip the callback altogether
+        if (!cancelled) {
+            uint32_t start = micros();
+            result = callback(doc["arguments"].as<JsonObjectConst>());
+            elapsedUs = micros() - start;
+        }
+    }
+
+    DynamicJsonDocument doc; // {"id":..., "arguments":...} copied from the request
+    String toolName;
+    ToolArgsCallback callback;
+    ToolResponse result;
+    std::atomic<bool> cancelled;
+    uint32_t session;        // _session the request arrived on
+    uint32_t elapsedUs;      // callback duration, for the tool's stats
+};
 
 // Default constructor implementation (CRITICAL FIXES in initializer list)
 WebSocketMCP::WebSocketMCP() : connected(false), lastReconnectAttempt(0),
@@ -22,9 +42,8 @@ currentBackoff(INITIAL_BACKOFF), reconnectAttempt(0), _injectedClient(nullptr),
 _currentState(WebSocketMCP::WS_DISCONNECTED),
 _host(""), _port(0), _path("/"), _isSecure(false) {
 
-    // Setting static instance pointer
-    instance = this;
     connectionCallback = nullptr;
+    registerBuiltinMethods();
 }
 
 // NEW CONSTRUCTOR IMPLEMENTATION (CRITICAL FIXES in initializer list)
@@ -33,13 +52,70 @@ currentBackoff(INITIAL_BACKOFF), reconnectAttempt(0), _injectedClient(&client),
 // ✅ FIX: Initialize all new members and use class scope for enum
 _currentState(WebSocketMCP::WS_DISCONNECTED),
 _host(""), _port(0), _path("/"), _isSecure(false) {
-    instance = this;
     connectionCallback = nullptr;
-    Serial.println("[xiaozhi-mcp] Network Client injected.");
+    registerBuiltinMethods();
+    MCP_LOGI("Network Client injected.");
+}
+
+WebSocketMCP::~WebSocketMCP() {
+    setHeapTrace(false);
+    endNetworkTask();
+    // Workers must be gone before the jobs they might still be running
+    _toolWorkers.end();
+    for (size_t i = 0; i < _toolJobs.size(); i++) {
+        delete _toolJobs[i];
+    }
+    free(_inflated);
 }
 
 // --- CORE NETWORKING AND PROTOCOL IMPLEMENTATION (Native) ---
 
+namespace {
+
+/**
+ * @brief Assembles the upgrade request in a stack buffer, writing it out whenever the buffer fills.
+ * A typical request goes out in one write, with no String built for it.
+ */
+class HandshakeWriter {
+public:
+    explicit HandshakeWriter(Client &client) : _client(client), _len(0), _ok(true) {}
+
+    void add(const char *text, size_t len) {
+        while (len > 0) {
+            if (_len == sizeof(_buf)) {
+                flush();
+            }
+            size_t n = sizeof(_buf) - _len;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(_buf + _len, text, n);
+            _len += n;
+            text += n;
+            len -= n;
+        }
+    }
+    void add(const char *text) { add(text, strlen(text)); }
+    void add(const String &text) { add(text.c_str(), text.length()); }
+
+    // False if any write came up short
+    bool flush() {
+        if (_len > 0 && _client.write(_buf, _len) != _len) {
+            _ok = false;
+        }
+        _len = 0;
+        return _ok;
+    }
+
+private:
+    Client &_client;
+    size_t _len;
+    bool _ok;
+    uint8_t _buf[MCP_HANDSHAKE_WRITE_SIZE];
+};
+
+} // namespace
+
 /**
  * @brief Attempts to connect the underlying TCP/TLS client and performs the WebSocket handshake.
  * @return True if handshake successful, False otherwise.
@@ -48,77 +124,112 @@ bool WebSocketMCP::performHandshake() {
     Client* netClient = _injectedClient; 
 
     if (!netClient || !netClient->connected()) {
-        Serial.println("[xiaozhi-mcp] ERROR: No connected network client for handshake.");
+        MCP_LOGE("ERROR: No connected network client for handshake.");
         return false;
     }
 
     // 1. Generate Sec-WebSocket-Key (16 random bytes, Base64 encoded)
-    uint8_t keyBytes[1];
+    uint8_t keyBytes[16];
     for (int i = 0; i < 16; i++) {
         keyBytes[i] = random(0, 256);
     }
 
-    char keyBase64[2]; // 16 bytes -> 24 chars Base64 + null terminator
+    char keyBase64[25]; // 16 bytes -> 24 chars Base64 + null terminator
     size_t len;
     // NOTE: This assumes mbedtls base64_encode is correctly linked in the Arduino environment
     mbedtls_base64_encode((unsigned char*)keyBase64, sizeof(keyBase64), &len, keyBytes, 16);
     keyBase64[len] = '\0'; 
-    String clientKey = String(keyBase64);
     
-    // 2. Construct the Handshake Request (HTTP Upgrade)
-    String handshakeRequest = 
-        "GET " + _path + " HTTP/1.1\r\n"
-        "Host: " + _host + "\r\n"
-        "Upgrade: websocket\r\n"
-        "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Key: " + clientKey + "\r\n"
-        "Sec-WebSocket-Version: 13\r\n"
-        "\r\n"; // End of headers
-    
-    // 3. Send Request
-    netClient->print(handshakeRequest);
-
-    unsigned long timeout = millis() + 5000;
-    String response = "";
-
-    // 4. Read Response Headers (Wait for the empty line)
-    while (millis() < timeout && netClient->connected()) {
-        if (netClient->available()) {
-            char c = netClient->read();
-            response += c;
-            if (response.endsWith("\r\n\r\n")) {
-                break; // Found end of headers
-            }
-        }
+    // 2. Construct the Handshake Request (HTTP Upgrade) and 3. Send it
+    HandshakeWriter request(*netClient);
+    request.add("GET ");
+    request.add(_path);
+    request.add(" HTTP/1.1\r\nHost: ");
+    request.add(_host);
+    request.add("\r\nUpgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Key: ");
+    request.add(keyBase64);
+    request.add("\r\nSec-WebSocket-Version: 13\r\n");
+    if (_deflateEnabled) {
+        // No context takeover either way: neither side keeps a window between messages
+        request.add("Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover; "
+                    "server_no_context_takeover; client_max_window_bits\r\n");
+    }
+    if (_subprotocols.length() > 0) {
+        request.add("Sec-WebSocket-Protocol: ");
+        request.add(_subprotocols);
+        request.add("\r\n");
+    }
+    for (size_t i = 0; i < _requestHeaders.size(); i++) {
+        request.add(_requestHeaders[i].name);
+        request.add(": ");
+        request.add(_requestHeaders[i].value);
+        request.add("\r\n");
+    }
+    request.add("\r\n"); // End of headers
+    if (!request.flush()) {
+        MCP_LOGW("Handshake failed: could not send the upgrade request.");
+        netClient->stop();
+        return false;
     }
 
-    if (!netClient->connected() || response.length() == 0) {
-        Serial.println("[xiaozhi-mcp] Handshake timeout or connection lost during response.");
+    // 4. Read Response Headers (Wait for the empty line), in bulk into a fixed buffer
+    _upgrade.reset();
+    unsigned long start = millis();
+    WsUpgradeResponse::Result result = _upgrade.readFrom(*netClient);
+    while (result == WsUpgradeResponse::NEED_MORE) {
+        if (!netClient->connected() || millis() - start > MCP_HANDSHAKE_TIMEOUT_MS) {
+            MCP_LOGW("Handshake timeout or connection lost during response.");
+            netClient->stop();
+            return false;
+        }
+        delay(1);
+        result = _upgrade.readFrom(*netClient);
+    }
+    if (result == WsUpgradeResponse::ERROR) {
+        MCP_LOGW("Handshake failed: malformed response (error %d).", (int)_upgrade.error());
+        netClient->stop();
         return false;
     }
 
     // 5. Validate Response Status and Headers
-    if (!response.startsWith("HTTP/1.1 101")) {
-        Serial.println("[xiaozhi-mcp] Invalid Handshake response code. Expected 101.");
+    if (_upgrade.status() != 101) {
+        MCP_LOGW("Invalid Handshake response code %d. Expected 101.", _upgrade.status());
         netClient->stop(); // Close connection if invalid
         return false;
     }
+    const char *upgrade = _upgrade.header("Upgrade");
+    const char *connection = _upgrade.header("Connection");
+    if (!upgrade || !WsUpgradeResponse::hasToken(upgrade, "websocket") ||
+        !connection || !WsUpgradeResponse::hasToken(connection, "upgrade")) {
+        MCP_LOGW("Handshake failed: missing Upgrade: websocket or Connection: Upgrade.");
+        netClient->stop();
+        return false;
+    }
 
     // 6. Validate Sec-WebSocket-Accept
-    String magicString = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-    String combined = clientKey + magicString;
+    static const char magicString[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    char combined[24 + sizeof(magicString)];
+    memcpy(combined, keyBase64, 24);
+    memcpy(combined + 24, magicString, sizeof(magicString));
     
-    uint8_t hash[3]; // SHA1 produces 20 bytes
+    uint8_t hash[20]; // SHA1 produces 20 bytes
     // NOTE: This assumes mbedtls sha1 is correctly linked
-    mbedtls_sha1((const unsigned char*)combined.c_str(), combined.length(), hash);
+    mbedtls_sha1((const unsigned char*)combined, sizeof(combined) - 1, hash);
 
-    char expectedAcceptBase64[4]; // 20 bytes -> 28 chars Base64 + null terminator
+    char expectedAcceptBase64[29]; // 20 bytes -> 28 chars Base64 + null terminator
     mbedtls_base64_encode((unsigned char*)expectedAcceptBase64, sizeof(expectedAcceptBase64), &len, hash, 20);
     expectedAcceptBase64[len] = '\0';
-    String expectedAccept = String(expectedAcceptBase64);
 
-    if (response.indexOf("Sec-WebSocket-Accept: " + expectedAccept) == -1) {
-        Serial.println("[xiaozhi-mcp] Handshake failed: Sec-WebSocket-Accept mismatch.");
+    const char *accept = _upgrade.header("Sec-WebSocket-Accept");
+    if (!accept || strcmp(accept, expectedAcceptBase64) != 0) {
+        MCP_LOGW("Handshake failed: Sec-WebSocket-Accept mismatch.");
+        netClient->stop();
+        return false;
+    }
+
+    if (!acceptSubprotocol(_upgrade) || !acceptExtensions(_upgrade)) {
         netClient->stop();
         return false;
     }
@@ -127,255 +238,590 @@ bool WebSocketMCP::performHandshake() {
     return true;
 }
 
+// Next ';' separated element of an extension header value, trimmed, with its optional
+// (possibly quoted) value; false at the end
+static bool nextExtensionParam(const char *&p, const char *&name, size_t &nameLen,
+                               const char *&value, size_t &valueLen) {
+    while (*p == ';' || *p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == '\0') {
+        return false;
+    }
+    const char *end = p;
+    while (*end && *end != ';') {
+        end++;
+    }
+    const char *eq = (const char *)memchr(p, '=', end - p);
+    const char *nameEnd = eq ? eq : end;
+    while (nameEnd > p && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t')) {
+        nameEnd--;
+    }
+    name = p;
+    nameLen = nameEnd - p;
+
+    value = end;
+    valueLen = 0;
+    if (eq) {
+        value = eq + 1;
+        const char *valueEnd = end;
+        while (value < valueEnd && (*value == ' ' || *value == '\t' || *value == '"')) {
+            value++;
+        }
+        while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t' || valueEnd[-1] == '"')) {
+            valueEnd--;
+        }
+        valueLen = valueEnd - value;
+    }
+    p = end;
+    return true;
+}
+
+static bool paramIs(const char *name, size_t nameLen, const char *expected) {
+    return nameLen == strlen(expected) && strncasecmp(name, expected, nameLen) == 0;
+}
+
+// Window size parameter value: 8 to 15, or -1 if invalid
+static int windowBitsParam(const char *value, size_t len) {
+    if (len == 1 && value[0] >= '8' && value[0] <= '9') {
+        return value[0] - '0';
+    }
+    if (len == 2 && value[0] == '1' && value[1] >= '0' && value[1] <= '5') {
+        return 10 + (value[1] - '0');
+    }
+    return -1;
+}
+
 /**
- * @brief Implements WebSocket framing (RFC 6455) and sends data over the underlying client.
- * NOTE: This implementation includes mandatory client masking (M=1).
+ * @brief Applies the Sec-WebSocket-Extensions response header, if any, to this connection.
+ * @return False if the server answered with an extension or parameters that were not offered.
  */
-bool WebSocketMCP::sendWebSocketFrame(const String& data, bool isText) {
-    if (!connected || !_injectedClient) {
+bool WebSocketMCP::acceptExtensions(const WsUpgradeResponse &response) {
+    _deflateActive = false;
+    _rxParser.setRsv1Allowed(false);
+
+    const char *extension = nullptr;
+    for (size_t i = 0; i < response.headerCount(); i++) {
+        if (strcasecmp(response.headerName(i), "Sec-WebSocket-Extensions") != 0) {
+            continue;
+        }
+        // Only one extension was offered, so only one can be accepted
+        if (extension || strchr(response.headerValue(i), ',')) {
+            MCP_LOGW("Handshake failed: more than one extension accepted.");
+            return false;
+        }
+        extension = response.headerValue(i);
+    }
+    if (!extension || *extension == '\0') {
+        return true; // Compression declined (or not offered)
+    }
+
+    const char *p = extension;
+    const char *name;
+    const char *value;
+    size_t nameLen;
+    size_t valueLen;
+    if (!_deflateEnabled || !nextExtensionParam(p, name, nameLen, value, valueLen) ||
+        !paramIs(name, nameLen, "permessage-deflate") || valueLen > 0) {
+        MCP_LOGW("Handshake failed: unexpected extension '%s'.", extension);
         return false;
     }
 
-    Client* netClient = _injectedClient;
-    size_t payloadLength = data.length();
-    uint8_t header[5]; // Max header size for 64-bit length + mask key
-    int headerLen = 0;
-    
-    // 1. First byte: FIN=1, RSV=0, Opcode=TEXT (0x1), PING (0x9), PONG (0xA), CLOSE (0x8)
-    uint8_t opcode;
-    if (isText) {
-        opcode = 0x01; // TEXT
-    } else if (payloadLength == 0) {
-        // Assume empty payload means PING/PONG/CLOSE signaling
-        if (!connected) opcode = 0x08; // CLOSE frame
-        else opcode = 0x09; // PING frame (Ping is used for heartbeat, Pong is passive response)
-    } else {
-        // If it's not text and not a control frame, something is wrong
-        return false; 
+    bool serverNoContext = false;
+    _deflateSendBits = _deflateWindowBits;
+    while (nextExtensionParam(p, name, nameLen, value, valueLen)) {
+        if (paramIs(name, nameLen, "server_no_context_takeover") && valueLen == 0) {
+            serverNoContext = true;
+        } else if (paramIs(name, nameLen, "client_no_context_takeover") && valueLen == 0) {
+            // Offered by us anyway
+        } else if (paramIs(name, nameLen, "server_max_window_bits")) {
+            // Messages are inflated whole, so any window the server uses is fine
+            if (windowBitsParam(value, valueLen) < 0) {
+                MCP_LOGW("Handshake failed: invalid server_max_window_bits.");
+                return false;
+            }
+        } else if (paramIs(name, nameLen, "client_max_window_bits")) {
+            int limit = windowBitsParam(value, valueLen);
+            if (limit < 0) {
+                MCP_LOGW("Handshake failed: invalid client_max_window_bits.");
+                return false;
+            }
+            if (limit < _deflateSendBits) {
+                // 8 is allowed by RFC 7692 but zlib treats it as 9; stay on the safe side
+                _deflateSendBits = limit < 9 ? 9 : (uint8_t)limit;
+            }
+        } else {
+            MCP_LOGW("Handshake failed: unknown permessage-deflate parameter '%.*s'.", (int)nameLen, name);
+            return false;
+        }
+    }
+    // The server must keep no context, as the receive side has no window to resolve it against
+    if (!serverNoContext) {
+        MCP_LOGW("Handshake failed: permessage-deflate without server_no_context_takeover.");
+        return false;
     }
 
-    header[headerLen++] = 0x80 | opcode; // FIN bit set + Opcode
+    _rxParser.setRsv1Allowed(true);
+    _deflateActive = true;
+    MCP_LOGI("permessage-deflate active (window %u bits).", _deflateSendBits);
+    return true;
+}
 
-    // 2. Second byte: Mask=1 (M=1 is mandatory for clients), Payload Len
-    uint8_t mask_bit = 0x80;
-    if (payloadLength <= 125) {
-        header[headerLen++] = mask_bit | payloadLength; 
-    } else if (payloadLength <= 65535) {
-        header[headerLen++] = mask_bit | 126; 
-        header[headerLen++] = (payloadLength >> 8) & 0xFF;
-        header[headerLen++] = payloadLength & 0xFF;
-    } else {
-        Serial.println("[xiaozhi-mcp] ERROR: Payload too large.");
+/**
+ * @brief Records the subprotocol the server picked, which must be one that was offered.
+ */
+bool WebSocketMCP::acceptSubprotocol(const WsUpgradeResponse &response) {
+    _subprotocol = "";
+    const char *picked = response.header("Sec-WebSocket-Protocol");
+    if (!picked || *picked == '\0') {
+        return true;
+    }
+    if (_subprotocols.length() == 0 || strchr(picked, ',') ||
+        !WsUpgradeResponse::hasToken(_subprotocols.c_str(), picked)) {
+        MCP_LOGW("Handshake failed: server picked subprotocol '%s', which was not offered.", picked);
         return false;
     }
+    _subprotocol = picked;
+    MCP_LOGI("Subprotocol: %s", picked);
+    return true;
+}
 
-    // 3. Masking Key (4 random bytes)
-    uint8_t maskingKey[6];
-    for (int i = 0; i < 4; i++) {
-        maskingKey[i] = random(0, 256);
-        header[headerLen++] = maskingKey[i];
+/**
+ * @brief Adds, replaces or (with an empty value) removes a header of the upgrade request.
+ */
+bool WebSocketMCP::setHeader(const String &name, const String &value) {
+    static const char *const reserved[] = {"Host", "Upgrade", "Connection", "Sec-WebSocket-Key",
+                                           "Sec-WebSocket-Version", "Sec-WebSocket-Extensions",
+                                           "Sec-WebSocket-Protocol", "Sec-WebSocket-Accept"};
+    if (name.length() == 0 || value.indexOf('\r') >= 0 || value.indexOf('\n') >= 0) {
+        return false;
+    }
+    for (size_t i = 0; i < name.length(); i++) {
+        char c = name[i];
+        if (!isalnum((unsigned char)c) && !strchr("!#$%&'*+-.^_`|~", c)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < sizeof(reserved) / sizeof(reserved[0]); i++) {
+        if (name.equalsIgnoreCase(reserved[i])) {
+            MCP_LOGW("Header %s is set by the library.", reserved[i]);
+            return false;
+        }
     }
-    
-    // 4. Send Header
-    netClient->write(header, headerLen);
 
-    // 5. Mask and Send Payload
-    if (payloadLength > 0) {
-        for (size_t i = 0; i < payloadLength; i++) {
-            // Apply XOR masking before sending
-            uint8_t maskedByte = data[i] ^ maskingKey[i % 4];
-            netClient->write(maskedByte);
+    for (size_t i = 0; i < _requestHeaders.size(); i++) {
+        if (_requestHeaders[i].name.equalsIgnoreCase(name)) {
+            if (value.length() == 0) {
+                _requestHeaders.erase(_requestHeaders.begin() + i);
+            } else {
+                _requestHeaders[i].value = value;
+            }
+            return true;
         }
     }
-    
-    netClient->flush();
+    if (value.length() > 0) {
+        RequestHeader header;
+        header.name = name;
+        header.value = value;
+        _requestHeaders.push_back(header);
+    }
     return true;
 }
 
 /**
- * @brief Reads data from the socket, parses WebSocket frames, and extracts the payload.
+ * @brief Implements WebSocket framing (RFC 6455) and sends data over the underlying client.
+ * NOTE: This implementation includes mandatory client masking (M=1).
+ * The frame is built and masked in _txFrame, then written in as few write() calls as possible.
  */
-String WebSocketMCP::receiveWebSocketFrame() {
-    if (!_injectedClient || !_injectedClient->connected()) {
-        return "";
+bool WebSocketMCP::sendWebSocketFrame(const uint8_t* payload, size_t len, uint8_t opcode) {
+    if (!connected || !_injectedClient) {
+        return false;
     }
-    
-    Client* netClient = _injectedClient;
-    
-    // Wait until at least 2 bytes (minimum header size) are available
-    unsigned long timeout = millis() + 5000;
-    while (netClient->available() < 2 && millis() < timeout) {
-        vTaskDelay(pdMS_TO_TICKS(1));
+
+    if (_batchOpen) {
+        // A callback sending mid-batch: the batch reply being collected in _txFrame must survive
+        _capture.record(true, opcode, payload, len);
+        WsFrameEncoder frame;
+        if (!frame.encode(opcode, payload, len, nextMaskKey())) {
+            MCP_LOGE("ERROR: Out of memory for outgoing frame.");
+            return false;
+        }
+        return sendEncodedFrame(frame.frame(), frame.frameLength(), false);
     }
-    
-    if (netClient->available() < 2) {
-        return "";
+
+    _txFrame.begin();
+    if (!_txFrame.append(payload, len)) {
+        MCP_LOGE("ERROR: Out of memory for outgoing frame.");
+        return false;
     }
+    return finishTxFrame(opcode, false);
+}
 
-    // 1. Read first two header bytes
-    uint8_t header1 = netClient->read(); 
-    uint8_t header2 = netClient->read(); 
+/**
+ * @brief Sends the payload built in _txFrame (begin() + append()) as one frame.
+ */
+bool WebSocketMCP::sendTxFrame(uint8_t opcode) {
+    if (!connected || !_injectedClient) {
+        return false;
+    }
+    return finishTxFrame(opcode, true);
+}
 
-    bool fin = header1 & 0x80;
-    uint8_t opcode = header1 & 0x0F;
-    bool mask = header2 & 0x80; // Should be 0 for server response
-    size_t payloadLen = header2 & 0x7F;
-    
-    if (opcode == 0x08) { // CLOSE frame received
-        Serial.println("[xiaozhi-mcp] Received CLOSE frame. Disconnecting.");
-        disconnect();
-        return "";
+/**
+ * @brief Encodes the _txFrame payload as one frame, compressed into _txDeflated when that pays off.
+ */
+bool WebSocketMCP::finishTxFrame(uint8_t opcode, bool wait) {
+    size_t len = _txFrame.payloadLength();
+    _capture.record(true, opcode, _txFrame.payload(), len);
+    if (_deflateActive && len >= _deflateThreshold && !(opcode & 0x08)) {
+        // Output capped below the input: incompressible payloads come back as 0 and go out as-is
+        _txDeflated.begin();
+        uint8_t *out = _txDeflated.appendSpace(len);
+        size_t compressedLen = out ? _deflater.compress(_txFrame.payload(), len, out, len - 1, _deflateSendBits) : 0;
+        if (compressedLen > 0) {
+            _txDeflated.commit(compressedLen);
+            _txDeflated.finish(opcode | WS_FLAG_RSV1, nextMaskKey());
+            return sendEncodedFrame(_txDeflated.frame(), _txDeflated.frameLength(), wait);
+        }
     }
-    if (opcode == 0x0A) { // PONG frame received
-        Serial.println("[xiaozhi-mcp] Received PONG frame.");
-        // PONG confirms connectivity, update lastPingTime
-        lastPingTime = millis();
-        return "";
+
+    if (!_txFrame.finish(opcode, nextMaskKey())) {
+        MCP_LOGE("ERROR: Out of memory for outgoing frame.");
+        return false;
     }
-    if (opcode != 0x01) { // Expecting only TEXT (0x1) from server
-        if (opcode == 0x09) { // Server PING received
-            Serial.println("[xiaozhi-mcp] Received PING frame. Sending PONG.");
-            // Send PONG response (opcode 0x0A, using sendWebSocketFrame with isText=false)
-            sendWebSocketFrame("", false); 
-            lastPingTime = millis();
-            return "";
+    return sendEncodedFrame(_txFrame.frame(), _txFrame.frameLength(), wait);
+}
+
+/**
+ * @brief Queues a frame encoded on the loop() side for the socket side.
+ * Without the network task the queue is flushed right away, or after the messages being read
+ * have all been answered, so their replies share writes. Frames too large to coalesce skip
+ * the copy into the queue when nothing is waiting ahead of them.
+ * @param wait Replies wait a little for room in a full queue; sendMessage() reports backpressure instead.
+ */
+bool WebSocketMCP::sendEncodedFrame(const uint8_t* frame, size_t len, bool wait) {
+    uint8_t tag = McpSendQueue::tagFor(_session);
+
+    if (!_netRunning) {
+        if (len > MCP_TX_COALESCE_SIZE && _sendQueue.idle()) {
+            return writeFrame(frame, len);
+        }
+        if (!_sendQueue.push(tag, frame, len)) {
+            // Make room by writing what the socket takes now, then try once more
+            if (!flushSendQueue() || !_sendQueue.push(tag, frame, len)) {
+                if (_sendQueue.idle()) {
+                    return writeFrame(frame, len); // Larger than the queue can hold
+                }
+                MCP_LOGW("Send queue full (%u bytes queued).", (unsigned)_sendQueue.depth());
+                return false;
+            }
         }
-        Serial.printf("[xiaozhi-mcp] WARNING: Received unsupported opcode 0x%X\n", opcode);
-        return ""; 
+        return _txHold || flushSendQueue();
+    }
+
+    if (len > _sendQueue.maxFrame()) {
+        MCP_LOGE("ERROR: %u byte frame exceeds the send queue (MCP_TX_QUEUE_SIZE).", (unsigned)len);
+        return false;
     }
-    if (!fin) {
-        Serial.println("[xiaozhi-mcp] WARNING: Received fragmented frame (FIN=0). Skipping.");
-        return ""; 
+    // Tagged with the connection it belongs to, so the task drops it after a reconnect
+    unsigned long start = millis();
+    while (!_sendQueue.push(tag, frame, len)) {
+        if (!wait || millis() - start > MCP_NET_TX_WAIT_MS) {
+            MCP_LOGW("Send queue full (%u bytes queued).", (unsigned)_sendQueue.depth());
+            return false;
+        }
+        delay(1);
     }
+    return true;
+}
 
-    // 2. Read Extended Length (if any)
-    if (payloadLen == 126) {
-        uint16_t len16 = netClient->read() << 8 | netClient->read();
-        payloadLen = (size_t)len16;
-    } else if (payloadLen == 127) {
-        // 64-bit length (skip reading 6 additional bytes)
-        for(int i=0; i<8; i++) netClient->read(); // Skip reading 8 bytes of 64-bit length
-        Serial.println("[xiaozhi-mcp] ERROR: Received 64-bit length payload (Unsupported).");
-        return "";
+/**
+ * @brief Queues a PING, PONG or CLOSE frame ahead of the data frames and flushes (socket side).
+ */
+bool WebSocketMCP::sendControlFrame(uint8_t opcode, const uint8_t* payload, size_t len) {
+    if (!connected || !_injectedClient) {
+        return false;
     }
 
-    // 3. Read Masking Key (if any)
-    uint8_t maskingKey[6] = {0, 0, 0, 0};
-    if (mask) {
-        // Server response should NOT be masked, but read defensively 
-        for (int i = 0; i < 4; i++) {
-            maskingKey[i] = netClient->read();
-        }
+    // Control frame payloads are at most 125 bytes (RFC 6455 5.5)
+    uint8_t frame[WsFrameEncoder::MAX_HEADER_LEN + 125];
+    if (len > 125) {
+        len = 125;
     }
+    _capture.record(true, opcode, payload, len);
+    uint32_t maskKey = nextMaskKey();
+    size_t headerLen = WsFrameEncoder::encodeHeader(frame, opcode, len, maskKey);
+    if (len > 0) {
+        memcpy(frame + headerLen, payload, len);
+        WsFrameEncoder::applyMask(frame + headerLen, len, maskKey);
+    }
+    if (!_sendQueue.pushControl(frame, headerLen + len)) {
+        MCP_LOGW("Control frame 0x%X dropped: %u already waiting.", opcode, MCP_TX_CONTROL_SLOTS);
+        return false;
+    }
+    return flushSendQueue();
+}
 
-    // 4. Read Payload
-    if (payloadLen == 0) {
-        return "";
+/**
+ * @brief Writes a large frame without copying it into the queue (socket side, queue idle).
+ * What the socket does not take right away is queued and resumed by flushSendQueue().
+ */
+bool WebSocketMCP::writeFrame(const uint8_t* frame, size_t len) {
+    if (!_sendQueue.write(*_injectedClient, McpSendQueue::tagFor(_linkSession), frame, len)) {
+        MCP_LOGE("ERROR: Socket stalled in the middle of a frame. Closing.");
+        _sendQueue.clear();
+        closeConnection(WS_CLOSE_INTERNAL_ERROR);
+        return false;
     }
+    return true;
+}
 
-    // Wait for the entire payload to be available (reuse timeout)
-    timeout = millis() + 5000;
-    while (netClient->available() < payloadLen && millis() < timeout) {
-        vTaskDelay(pdMS_TO_TICKS(1));
+/**
+ * @brief Writes queued frames as far as the socket takes them, control frames first (socket side).
+ * @return False if the socket has not taken anything for MCP_TX_STALL_TIMEOUT_MS; the connection is closed.
+ */
+bool WebSocketMCP::flushSendQueue() {
+    if (!connected || !_injectedClient) {
+        _sendQueue.clear();
+        return false;
     }
-    
-    if (netClient->available() < payloadLen) {
-        Serial.println("[xiaozhi-mcp] ERROR: Incomplete payload received.");
-        return "";
+    if (_sendQueue.flush(*_injectedClient, McpSendQueue::tagFor(_linkSession)) == McpSendQueue::STALLED) {
+        MCP_LOGE("ERROR: Socket took no data for %u ms. Closing.", (unsigned)MCP_TX_STALL_TIMEOUT_MS);
+        _sendQueue.clear();
+        closeConnection(WS_CLOSE_INTERNAL_ERROR);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a fresh 32-bit masking key (hardware RNG on ESP32).
+ */
+uint32_t WebSocketMCP::nextMaskKey() {
+#ifdef ESP32
+    return esp_random();
+#else
+    return ((uint32_t)random(0x10000) << 16) | (uint32_t)random(0x10000);
+#endif
+}
+
+/**
+ * @brief Feeds whatever the socket has buffered into the frame parser, without waiting for more.
+ * Control frames are answered here, also while a fragmented message is being reassembled.
+ * Partial frames and messages stay in _rxParser until the next loop().
+ * @return True when a complete TEXT message is available in _rxParser.
+ */
+bool WebSocketMCP::receiveWebSocketFrame() {
+    if (!_injectedClient || !_injectedClient->connected()) {
+        return false;
     }
 
-    String payload = "";
-    payload.reserve(payloadLen + 1);
+    while (connected) {
+        WsFrameParser::Result result;
+        if (_upgrade.pendingLength() > 0) {
+            // Frames the server sent right behind the upgrade response
+            size_t used = 0;
+            result = _rxParser.feed(_upgrade.pending(), _upgrade.pendingLength(), used);
+            _upgrade.consumePending(used);
+            if (result == WsFrameParser::NEED_MORE) {
+                result = _rxParser.readFrom(*_injectedClient);
+            }
+        } else {
+            result = _rxParser.readFrom(*_injectedClient);
+        }
+        if (result == WsFrameParser::NEED_MORE) {
+            return false;
+        }
+        if (result == WsFrameParser::ERROR) {
+            _metrics.frameErrors++;
+            MCP_LOGE("ERROR: Invalid frame received (parser error %d). Closing with %u.",
+                          (int)_rxParser.error(), _rxParser.closeCode());
+            closeConnection(_rxParser.closeCode());
+            return false;
+        }
+
+        uint8_t opcode = _rxParser.opcode();
+        if (opcode != WS_OP_TEXT) {
+            // TEXT payloads are captured once decompressed
+            _capture.record(false, opcode, _rxParser.payload(), _rxParser.payloadLength());
+        }
+
+        if (opcode == WS_OP_CLOSE) {
+            MCP_LOGI("Received CLOSE frame. Disconnecting.");
+            closeConnection(WS_CLOSE_NORMAL);
+            return false;
+        }
+        if (opcode == WS_OP_PONG) {
+            MCP_LOGD("Received PONG frame.");
+            // Unsolicited PONGs (RFC 6455 5.5.3) only count as activity, like any other frame
+            uint32_t rtt;
+            if (_keepalive.pong(_rxParser.payload(), _rxParser.payloadLength(), millis(), rtt)) {
+                _metrics.recordRtt(rtt);
+            }
+            continue;
+        }
+        if (opcode == WS_OP_PING) {
+            MCP_LOGD("Received PING frame. Sending PONG.");
+            // PONG must echo the PING payload
+            sendControlFrame(WS_OP_PONG, _rxParser.payload(), _rxParser.payloadLength());
+            continue;
+        }
+        if (opcode != WS_OP_TEXT) { // Expecting only TEXT (0x1) from server
+            MCP_LOGW("WARNING: Received unsupported opcode 0x%X", opcode);
+            continue;
+        }
+        if (_rxParser.payloadLength() == 0) {
+            continue;
+        }
+        if (_rxParser.compressed()) {
+            if (!inflateMessage()) {
+                return false;
+            }
+        } else {
+            _rxMessage = _rxParser.payload();
+            _rxMessageLength = _rxParser.payloadLength();
+        }
+        _capture.record(false, WS_OP_TEXT, _rxMessage, _rxMessageLength);
+        return true;
+    }
+    return false;
+}
 
-    for (size_t i = 0; i < payloadLen; i++) {
-        uint8_t b = netClient->read();
-        // Unmask if necessary
-        if (mask) {
-            b ^= maskingKey[i % 4];
+/**
+ * @brief Decompresses the message in _rxParser into _inflated (permessage-deflate).
+ * Closes the connection if it is corrupt or inflates beyond the maximum message size.
+ * @return True when the message is ready in _rxMessage.
+ */
+bool WebSocketMCP::inflateMessage() {
+    size_t capacity = _rxParser.maxMessageSize();
+    if (_inflatedCapacity != capacity) {
+        free(_inflated);
+        _inflated = (uint8_t*)malloc(capacity + 1);
+        _inflatedCapacity = _inflated ? capacity : 0;
+        if (!_inflated) {
+            MCP_LOGE("ERROR: Out of memory for decompressed message.");
+            closeConnection(WS_CLOSE_INTERNAL_ERROR);
+            return false;
         }
-        payload += (char)b;
     }
 
-    return payload;
+    size_t len = 0;
+    McpInflater::Result result = McpInflater::inflate(_rxParser.payload(), _rxParser.payloadLength(),
+                                                      _inflated, capacity, len);
+    if (result != McpInflater::OK) {
+        _metrics.frameErrors++;
+        bool tooLarge = result == McpInflater::ERR_TOO_LARGE;
+        MCP_LOGE("ERROR: %s compressed message. Closing.", tooLarge ? "Oversized" : "Corrupt");
+        closeConnection(tooLarge ? WS_CLOSE_MESSAGE_TOO_BIG : WS_CLOSE_INVALID_DATA);
+        return false;
+    }
+    _inflated[len] = '\0';
+    _rxMessage = _inflated;
+    _rxMessageLength = len;
+    return true;
 }
 
 
 /**
- * @brief Processes incoming data from the socket by iterating through frames.
+ * @brief Processes incoming data from the socket by iterating through complete messages.
  */
 void WebSocketMCP::processReceivedData() { // ✅ FIX: Function declared in .h
-    // Continuously process frames while data is available
-    while (_injectedClient && _injectedClient->available()) {
-        String message = receiveWebSocketFrame();
-        
-        if (message.length() > 0) {
-            // Received a valid WebSocket message, handle as JSON-RPC
-            handleJsonRpcMessage(message);
-        } else if (!connected) {
-            // Disconnect occurred during frame reading (e.g., received CLOSE frame)
-            break;
+    // A message the receive queue had no room for goes first; it is still in _rxParser (or _inflated)
+    if (_rxHeld) {
+        if (!deliverMessage(_rxMessage, _rxMessageLength)) {
+            return;
+        }
+        _rxHeld = false;
+    }
+
+    // Handle every message that is complete; a partial one is resumed on the next call
+    while (receiveWebSocketFrame()) {
+        // Received a valid WebSocket message, handle as JSON-RPC
+        if (!deliverMessage(_rxMessage, _rxMessageLength)) {
+            // Stop reading until loop() catches up; TCP pushes back on the server
+            _rxHeld = true;
+            return;
         }
     }
 }
 
+/**
+ * @brief Hands a received message to the JSON-RPC layer, directly or through the receive queue.
+ * @return False if the queue is full right now (try again later).
+ */
+bool WebSocketMCP::deliverMessage(const uint8_t* message, size_t len) {
+    if (!_netRunning) {
+        handleJsonRpcMessage((const char*)message, len);
+        return true;
+    }
+    if (len > _rxRing.maxRecord()) {
+        MCP_LOGE("ERROR: %u byte message exceeds the receive queue (MCP_NET_RX_RING_SIZE), dropped.",
+                      (unsigned)len);
+        return true;
+    }
+    return _rxRing.push(NET_MESSAGE, message, len);
+}
+
 
 bool WebSocketMCP::begin(const char *mcpEndpoint, ConnectionCallback connCb) {
 
     // Save the callback function
     connectionCallback = connCb;
 
-    // Parse WebSocket URLs
-    String url = String(mcpEndpoint);
-    int protocolPos = url.indexOf("://");
-    if (protocolPos == -1) {
-        Serial.println("[xiaozhi-mcp] ERROR: Invalid endpoint URL format.");
+    // Parse WebSocket URLs (scheme://host[:port][/path]) in place
+    const char *separator = strstr(mcpEndpoint, "://");
+    if (!separator) {
+        MCP_LOGE("ERROR: Invalid endpoint URL format.");
         return false;
     }
-
-    String protocol = url.substring(0, protocolPos);
-    String remaining = url.substring(protocolPos + 3);
-
-    int pathPos = remaining.indexOf('/');
-    String host;
-    String path = "/";
-    uint16_t port = 80;
-
-    if (pathPos >= 0) {
-        host = remaining.substring(0, pathPos);
-        path = remaining.substring(pathPos);
-    } else {
-        host = remaining;
-    }
-
-    // Check port
-    int portPos = host.indexOf(':');
-    if (portPos >= 0) {
-        port = host.substring(portPos + 1).toInt();
-        host = host.substring(0, portPos);
-    } else {
-        // Set the default port according to the protocol
-        if (protocol == "ws") {
-            port = 80;
-        } else if (protocol == "wss") {
-            port = 443;
-        }
+    size_t schemeLen = separator - mcpEndpoint;
+    bool secure = schemeLen == 3 && memcmp(mcpEndpoint, "wss", 3) == 0;
+
+    const char *host = separator + 3;
+    const char *path = strchr(host, '/');
+    const char *hostEnd = path ? path : host + strlen(host);
+
+    // Check port, or set the default one according to the protocol
+    uint16_t port = secure ? 443 : 80;
+    const char *colon = (const char *)memchr(host, ':', hostEnd - host);
+    if (colon) {
+        port = (uint16_t)atoi(colon + 1);
+        hostEnd = colon;
     }
     
     // ✅ FIX: Assignment to member variables must work now since they are initialized in constructors
-    _host = host;
+    _host = "";
+    _host.concat(host, hostEnd - host);
     _port = port;
-    _path = path;
-    _isSecure = (protocol == "wss");
+    _path = path ? path : "/";
+    _isSecure = secure;
     
     // Check if client injection is required for WSS
     if (_isSecure && !_injectedClient) {
-        Serial.println("[xiaozhi-mcp] ERROR: WSS requested but no Client object injected. TLS will fail.");
+        MCP_LOGE("ERROR: WSS requested but no Client object injected. TLS will fail.");
     }
     
     lastReconnectAttempt = 0;
     currentBackoff = INITIAL_BACKOFF;
+    _reconnectDelay = 0;
+    _dnsCache.invalidate();
+
+    // Preallocate the frame buffers so typical messages never allocate
+    _txFrame.reserve(MCP_TX_BUFFER_INITIAL);
+    if (!_sendQueue.begin()) {
+        MCP_LOGE("ERROR: Could not allocate the send queue.");
+        return false;
+    }
+    if (!_rxParser.begin()) {
+        MCP_LOGE("ERROR: Could not allocate the receive message buffer.");
+        return false;
+    }
+    if (!_jsonArena.begin()) {
+        MCP_LOGE("ERROR: Could not allocate the JSON document.");
+        return false;
+    }
     
-    Serial.println("[xiaozhi-mcp] Configuration complete. Connection attempt delegated to loop.");
+    MCP_LOGI("Configuration complete. Connection attempt delegated to loop.");
 
     return true;
 }
@@ -384,24 +830,60 @@ bool WebSocketMCP::begin(const char *mcpEndpoint, ConnectionCallback connCb) {
 
 bool WebSocketMCP::sendMessage(const String &message) {
     if (!connected) {
-        Serial.println("[xiaozhi-mcp] Not connected to WebSocket server, unable to send messages");
+        MCP_LOGW("Not connected to WebSocket server, unable to send messages");
         return false;
     }
 
-    Serial.println("[xiaozhi-mcp] Send message:" + message);
+    // Truncated to MCP_LOG_LINE_SIZE; no copy of the payload
+    MCP_LOGD("Send message:%s", message.c_str());
 
     // ✅ FIX: Use manual WebSocket framing over the Client socket
-    if (sendWebSocketFrame(message, true)) { // ✅ FIX: Function declared in .h
+    if (sendWebSocketFrame(message, WS_OP_TEXT)) { // ✅ FIX: Function declared in .h
         return true;
     }
 
-    Serial.println("[xiaozhi-mcp] Failed to send WebSocket frame.");
+    MCP_LOGE("Failed to send WebSocket frame.");
     return false;
 }
 
 
 void WebSocketMCP::loop() {
+
+    // Replies of async tools that finished on the worker pool
+    if (!_toolJobs.empty()) {
+        processToolJobs();
+    }
+
+    // The network task does the transport work; only handle what it received
+    if (_netRunning) {
+        pollNetworkEvents();
+    } else {
+        networkLoop();
+    }
+
+    // Deferred log lines are printed once the messages have been answered
+    if (McpLog::deferred()) {
+        McpLog::flush();
+    }
+}
+
+/**
+ * @brief Transport work: reconnect, read and answer frames, keepalive.
+ * Runs from loop(), or on the network task after beginNetworkTask().
+ */
+void WebSocketMCP::networkLoop() {
+    // Frames queued since the last pass, and the rest of any the socket did not take
+    flushSendQueue();
+    if (_netRunning && _closeRequested.exchange(false)) {
+        closeConnection(WS_CLOSE_NORMAL);
+    }
     
+    // A socket closed under us (server gone, WiFi dropped) ends the session, so reconnecting starts
+    if (connected && _injectedClient && !_injectedClient->connected()) {
+        MCP_LOGW("Connection lost.");
+        closeConnection(WS_CLOSE_NORMAL);
+    }
+
     // Check underlying connection status
     if (!connected || !_injectedClient || !_injectedClient->connected()) {
         handleReconnect();
@@ -412,50 +894,219 @@ void WebSocketMCP::loop() {
     if (connected && _injectedClient) {
         
         // 1. Process Incoming Data
-        if (_injectedClient->available()) {
+        unsigned long now = millis();
+        bool incoming = _injectedClient->available() || _upgrade.pendingLength() > 0;
+        if (incoming) {
+            // Any byte from the server, even of an unfinished frame, shows it is alive
+            _keepalive.received(now);
+        }
+        if (_rxHeld || incoming) {
+            // Replies to everything read in this pass go out together afterwards
+            _txHold = true;
             processReceivedData(); // ✅ FIX: Function declared in .h
+            _txHold = false;
+            flushSendQueue();
         }
         
-        // 2. Handle Keep-Alive (PING)
-        unsigned long now = millis();
-        if (now - lastPingTime > PING_INTERVAL) {
-            Serial.println("[xiaozhi-mcp] Sending WebSocket PING frame.");
-            sendWebSocketFrame("", false); // ✅ FIX: Function declared in .h
-            lastPingTime = now;
+        // 2. Keep-Alive: probe a quiet server, give up on one that stopped answering
+        switch (_keepalive.poll(now)) {
+        case McpKeepalive::PROBE: {
+            uint8_t payload[McpKeepalive::PAYLOAD_LEN];
+            _keepalive.probe(now, payload);
+            MCP_LOGD("Sending WebSocket PING frame.");
+            if (sendControlFrame(WS_OP_PING, payload, sizeof(payload))) {
+                _metrics.pingsSent++;
+            }
+            break;
         }
-
-        // 3. Handle Disconnection Timeout
-        if (lastPingTime > 0 && now - lastPingTime > DISCONNECT_TIMEOUT) {
-            Serial.println("[xiaozhi-mcp] Ping/Inactivity timeout, resetting connection.");
-            disconnect();
+        case McpKeepalive::DEAD:
+            MCP_LOGW("No answer to %u PINGs, resetting connection.", (unsigned)_keepalive.probes());
+            _metrics.keepaliveTimeouts++;
+            closeConnection(WS_CLOSE_NORMAL);
+            break;
+        default:
+            break;
         }
     }
 }
 
-
-bool WebSocketMCP::isConnected() {
-    return connected;
+/**
+ * @brief loop() side of network task mode: handles received messages and connection changes, in order.
+ */
+void WebSocketMCP::pollNetworkEvents() {
+    const uint8_t *data;
+    size_t len;
+    uint8_t type;
+    while ((data = _rxRing.peek(len, type)) != nullptr) {
+        if (type == NET_MESSAGE) {
+            handleJsonRpcMessage((const char*)data, len);
+        } else {
+            onConnectionChanged(type == NET_CONNECTED);
+        }
+        _rxRing.pop();
+    }
 }
 
-
-void WebSocketMCP::disconnect() {
-    if (connected) {
-        // Send CLOSE frame (Opcode 0x08)
-        sendWebSocketFrame("", false); // ✅ FIX: Function declared in .h
-        
+/**
+ * @brief Reports a connection change to loop(): directly, or queued behind the messages already received.
+ */
+void WebSocketMCP::notifyConnection(bool up) {
+    if (!_netRunning) {
+        onConnectionChanged(up);
+        return;
+    }
+    while (!_rxRing.push(up ? NET_CONNECTED : NET_DISCONNECTED, nullptr, 0) && _netRunning) {
+        delay(1);
+    }
+}
+
+void WebSocketMCP::onConnectionChanged(bool up) {
+    if (up) {
+        _session++;
+    }
+    if (connectionCallback) {
+        connectionCallback(up);
+    }
+}
+
+bool WebSocketMCP::beginNetworkTask(int core, uint32_t stackSize, uint8_t priority) {
+    if (_netRunning) {
+        return true;
+    }
+    if (!_rxRing.begin(MCP_NET_RX_RING_SIZE)) {
+        MCP_LOGE("ERROR: Could not allocate the network task queue.");
+        return false;
+    }
+
+    _netExited = false;
+    _netRunning = true;
+#ifdef ESP32
+    if (xTaskCreatePinnedToCore(networkTask, "mcp_net", stackSize, this, priority, nullptr, core) != pdPASS) {
+        _netRunning = false;
+        _rxRing.end();
+        MCP_LOGE("ERROR: Could not create the network task.");
+        return false;
+    }
+#else
+    (void)core;
+    (void)stackSize;
+    (void)priority;
+    _netThread = std::thread(&WebSocketMCP::runNetworkTask, this);
+#endif
+    MCP_LOGI("Network task started on core %d.", core);
+    return true;
+}
+
+void WebSocketMCP::endNetworkTask() {
+    if (!_netRunning) {
+        return;
+    }
+    _netRunning = false;
+#ifdef ESP32
+    while (!_netExited) {
+        delay(1);
+    }
+#else
+    _netThread.join();
+#endif
+    _rxHeld = false;
+    _rxRing.end();
+    MCP_LOGI("Network task stopped.");
+}
+
+#ifdef ESP32
+void WebSocketMCP::networkTask(void *arg) {
+    static_cast<WebSocketMCP *>(arg)->runNetworkTask();
+    vTaskDelete(nullptr);
+}
+#endif
+
+void WebSocketMCP::runNetworkTask() {
+    while (_netRunning) {
+        networkLoop();
+        // Sockets cannot be waited on through Client; poll every tick
+        delay(1);
+    }
+    _netExited = true;
+}
+
+
+bool WebSocketMCP::isConnected() {
+    return connected;
+}
+
+
+void WebSocketMCP::disconnect() {
+    // The socket belongs to the network task when there is one
+    if (_netRunning) {
+        _closeRequested = true;
+        return;
+    }
+    closeConnection(WS_CLOSE_NORMAL);
+}
+
+
+bool WebSocketMCP::setMaxMessageSize(size_t maxMessageSize) {
+    return _rxParser.setMaxMessageSize(maxMessageSize);
+}
+
+
+bool WebSocketMCP::setJsonDocumentCapacity(size_t capacity, size_t maxCapacity) {
+    return _jsonArena.begin(capacity, maxCapacity);
+}
+
+/**
+ * @brief Offers permessage-deflate on the next handshake; the current connection is unaffected.
+ */
+bool WebSocketMCP::setCompression(bool enable, uint8_t windowBits, size_t threshold) {
+    _deflateEnabled = false;
+    if (!enable) {
+        _deflater.end();
+        return true;
+    }
+    if (!_deflater.begin(windowBits)) {
+        MCP_LOGE("ERROR: Out of memory for the compression table.");
+        return false;
+    }
+    _deflateWindowBits = windowBits < 9 ? 9 : (windowBits > 15 ? 15 : windowBits);
+    _deflateThreshold = threshold;
+    _deflateEnabled = true;
+    return true;
+}
+
+
+const McpJsonArena::Stats &WebSocketMCP::getJsonDocumentStats() const {
+    return _jsonArena.stats();
+}
+
+
+/**
+ * @brief Sends a CLOSE frame with the given status code and tears the connection down.
+ * @param code Close status (WS_CLOSE_NORMAL, WS_CLOSE_PROTOCOL_ERROR, WS_CLOSE_MESSAGE_TOO_BIG, ...)
+ */
+void WebSocketMCP::closeConnection(uint16_t code) {
+    if (connected) {
+        // Send CLOSE frame (Opcode 0x08) with the status code in network byte order
+        uint8_t status[2] = {(uint8_t)(code >> 8), (uint8_t)code};
+        sendControlFrame(WS_OP_CLOSE, status, sizeof(status));
+        
         if (_injectedClient) {
             _injectedClient->stop(); // Close the underlying TCP/TLS connection
         }
+        _sendQueue.clear();
         connected = false;
-        lastPingTime = 0;
+        // The first attempt is spread over INITIAL_BACKOFF too: a server restart drops many devices at once
+        lastReconnectAttempt = millis();
+        _reconnectDelay = random(INITIAL_BACKOFF + 1);
+        _deflateActive = false;
+        _rxParser.reset();
+        _rxHeld = false;
         
         // ✅ FIX: Use class scope for enum
         _currentState = WebSocketMCP::WS_DISCONNECTED; 
 
-        Serial.println("[xiaozhi-mcp] WebSocket connection disconnected.");
-        if (connectionCallback) {
-            connectionCallback(false);
-        }
+        MCP_LOGI("WebSocket connection disconnected.");
+        notifyConnection(false);
     }
 }
 
@@ -463,246 +1114,542 @@ void WebSocketMCP::disconnect() {
 void WebSocketMCP::handleReconnect() {
     unsigned long now = millis();
 
-    if (!connected && (now - lastReconnectAttempt > currentBackoff || lastReconnectAttempt == 0)) {
+    if (!connected && now - lastReconnectAttempt >= _reconnectDelay) {
         reconnectAttempt++;
         lastReconnectAttempt = now;
 
-        currentBackoff = min(currentBackoff * 2, MAX_BACKOFF);
-
-        Serial.println("[xiaozhi-mcp] Trying to reconnect (number of attempts:" + String(reconnectAttempt) +
-                        ", Next time waiting time:" + String(currentBackoff / 1000.0, 2) + "s)");
+        MCP_LOGI("Trying to reconnect (number of attempts:%d)", reconnectAttempt);
 
         Client* netClient = _injectedClient; 
 
         if (_isSecure && !netClient) { // ✅ FIX: Access to _isSecure and _host/_port
-             Serial.println("[xiaozhi-mcp] ERROR: Secure WSS requested but network client is NULL (must be injected).");
+             MCP_LOGE("ERROR: Secure WSS requested but network client is NULL (must be injected).");
+             scheduleReconnect(currentBackoff);
              return;
         }
         if (!netClient && !_isSecure) {
             // Non-secure connection without injected client needs a standard WiFiClient, 
             // but for simplicity in this port, we rely on injection or standard client context.
-             Serial.println("[xiaozhi-mcp] ERROR: Only secure connections supported in this port (requires injected client).");
+             MCP_LOGE("ERROR: Only secure connections supported in this port (requires injected client).");
+             scheduleReconnect(currentBackoff);
              return;
         }
 
 
+        _metrics.reconnectAttempts++;
+        McpConnectTiming timing = {0, 0, 0, 0};
+
         // 1. Attempt TCP/TLS Connection
-        Serial.printf("[xiaozhi-mcp] Connecting to %s:%u...\n", _host.c_str(), _port);
-        if (netClient->connect(_host.c_str(), _port)) {
-            Serial.println("[xiaozhi-mcp] TCP/TLS connected. Performing WebSocket Handshake...");
+        if (connectTransport(*netClient, timing)) {
+            MCP_LOGI("TCP/TLS connected. Performing WebSocket Handshake...");
             
             // 2. Perform WebSocket Handshake
-            if (performHandshake()) { // ✅ FIX: Function declared in .h
+            unsigned long upgradeStart = millis();
+            bool upgraded = performHandshake(); // ✅ FIX: Function declared in .h
+            timing.upgradeMs = millis() - upgradeStart;
+            if (upgraded) {
                 connected = true;
+                _linkSession++;
+                _metrics.connects++;
+                _metrics.lastConnect = timing;
+                _keepalive.reset(millis());
+                _rxParser.reset();
+                _rxHeld = false;
                 resetReconnectParams();
-                Serial.println("[xiaozhi-mcp] WebSocket is connected (Handshake Success)");
-                if (connectionCallback) {
-                    connectionCallback(true);
-                }
-                lastPingTime = millis();
+                MCP_LOGI("WebSocket is connected (Handshake Success, dns %lu ms, tcp %lu ms, tls %lu ms, upgrade %lu ms)",
+                         (unsigned long)timing.dnsMs, (unsigned long)timing.tcpMs, (unsigned long)timing.tlsMs,
+                         (unsigned long)timing.upgradeMs);
+                notifyConnection(true);
             } else {
                 netClient->stop();
                 _currentState = WebSocketMCP::WS_DISCONNECTED; // ✅ FIX: Use class scope for enum
-                Serial.println("[xiaozhi-mcp] WebSocket Handshake failed.");
+                MCP_LOGW("WebSocket Handshake failed.");
             }
+        }
+        _metrics.reconnectTimeMs += timing.dnsMs + timing.tcpMs + timing.tlsMs + timing.upgradeMs;
+
+        if (!connected) {
+            scheduleReconnect(currentBackoff);
+            currentBackoff = min(currentBackoff * 2, MAX_BACKOFF);
+            MCP_LOGI("Next attempt in %.2fs", _reconnectDelay / 1000.0);
+        }
+    }
+}
+
+/**
+ * @brief Resolves the host (through the cache) and opens the TCP/TLS connection, timing each step.
+ * Without a connect handler a TLS client looks the name up itself, so the cache is not used.
+ */
+bool WebSocketMCP::connectTransport(Client &client, McpConnectTiming &timing) {
+    McpConnectInfo info = {0, false};
+    unsigned long start;
+    bool ok;
+    if (_isSecure && !_connectHandler) {
+        // The name is needed for SNI and the certificate; its lookup counts as TCP time
+        MCP_LOGI("Connecting to %s:%u...", _host.c_str(), _port);
+        timing.dnsMs = 0;
+        start = millis();
+        ok = client.connect(_host.c_str(), _port);
+    } else {
+        start = millis();
+        IPAddress ip;
+        bool cached = false;
+        bool resolved = _dnsCache.resolve(_host, ip, cached);
+        if (cached) {
+            _metrics.dnsCacheHits++;
         } else {
-            Serial.println("[xiaozhi-mcp] TCP/TLS connection failed.");
+            _metrics.dnsLookups++;
+        }
+        timing.dnsMs = millis() - start;
+        if (!resolved) {
+            MCP_LOGW("DNS lookup of %s failed.", _host.c_str());
+            return false;
+        }
+
+        MCP_LOGI("Connecting to %s:%u (%s%s)...", _host.c_str(), _port, ip.toString().c_str(), cached ? ", cached" : "");
+        start = millis();
+        if (_connectHandler) {
+            ok = _connectHandler(client, ip, _host.c_str(), _port, info);
+        } else {
+            ok = client.connect(ip, _port);
         }
     }
+    uint32_t elapsed = millis() - start;
+    timing.tlsMs = info.tlsMs < elapsed ? info.tlsMs : elapsed;
+    timing.tcpMs = elapsed - timing.tlsMs;
+
+    if (!ok) {
+        // The server may have moved; look the name up again next time
+        _dnsCache.invalidate();
+        MCP_LOGW("TCP/TLS connection failed.");
+        return false;
+    }
+    if (info.resumed) {
+        _metrics.tlsResumed++;
+    }
+    return true;
 }
 
+/**
+ * @brief Waits a random time in [maxDelay / 2, maxDelay] before the next attempt.
+ * The jitter keeps devices dropped together (a server restart) from coming back in lock-step.
+ */
+void WebSocketMCP::scheduleReconnect(unsigned long maxDelay) {
+    lastReconnectAttempt = millis();
+    _reconnectDelay = maxDelay / 2 + random(maxDelay / 2 + 1);
+}
 
 void WebSocketMCP::resetReconnectParams() {
     reconnectAttempt = 0;
     currentBackoff = INITIAL_BACKOFF;
     lastReconnectAttempt = 0;
+    _reconnectDelay = 0;
 }
 
 
 // Added a new method to process JSON-RPC messages (Logic retained from original)
-void WebSocketMCP::handleJsonRpcMessage(const String &message) {
-
-    DynamicJsonDocument doc(1024); 
+void WebSocketMCP::handleJsonRpcMessage(const char *message, size_t length) {
 
-    DeserializationError error = deserializeJson(doc, message);
+    // Parsed into the persistent document, which is reused for every message
+    DeserializationError error = _jsonArena.parse(message, length);
 
     if (error) {
-        Serial.println("[xiaozhi-mcp] Failed to parse JSON:" + String(error.c_str()));
-        // Note: The buffer size 1024 might be insufficient for large responses, leading to failures [7].
+        _metrics.parseFailures++;
+        if (error == DeserializationError::NoMemory) {
+            MCP_LOGW("Failed to parse JSON:%s (%u byte message, document limit %u)",
+                          error.c_str(), (unsigned)length, (unsigned)_jsonArena.stats().maxCapacity);
+        } else {
+            MCP_LOGW("Failed to parse JSON:%s", error.c_str());
+        }
         return;
     }
+    JsonDocument &doc = _jsonArena.doc();
 
-    // Check if it is a ping request (MCP keep-alive, distinct from WebSocket PING/PONG)
-    if (doc.containsKey("method") && doc["method"] == "ping") {
-        lastPingTime = millis(); 
+    // Replies are streamed straight into the outgoing frame buffer
+    McpResponseWriter reply(_txFrame);
 
-        String id = doc["id"].as<String>();
-        Serial.println("[xiaozhi-mcp] Received a ping request:" + id);
+    if (doc.is<JsonArrayConst>()) {
+        handleBatch(doc.as<JsonArrayConst>(), reply);
+        return;
+    }
+    dispatchRequest(doc.as<JsonObjectConst>(), reply);
+}
 
-        String response = "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",\"result\":{}}"; 
+/**
+ * @brief Dispatches the elements of a JSON-RPC batch and sends all their replies as one array in one frame.
+ * Notifications get no element; when only notifications were sent, nothing is.
+ */
+void WebSocketMCP::handleBatch(JsonArrayConst batch, McpResponseWriter &reply) {
+    if (batch.size() == 0) {
+        _metrics.messagesIn++;
+        reply.error(JsonVariantConst(), -32600, "Invalid Request");
+        sendReply(reply);
+        return;
+    }
 
-        sendMessage(response);
-        Serial.println("[xiaozhi-mcp] Respond to ping request:" + id);
+    reply.beginBatch();
+    _batchOpen = true;
+    for (JsonVariantConst element : batch) {
+        if (element.is<JsonObjectConst>()) {
+            dispatchRequest(element.as<JsonObjectConst>(), reply);
+        } else {
+            _metrics.messagesIn++;
+            reply.error(JsonVariantConst(), -32600, "Invalid Request");
+            reply.end();
+        }
     }
+    _batchOpen = false;
 
-    // Process initialization request
-    else if (doc.containsKey("method") && doc["method"] == "initialize") {
-        String id = doc["id"].as<String>();
-        String serverName = "ESP-HA";
+    bool ok = reply.ok();
+    if (!reply.endBatch()) {
+        if (!ok) {
+            MCP_LOGE("ERROR: Out of memory for outgoing frame.");
+        }
+        return; // Notifications only
+    }
+    if (!sendTxFrame(WS_OP_TEXT)) {
+        MCP_LOGE("Failed to send WebSocket frame.");
+    }
+}
 
-        // Send initialization response
-        String response = "{\"jsonrpc\":\"2.0\",\"id\":" + id +
-            ",\"result\":{\"protocolVersion\":\"2024-11-05\",\"capabilities\":{\"experimental\":{},\"prompts\":{\"listChanged\":false},\"resources\":{\"subscribe\":false,\"listChanged\":false},\"tools\":{\"listChanged\":false}},\"serverInfo\":{\"name\":\"" + serverName + "\",\"version\":\"1.0.0\"}}}";
+/**
+ * @brief Looks up the handler of one JSON-RPC request or notification and runs it.
+ * The reply is sent, or collected into the batch reply when one is open.
+ */
+void WebSocketMCP::dispatchRequest(JsonObjectConst request, McpResponseWriter &reply) {
+    _metrics.messagesIn++;
 
-        sendMessage(response);
+    JsonVariantConst id = request["id"];
+    bool isRequest = request.containsKey("id");
 
-        Serial.println("[xiaozhi-mcp] Respond to initialize request");
+    // Read "method" once and look its handler up by hash
+    const char *method = request["method"];
+    if (!method) {
+        MCP_LOGW("Received unhandled JSON-RPC message.");
+        return;
+    }
 
-        // Send initialized notifications
-        sendMessage("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}");
+    int index = findMethod(method, strlen(method));
+    if (index == McpNameIndex::NOT_FOUND) {
+        MCP_LOGW("Received unhandled JSON-RPC method: %s", method);
+        if (isRequest) {
+            reply.beginError(id, -32601);
+            reply.raw("\"Method not found: ");
+            reply.escaped(method);
+            reply.raw("\"");
+            sendReply(reply);
+        }
+        return;
     }
-    
-    // Process tool invocation request
-    else if (doc.containsKey("method") && doc["method"] == "tools/invoke") {
-        String toolName = doc["params"]["tool_name"].as<String>();
-        String toolId = doc["id"].as<String>();
-        
-        JsonVariantConst paramsVariant = doc["params"]["arguments"];
-        String paramsJson;
-        serializeJson(paramsVariant, paramsJson);
-        
-        Serial.println("[xiaozhi-mcp] Received tool invoke: " + toolName);
 
-        ToolResponse toolResult;
-        bool toolFound = false;
+    McpHeapSnapshot heapBefore = _heapTrace ? McpHeapSnapshot::take() : McpHeapSnapshot();
 
-        for (const auto& tool : _tools) {
-            if (tool.name == toolName) {
-                toolFound = true;
-                toolResult = tool.callback(paramsJson);
-                break;
-            }
-        }
+    _methods[index].handler(request["params"], id, reply);
 
-        if (toolFound) {
-            String contentStr;
-            
-            // ✅ CRITICAL FIX: Access the 'text' member of the first item in the content vector.
-            if (!toolResult.content.empty()) {
-                contentStr = toolResult.content.front().text; // Fixed access
-            } else {
-                 contentStr = "{\"success\":true}"; 
-            }
-            
-            // Build the final JSON-RPC response message
-            String response = "{\"jsonrpc\":\"2.0\",\"id\":" + toolId + 
-                              ",\"result\":{\"content\":[{\"type\":\"text\",\"text\":" + escapeJsonString(contentStr) + 
-                              "}],\"isError\":" + (toolResult.isError ? "true" : "false") + "}}";
-            
-            sendMessage(response);
-            Serial.println("[xiaozhi-mcp] Tool response sent.");
+    // Send the reply the handler wrote; notifications never get one
+    if (reply.started()) {
+        if (isRequest) {
+            sendReply(reply);
         } else {
-            // Tool not found error
-            String errorMsg = "Tool not found: " + toolName;
-            String response = "{\"jsonrpc\":\"2.0\",\"id\":" + toolId + 
-                              ",\"error\":{\"code\":-32601,\"message\":\"" + errorMsg + "\"}}";
-            sendMessage(response);
-            Serial.println("[xiaozhi-mcp] Tool not found error sent.");
+            reply.discard();
+            MCP_LOGW("WARNING: Reply to notification %s dropped.", method);
         }
     }
 
+    if (_heapTrace) {
+        McpHeapSnapshot heapAfter = McpHeapSnapshot::take();
+        // The handler may have changed the method table
+        index = findMethod(method, strlen(method));
+        if (index != McpNameIndex::NOT_FOUND) {
+            _methods[index].heap.record(heapBefore, heapAfter);
+        }
+    }
+}
 
-    // Process tools/list requests
-    else if (doc.containsKey("method") && doc["method"] == "tools/list") {
+// Built-in MCP methods; registerMethod() can replace any of them
+void WebSocketMCP::registerBuiltinMethods() {
+    addMethod("ping", [this](JsonVariantConst, JsonVariantConst id, McpResponseWriter &reply) {
+        handlePing(id, reply);
+    });
+    addMethod("initialize", [this](JsonVariantConst, JsonVariantConst id, McpResponseWriter &reply) {
+        handleInitialize(id, reply);
+    });
+    addMethod("tools/list", [this](JsonVariantConst, JsonVariantConst id, McpResponseWriter &reply) {
+        handleToolsList(id, reply);
+    });
+    addMethod("tools/invoke", [this](JsonVariantConst params, JsonVariantConst id, McpResponseWriter &reply) {
+        handleToolsInvoke(params, id, reply);
+    });
+    addMethod("notifications/cancelled", [this](JsonVariantConst params, JsonVariantConst, McpResponseWriter &) {
+        handleCancelled(params);
+    });
+    // Sent by clients after initialize; nothing to do
+    addMethod("notifications/initialized", [](JsonVariantConst, JsonVariantConst, McpResponseWriter &) {});
+}
 
-        String id = doc["id"].as<String>();
+// Check if it is a ping request (MCP keep-alive, distinct from WebSocket PING/PONG)
+void WebSocketMCP::handlePing(JsonVariantConst id, McpResponseWriter &reply) {
+    // Link liveness is the network side's business: the request's bytes already counted as activity
+#if MCP_LOG_LEVEL >= MCP_LOG_LEVEL_DEBUG
+    char idText[32];
+    serializeJson(id, idText, sizeof(idText));
+    MCP_LOGD("Received a ping request:%s", idText);
+#endif
+
+    reply.beginResult(id);
+    reply.raw("{}");
+}
 
-        String toolArrayContent = "";
-        bool firstTool = true;
+// Process initialization request
+void WebSocketMCP::handleInitialize(JsonVariantConst id, McpResponseWriter &reply) {
+    static const char serverName[] = "ESP-HA";
 
-        for (const auto& tool : _tools) {
-            if (!firstTool) {
-                toolArrayContent += ",";
-            }
-            toolArrayContent += "{\"name\":\"" + tool.name + "\",\"description\":\"" + 
-                                escapeJsonString(tool.description) + "\",\"inputSchema\":" + 
-                                tool.inputSchema + "}"; 
-            firstTool = false;
-        }
+    // Send initialization response
+    reply.beginResult(id);
+    reply.raw("{\"protocolVersion\":\"2024-11-05\",\"capabilities\":{\"experimental\":{},\"prompts\":{\"listChanged\":false},\"resources\":{\"subscribe\":false,\"listChanged\":false},\"tools\":{\"listChanged\":false}},\"serverInfo\":{\"name\":");
+    reply.string(serverName);
+    reply.raw(",\"version\":\"1.0.0\"}}");
+    sendReply(reply);
 
-        String response = "{\"jsonrpc\":\"2.0\",\"id\":" + id +
-                          ",\"result\":{\"tools\":[" + toolArrayContent + "]}}";
+    MCP_LOGI("Respond to initialize request");
 
-        sendMessage(response);
-        Serial.println("[xiaozhi-mcp] Respond to tools/list request");
+    // Send initialized notifications
+    reply.beginNotification("notifications/initialized");
+    sendReply(reply);
+}
 
+// Process tool invocation request
+void WebSocketMCP::handleToolsInvoke(JsonVariantConst params, JsonVariantConst id, McpResponseWriter &reply) {
+    const char *toolName = params["tool_name"] | "";
+    
+    // Callbacks get a view into the parsed request: no serialize/reparse round trip
+    JsonObjectConst arguments = params["arguments"];
+    
+    MCP_LOGD("Received tool invoke: %s", toolName);
+
+    int toolIndex = _registry->find(toolName, strlen(toolName));
+
+    if (toolIndex == McpNameIndex::NOT_FOUND) {
+        // Tool not found error
+        reply.beginError(id, -32601);
+        reply.raw("\"Tool not found: ");
+        reply.escaped(toolName);
+        reply.raw("\"");
+        MCP_LOGW("Tool not found error sent.");
+        return;
+    }
+
+    Tool &tool = (*_registry)[toolIndex];
+    // Writer tools always run here: the reply buffer belongs to this task. So do async
+    // tools inside a batch, whose reply has to be an element of the batch array.
+    if (tool.maxConcurrency > 0 && tool.callback && _toolWorkers.running() && !_batchOpen) {
+        startToolJob(tool, id, arguments, reply);
+        return;
+    }
+
+    uint32_t toolsVersion = _registry->version();
+    McpHeapSnapshot heapBefore = _heapTrace ? McpHeapSnapshot::take() : McpHeapSnapshot();
+    uint32_t start = micros();
+    bool isError;
+    if (tool.writer) {
+        // The result text is escaped straight into the reply
+        reply.beginResult(id);
+        reply.raw("{\"content\":[{\"type\":\"text\",\"text\":\"");
+        McpToolResult result(reply);
+        tool.writer(arguments, result);
+        if (result.length() == 0) {
+            reply.escaped("{\"success\":true}");
+        }
+        isError = result.isError();
+        reply.raw(isError ? "\"}],\"isError\":true}" : "\"}],\"isError\":false}");
     } else {
-        Serial.println("[xiaozhi-mcp] Received unhandled JSON-RPC message.");
+        ToolResponse toolResult = tool.callback(arguments);
+        isError = toolResult.isError;
+        writeToolResult(reply, id, toolResult);
     }
-}
+    uint32_t elapsed = micros() - start;
+    McpHeapSnapshot heapAfter = _heapTrace ? McpHeapSnapshot::take() : McpHeapSnapshot();
 
+    // The callback may have changed the registry, moving the tool
+    if (_registry->version() != toolsVersion) {
+        toolIndex = _registry->find(toolName, strlen(toolName));
+    }
+    if (toolIndex != McpNameIndex::NOT_FOUND) {
+        (*_registry)[toolIndex].stats.record(elapsed, isError);
+        if (_heapTrace) {
+            (*_registry)[toolIndex].heap.record(heapBefore, heapAfter);
+        }
+    }
+    MCP_LOGD("Tool response sent.");
+}
 
-// Escape special characters in JSON strings 
-String WebSocketMCP::escapeJsonString(const String &input) {
+// Build the final JSON-RPC response message for a tool result
+void WebSocketMCP::writeToolResult(McpResponseWriter &reply, JsonVariantConst id, const ToolResponse &toolResult) {
+    reply.beginResult(id);
+    reply.raw("{\"content\":[{\"type\":\"text\",\"text\":");
+    // ✅ CRITICAL FIX: Access the 'text' member of the first item in the content vector.
+    if (!toolResult.content.empty()) {
+        reply.string(toolResult.content.front().text);
+    } else {
+        reply.string("{\"success\":true}");
+    }
+    reply.raw(toolResult.isError ? "}],\"isError\":true}" : "}],\"isError\":false}");
+}
 
-    String result = "";
+/**
+ * @brief Hands an async tool invocation to the worker pool; the reply is sent from loop() when it completes.
+ */
+void WebSocketMCP::startToolJob(Tool &tool, JsonVariantConst id, JsonObjectConst arguments, McpResponseWriter &reply) {
+    if (tool.running >= tool.maxConcurrency || _toolJobs.size() >= MCP_TOOL_QUEUE_LENGTH) {
+        reply.beginError(id, -32000);
+        reply.raw("\"Tool busy: ");
+        reply.escaped(tool.name);
+        reply.raw("\"");
+        MCP_LOGW("Tool %s busy (%u running).", tool.name.c_str(), tool.running);
+        return;
+    }
 
-    for (size_t i = 0; i < input.length(); i++) {
+    // The request document is reused for the next message, so the job keeps its own copy
+    ToolJob *job = new (std::nothrow) ToolJob(_jsonArena.doc().memoryUsage());
+    if (job) {
+        job->doc["id"] = id;
+        job->doc["arguments"] = arguments;
+    }
+    if (!job || job->doc.overflowed()) {
+        delete job;
+        reply.error(id, -32603, "Out of memory");
+        return;
+    }
+    job->toolName = tool.name;
+    job->callback = tool.callback;
+    job->session = _session;
 
-        char c = input[i];
+    if (!_toolWorkers.submit(job)) {
+        delete job;
+        reply.error(id, -32603, "Tool queue full");
+        return;
+    }
+    tool.running++;
+    _toolJobs.push_back(job);
+    MCP_LOGD("Tool %s queued.", tool.name.c_str());
+}
 
-        if (c == '\"' || c == '\\' || c == '/' ||
-            c == '\b' || c == '\f' || c == '\n' ||
-            c == '\r' || c == '\t') {
+/**
+ * @brief Sends the replies of async tool invocations that finished since the last call.
+ */
+void WebSocketMCP::processToolJobs() {
+    McpWorkItem *item;
+    while ((item = _toolWorkers.takeCompleted()) != nullptr) {
+        ToolJob *job = static_cast<ToolJob *>(item);
+
+        for (size_t i = 0; i < _toolJobs.size(); i++) {
+            if (_toolJobs[i] == job) {
+                _toolJobs.erase(_toolJobs.begin() + i);
+                break;
+            }
+        }
+        int toolIndex = _registry->find(job->toolName.c_str(), job->toolName.length());
+        if (toolIndex != McpNameIndex::NOT_FOUND) {
+            if ((*_registry)[toolIndex].running > 0) {
+                (*_registry)[toolIndex].running--;
+            }
+            if (!job->cancelled) {
+                (*_registry)[toolIndex].stats.record(job->elapsedUs, job->result.isError);
+            }
+        }
 
-            if (c == '\"') result += "\\\"";
-            else if (c == '\\') result += "\\\\";
-            else if (c == '/') result += "\\/";
-            else if (c == '\b') result += "\\b";
-            else if (c == '\f') result += "\\f";
-            else if (c == '\n') result += "\\n";
-            else if (c == '\r') result += "\\r";
-            else if (c == '\t') result += "\\t";
+        // No reply for cancelled requests or ones from an earlier connection
+        if (job->cancelled || job->session != _session || !connected) {
+            MCP_LOGD("Tool %s result dropped.", job->toolName.c_str());
         } else {
-            result += c;
+            McpResponseWriter reply(_txFrame);
+            writeToolResult(reply, job->doc["id"], job->result);
+            sendReply(reply);
+            MCP_LOGD("Tool response sent.");
         }
+        delete job;
     }
+}
 
-    return result;
+// JSON-RPC ids are strings or integers
+static bool sameRequestId(JsonVariantConst a, JsonVariantConst b) {
+    if (a.is<const char *>() && b.is<const char *>()) {
+        return strcmp(a.as<const char *>(), b.as<const char *>()) == 0;
+    }
+    if (a.is<long>() && b.is<long>()) {
+        return a.as<long>() == b.as<long>();
+    }
+    return false;
+}
 
+// Process notifications/cancelled: drop the reply of an async invocation still in flight
+void WebSocketMCP::handleCancelled(JsonVariantConst params) {
+    JsonVariantConst requestId = params["requestId"];
+    for (size_t i = 0; i < _toolJobs.size(); i++) {
+        if (sameRequestId(_toolJobs[i]->doc["id"], requestId)) {
+            _toolJobs[i]->cancelled = true;
+            MCP_LOGI("Tool %s cancelled.", _toolJobs[i]->toolName.c_str());
+        }
+    }
 }
 
-// Add tool registration method
-bool WebSocketMCP::registerTool(const String &name, const String &description,
-                                const String &inputSchema, ToolCallback callback) {
+// Process tools/list requests
+void WebSocketMCP::handleToolsList(JsonVariantConst id, McpResponseWriter &reply) {
+    // Only the id differs between replies; the tool array is cached
+    reply.beginResult(id);
+    reply.raw("{\"tools\":[");
+    reply.raw(_registry->listJson());
+    reply.raw("]}");
+    MCP_LOGD("Respond to tools/list request");
+}
 
-    // Check if the tool already exists
-    for (size_t i = 0; i < _tools.size(); i++) {
-        if (_tools[i].name == name) {
-            // If the tool exists, update the callback
-            _tools[i].callback = callback;
-            Serial.println("[xiaozhi-mcp] Update tool callback:" + name);
-            return true;
-        }
+/**
+ * @brief Finishes a reply built with McpResponseWriter and sends it as one TEXT frame.
+ * Inside a batch the reply only joins the batch array.
+ */
+bool WebSocketMCP::sendReply(McpResponseWriter &reply) {
+    if (reply.batching()) {
+        return reply.end(); // Sent with the rest of the batch
+    }
+    if (!reply.end()) {
+        MCP_LOGE("ERROR: Out of memory for outgoing frame.");
+        return false;
+    }
+    if (!sendTxFrame(WS_OP_TEXT)) {
+        MCP_LOGE("Failed to send WebSocket frame.");
+        return false;
     }
+    return true;
+}
+
 
-    // Create a new tool and add it to the list
-    Tool newTool;
-    newTool.name = name;
-    newTool.description = description;
-    newTool.inputSchema = inputSchema;
-    newTool.callback = callback;
-    _tools.push_back(newTool);
+// Add tool registration method (String callback, kept for existing sketches)
+bool WebSocketMCP::registerTool(const String &name, const String &description,
+                                const String &inputSchema, ToolCallback callback) {
+    return registerTool(name, description, inputSchema, McpToolRegistry::adaptStringCallback(callback));
+}
 
-    Serial.println("[xiaozhi-mcp] Successful registration tool:" + name);
+// Add tool registration method
+bool WebSocketMCP::registerTool(const String &name, const String &description,
+                                const String &inputSchema, ToolArgsCallback callback) {
+    return _registry->add(name, description, inputSchema, callback);
+}
 
-    return true;
+bool WebSocketMCP::registerTool(const String &name, const String &description,
+                                const String &inputSchema, ToolWriterCallback callback) {
+    return _registry->add(name, description, inputSchema, callback);
 }
 
 // Add a simplified tool registration method 
 bool WebSocketMCP::registerSimpleTool(const String &name, const String &description,
                                         const String &paramName, const String &paramDesc,
                                         const String &paramType, ToolCallback callback) {
+    return registerSimpleTool(name, description, paramName, paramDesc, paramType, McpToolRegistry::adaptStringCallback(callback));
+}
+
+bool WebSocketMCP::registerSimpleTool(const String &name, const String &description,
+                                        const String &paramName, const String &paramDesc,
+                                        const String &paramType, ToolArgsCallback callback) {
 
     // Build a simple inputSchema
     String inputSchema = "{\"type\":\"object\",\"properties\":{\"" +
@@ -713,34 +1660,262 @@ bool WebSocketMCP::registerSimpleTool(const String &name, const String &descript
     return registerTool(name, description, inputSchema, callback);
 }
 
-// Uninstall tool 
-bool WebSocketMCP::unregisterTool(const String &name) {
+// Start the worker tasks that run async tools (see setToolAsync)
+bool WebSocketMCP::beginToolWorkers(uint8_t workers, uint32_t stackSize, uint8_t priority) {
+    if (!_toolWorkers.begin(workers, stackSize, priority)) {
+        MCP_LOGE("ERROR: Could not start tool workers.");
+        return false;
+    }
+    MCP_LOGI("%u tool worker(s) started.", workers);
+    return true;
+}
 
-    for (size_t i = 0; i < _tools.size(); i++) {
+// Run a tool on the worker pool, at most maxConcurrency invocations at a time (0 = inline)
+bool WebSocketMCP::setToolAsync(const String &name, uint8_t maxConcurrency) {
+    int index = _registry->find(name.c_str(), name.length());
+    if (index == McpNameIndex::NOT_FOUND) {
+        MCP_LOGW("Tools %s Does not exist, cannot be made async", name.c_str());
+        return false;
+    }
+    if (maxConcurrency > 0 && (*_registry)[index].writer) {
+        MCP_LOGW("Tool %s writes into the reply and runs in loop() only", name.c_str());
+        return false;
+    }
+    (*_registry)[index].maxConcurrency = maxConcurrency;
+    return true;
+}
 
-        if (_tools[i].name == name) {
+// Snapshot of the transport counters
+McpMetrics WebSocketMCP::getMetrics() const {
+    McpMetrics metrics = _metrics;
+    metrics.framesIn = _rxParser.framesIn();
+    metrics.bytesIn = _rxParser.bytesIn();
+    const McpSendQueue::Stats &tx = _sendQueue.stats();
+    metrics.framesOut = tx.framesOut;
+    metrics.bytesOut = tx.bytesOut;
+    metrics.socketWrites = tx.writes;
+    metrics.sendQueueDepth = _sendQueue.depth();
+    metrics.sendQueueHighWater = tx.highWater;
+    metrics.sendQueueFull = tx.full;
+    metrics.sendStalls = tx.stalls;
+    metrics.sendStallMs = tx.stallMs;
+    metrics.rttSmoothedMs = _keepalive.srtt();
+    metrics.rttVarMs = _keepalive.rttVar();
+    return metrics;
+}
 
-            _tools.erase(_tools.begin() + i);
+bool WebSocketMCP::getToolStats(const String &name, McpToolStats &stats) const {
+    int index = _registry->find(name.c_str(), name.length());
+    if (index == McpNameIndex::NOT_FOUND) {
+        return false;
+    }
+    stats = (*_registry)[index].stats;
+    return true;
+}
 
-            Serial.println("[xiaozhi-mcp] Uninstalled tool:" + name);
+void WebSocketMCP::resetMetrics() {
+    _metrics.reset();
+    _rxParser.resetCounters();
+    _sendQueue.resetStats();
+    for (size_t i = 0; i < _registry->size(); i++) {
+        (*_registry)[i].stats.reset();
+        (*_registry)[i].heap.reset();
+    }
+    for (size_t i = 0; i < _methods.size(); i++) {
+        _methods[i].heap.reset();
+    }
+}
 
-            return true;
+// The ESP32 allocation hook counts only while some instance traces
+void WebSocketMCP::setHeapTrace(bool enable) {
+    if (enable != _heapTrace) {
+        McpHeapSnapshot::setCounting(enable);
+        _heapTrace = enable;
+    }
+}
+
+bool WebSocketMCP::getMethodHeapStats(const String &method, McpHeapStats &stats) const {
+    int index = findMethod(method.c_str(), method.length());
+    if (index == McpNameIndex::NOT_FOUND) {
+        return false;
+    }
+    stats = _methods[index].heap;
+    return true;
+}
+
+bool WebSocketMCP::getToolHeapStats(const String &name, McpHeapStats &stats) const {
+    int index = _registry->find(name.c_str(), name.length());
+    if (index == McpNameIndex::NOT_FOUND) {
+        return false;
+    }
+    stats = (*_registry)[index].heap;
+    return true;
+}
+
+static void printHeapLine(Print &out, const char *kind, const String &name, const McpHeapStats &heap) {
+    if (heap.calls == 0) {
+        return;
+    }
+    out.printf("%-6s %-24s %8u %9.1f %9.1f %6u %7u %8d %8d\n", kind, name.c_str(), (unsigned)heap.calls,
+               (double)heap.allocs / heap.calls, (double)heap.bytes / heap.calls, (unsigned)heap.maxAllocs,
+               (unsigned)heap.maxBytes, (int)heap.minFreeDelta, (int)heap.minLargestDelta);
+}
+
+// Summary of the heap stats, written line by line: no String is built for it
+void WebSocketMCP::printHeapStats(Print &out) const {
+    if (!McpHeapSnapshot::countsAllocations()) {
+        out.println("(allocations are not counted on this build; heap deltas only)");
+    }
+    out.printf("%-6s %-24s %8s %9s %9s %6s %7s %8s %8s\n", "kind", "name", "calls", "allocs/c", "bytes/c",
+               "max-a", "max-B", "free-min", "big-min");
+    for (size_t i = 0; i < _methods.size(); i++) {
+        printHeapLine(out, "method", _methods[i].name, _methods[i].heap);
+    }
+    for (size_t i = 0; i < _registry->size(); i++) {
+        printHeapLine(out, "tool", (*_registry)[i].name, (*_registry)[i].heap);
+    }
+}
+
+// Register the built-in tool that reports getMetrics() and the per-tool stats as JSON
+bool WebSocketMCP::enableStatsTool(const String &name) {
+    return registerTool(name, "Report this device's MCP client statistics: traffic, errors, reconnects, "
+                              "PING round-trip time and per-tool call counts and latency histograms.",
+                        "{\"type\":\"object\",\"properties\":{\"reset\":{\"type\":\"boolean\","
+                        "\"description\":\"Reset the counters after reading\"}}}",
+                        [this](JsonObjectConst args) {
+                            String json = metricsJson();
+                            if (args["reset"] | false) {
+                                resetMetrics();
+                            }
+                            return ToolResponse(json);
+                        });
+}
+
+String WebSocketMCP::metricsJson() {
+    McpMetrics m = getMetrics();
+    char buf[224];
+    String json;
+    json.reserve(512 + _registry->size() * 128);
+
+    snprintf(buf, sizeof(buf), "{\"uptimeMs\":%lu,\"framesIn\":%lu,\"framesOut\":%lu,\"bytesIn\":%llu,\"bytesOut\":%llu,",
+             (unsigned long)millis(), (unsigned long)m.framesIn, (unsigned long)m.framesOut,
+             (unsigned long long)m.bytesIn, (unsigned long long)m.bytesOut);
+    json += buf;
+    snprintf(buf, sizeof(buf), "\"messagesIn\":%lu,\"parseFailures\":%lu,\"frameErrors\":%lu,",
+             (unsigned long)m.messagesIn, (unsigned long)m.parseFailures, (unsigned long)m.frameErrors);
+    json += buf;
+    snprintf(buf, sizeof(buf), "\"sendQueue\":{\"writes\":%lu,\"depth\":%lu,\"highWater\":%lu,\"full\":%lu,\"stalls\":%lu,\"stallMs\":%lu},",
+             (unsigned long)m.socketWrites, (unsigned long)m.sendQueueDepth, (unsigned long)m.sendQueueHighWater,
+             (unsigned long)m.sendQueueFull, (unsigned long)m.sendStalls, (unsigned long)m.sendStallMs);
+    json += buf;
+    snprintf(buf, sizeof(buf), "\"reconnectAttempts\":%lu,\"reconnectTimeMs\":%lu,\"connects\":%lu,",
+             (unsigned long)m.reconnectAttempts, (unsigned long)m.reconnectTimeMs, (unsigned long)m.connects);
+    json += buf;
+    snprintf(buf, sizeof(buf),
+             "\"lastConnect\":{\"dnsMs\":%lu,\"tcpMs\":%lu,\"tlsMs\":%lu,\"upgradeMs\":%lu},"
+             "\"dnsLookups\":%lu,\"dnsCacheHits\":%lu,\"tlsResumed\":%lu,",
+             (unsigned long)m.lastConnect.dnsMs, (unsigned long)m.lastConnect.tcpMs, (unsigned long)m.lastConnect.tlsMs,
+             (unsigned long)m.lastConnect.upgradeMs, (unsigned long)m.dnsLookups, (unsigned long)m.dnsCacheHits,
+             (unsigned long)m.tlsResumed);
+    json += buf;
+    snprintf(buf, sizeof(buf), "\"ping\":{\"sent\":%lu,\"received\":%lu,\"lastMs\":%lu,\"minMs\":%lu,\"avgMs\":%lu,\"maxMs\":%lu,"
+             "\"srttMs\":%lu,\"rttVarMs\":%lu,\"timeouts\":%lu},",
+             (unsigned long)m.pingsSent, (unsigned long)m.pongsReceived, (unsigned long)m.rttLastMs,
+             (unsigned long)m.rttMinMs,
+             (unsigned long)(m.pongsReceived ? m.rttTotalMs / m.pongsReceived : 0), (unsigned long)m.rttMaxMs,
+             (unsigned long)m.rttSmoothedMs, (unsigned long)m.rttVarMs, (unsigned long)m.keepaliveTimeouts);
+    json += buf;
+
+    json += "\"latencyBucketsUs\":[";
+    for (size_t b = 0; b + 1 < MCP_LATENCY_BUCKETS; b++) {
+        if (b > 0) {
+            json += ',';
         }
+        json += String((unsigned long)McpToolStats::bucketBound(b));
     }
+    json += "],\"tools\":{";
 
-    Serial.println("[xiaozhi-mcp] Tools" + name + "Does not exist, cannot be uninstalled");
-    return false;
+    for (size_t i = 0; i < _registry->size(); i++) {
+        const McpToolStats &t = (*_registry)[i].stats;
+        if (i > 0) {
+            json += ',';
+        }
+        json += '"';
+        json += McpToolRegistry::escapeJsonString((*_registry)[i].name);
+        snprintf(buf, sizeof(buf), "\":{\"calls\":%lu,\"errors\":%lu,\"avgUs\":%lu,\"maxUs\":%lu,\"histogram\":[",
+                 (unsigned long)t.calls, (unsigned long)t.errors,
+                 (unsigned long)(t.calls ? t.totalUs / t.calls : 0), (unsigned long)t.maxUs);
+        json += buf;
+        for (size_t b = 0; b < MCP_LATENCY_BUCKETS; b++) {
+            if (b > 0) {
+                json += ',';
+            }
+            json += String((unsigned long)t.histogram[b]);
+        }
+        json += "]}";
+    }
+    json += "}}";
+    return json;
+}
+
+// Uninstall tool 
+bool WebSocketMCP::unregisterTool(const String &name) {
+    return _registry->remove(name);
+}
+
+// Register a handler for a JSON-RPC method, replacing any existing one
+bool WebSocketMCP::registerMethod(const String &method, MethodHandler handler) {
+    if (!addMethod(method, handler)) {
+        MCP_LOGE("Too many methods, cannot register:%s", method.c_str());
+        return false;
+    }
+    MCP_LOGI("Registered method handler:%s", method.c_str());
+    return true;
+}
+
+bool WebSocketMCP::addMethod(const String &method, MethodHandler handler) {
+    int existing = findMethod(method.c_str(), method.length());
+    if (existing != McpNameIndex::NOT_FOUND) {
+        _methods[existing].handler = handler;
+        return true;
+    }
+    if (!_methodIndex.insert(McpNameIndex::hash(method.c_str(), method.length()), _methods.size())) {
+        return false;
+    }
+    Method newMethod;
+    newMethod.name = method;
+    newMethod.handler = handler;
+    _methods.push_back(newMethod);
+    return true;
+}
+
+// Remove a method handler; the method then gets -32601 like any unknown one
+bool WebSocketMCP::unregisterMethod(const String &method) {
+    int index = findMethod(method.c_str(), method.length());
+    if (index == McpNameIndex::NOT_FOUND) {
+        return false;
+    }
+    _methods.erase(_methods.begin() + index);
+    _methodIndex.remove(index);
+    MCP_LOGI("Removed method handler:%s", method.c_str());
+    return true;
+}
+
+int WebSocketMCP::findMethod(const char *method, size_t len) const {
+    return _methodIndex.find(McpNameIndex::hash(method, len), [&](size_t position) {
+        const String &name = _methods[position].name;
+        return name.length() == len && memcmp(name.c_str(), method, len) == 0;
+    });
 }
 
 // Get the number of tools
 size_t WebSocketMCP::getToolCount() {
-    return _tools.size();
+    return _registry->size();
 }
 
 // Clear all tools
 void WebSocketMCP::clearTools() {
-    _tools.clear();
-    Serial.println("[WebSocketMCP] All tools have been cleared");
+    _registry->clear();
 }
 
 // Format JSON strings, each key-value pair takes up one line (Restored to original complex logic)
@@ -752,8 +1927,9 @@ String WebSocketMCP::formatJsonString(const String &jsonStr) {
     }
 
     // 2. Try parsing JSON to make sure it works
-    DynamicJsonDocument doc(1024); 
-    DeserializationError error = deserializeJson(doc, jsonStr);
+    // NOTE: Reuses the inbound message document, so never call this while a message is being handled.
+    DeserializationError error = _jsonArena.parse(jsonStr.c_str(), jsonStr.length());
+    JsonDocument &doc = _jsonArena.doc();
 
     if (error) {
         // If parsing fails, return to the original string
@@ -2,99 +2,151 @@
 #define WEBSOCKET_MCP_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <new>
 #include <vector>
 #include <ArduinoJson.h> 
 #include <WiFiClientSecure.h> // Necessary for TLS/WSS connections on ESP32
 #include <Client.h>           // Base class for network sockets
+#include "WsFrameEncoder.h"
+#include "WsFrameParser.h"
+#include "WsUpgradeResponse.h"
+#include "McpNameIndex.h"
+#include "McpResponseWriter.h"
+#include "McpJsonArena.h"
+#include "McpWorkerPool.h"
+#include "McpSpscRing.h"
+#include "McpLog.h"
+#include "McpMetrics.h"
+#include "McpDeflate.h"
+#include "McpSendQueue.h"
+#include "McpDnsCache.h"
+#include "McpKeepalive.h"
+#include "McpToolRegistry.h"
+#include "McpTypedTool.h"
+#include "McpCapture.h"
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
 
 /* *
  * WebSocketMCP Class
  * Encapsulates WebSocket connection and communication with MCP server
  */
 
-// Define the tool response content structure
-struct ToolContentItem {
-    String type; // Content type, such as "text"
-    String text; // Text content
-};
-
-// Define tool response structure
-class ToolResponse {
-public:
-    std::vector<ToolContentItem> content; // Response content array
-    bool isError; // Is it an error response
-
-    // Constructor: Create a response from a single text content (used for JSON response)
-    ToolResponse(const String& textContent, bool error = false) : isError(error) {
-        ToolContentItem item;
-        item.type = "text";
-        item.text = textContent;
-        content.push_back(item);
-    }
-
-    // Constructor: Create a response from a boolean status and message (used for text response)
-    ToolResponse(bool error, const String& message) {
-        ToolContentItem item;
-        item.type = "text";
-        item.text = message;
-        content.push_back(item);
-        isError = error;
-    }
-
-    // Default constructor
-    ToolResponse() : isError(false) {}
-
-    // Create a response from a JSON object (convenient method)
-    static ToolResponse fromJson(const JsonObject& json, bool error = false) {
-        String jsonStr;
-        serializeJson(json, jsonStr);
-        return ToolResponse(jsonStr, error);
-    }
-};
+// Opt-in network task (see beginNetworkTask)
+#ifndef MCP_NET_TASK_STACK_SIZE
+#define MCP_NET_TASK_STACK_SIZE 6144
+#endif
+
+// Above the Arduino loop task (priority 1)
+#ifndef MCP_NET_TASK_PRIORITY
+#define MCP_NET_TASK_PRIORITY 2
+#endif
+
+// Core 0 runs the WiFi stack, the Arduino loop task runs on core 1
+#ifndef MCP_NET_TASK_CORE
+#define MCP_NET_TASK_CORE 0
+#endif
+
+// Queue of received messages; only half of it is guaranteed to hold one message
+#ifndef MCP_NET_RX_RING_SIZE
+#define MCP_NET_RX_RING_SIZE (2 * MCP_RX_MAX_MESSAGE_SIZE + 64)
+#endif
+
+// How long replies wait for the network task to make room in a full send queue
+#ifndef MCP_NET_TX_WAIT_MS
+#define MCP_NET_TX_WAIT_MS 100
+#endif
+
+// Stack buffer the upgrade request is assembled in; longer requests go out in several writes
+#ifndef MCP_HANDSHAKE_WRITE_SIZE
+#define MCP_HANDSHAKE_WRITE_SIZE 512
+#endif
+
+// How long the server has to answer the upgrade request
+#ifndef MCP_HANDSHAKE_TIMEOUT_MS
+#define MCP_HANDSHAKE_TIMEOUT_MS 5000
+#endif
 
 // Auxiliary class for parameter processing
+// Built from a JsonObjectConst it is only a view over the request document (no copy);
+// built from a JSON string it parses into a document of its own.
 class ToolParams {
 
 public:
-    ToolParams(const String& json) {
-        // Assume doc has sufficient capacity or is statically allocated correctly.
-        DeserializationError error = deserializeJson(doc, json);
-        valid = !error;
+    ToolParams(JsonObjectConst args) : args(args), valid(!args.isNull()) {}
+
+    // Out of memory gives isValid() == false, like a parse error
+    ToolParams(const String& json) : owned(new (std::nothrow) DynamicJsonDocument(TOOL_PARAMS_CAPACITY)) {
+        // DynamicJsonDocument reports capacity 0 when its pool allocation failed
+        if (!owned || owned->capacity() == 0) {
+            owned.reset();
+            return;
+        }
+        DeserializationError error = deserializeJson(*owned, json);
+        args = owned->as<JsonObjectConst>();
+        valid = !error && !args.isNull();
     }
 
     // Static factory method from JsonVariantConst
     static ToolParams fromVariant(const JsonVariantConst& variant) {
-        String variantJson;
-        serializeJson(variant, variantJson);
-        return ToolParams(variantJson);
+        return ToolParams(variant.as<JsonObjectConst>());
     }
 
     bool isValid() const { return valid; }
-    String getString(const String& key) const { return doc[key].as<String>(); }
-    int getInt(const String& key, int defaultValue = 0) const { return doc[key].as<int>() ? doc[key].as<int>() : defaultValue; }
-    bool getBool(const String& key, bool defaultValue = false) const { return doc[key].as<bool>() ? doc[key].as<bool>() : defaultValue; }
-    float getFloat(const String& key, float defaultValue = 0.0f) const { return doc[key].as<float>() ? doc[key].as<float>() : defaultValue; }
+    JsonObjectConst json() const { return args; }
+    String getString(const String& key) const { return args[key].as<String>(); }
+    // The default only replaces a missing value or one of another type; 0 and false are values
+    int getInt(const String& key, int defaultValue = 0) const { return args[key].is<int>() ? args[key].as<int>() : defaultValue; }
+    bool getBool(const String& key, bool defaultValue = false) const { return args[key].is<bool>() ? args[key].as<bool>() : defaultValue; }
+    float getFloat(const String& key, float defaultValue = 0.0f) const { return args[key].is<float>() ? args[key].as<float>() : defaultValue; }
 
 private:
-    StaticJsonDocument<512> doc;
+    // Capacity used when parsing from a string (the previous StaticJsonDocument size)
+    static const size_t TOOL_PARAMS_CAPACITY = 512;
+
+    std::shared_ptr<DynamicJsonDocument> owned; // Only set when parsed from a string
+    JsonObjectConst args;
     bool valid = false;
 };
 
-// Redefine the tool callback function type - receive JSON string parameters and return the ToolResponse structure
-typedef std::function<ToolResponse(const String&)> ToolCallback;
+// JSON-RPC method handler (see registerMethod). For a request, write the reply with
+// reply.beginResult(id) or reply.beginError(id, code); it is sent when the handler returns
+// (inside a JSON-RPC batch, as an element of the single batch reply). Notifications (no id) get no reply.
+typedef std::function<void(JsonVariantConst params, JsonVariantConst id, McpResponseWriter &reply)> MethodHandler;
 
 // Callback type definition
-typedef void (*ConnectionCallback)(bool);
+typedef std::function<void(bool)> ConnectionCallback;
+
+// What a connect handler reports about the connection it opened (see setConnectHandler)
+struct McpConnectInfo {
+    uint32_t tlsMs; // part of the connect spent in the TLS handshake, when the client can tell
+    bool resumed;   // an earlier TLS session was resumed instead of a full handshake
+};
+
+// Opens the TCP/TLS connection to the server (see setConnectHandler)
+typedef std::function<bool(Client &client, const IPAddress &ip, const char *host, uint16_t port,
+                           McpConnectInfo &info)> ConnectHandler;
 
 class WebSocketMCP {
 
+    // Host build benchmarks (extras/host) drive the private protocol functions directly.
+    friend class WebSocketMCPHostAccess;
+
 public:
     // Original Constructor
     WebSocketMCP();
 
     // NEW CONSTRUCTOR: Accepts a reference to the configured Client object (for TLS injection).
     WebSocketMCP(Client& client); 
+    ~WebSocketMCP();
 
     /* *
     * Initialize the WebSocket connection
@@ -106,8 +158,10 @@ public:
 
     /* *
     * Send data to the WebSocket server (equivalent to stdin)
+    * The frame is queued (MCP_TX_QUEUE_SIZE) and written as the socket takes it; the call never
+    * waits for the socket.
     * @param message message to send
-    * @return Whether the sending is successful
+    * @return false if not connected or the send queue is full (backpressure: retry later)
     */
     bool sendMessage(const String &message);
 
@@ -128,16 +182,250 @@ public:
     */
     void disconnect();
 
+    /* *
+    * Set the largest incoming message accepted (all fragments together)
+    * Larger messages close the connection with status 1009. Drops a partially received message.
+    * @param maxMessageSize Size in bytes (default MCP_RX_MAX_MESSAGE_SIZE)
+    * @return Whether the receive buffer could be allocated
+    */
+    bool setMaxMessageSize(size_t maxMessageSize);
+
+    /* *
+    * Size the JSON document reused for every incoming message
+    * It starts at capacity and doubles as needed up to maxCapacity; larger messages are rejected.
+    * @param capacity Initial capacity in bytes (default MCP_JSON_DOC_CAPACITY)
+    * @param maxCapacity Growth ceiling in bytes (default MCP_JSON_DOC_MAX_CAPACITY); pass capacity to disable growth
+    * @return Whether the document could be allocated
+    */
+    bool setJsonDocumentCapacity(size_t capacity, size_t maxCapacity);
+
+    /* *
+    * Document usage counters: current capacity, peak usage, grows and rejected messages
+    */
+    const McpJsonArena::Stats &getJsonDocumentStats() const;
+
     // --- Tool registration and management methods (MCP Protocol) ---
 
     bool registerTool(const String &name, const String &description, const String &inputSchema, ToolCallback callback);
+    bool registerTool(const String &name, const String &description, const String &inputSchema, ToolArgsCallback callback);
+    // The callback prints its result into the reply (McpToolResult): no allocation per call
+    bool registerTool(const String &name, const String &description, const String &inputSchema, ToolWriterCallback callback);
+
+    /* *
+    * Register a tool whose arguments are declared once in a McpToolParam table (see McpTypedTool.h)
+    * The inputSchema is generated from the table; the callback gets the arguments as a struct.
+    * @param params Constant table, e.g. static constexpr; it must outlive the tool
+    */
+    template <typename Args, size_t N>
+    bool registerTypedTool(const String &name, const String &description, const McpToolParam (&params)[N],
+                           typename McpTypedTool::Callback<Args>::Type callback) {
+        static_assert(N <= McpTypedTool::MAX_PARAMS, "too many tool parameters");
+        return registerTool(name, description, McpTypedTool::schema(params, N),
+                            McpTypedTool::writer<Args>(params, N, callback));
+    }
     bool registerSimpleTool(const String &name, const String &description,
                             const String &paramName, const String &paramDesc,
                             const String &paramType, ToolCallback callback);
+    bool registerSimpleTool(const String &name, const String &description,
+                            const String &paramName, const String &paramDesc,
+                            const String &paramType, ToolArgsCallback callback);
     bool unregisterTool(const String &name);
     size_t getToolCount();
     void clearTools();
 
+    /* *
+    * Serve the tools of a registry shared with other connections instead of this client's own
+    * (see McpEndpointManager). The tool functions above then act on it. The registry must
+    * outlive this client, and every connection using it must be polled from the same task.
+    * Call before begin().
+    */
+    void useToolRegistry(McpToolRegistry &registry) { _registry = &registry; }
+    McpToolRegistry &toolRegistry() { return *_registry; }
+
+    /* *
+    * Start the worker tasks that run async tools, so slow callbacks (delay(), sensor reads)
+    * no longer block loop(). Replies are sent from loop() when a tool finishes.
+    * @param workers Number of worker tasks (1 to MCP_MAX_TOOL_WORKERS)
+    * @param stackSize Stack per worker in bytes
+    * @param priority FreeRTOS task priority
+    * @return Whether the workers were started
+    */
+    bool beginToolWorkers(uint8_t workers = 1, uint32_t stackSize = MCP_TOOL_WORKER_STACK_SIZE,
+                          uint8_t priority = MCP_TOOL_WORKER_PRIORITY);
+
+    /* *
+    * Run a registered tool on the worker pool
+    * Invocations beyond maxConcurrency get a "Tool busy" error; notifications/cancelled
+    * suppresses the reply of an invocation still in flight. Without workers, or inside a
+    * JSON-RPC batch, the tool runs inline.
+    * @param name Tool name
+    * @param maxConcurrency Invocations allowed at once; 0 makes the tool synchronous again
+    * @return false if the tool does not exist or is a ToolWriterCallback tool (those run in loop())
+    */
+    bool setToolAsync(const String &name, uint8_t maxConcurrency = 1);
+
+    /* *
+    * Move the transport (socket I/O, framing, keepalive, reconnect) onto a task of its own
+    * Call after begin(). loop() is still required, but only handles the decoded messages
+    * and tool calls, so slow application code no longer delays PING/PONG or trips the
+    * inactivity timeout. Messages and encoded replies cross between the tasks through
+    * lock-free single-producer/single-consumer queues (MCP_NET_RX_RING_SIZE and
+    * MCP_TX_QUEUE_SIZE bytes). sendMessage() must then only be called from the loop() task.
+    * @param core Core to pin the task to (ESP32)
+    * @param stackSize Task stack in bytes
+    * @param priority FreeRTOS task priority
+    * @return Whether the queues and the task could be created
+    */
+    bool beginNetworkTask(int core = MCP_NET_TASK_CORE, uint32_t stackSize = MCP_NET_TASK_STACK_SIZE,
+                          uint8_t priority = MCP_NET_TASK_PRIORITY);
+
+    /* *
+    * Stop the network task; loop() drives the transport again
+    * Messages still queued in either direction are dropped.
+    */
+    void endNetworkTask();
+
+    // --- Compression ---
+
+    /* *
+    * Offer permessage-deflate (RFC 7692) from the next handshake on
+    * Both directions run without context takeover, so no history is kept between messages:
+    * sending costs a 2^(windowBits - 1) byte hash table plus a second frame buffer, receiving
+    * a buffer of the largest message (setMaxMessageSize). Messages below threshold, and those
+    * that do not shrink, are sent uncompressed.
+    * @param enable Whether to offer the extension
+    * @param windowBits LZ77 window of outgoing messages (9 to 15); lowered if the server asks for less
+    * @param threshold Smallest payload in bytes worth compressing
+    * @return Whether the hash table could be allocated
+    */
+    bool setCompression(bool enable, uint8_t windowBits = MCP_DEFLATE_WINDOW_BITS,
+                        size_t threshold = MCP_DEFLATE_THRESHOLD);
+
+    // Whether the current connection negotiated permessage-deflate
+    bool isCompressionActive() const { return _deflateActive; }
+
+    /* *
+    * Add a header to the upgrade request, e.g. setHeader("Authorization", "Bearer " + token)
+    * instead of putting the token in the URL query. Setting a name again replaces its value,
+    * an empty value removes it. Used from the next handshake on; call before begin(), or from
+    * the loop() task when the network task is not running.
+    * @return false if the name is not a valid token, either contains CR/LF, or the library
+    *         sets that header itself (Host, Upgrade, Connection, Sec-WebSocket-*)
+    */
+    bool setHeader(const String &name, const String &value);
+
+    /* *
+    * Offer subprotocols (Sec-WebSocket-Protocol) from the next handshake on
+    * A server that picks one that was not offered, or picks one when none was, fails the handshake.
+    * @param protocols Comma separated list, most preferred first; empty offers none
+    */
+    void setSubprotocols(const String &protocols) { _subprotocols = protocols; }
+
+    // Subprotocol the server picked for the current connection; empty if none
+    const String &subprotocol() const { return _subprotocol; }
+
+    /* *
+    * Take over opening the TCP/TLS connection on (re)connect
+    * By default a ws:// client connects to the cached address and a wss:// client to the host
+    * name, since the injected Client needs the name for SNI and certificate checks and cannot
+    * be told both; it does its own lookup, bypassing the DNS cache. A handler gets both, so it
+    * is the only way to use the cache for wss://, and the place to resume a TLS session (ticket
+    * or session ID) with a client that supports it; it reports that, and the TLS handshake
+    * time if it can measure it, in info.
+    * @param handler Returns whether the client is connected; nullptr restores the default
+    */
+    void setConnectHandler(ConnectHandler handler) { _connectHandler = handler; }
+
+    /* *
+    * Keepalive: PING the server after intervalMs without receiving anything from it, and close
+    * the connection once probes PINGs in a row went unanswered. Each PING is given
+    * 2 * (SRTT + 4 * RTTVAR) to be answered, within MCP_KEEPALIVE_MIN/MAX_TIMEOUT_MS.
+    * Call before begin().
+    */
+    void setKeepalive(uint32_t intervalMs, uint8_t probes = MCP_KEEPALIVE_PROBES) {
+        _keepalive.configure(intervalMs, probes);
+    }
+
+    // Smoothed PING round-trip time and its mean deviation in ms (RFC 6298); 0 before the first PONG
+    uint32_t getSmoothedRtt() const { return _keepalive.srtt(); }
+    uint32_t getRttVariation() const { return _keepalive.rttVar(); }
+
+    // --- Traffic capture ---
+
+    /* *
+    * Record every frame sent and received, with its time, into a RAM ring buffer (see McpCapture)
+    * The ring keeps the latest traffic; save it with writeCapture() after a stall or an unexpected
+    * disconnect and replay it on the host (extras/host, mcp_replay).
+    * @param size Ring size in bytes
+    * @param maxPayload Payload bytes kept per frame
+    * @return false if the ring could not be allocated
+    */
+    bool beginCapture(size_t size = MCP_CAPTURE_SIZE, size_t maxPayload = MCP_CAPTURE_MAX_PAYLOAD) {
+        return _capture.begin(size, maxPayload);
+    }
+    void endCapture() { _capture.end(); }
+
+    /* *
+    * Write the captured frames, oldest first, e.g. to a LittleFS File
+    * @return Bytes written
+    */
+    size_t writeCapture(Print &out) { return _capture.writeTo(out); }
+    const McpCapture &capture() const { return _capture; }
+
+    // --- Metrics ---
+
+    /* *
+    * Snapshot of the transport counters: frames and bytes in/out, parse failures,
+    * reconnect attempts and time, PING round-trip times
+    */
+    McpMetrics getMetrics() const;
+
+    /* *
+    * Invocation count, error count and latency histogram of a registered tool
+    * @return false if the tool does not exist
+    */
+    bool getToolStats(const String &name, McpToolStats &stats) const;
+
+    // Zero all counters, including every tool's
+    void resetMetrics();
+
+    /* *
+    * Record what each JSON-RPC method and tool callback does to the heap (see McpHeapTrace.h)
+    * Off by default: on ESP32 each snapshot walks the heap for the largest free block.
+    * A method is measured from its handler to its reply being queued; a tool only
+    * around its callback, and only when it runs inline (not on the worker pool).
+    */
+    void setHeapTrace(bool enable);
+    bool isHeapTraceEnabled() const { return _heapTrace; }
+
+    // @return false if no such method or tool is registered
+    bool getMethodHeapStats(const String &method, McpHeapStats &stats) const;
+    bool getToolHeapStats(const String &name, McpHeapStats &stats) const;
+
+    // One line per method and tool that was called: allocations, bytes and the worst heap deltas
+    void printHeapStats(Print &out) const;
+
+    /* *
+    * Register a built-in tool returning getMetrics() and all tool stats as JSON,
+    * so the agent platform can read them remotely. Takes an optional "reset" argument.
+    * @param name Tool name
+    * @return Whether the registration was successful
+    */
+    bool enableStatsTool(const String &name = "mcp_stats");
+
+    // --- JSON-RPC method handlers ---
+
+    /* *
+    * Handle an additional JSON-RPC method (e.g. resources/list, prompts/list, notifications/cancelled)
+    * Replaces the existing handler of that name, including the built-in ones.
+    * Requests for methods without a handler get a -32601 error reply.
+    * @param method Method name
+    * @param handler Called with the request params and id
+    * @return Whether the registration was successful
+    */
+    bool registerMethod(const String &method, MethodHandler handler);
+    bool unregisterMethod(const String &method);
+
 private:
     // REMOVED: WebSocketsClient webSocket;
 
@@ -161,48 +449,156 @@ private:
 
     ConnectionCallback connectionCallback;
 
-    bool connected;
+    std::atomic<bool> connected; // also read by the loop() task in network task mode
     unsigned long lastReconnectAttempt;
 
     // Reconnect settings
     static const int INITIAL_BACKOFF = 1000; 
     static const int MAX_BACKOFF = 60000; 
-    static const int PING_INTERVAL = 10000; 
-    static const int DISCONNECT_TIMEOUT = 60000; 
 
-    int currentBackoff;
+    int currentBackoff;               // ceiling of the next wait; doubles per failed attempt
+    unsigned long _reconnectDelay = 0; // jittered wait before the next attempt
     int reconnectAttempt;
 
+    McpDnsCache _dnsCache;
+    ConnectHandler _connectHandler;
+
+    // Upgrade request extras and the parsed response; bytes the server sent after the
+    // response headers wait in _upgrade until the frame parser takes them
+    struct RequestHeader {
+        String name;
+        String value;
+    };
+    std::vector<RequestHeader> _requestHeaders;
+    String _subprotocols;
+    String _subprotocol;
+    WsUpgradeResponse _upgrade;
+
     // FIX: Declarations for the new native WebSocket functions
     bool performHandshake();
-    bool sendWebSocketFrame(const String& data, bool isText);
-    String receiveWebSocketFrame();
+    bool sendWebSocketFrame(const uint8_t* payload, size_t len, uint8_t opcode);
+    bool sendWebSocketFrame(const String& data, uint8_t opcode) {
+        return sendWebSocketFrame((const uint8_t*)data.c_str(), data.length(), opcode);
+    }
+    bool writeFrame(const uint8_t* frame, size_t len);
+    bool sendEncodedFrame(const uint8_t* frame, size_t len, bool wait);
+    bool sendControlFrame(uint8_t opcode, const uint8_t* payload, size_t len);
+    bool sendTxFrame(uint8_t opcode);
+    bool finishTxFrame(uint8_t opcode, bool wait);
+    bool flushSendQueue();
+    bool sendReply(McpResponseWriter &reply);
+    uint32_t nextMaskKey();
+    bool receiveWebSocketFrame();
     void processReceivedData();
+    void closeConnection(uint16_t code);
+    bool deliverMessage(const uint8_t* message, size_t len);
+    bool inflateMessage();
+    bool acceptExtensions(const WsUpgradeResponse &response);
+    bool acceptSubprotocol(const WsUpgradeResponse &response);
+    void networkLoop();
+    void notifyConnection(bool up);
+    void onConnectionChanged(bool up);
 
 
     // Reconnect processing
     void handleReconnect();
+    bool connectTransport(Client &client, McpConnectTiming &timing);
+    void scheduleReconnect(unsigned long maxDelay);
     void resetReconnectParams();
 
-    // Static instance pointer definition (needed for potential static callbacks, although most are member functions now)
-    static WebSocketMCP *instance;
-
-    unsigned long lastPingTime = 0;
-    void handleJsonRpcMessage(const String &message);
-
-    // Tool structure definition
-    struct Tool {
-        String name; 
-        String description; 
-        String inputSchema; 
-        ToolCallback callback;
+    void handleJsonRpcMessage(const char *message, size_t length);
+    void handleBatch(JsonArrayConst batch, McpResponseWriter &reply);
+    void dispatchRequest(JsonObjectConst request, McpResponseWriter &reply);
+    bool _batchOpen = false; // a batch reply is being collected in _txFrame
+    bool _heapTrace = false; // see setHeapTrace
+
+    // Reusable outgoing frame buffer (header + masked payload)
+    WsFrameEncoder _txFrame;
+    // Incremental parser for incoming frames, resumed across loop() calls
+    WsFrameParser _rxParser;
+    // JSON document reused for every incoming message
+    McpJsonArena _jsonArena;
+
+    // Tools, in registration order (tools/list); _ownTools unless useToolRegistry() shares another
+    McpToolRegistry _ownTools;
+    McpToolRegistry *_registry = &_ownTools;
+    typedef McpToolRegistry::Tool Tool;
+
+    // JSON-RPC methods, looked up by name hash
+    struct Method {
+        String name;
+        MethodHandler handler;
+        McpHeapStats heap; // while heap tracing is on
     };
-
-    // Tool list
-    std::vector<Tool> _tools;
+    std::vector<Method> _methods;
+    McpNameIndex _methodIndex;
+
+    bool addMethod(const String &method, MethodHandler handler);
+    int findMethod(const char *method, size_t len) const;
+    void registerBuiltinMethods();
+    void handlePing(JsonVariantConst id, McpResponseWriter &reply);
+    void handleInitialize(JsonVariantConst id, McpResponseWriter &reply);
+    void handleToolsList(JsonVariantConst id, McpResponseWriter &reply);
+    void handleToolsInvoke(JsonVariantConst params, JsonVariantConst id, McpResponseWriter &reply);
+
+    // Async tool execution
+    struct ToolJob;
+    McpWorkerPool _toolWorkers;
+    std::vector<ToolJob *> _toolJobs; // in flight, owned here
+    uint32_t _session = 0;            // connections seen by loop(), so stale replies are dropped
+    void startToolJob(Tool &tool, JsonVariantConst id, JsonObjectConst arguments, McpResponseWriter &reply);
+    void processToolJobs();
+    void handleCancelled(JsonVariantConst params);
+    void writeToolResult(McpResponseWriter &reply, JsonVariantConst id, const ToolResponse &toolResult);
+
+    // Network task mode: the task owns the socket, _rxParser and the keepalive state;
+    // loop() owns the JSON document, the tools and _txFrame
+    enum NetRecordType : uint8_t {
+        NET_MESSAGE,
+        NET_CONNECTED,
+        NET_DISCONNECTED
+    };
+    McpSpscRing _rxRing;                // network task -> loop(): messages and connection events
+    std::atomic<bool> _netRunning{false};
+    std::atomic<bool> _netExited{false};
+    std::atomic<bool> _closeRequested{false}; // disconnect() called from loop()
+    bool _rxHeld = false;               // a received message is waiting for room in _rxRing
+    uint32_t _linkSession = 0;          // connections made by the transport; _session follows it in loop()
+#ifdef ESP32
+    static void networkTask(void *arg);
+#else
+    std::thread _netThread;
+#endif
+    void runNetworkTask();
+    void pollNetworkEvents();
+
+    // permessage-deflate: _deflater and _txDeflated belong to the sending side (loop()),
+    // _inflated to the receiving side (the network task, if any)
+    bool _deflateEnabled = false;
+    uint8_t _deflateWindowBits = MCP_DEFLATE_WINDOW_BITS; // configured
+    uint8_t _deflateSendBits = MCP_DEFLATE_WINDOW_BITS;   // in use on this connection
+    size_t _deflateThreshold = MCP_DEFLATE_THRESHOLD;
+    std::atomic<bool> _deflateActive{false};
+    McpDeflater _deflater;
+    WsFrameEncoder _txDeflated;
+    uint8_t *_inflated = nullptr;       // maxMessageSize + 1 bytes, allocated on first use
+    size_t _inflatedCapacity = 0;
+    const uint8_t *_rxMessage = nullptr; // message ready in _rxParser or _inflated
+    size_t _rxMessageLength = 0;
+
+    // Outgoing frames, in both modes: produced where they are encoded, written by the socket side
+    McpSendQueue _sendQueue;
+    bool _txHold = false; // replies produced while reading are flushed together afterwards
+
+    // Counters; framesIn/bytesIn live in _rxParser, the outgoing ones in _sendQueue
+    McpMetrics _metrics;
+    // PING scheduling and RTT estimates; transport side only
+    McpKeepalive _keepalive;
+    // Optional record of the traffic; frames are captured from both sides
+    McpCapture _capture;
+    String metricsJson();
 
     // Auxiliary methods
-    String escapeJsonString(const String &input);
     String formatJsonString(const String &jsonStr);
 };
 
@@ -0,0 +1,132 @@
+#include "WsFrameEncoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Grow in steps so a slowly growing reply does not realloc on every frame
+static const size_t TX_BUFFER_GRANULARITY = 256;
+
+WsFrameEncoder::WsFrameEncoder() : _buf(nullptr), _capacity(0), _payloadLen(0), _frameStart(MAX_HEADER_LEN) {
+}
+
+WsFrameEncoder::~WsFrameEncoder() {
+    free(_buf);
+}
+
+bool WsFrameEncoder::reserve(size_t payloadCapacity) {
+    if (_buf && payloadCapacity <= _capacity) {
+        return true;
+    }
+    size_t newCapacity = (payloadCapacity + TX_BUFFER_GRANULARITY - 1) / TX_BUFFER_GRANULARITY * TX_BUFFER_GRANULARITY;
+    uint8_t *newBuf = (uint8_t *)realloc(_buf, MAX_HEADER_LEN + newCapacity);
+    if (!newBuf) {
+        return false;
+    }
+    _buf = newBuf;
+    _capacity = newCapacity;
+    return true;
+}
+
+bool WsFrameEncoder::append(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    uint8_t *to = appendSpace(len);
+    if (!to) {
+        return false;
+    }
+    memcpy(to, data, len);
+    _payloadLen += len;
+    return true;
+}
+
+uint8_t *WsFrameEncoder::appendSpace(size_t len) {
+    if (_payloadLen + len > _capacity || !_buf) {
+        // At least double, to keep repeated small appends amortized
+        size_t wanted = _payloadLen + len;
+        if (wanted < _capacity * 2) {
+            wanted = _capacity * 2;
+        }
+        if (!reserve(wanted)) {
+            return nullptr;
+        }
+    }
+    return _buf + MAX_HEADER_LEN + _payloadLen;
+}
+
+size_t WsFrameEncoder::encodeHeader(uint8_t *out, uint8_t opcode, uint64_t payloadLen, uint32_t maskKey, bool fin) {
+    size_t n = 0;
+    out[n++] = (fin ? 0x80 : 0x00) | (opcode & (0x0F | WS_FLAG_RSV1));
+
+    // Mask=1 is mandatory for client frames
+    if (payloadLen <= 125) {
+        out[n++] = 0x80 | (uint8_t)payloadLen;
+    } else if (payloadLen <= 0xFFFF) {
+        out[n++] = 0x80 | 126;
+        out[n++] = (uint8_t)(payloadLen >> 8);
+        out[n++] = (uint8_t)payloadLen;
+    } else {
+        out[n++] = 0x80 | 127;
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out[n++] = (uint8_t)(payloadLen >> shift);
+        }
+    }
+
+    out[n++] = (uint8_t)(maskKey >> 24);
+    out[n++] = (uint8_t)(maskKey >> 16);
+    out[n++] = (uint8_t)(maskKey >> 8);
+    out[n++] = (uint8_t)maskKey;
+    return n;
+}
+
+void WsFrameEncoder::applyMask(uint8_t *data, size_t len, uint32_t maskKey, size_t offset) {
+    uint8_t key[4] = {(uint8_t)(maskKey >> 24), (uint8_t)(maskKey >> 16), (uint8_t)(maskKey >> 8), (uint8_t)maskKey};
+    size_t k = offset & 3;
+
+    // Byte-wise until data is word aligned (Xtensa has no unaligned 32-bit loads)
+    while (len > 0 && ((uintptr_t)data & 3) != 0) {
+        *data++ ^= key[k];
+        k = (k + 1) & 3;
+        len--;
+    }
+
+    // The key rotated so that its first byte lines up with data[0]
+    uint8_t rotated[4] = {key[k], key[(k + 1) & 3], key[(k + 2) & 3], key[(k + 3) & 3]};
+    uint32_t word;
+    memcpy(&word, rotated, 4);
+
+    uint8_t *aligned = (uint8_t *)__builtin_assume_aligned(data, 4);
+    size_t words = len / 4;
+    for (size_t i = 0; i < words; i++) {
+        uint32_t v;
+        memcpy(&v, aligned + i * 4, 4);
+        v ^= word;
+        memcpy(aligned + i * 4, &v, 4);
+    }
+
+    for (size_t i = words * 4; i < len; i++) {
+        data[i] ^= rotated[i & 3];
+    }
+}
+
+bool WsFrameEncoder::finish(uint8_t opcode, uint32_t maskKey, bool fin) {
+    if (!_buf && !reserve(0)) {
+        return false;
+    }
+    uint8_t header[MAX_HEADER_LEN];
+    size_t headerLen = encodeHeader(header, opcode, _payloadLen, maskKey, fin);
+
+    // Header sits right in front of the payload
+    _frameStart = MAX_HEADER_LEN - headerLen;
+    memcpy(_buf + _frameStart, header, headerLen);
+    applyMask(_buf + MAX_HEADER_LEN, _payloadLen, maskKey);
+    return true;
+}
+
+bool WsFrameEncoder::encode(uint8_t opcode, const uint8_t *payload, size_t len, uint32_t maskKey, bool fin) {
+    begin();
+    if (!reserve(len) || !append(payload, len)) {
+        return false;
+    }
+    return finish(opcode, maskKey, fin);
+}
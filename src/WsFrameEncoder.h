@@ -0,0 +1,119 @@
+#ifndef WS_FRAME_ENCODER_H
+#define WS_FRAME_ENCODER_H
+
+#include <Arduino.h>
+
+/* *
+ * WsFrameEncoder Class
+ * Builds complete client-to-server WebSocket frames (RFC 6455) in one reusable buffer.
+ *
+ * The payload is appended after MAX_HEADER_LEN reserved bytes; finish() then writes the
+ * header immediately in front of it and masks the payload in place, 32 bits at a time,
+ * so the whole frame is contiguous and can be handed to Client::write() in one call.
+ * The buffer keeps its high-water capacity between frames.
+ */
+
+// Size of the pieces a frame is handed to Client::write() in. Matching the TLS
+// record size keeps WiFiClientSecure from emitting one record per write() call.
+#ifndef MCP_TX_CHUNK_SIZE
+#ifdef CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN
+#define MCP_TX_CHUNK_SIZE CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN
+#else
+#define MCP_TX_CHUNK_SIZE 4096
+#endif
+#endif
+
+// Payload capacity reserved up front by WebSocketMCP::begin()
+#ifndef MCP_TX_BUFFER_INITIAL
+#define MCP_TX_BUFFER_INITIAL 1024
+#endif
+
+// WebSocket opcodes
+enum WsOpcode : uint8_t {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+
+// OR'd into the opcode passed to finish()/encode()/encodeHeader(): sets RSV1,
+// which marks a compressed message under permessage-deflate (RFC 7692)
+#define WS_FLAG_RSV1 0x40
+
+class WsFrameEncoder {
+public:
+    // FIN/opcode + length byte + 64-bit extended length + masking key
+    static const size_t MAX_HEADER_LEN = 14;
+
+    WsFrameEncoder();
+    ~WsFrameEncoder();
+
+    /* *
+     * Make sure a payload of the given size fits without reallocating
+     * @return false if the allocation failed
+     */
+    bool reserve(size_t payloadCapacity);
+
+    // Start a new frame, discarding any previous payload
+    void begin() { _payloadLen = 0; _frameStart = MAX_HEADER_LEN; }
+
+    bool append(const uint8_t *data, size_t len);
+    bool append(const char *data, size_t len) { return append((const uint8_t *)data, len); }
+    bool append(char c) { return append((const uint8_t *)&c, 1); }
+
+    /* *
+     * Room for up to len more payload bytes, written in place (e.g. by a compressor)
+     * @return Where to write, or nullptr if the allocation failed; commit() adds what was written
+     */
+    uint8_t *appendSpace(size_t len);
+    void commit(size_t len) { _payloadLen += len; }
+
+    // Drop payload bytes appended after the first len
+    void truncate(size_t len) { if (len < _payloadLen) _payloadLen = len; }
+
+    /* *
+     * Write the header in front of the payload and mask it
+     * @param opcode Frame opcode (WsOpcode)
+     * @param maskKey Masking key, applied in network byte order
+     * @param fin Whether this is the final fragment of the message
+     * @return false if no buffer could be allocated
+     */
+    bool finish(uint8_t opcode, uint32_t maskKey, bool fin = true);
+
+    // begin() + append() + finish() in one call
+    bool encode(uint8_t opcode, const uint8_t *payload, size_t len, uint32_t maskKey, bool fin = true);
+
+    // Frame produced by finish()
+    const uint8_t *frame() const { return _buf + _frameStart; }
+    size_t frameLength() const { return MAX_HEADER_LEN - _frameStart + _payloadLen; }
+
+    // Payload appended since begin() (unmasked until finish())
+    uint8_t *payload() { return _buf + MAX_HEADER_LEN; }
+    size_t payloadLength() const { return _payloadLen; }
+    size_t capacity() const { return _capacity; }
+
+    /* *
+     * Encode a frame header
+     * @return Header length in bytes (2 to MAX_HEADER_LEN)
+     */
+    static size_t encodeHeader(uint8_t *out, uint8_t opcode, uint64_t payloadLen, uint32_t maskKey, bool fin = true);
+
+    /* *
+     * XOR data with a masking key in place
+     * @param offset Position of data[0] within the masked payload (selects the key byte)
+     */
+    static void applyMask(uint8_t *data, size_t len, uint32_t maskKey, size_t offset = 0);
+
+private:
+    WsFrameEncoder(const WsFrameEncoder &);
+    WsFrameEncoder &operator=(const WsFrameEncoder &);
+
+    uint8_t *_buf;
+    size_t _capacity;   // payload capacity, excluding the reserved header space
+    size_t _payloadLen;
+    size_t _frameStart; // offset of the first header byte after finish()
+};
+
+#endif // WS_FRAME_ENCODER_H
@@ -0,0 +1,314 @@
+#include "WsFrameParser.h"
+#include "WsFrameEncoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool WsMessageArena::allocate(size_t capacity) {
+    free(_buf);
+    // +1 for the NUL terminator
+    _buf = (uint8_t *)malloc(capacity + 1);
+    _length = 0;
+    _capacity = _buf ? capacity : 0;
+    return _buf != nullptr;
+}
+
+WsFrameParser::WsFrameParser(size_t maxMessageSize)
+    : _state(ST_HEADER), _error(ERR_NONE), _ready(NEED_MORE), _readyOpcode(0), _scratchLen(0), _scratchNeeded(2),
+      _masked(false), _maskKey(0), _payloadLen(0), _payloadRead(0), _framesIn(0), _bytesIn(0), _messageOpcode(0),
+      _messageCompressed(false), _readyCompressed(false), _rsv1Allowed(false),
+      _maxMessageSize(maxMessageSize), _controlLen(0) {
+    _header[0] = _header[1] = 0;
+}
+
+bool WsFrameParser::begin() {
+    if (_arena.capacity() == _maxMessageSize && _arena.data()) {
+        return true;
+    }
+    return _arena.allocate(_maxMessageSize);
+}
+
+bool WsFrameParser::setMaxMessageSize(size_t maxMessageSize) {
+    _maxMessageSize = maxMessageSize;
+    reset();
+    return _arena.allocate(maxMessageSize);
+}
+
+void WsFrameParser::reset() {
+    startFrame();
+    _error = ERR_NONE;
+    _ready = NEED_MORE;
+    _messageOpcode = 0;
+    _arena.clear();
+}
+
+void WsFrameParser::startFrame() {
+    _state = ST_HEADER;
+    _scratchLen = 0;
+    _scratchNeeded = 2;
+    _payloadLen = 0;
+    _payloadRead = 0;
+}
+
+// Called at the start of feed()/readFrom(): whatever was handed out last is no longer needed
+void WsFrameParser::releaseReady() {
+    if (_ready == MESSAGE_READY) {
+        _arena.clear();
+        _messageOpcode = 0;
+    }
+    _ready = NEED_MORE;
+}
+
+const uint8_t *WsFrameParser::payload() const {
+    return _ready == CONTROL_READY ? _control : _arena.data();
+}
+
+size_t WsFrameParser::payloadLength() const {
+    return _ready == CONTROL_READY ? _controlLen : _arena.length();
+}
+
+uint16_t WsFrameParser::closeCode() const {
+    switch (_error) {
+    case ERR_PROTOCOL:
+        return WS_CLOSE_PROTOCOL_ERROR;
+    case ERR_TOO_LARGE:
+        return WS_CLOSE_MESSAGE_TOO_BIG;
+    case ERR_NO_MEMORY:
+        return WS_CLOSE_INTERNAL_ERROR;
+    default:
+        return WS_CLOSE_NORMAL;
+    }
+}
+
+WsFrameParser::Result WsFrameParser::fail(Error error) {
+    _error = error;
+    _state = ST_ERROR;
+    return ERROR;
+}
+
+WsFrameParser::Result WsFrameParser::headerComplete() {
+    _header[0] = _scratch[0];
+    _header[1] = _scratch[1];
+    _framesIn++;
+    uint8_t opcode = _header[0] & 0x0F;
+    bool fin = (_header[0] & 0x80) != 0;
+    _masked = (_header[1] & 0x80) != 0; // Server frames should not be masked; unmask defensively
+    uint8_t len7 = _header[1] & 0x7F;
+
+    // RSV2/RSV3 are never negotiated; RSV1 only with permessage-deflate (RFC 7692)
+    bool rsv1 = (_header[0] & WS_FLAG_RSV1) != 0;
+    if ((_header[0] & 0x30) || (rsv1 && !_rsv1Allowed)) {
+        return fail(ERR_PROTOCOL);
+    }
+
+    if (opcode & 0x08) {
+        // Control frames must be final, carry at most 125 bytes and use a known opcode
+        if (!fin || rsv1 || len7 > 125 || (opcode != WS_OP_CLOSE && opcode != WS_OP_PING && opcode != WS_OP_PONG)) {
+            return fail(ERR_PROTOCOL);
+        }
+    } else if (opcode == WS_OP_CONTINUATION) {
+        if (_messageOpcode == 0 || rsv1) {
+            return fail(ERR_PROTOCOL); // Nothing to continue; RSV1 belongs on the first frame only
+        }
+    } else if (opcode == WS_OP_TEXT || opcode == WS_OP_BINARY) {
+        if (_messageOpcode != 0) {
+            return fail(ERR_PROTOCOL); // New message before the last one finished
+        }
+        _messageOpcode = opcode;
+        _messageCompressed = rsv1;
+    } else {
+        return fail(ERR_PROTOCOL); // Reserved data opcode
+    }
+
+    _scratchLen = 0;
+    if (len7 == 126) {
+        _scratchNeeded = 2;
+        _state = ST_LENGTH;
+        return NEED_MORE;
+    }
+    if (len7 == 127) {
+        _scratchNeeded = 8;
+        _state = ST_LENGTH;
+        return NEED_MORE;
+    }
+    _payloadLen = len7;
+    return lengthComplete();
+}
+
+WsFrameParser::Result WsFrameParser::lengthComplete() {
+    if (_state == ST_LENGTH) {
+        _payloadLen = 0;
+        for (size_t i = 0; i < _scratchNeeded; i++) {
+            _payloadLen = (_payloadLen << 8) | _scratch[i];
+        }
+    }
+    if (_masked) {
+        _scratchLen = 0;
+        _scratchNeeded = 4;
+        _state = ST_MASK;
+        return NEED_MORE;
+    }
+    return payloadStart();
+}
+
+WsFrameParser::Result WsFrameParser::payloadStart() {
+    if (_state == ST_MASK) {
+        _maskKey = (uint32_t)_scratch[0] << 24 | (uint32_t)_scratch[1] << 16 | (uint32_t)_scratch[2] << 8 | _scratch[3];
+    }
+    _payloadRead = 0;
+
+    if (_header[0] & 0x08) {
+        _controlLen = (size_t)_payloadLen;
+    } else {
+        if (!_arena.data() && !begin()) {
+            return fail(ERR_NO_MEMORY);
+        }
+        // The whole message, not just this fragment, has to fit
+        if (_payloadLen > _arena.available()) {
+            return fail(ERR_TOO_LARGE);
+        }
+    }
+
+    _state = ST_PAYLOAD;
+    if (_payloadLen == 0) {
+        return payloadComplete();
+    }
+    return NEED_MORE;
+}
+
+WsFrameParser::Result WsFrameParser::payloadComplete() {
+    uint8_t opcode = _header[0] & 0x0F;
+    bool fin = (_header[0] & 0x80) != 0;
+    startFrame();
+
+    if (opcode & 0x08) {
+        _control[_controlLen] = '\0';
+        _readyOpcode = opcode;
+        _ready = CONTROL_READY;
+        return CONTROL_READY;
+    }
+    if (!fin) {
+        return NEED_MORE; // Wait for the continuation frames
+    }
+    _arena.terminate();
+    _readyOpcode = _messageOpcode;
+    _readyCompressed = _messageCompressed;
+    _ready = MESSAGE_READY;
+    return MESSAGE_READY;
+}
+
+uint8_t *WsFrameParser::payloadTarget() {
+    return (_header[0] & 0x08) ? _control + _payloadRead : _arena.tail();
+}
+
+void WsFrameParser::payloadReceived(size_t n) {
+    uint8_t *target = payloadTarget();
+    if (_masked) {
+        WsFrameEncoder::applyMask(target, n, _maskKey, _payloadRead);
+    }
+    _bytesIn += n;
+    if (!(_header[0] & 0x08)) {
+        _arena.commit(n);
+    }
+    _payloadRead += n;
+}
+
+WsFrameParser::Result WsFrameParser::feed(const uint8_t *data, size_t len, size_t &consumed) {
+    consumed = 0;
+    releaseReady();
+    if (_state == ST_ERROR) {
+        return ERROR;
+    }
+
+    while (consumed < len) {
+        Result r;
+        if (_state == ST_PAYLOAD) {
+            size_t n = (size_t)_payloadLen - _payloadRead;
+            if (n > len - consumed) {
+                n = len - consumed;
+            }
+            memcpy(payloadTarget(), data + consumed, n);
+            payloadReceived(n);
+            consumed += n;
+            if (_payloadRead < _payloadLen) {
+                return NEED_MORE;
+            }
+            r = payloadComplete();
+        } else {
+            // Header, extended length or masking key: collect into _scratch
+            size_t n = _scratchNeeded - _scratchLen;
+            if (n > len - consumed) {
+                n = len - consumed;
+            }
+            memcpy(_scratch + _scratchLen, data + consumed, n);
+            _scratchLen += n;
+            _bytesIn += n;
+            consumed += n;
+            if (_scratchLen < _scratchNeeded) {
+                return NEED_MORE;
+            }
+
+            if (_state == ST_HEADER) {
+                r = headerComplete();
+            } else if (_state == ST_LENGTH) {
+                r = lengthComplete();
+            } else {
+                r = payloadStart();
+            }
+        }
+        if (r != NEED_MORE) {
+            return r;
+        }
+    }
+    return NEED_MORE;
+}
+
+WsFrameParser::Result WsFrameParser::readFrom(Client &client) {
+    releaseReady();
+    if (_state == ST_ERROR) {
+        return ERROR;
+    }
+
+    while (true) {
+        int avail = client.available();
+        if (avail <= 0) {
+            return NEED_MORE;
+        }
+
+        if (_state == ST_PAYLOAD) {
+            // Read payload straight into the arena (or control buffer)
+            size_t want = (size_t)_payloadLen - _payloadRead;
+            if (want > (size_t)avail) {
+                want = (size_t)avail;
+            }
+            int n = client.read(payloadTarget(), want);
+            if (n <= 0) {
+                return NEED_MORE;
+            }
+            payloadReceived((size_t)n);
+            if (_payloadRead == _payloadLen) {
+                Result r = payloadComplete();
+                if (r != NEED_MORE) {
+                    return r;
+                }
+            }
+            continue;
+        }
+
+        // Header bytes: read no more than the current field needs
+        uint8_t tmp[8];
+        size_t want = _scratchNeeded - _scratchLen;
+        if (want > (size_t)avail) {
+            want = (size_t)avail;
+        }
+        int n = client.read(tmp, want);
+        if (n <= 0) {
+            return NEED_MORE;
+        }
+        size_t used;
+        Result r = feed(tmp, (size_t)n, used);
+        if (r != NEED_MORE) {
+            return r;
+        }
+    }
+}
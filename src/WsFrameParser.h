@@ -0,0 +1,177 @@
+#ifndef WS_FRAME_PARSER_H
+#define WS_FRAME_PARSER_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+/* *
+ * WsFrameParser Class
+ * Incremental, non-blocking parser for server-to-client WebSocket messages (RFC 6455).
+ *
+ * Bytes can arrive in any split: the parser keeps its progress (header, extended
+ * length, masking key, payload offset) between calls. Fragmented messages (FIN=0 +
+ * continuation frames) are reassembled into a fixed-capacity WsMessageArena, while
+ * control frames arriving in between are reported on their own from a separate
+ * 125 byte buffer, so PING/PONG/CLOSE keep working during a long message.
+ */
+
+// Largest message (sum of all its fragments) accepted; bigger ones close the
+// connection with status 1009. The arena of this size is allocated once.
+#ifndef MCP_RX_MAX_MESSAGE_SIZE
+#define MCP_RX_MAX_MESSAGE_SIZE 8192
+#endif
+
+// WebSocket close status codes (RFC 6455 section 7.4.1)
+#define WS_CLOSE_NORMAL 1000
+#define WS_CLOSE_PROTOCOL_ERROR 1002
+#define WS_CLOSE_INVALID_DATA 1007
+#define WS_CLOSE_MESSAGE_TOO_BIG 1009
+#define WS_CLOSE_INTERNAL_ERROR 1011
+
+/* *
+ * Fixed-capacity byte arena for one reassembled message
+ * Allocated once; appends beyond the capacity fail instead of growing.
+ */
+class WsMessageArena {
+public:
+    WsMessageArena() : _buf(nullptr), _capacity(0), _length(0) {}
+    ~WsMessageArena() { free(_buf); }
+
+    // (Re)allocate with the given capacity, discarding the content
+    bool allocate(size_t capacity);
+
+    void clear() { _length = 0; }
+    size_t capacity() const { return _capacity; }
+    size_t length() const { return _length; }
+    size_t available() const { return _capacity - _length; }
+
+    // Free space at the end, filled by the caller and then committed
+    uint8_t *tail() { return _buf + _length; }
+    void commit(size_t len) { _length += len; }
+
+    // NUL-terminate the content (the terminator is not counted in length())
+    void terminate() { _buf[_length] = '\0'; }
+    const uint8_t *data() const { return _buf; }
+
+private:
+    WsMessageArena(const WsMessageArena &);
+    WsMessageArena &operator=(const WsMessageArena &);
+
+    uint8_t *_buf;
+    size_t _capacity;
+    size_t _length;
+};
+
+class WsFrameParser {
+public:
+    enum Result {
+        NEED_MORE,     // all input consumed, nothing complete yet
+        MESSAGE_READY, // a complete (possibly reassembled) TEXT/BINARY message
+        CONTROL_READY, // a PING, PONG or CLOSE frame
+        ERROR          // protocol violation or message too large; see error()
+    };
+
+    enum Error {
+        ERR_NONE,
+        ERR_PROTOCOL,  // bad opcode, RSV bits, control frame or continuation sequence
+        ERR_TOO_LARGE, // message exceeds the configured maximum
+        ERR_NO_MEMORY  // message arena could not be allocated
+    };
+
+    explicit WsFrameParser(size_t maxMessageSize = MCP_RX_MAX_MESSAGE_SIZE);
+
+    /* *
+     * Allocate the message arena now instead of on first use
+     * @return false if the allocation failed
+     */
+    bool begin();
+
+    // Change the maximum message size; reallocates the arena and drops any partial message
+    bool setMaxMessageSize(size_t maxMessageSize);
+    size_t maxMessageSize() const { return _maxMessageSize; }
+
+    // Drop any partial frame or message and start over (e.g. after reconnecting)
+    void reset();
+
+    /* *
+     * Parse bytes from a buffer
+     * @param consumed Set to the number of bytes used; stops right after a complete message or control frame
+     */
+    Result feed(const uint8_t *data, size_t len, size_t &consumed);
+
+    /* *
+     * Read whatever the client has available, without waiting for more
+     * Data payloads are read straight into the message arena.
+     */
+    Result readFrom(Client &client);
+
+    // Valid after MESSAGE_READY / CONTROL_READY
+    uint8_t opcode() const { return _readyOpcode; }
+    // Payload is NUL terminated, so it can be used as a C string
+    const uint8_t *payload() const;
+    size_t payloadLength() const;
+
+    // Whether the message has RSV1 set, i.e. is compressed (permessage-deflate); valid after MESSAGE_READY
+    bool compressed() const { return _readyCompressed; }
+
+    // Accept RSV1 on the first frame of a message, once permessage-deflate is negotiated
+    void setRsv1Allowed(bool allowed) { _rsv1Allowed = allowed; }
+
+    // Whether a fragmented message is being reassembled
+    bool fragmented() const { return _messageOpcode != 0; }
+
+    Error error() const { return _error; }
+    // Close status to send for the current error
+    uint16_t closeCode() const;
+
+    // Frames (each fragment counts) and bytes parsed since construction or resetCounters()
+    uint32_t framesIn() const { return _framesIn; }
+    uint64_t bytesIn() const { return _bytesIn; }
+    void resetCounters() { _framesIn = 0; _bytesIn = 0; }
+
+private:
+    enum State {
+        ST_HEADER,  // 2 fixed header bytes
+        ST_LENGTH,  // 2 or 8 extended length bytes
+        ST_MASK,    // 4 masking key bytes
+        ST_PAYLOAD,
+        ST_ERROR
+    };
+
+    void startFrame();
+    void releaseReady();
+    Result headerComplete();
+    Result lengthComplete();
+    Result payloadStart();
+    Result payloadComplete();
+    Result fail(Error error);
+    uint8_t *payloadTarget();
+    void payloadReceived(size_t n);
+
+    State _state;
+    Error _error;
+    Result _ready;          // what was handed out last, released on the next call
+    uint8_t _readyOpcode;
+    uint8_t _header[2];
+    uint8_t _scratch[8];    // header, extended length or masking key being collected
+    size_t _scratchLen;
+    size_t _scratchNeeded;
+    bool _masked;
+    uint32_t _maskKey;
+    uint64_t _payloadLen;
+    size_t _payloadRead;
+    uint32_t _framesIn;
+    uint64_t _bytesIn;
+
+    uint8_t _messageOpcode; // opcode of the message being reassembled, 0 if none
+    bool _messageCompressed; // RSV1 of its first frame
+    bool _readyCompressed;
+    bool _rsv1Allowed;
+    WsMessageArena _arena;
+    size_t _maxMessageSize;
+
+    uint8_t _control[126];  // control frame payload (max 125) + NUL
+    size_t _controlLen;
+};
+
+#endif // WS_FRAME_PARSER_H
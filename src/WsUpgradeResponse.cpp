@@ -0,0 +1,224 @@
+#include "WsUpgradeResponse.h"
+
+#include <string.h>
+
+static_assert(MCP_HTTP_RESPONSE_MAX_SIZE <= 0xFFFF, "header offsets are 16 bits");
+
+static inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+static inline bool isSpace(uint8_t c) {
+    return c == ' ' || c == '\t';
+}
+
+// RFC 7230 tchar: header names are tokens
+static bool isTokenChar(uint8_t c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+        return true;
+    }
+    return c != 0 && strchr("!#$%&'*+-.^_`|~", c) != nullptr;
+}
+
+static bool equalsIgnoreCase(const char *a, const char *b) {
+    while (*a && lower(*a) == lower(*b)) {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+void WsUpgradeResponse::reset() {
+    _len = 0;
+    _scanPos = 0;
+    _lineStart = 0;
+    _pendingPos = 0;
+    _complete = false;
+    _error = ERR_NONE;
+    _status = 0;
+    _headerCount = 0;
+}
+
+WsUpgradeResponse::Result WsUpgradeResponse::fail(Error error) {
+    _error = error;
+    _pendingPos = _len;
+    return ERROR;
+}
+
+WsUpgradeResponse::Result WsUpgradeResponse::feed(const uint8_t *data, size_t len, size_t &consumed) {
+    consumed = 0;
+    if (_error != ERR_NONE) {
+        return ERROR;
+    }
+    if (_complete) {
+        return COMPLETE;
+    }
+
+    size_t room = sizeof(_buf) - _len;
+    size_t n = len < room ? len : room;
+    memcpy(_buf + _len, data, n);
+    _len += n;
+    Result result = scan();
+    if (result == COMPLETE) {
+        // What follows the empty line stays with the caller
+        n -= pendingLength();
+        _len = _pendingPos;
+    }
+    consumed = n;
+    return result;
+}
+
+WsUpgradeResponse::Result WsUpgradeResponse::readFrom(Client &client) {
+    if (_error != ERR_NONE) {
+        return ERROR;
+    }
+    if (_complete) {
+        return COMPLETE;
+    }
+
+    int avail = client.available();
+    if (avail > 0 && _len < sizeof(_buf)) {
+        size_t want = sizeof(_buf) - _len;
+        if (want > (size_t)avail) {
+            want = (size_t)avail;
+        }
+        int n = client.read(_buf + _len, want);
+        if (n > 0) {
+            _len += (size_t)n;
+        }
+    }
+    return scan();
+}
+
+/**
+ * @brief Splits the new bytes into lines and parses each line once.
+ */
+WsUpgradeResponse::Result WsUpgradeResponse::scan() {
+    while (_scanPos < _len) {
+        const uint8_t *lf = (const uint8_t *)memchr(_buf + _scanPos, '\n', _len - _scanPos);
+        if (!lf) {
+            _scanPos = _len;
+            break;
+        }
+        size_t end = lf - _buf;
+        _scanPos = end + 1;
+        Result result = parseLine(_lineStart, end);
+        _lineStart = _scanPos;
+        if (result != NEED_MORE) {
+            return result;
+        }
+    }
+    if (_len == sizeof(_buf)) {
+        return fail(ERR_TOO_LARGE);
+    }
+    _pendingPos = _len;
+    return NEED_MORE;
+}
+
+/**
+ * @brief Parses one line; end is the position of its LF (a CR before it is optional).
+ */
+WsUpgradeResponse::Result WsUpgradeResponse::parseLine(size_t start, size_t end) {
+    if (end > start && _buf[end - 1] == '\r') {
+        end--;
+    }
+    if (start == 0) {
+        return parseStatusLine(start, end);
+    }
+    if (end == start) {
+        _complete = true;
+        _pendingPos = _scanPos;
+        return COMPLETE;
+    }
+
+    // A line starting with whitespace continues the previous one (obs-fold, RFC 7230 3.2.4)
+    if (isSpace(_buf[start])) {
+        return fail(ERR_HEADER_LINE);
+    }
+    size_t colon = start;
+    while (colon < end && _buf[colon] != ':') {
+        if (!isTokenChar(_buf[colon])) {
+            return fail(ERR_HEADER_LINE);
+        }
+        colon++;
+    }
+    if (colon == end || colon == start) {
+        return fail(ERR_HEADER_LINE);
+    }
+    if (_headerCount == MCP_HTTP_MAX_HEADERS) {
+        return fail(ERR_TOO_MANY_HEADERS);
+    }
+
+    size_t value = colon + 1;
+    while (value < end && isSpace(_buf[value])) {
+        value++;
+    }
+    size_t valueEnd = end;
+    while (valueEnd > value && isSpace(_buf[valueEnd - 1])) {
+        valueEnd--;
+    }
+    _buf[colon] = '\0';
+    _buf[valueEnd] = '\0';
+    _headers[_headerCount].name = (uint16_t)start;
+    _headers[_headerCount].value = (uint16_t)value;
+    _headerCount++;
+    return NEED_MORE;
+}
+
+// HTTP/1.x SP 3DIGIT [SP reason-phrase]
+WsUpgradeResponse::Result WsUpgradeResponse::parseStatusLine(size_t start, size_t end) {
+    const uint8_t *line = _buf + start;
+    size_t len = end - start;
+    if (len < 12 || memcmp(line, "HTTP/1.", 7) != 0 || line[7] < '0' || line[7] > '9' || line[8] != ' ') {
+        return fail(ERR_STATUS_LINE);
+    }
+    int status = 0;
+    for (size_t i = 9; i < 12; i++) {
+        if (line[i] < '0' || line[i] > '9') {
+            return fail(ERR_STATUS_LINE);
+        }
+        status = status * 10 + (line[i] - '0');
+    }
+    if (len > 12 && line[12] != ' ') {
+        return fail(ERR_STATUS_LINE);
+    }
+    _status = status;
+    return NEED_MORE;
+}
+
+const char *WsUpgradeResponse::header(const char *name) const {
+    for (size_t i = 0; i < _headerCount; i++) {
+        if (equalsIgnoreCase(headerName(i), name)) {
+            return headerValue(i);
+        }
+    }
+    return nullptr;
+}
+
+bool WsUpgradeResponse::hasToken(const char *value, const char *token) {
+    size_t tokenLen = strlen(token);
+    const char *p = value;
+    while (*p) {
+        while (*p == ',' || isSpace(*p)) {
+            p++;
+        }
+        const char *start = p;
+        while (*p && *p != ',') {
+            p++;
+        }
+        const char *end = p;
+        while (end > start && isSpace(end[-1])) {
+            end--;
+        }
+        if ((size_t)(end - start) == tokenLen) {
+            size_t i = 0;
+            while (i < tokenLen && lower(start[i]) == lower(token[i])) {
+                i++;
+            }
+            if (i == tokenLen) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
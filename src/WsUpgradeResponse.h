@@ -0,0 +1,105 @@
+#ifndef WS_UPGRADE_RESPONSE_H
+#define WS_UPGRADE_RESPONSE_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+/* *
+ * WsUpgradeResponse Class
+ * Single-pass parser for the server's answer to the WebSocket upgrade request
+ * (RFC 6455 section 4.1, RFC 7230 section 3).
+ *
+ * The response is read in bulk into a fixed buffer; a status line plus headers
+ * longer than MCP_HTTP_RESPONSE_MAX_SIZE fails instead of growing. Every byte is
+ * scanned once: each line is split as soon as it is complete and a header is
+ * kept as offsets into the buffer, its name and trimmed value NUL-terminated in
+ * place. Lookups compare names case-insensitively.
+ *
+ * Bytes the server sent after the empty line already belong to the WebSocket
+ * stream. They stay in the buffer, available through pending(), until the frame
+ * parser has taken them.
+ */
+
+// Largest status line plus headers accepted
+#ifndef MCP_HTTP_RESPONSE_MAX_SIZE
+#define MCP_HTTP_RESPONSE_MAX_SIZE 1024
+#endif
+
+// Most header lines accepted
+#ifndef MCP_HTTP_MAX_HEADERS
+#define MCP_HTTP_MAX_HEADERS 24
+#endif
+
+class WsUpgradeResponse {
+public:
+    enum Result {
+        NEED_MORE, // all input used, the empty line has not arrived yet
+        COMPLETE,  // status line and headers parsed
+        ERROR      // see error()
+    };
+
+    enum Error {
+        ERR_NONE,
+        ERR_TOO_LARGE,        // no empty line within MCP_HTTP_RESPONSE_MAX_SIZE bytes
+        ERR_TOO_MANY_HEADERS,
+        ERR_STATUS_LINE,      // not "HTTP/1.x NNN ..."
+        ERR_HEADER_LINE       // no colon, invalid name, or an obsolete folded line
+    };
+
+    WsUpgradeResponse() { reset(); }
+
+    // Forget the previous response
+    void reset();
+
+    /* *
+     * Parse bytes from a buffer
+     * @param consumed Set to the number of bytes used; stops right after the empty line
+     */
+    Result feed(const uint8_t *data, size_t len, size_t &consumed);
+
+    // Read whatever the client has available, without waiting for more
+    Result readFrom(Client &client);
+
+    Error error() const { return _error; }
+
+    // Valid after COMPLETE
+    int status() const { return _status; }
+    size_t headerCount() const { return _headerCount; }
+    const char *headerName(size_t index) const { return (const char *)_buf + _headers[index].name; }
+    const char *headerValue(size_t index) const { return (const char *)_buf + _headers[index].value; }
+
+    // Value of the first header with this name (any case), or nullptr
+    const char *header(const char *name) const;
+
+    // Whether a comma separated header value lists token (any case), e.g. "Connection: keep-alive, Upgrade"
+    static bool hasToken(const char *value, const char *token);
+
+    // Bytes read past the headers, not yet taken by the frame parser
+    const uint8_t *pending() const { return _buf + _pendingPos; }
+    size_t pendingLength() const { return _len - _pendingPos; }
+    void consumePending(size_t n) { _pendingPos += n; }
+
+private:
+    struct Header {
+        uint16_t name;  // offsets into _buf
+        uint16_t value;
+    };
+
+    Result scan();
+    Result parseLine(size_t start, size_t end);
+    Result parseStatusLine(size_t start, size_t end);
+    Result fail(Error error);
+
+    uint8_t _buf[MCP_HTTP_RESPONSE_MAX_SIZE];
+    size_t _len;        // bytes in _buf
+    size_t _scanPos;    // bytes already scanned for line ends
+    size_t _lineStart;
+    size_t _pendingPos; // == _len unless the headers are complete
+    bool _complete;
+    Error _error;
+    int _status;
+    Header _headers[MCP_HTTP_MAX_HEADERS];
+    size_t _headerCount;
+};
+
+#endif // WS_UPGRADE_RESPONSE_H